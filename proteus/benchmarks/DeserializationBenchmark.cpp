@@ -0,0 +1,154 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdexcept>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+
+#include "proteus/framing/FrameSerializer.h"
+
+using namespace proteus;
+
+namespace {
+
+std::unique_ptr<FrameSerializer> createSerializer() {
+  return FrameSerializer::createFrameSerializer(ProtocolVersion(1, 0));
+}
+
+std::unique_ptr<folly::IOBuf> createFrame(const FrameSerializer& serializer) {
+  return serializer.serializeOut(Frame_REQUEST_RESPONSE(
+      1, FrameFlags::EMPTY, rsocket::Payload("data", "metadata")));
+}
+
+// Cuts the frame in the middle of the metadata length field, which is what
+// a peer sending garbage looks like to the deserializer.
+std::unique_ptr<folly::IOBuf> createTruncatedFrame(
+    const FrameSerializer& serializer) {
+  auto frame = createFrame(serializer);
+  frame->coalesce();
+  frame->trimEnd(frame->length() - 7);
+  return frame;
+}
+
+// Reference for the exception based decoding the serializer used to do:
+// unchecked cursor reads, with a truncated frame surfacing as a thrown
+// exception. It decodes the same REQUEST_RESPONSE frames as
+// tryDeserializeFrom, minus the payload codecs, which are not set up here.
+bool deserializeWithExceptions(
+    Frame_REQUEST_RESPONSE& frame,
+    std::unique_ptr<folly::IOBuf> in) {
+  folly::io::Cursor cur(in.get());
+  try {
+    auto streamId = cur.readBE<int32_t>();
+    if (streamId < 0) {
+      throw std::runtime_error("invalid stream id");
+    }
+    auto typeAndFlags = cur.readBE<uint16_t>();
+    frame.header_.streamId = static_cast<rsocket::StreamId>(streamId);
+    frame.header_.type = static_cast<FrameType>(typeAndFlags >> 10);
+    frame.header_.flags = static_cast<FrameFlags>(typeAndFlags & 0x3FF);
+
+    std::unique_ptr<folly::IOBuf> metadata;
+    if (!!(frame.header_.flags & FrameFlags::METADATA)) {
+      uint32_t metadataLength = 0;
+      metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 16);
+      metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 8);
+      metadataLength |= cur.read<uint8_t>();
+      cur.clone(metadata, metadataLength);
+    }
+    std::unique_ptr<folly::IOBuf> data;
+    if (auto length = cur.totalLength()) {
+      cur.clone(data, length);
+    }
+    frame.payload_ = rsocket::Payload(std::move(data), std::move(metadata));
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+BENCHMARK(DeserializeValidFrame, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  auto frame = createFrame(*serializer);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    Frame_REQUEST_RESPONSE out;
+    folly::doNotOptimizeAway(deserializeWithExceptions(out, frame->clone()));
+  }
+}
+
+BENCHMARK_RELATIVE(TryDeserializeValidFrame, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  auto frame = createFrame(*serializer);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    Frame_REQUEST_RESPONSE out;
+    folly::doNotOptimizeAway(
+        serializer->tryDeserializeFrom(out, frame->clone()));
+  }
+}
+
+BENCHMARK_RELATIVE(TryDeserializeLazyFrame, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  auto frame = createFrame(*serializer);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    LazyFrame out;
+    folly::doNotOptimizeAway(
+        serializer->tryDeserializeFrom(out, frame->clone()));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(DeserializeTruncatedFrame, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  auto frame = createTruncatedFrame(*serializer);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    Frame_REQUEST_RESPONSE out;
+    folly::doNotOptimizeAway(deserializeWithExceptions(out, frame->clone()));
+  }
+}
+
+BENCHMARK_RELATIVE(TryDeserializeTruncatedFrame, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  auto frame = createTruncatedFrame(*serializer);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    Frame_REQUEST_RESPONSE out;
+    folly::doNotOptimizeAway(
+        serializer->tryDeserializeFrom(out, frame->clone()));
+  }
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
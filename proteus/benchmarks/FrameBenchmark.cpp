@@ -0,0 +1,497 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Encode and decode cost of every frame type, RSocket and broker, across
+// payload sizes, with payloads in one buffer or chained.
+//
+// Besides time per op, benchmarks report allocs_per_op: calls into the C
+// allocator, where IOBuf and operator new both end up. They are counted by
+// wrapping glibc's malloc, so they are only reported when folly doesn't use
+// jemalloc.
+//
+// Use --json for machine-readable output, --bm_json_verbose=<file> to keep
+// the results of a release and --bm_relative_to=<file> to compare with
+// them; --bm_regex=<regex> selects benchmarks.
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/Portability.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBufQueue.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameSerializer.h"
+
+using namespace proteus;
+
+namespace {
+std::atomic<uint64_t> gAllocations{0};
+} // namespace
+
+#if defined(__GLIBC__) && !defined(FOLLY_USE_JEMALLOC)
+constexpr const bool kCountAllocations = true;
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) noexcept {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+} // extern "C"
+#else
+constexpr const bool kCountAllocations = false;
+#endif
+
+namespace {
+
+constexpr const size_t kChainLength = 4;
+
+// Counts the allocations of the benchmark loop.
+class AllocationCounter {
+ public:
+  AllocationCounter()
+      : start_(gAllocations.load(std::memory_order_relaxed)) {}
+
+  void report(folly::UserCounters& counters, size_t iters) const {
+    if (!kCountAllocations || iters == 0) {
+      return;
+    }
+    const auto allocations =
+        gAllocations.load(std::memory_order_relaxed) - start_;
+    counters["allocs_per_op"] =
+        static_cast<int>((allocations + iters / 2) / iters);
+  }
+
+ private:
+  const uint64_t start_;
+};
+
+// `size` bytes, cut into kChainLength buffers if `chained`.
+std::unique_ptr<folly::IOBuf> createBuffer(size_t size, bool chained) {
+  const auto pieces = chained && size >= kChainLength ? kChainLength : 1;
+  folly::IOBufQueue queue;
+  for (size_t i = 0; i < pieces; ++i) {
+    const auto length =
+        i + 1 < pieces ? size / pieces : size - (pieces - 1) * (size / pieces);
+    auto buf = folly::IOBuf::create(length);
+    std::memset(buf->writableData(), 'x', length);
+    buf->append(length);
+    queue.append(std::move(buf));
+  }
+  auto buf = queue.move();
+  return buf ? std::move(buf) : folly::IOBuf::create(0);
+}
+
+// Payload cloned into every frame, so encoding doesn't copy or fill it.
+struct Payload {
+  Payload(size_t size, bool chained)
+      : data(createBuffer(size, chained)),
+        metadata(createBuffer(size, chained)) {}
+
+  rsocket::Payload clone() const {
+    return rsocket::Payload(data->clone(), metadata->clone());
+  }
+
+  std::unique_ptr<folly::IOBuf> data;
+  std::unique_ptr<folly::IOBuf> metadata;
+};
+
+template <typename Frame>
+struct Tag {};
+
+Frame_REQUEST_STREAM createFrame(Tag<Frame_REQUEST_STREAM>, const Payload& p) {
+  return Frame_REQUEST_STREAM(1, FrameFlags::EMPTY, 128, p.clone());
+}
+
+Frame_REQUEST_CHANNEL createFrame(
+    Tag<Frame_REQUEST_CHANNEL>,
+    const Payload& p) {
+  return Frame_REQUEST_CHANNEL(1, FrameFlags::EMPTY, 128, p.clone());
+}
+
+Frame_REQUEST_RESPONSE createFrame(
+    Tag<Frame_REQUEST_RESPONSE>,
+    const Payload& p) {
+  return Frame_REQUEST_RESPONSE(1, FrameFlags::EMPTY, p.clone());
+}
+
+Frame_REQUEST_FNF createFrame(Tag<Frame_REQUEST_FNF>, const Payload& p) {
+  return Frame_REQUEST_FNF(1, FrameFlags::EMPTY, p.clone());
+}
+
+Frame_REQUEST_N createFrame(Tag<Frame_REQUEST_N>, const Payload&) {
+  return Frame_REQUEST_N(1, 128);
+}
+
+Frame_METADATA_PUSH createFrame(Tag<Frame_METADATA_PUSH>, const Payload& p) {
+  return Frame_METADATA_PUSH(p.metadata->clone());
+}
+
+Frame_CANCEL createFrame(Tag<Frame_CANCEL>, const Payload&) {
+  return Frame_CANCEL(1);
+}
+
+Frame_PAYLOAD createFrame(Tag<Frame_PAYLOAD>, const Payload& p) {
+  return Frame_PAYLOAD(1, FrameFlags::NEXT, p.clone());
+}
+
+Frame_ERROR createFrame(Tag<Frame_ERROR>, const Payload& p) {
+  return Frame_ERROR(1, ErrorCode::APPLICATION_ERROR, p.clone());
+}
+
+Frame_KEEPALIVE createFrame(Tag<Frame_KEEPALIVE>, const Payload& p) {
+  return Frame_KEEPALIVE(
+      FrameFlags::KEEPALIVE_RESPOND, 1024, p.data->clone());
+}
+
+Frame_SETUP createFrame(Tag<Frame_SETUP>, const Payload& p) {
+  return Frame_SETUP(
+      FrameFlags::EMPTY,
+      1,
+      0,
+      500,
+      10000,
+      rsocket::ResumeIdentificationToken(),
+      "application/x.netifi",
+      "application/json",
+      p.clone());
+}
+
+Frame_LEASE createFrame(Tag<Frame_LEASE>, const Payload& p) {
+  return Frame_LEASE(1000, 128, p.metadata->clone());
+}
+
+Frame_RESUME createFrame(Tag<Frame_RESUME>, const Payload&) {
+  return Frame_RESUME(
+      rsocket::ResumeIdentificationToken(), 1024, 2048, ProtocolVersion(1, 0));
+}
+
+Frame_RESUME_OK createFrame(Tag<Frame_RESUME_OK>, const Payload&) {
+  return Frame_RESUME_OK(1024);
+}
+
+std::unique_ptr<FrameSerializer> createSerializer() {
+  return FrameSerializer::createFrameSerializer(ProtocolVersion(1, 0));
+}
+
+template <typename Frame>
+void encode(
+    folly::UserCounters& counters,
+    unsigned iters,
+    size_t payloadSize,
+    bool chained) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  auto batch = serializer->createFrameBatch();
+  const Payload payload(payloadSize, chained);
+  suspender.dismiss();
+
+  AllocationCounter allocations;
+  for (unsigned i = 0; i < iters; ++i) {
+    serializer->serializeOut(batch, createFrame(Tag<Frame>(), payload));
+    folly::doNotOptimizeAway(batch.move());
+  }
+  allocations.report(counters, iters);
+}
+
+template <typename Frame>
+void decode(
+    folly::UserCounters& counters,
+    unsigned iters,
+    size_t payloadSize,
+    bool chained) {
+  folly::BenchmarkSuspender suspender;
+  auto serializer = createSerializer();
+  const Payload payload(payloadSize, chained);
+  auto frame =
+      serializer->serializeBatchOut(createFrame(Tag<Frame>(), payload));
+  if (!chained) {
+    frame->coalesce();
+  }
+  suspender.dismiss();
+
+  AllocationCounter allocations;
+  for (unsigned i = 0; i < iters; ++i) {
+    Frame out;
+    folly::doNotOptimizeAway(
+        serializer->tryDeserializeFrom(out, frame->clone()));
+  }
+  allocations.report(counters, iters);
+}
+
+// Broker frames, with `metadata` as application metadata.
+template <typename Appender>
+void encodeBrokerFrame(
+    Appender& appender,
+    FrameType frameType,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  const folly::StringPiece destination("service-instance-1");
+  const folly::StringPiece group("services");
+  const folly::ByteRange token(folly::StringPiece("access-token"));
+
+  switch (frameType) {
+    case FrameType::BROKER_SETUP:
+      BrokerSetupLayout::encode(
+          appender,
+          uint16_t{1},
+          uint16_t{0},
+          frameType,
+          folly::StringPiece("broker-1"),
+          folly::StringPiece("cluster"),
+          uint64_t{42},
+          token);
+      break;
+    case FrameType::DESTINATION_SETUP:
+      DestinationSetupLayout::encode(
+          appender,
+          uint16_t{1},
+          uint16_t{0},
+          frameType,
+          destination,
+          group,
+          uint64_t{42},
+          token);
+      break;
+    case FrameType::DESTINATION:
+      DestinationLayout::encode(
+          appender,
+          uint16_t{1},
+          uint16_t{0},
+          frameType,
+          folly::StringPiece("client-1"),
+          folly::StringPiece("clients"),
+          destination,
+          group,
+          std::move(metadata));
+      break;
+    case FrameType::GROUP:
+    case FrameType::BROADCAST:
+      GroupLayout::encode(
+          appender,
+          uint16_t{1},
+          uint16_t{0},
+          frameType,
+          folly::StringPiece("client-1"),
+          folly::StringPiece("clients"),
+          group,
+          std::move(metadata));
+      break;
+    case FrameType::SHARD:
+      ShardLayout::encode(
+          appender,
+          uint16_t{1},
+          uint16_t{0},
+          frameType,
+          folly::StringPiece("client-1"),
+          folly::StringPiece("clients"),
+          group,
+          folly::ByteRange(folly::StringPiece("shard-key")),
+          std::move(metadata));
+      break;
+    default:
+      LOG(FATAL) << "not a broker frame: " << frameType;
+  }
+}
+
+size_t brokerHeaderSize(FrameType frameType) {
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  folly::io::QueueAppender appender(&queue, 256);
+  encodeBrokerFrame(appender, frameType, nullptr);
+  return queue.chainLength();
+}
+
+void encodeBroker(
+    folly::UserCounters& counters,
+    unsigned iters,
+    FrameType frameType,
+    size_t metadataSize,
+    bool chained) {
+  folly::BenchmarkSuspender suspender;
+  FrameBatch batch;
+  const auto headerSize = brokerHeaderSize(frameType);
+  const auto metadata = createBuffer(metadataSize, chained);
+  suspender.dismiss();
+
+  AllocationCounter allocations;
+  for (unsigned i = 0; i < iters; ++i) {
+    batch.beginFrame(headerSize, metadataSize);
+    encodeBrokerFrame(batch, frameType, metadata->clone());
+    folly::doNotOptimizeAway(batch.move());
+  }
+  allocations.report(counters, iters);
+}
+
+template <typename View>
+void decodeBroker(
+    folly::UserCounters& counters,
+    unsigned iters,
+    FrameType frameType,
+    size_t metadataSize,
+    bool chained) {
+  folly::BenchmarkSuspender suspender;
+  FrameBatch batch;
+  batch.beginFrame(brokerHeaderSize(frameType), metadataSize);
+  encodeBrokerFrame(batch, frameType, createBuffer(metadataSize, chained));
+  auto frame = batch.move();
+  if (!chained) {
+    frame->coalesce();
+  }
+  suspender.dismiss();
+
+  // Views parse the head buffer, the rest of a chained frame is cloned.
+  AllocationCounter allocations;
+  for (unsigned i = 0; i < iters; ++i) {
+    auto view = View::tryParse(*frame);
+    folly::doNotOptimizeAway(view);
+    if (chained) {
+      folly::doNotOptimizeAway(view->cloneMetadata(*frame));
+    }
+  }
+  allocations.report(counters, iters);
+}
+
+template <typename View>
+void decodeBrokerSetup(
+    folly::UserCounters& counters,
+    unsigned iters,
+    FrameType frameType) {
+  folly::BenchmarkSuspender suspender;
+  FrameBatch batch;
+  batch.beginFrame(brokerHeaderSize(frameType), 0);
+  encodeBrokerFrame(batch, frameType, nullptr);
+  auto frame = batch.move();
+  frame->coalesce();
+  suspender.dismiss();
+
+  AllocationCounter allocations;
+  for (unsigned i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(View::tryParse(*frame));
+  }
+  allocations.report(counters, iters);
+}
+
+} // namespace
+
+// Frames with a payload, across payload sizes. Data and metadata are both
+// of the given size.
+#define PAYLOAD_FRAME_BENCHMARKS(Type)                                       \
+  void encode_##Type(                                                        \
+      folly::UserCounters& counters, unsigned iters, size_t size, bool c) {  \
+    encode<Frame_##Type>(counters, iters, size, c);                          \
+  }                                                                          \
+  void decode_##Type(                                                        \
+      folly::UserCounters& counters, unsigned iters, size_t size, bool c) {  \
+    decode<Frame_##Type>(counters, iters, size, c);                          \
+  }                                                                          \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 16B, 16, false)    \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 1KB, 1024, false)  \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 64KB, 65536, false)\
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 1KB_chained, 1024, \
+                                 true)                                       \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 64KB_chained,      \
+                                 65536, true)                                \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 16B, 16, false)    \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 1KB, 1024, false)  \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 64KB, 65536, false)\
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 1KB_chained, 1024, \
+                                 true)                                       \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 64KB_chained,      \
+                                 65536, true)                                \
+  BENCHMARK_DRAW_LINE();
+
+// Frames without a payload.
+#define HEADER_FRAME_BENCHMARKS(Type)                                        \
+  BENCHMARK_COUNTERS(encode_##Type, counters, iters) {                       \
+    encode<Frame_##Type>(counters, iters, 0, false);                         \
+  }                                                                          \
+  BENCHMARK_COUNTERS(decode_##Type, counters, iters) {                       \
+    decode<Frame_##Type>(counters, iters, 0, false);                         \
+  }                                                                          \
+  BENCHMARK_DRAW_LINE();
+
+PAYLOAD_FRAME_BENCHMARKS(REQUEST_STREAM)
+PAYLOAD_FRAME_BENCHMARKS(REQUEST_CHANNEL)
+PAYLOAD_FRAME_BENCHMARKS(REQUEST_RESPONSE)
+PAYLOAD_FRAME_BENCHMARKS(REQUEST_FNF)
+HEADER_FRAME_BENCHMARKS(REQUEST_N)
+PAYLOAD_FRAME_BENCHMARKS(METADATA_PUSH)
+HEADER_FRAME_BENCHMARKS(CANCEL)
+PAYLOAD_FRAME_BENCHMARKS(PAYLOAD)
+PAYLOAD_FRAME_BENCHMARKS(ERROR)
+PAYLOAD_FRAME_BENCHMARKS(KEEPALIVE)
+PAYLOAD_FRAME_BENCHMARKS(SETUP)
+PAYLOAD_FRAME_BENCHMARKS(LEASE)
+HEADER_FRAME_BENCHMARKS(RESUME)
+HEADER_FRAME_BENCHMARKS(RESUME_OK)
+
+// Broker routing frames, across application metadata sizes.
+#define BROKER_FRAME_BENCHMARKS(Type, View)                                  \
+  void encode_##Type(                                                        \
+      folly::UserCounters& counters, unsigned iters, size_t size, bool c) {  \
+    encodeBroker(counters, iters, FrameType::Type, size, c);                 \
+  }                                                                          \
+  void decode_##Type(                                                        \
+      folly::UserCounters& counters, unsigned iters, size_t size, bool c) {  \
+    decodeBroker<View>(counters, iters, FrameType::Type, size, c);           \
+  }                                                                          \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 16B, 16, false)    \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 1KB, 1024, false)  \
+  BENCHMARK_COUNTERS_NAMED_PARAM(encode_##Type, counters, 1KB_chained, 1024, \
+                                 true)                                       \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 16B, 16, false)    \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 1KB, 1024, false)  \
+  BENCHMARK_COUNTERS_NAMED_PARAM(decode_##Type, counters, 1KB_chained, 1024, \
+                                 true)                                       \
+  BENCHMARK_DRAW_LINE();
+
+// Broker setup frames, which have no metadata.
+#define BROKER_SETUP_BENCHMARKS(Type, View)                                  \
+  BENCHMARK_COUNTERS(encode_##Type, counters, iters) {                       \
+    encodeBroker(counters, iters, FrameType::Type, 0, false);                \
+  }                                                                          \
+  BENCHMARK_COUNTERS(decode_##Type, counters, iters) {                       \
+    decodeBrokerSetup<View>(counters, iters, FrameType::Type);               \
+  }                                                                          \
+  BENCHMARK_DRAW_LINE();
+
+BROKER_SETUP_BENCHMARKS(BROKER_SETUP, BrokerSetupView)
+BROKER_SETUP_BENCHMARKS(DESTINATION_SETUP, DestinationSetupView)
+BROKER_FRAME_BENCHMARKS(DESTINATION, DestinationView)
+BROKER_FRAME_BENCHMARKS(GROUP, GroupView)
+BROKER_FRAME_BENCHMARKS(BROADCAST, BroadcastView)
+BROKER_FRAME_BENCHMARKS(SHARD, ShardView)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
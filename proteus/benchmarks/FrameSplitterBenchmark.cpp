@@ -0,0 +1,118 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+
+#include "proteus/framing/FrameSplitter.h"
+
+using namespace proteus;
+
+namespace {
+
+constexpr size_t kReadSize = 64 * 1024;
+// REQUEST_N: 6 bytes of header and 4 bytes of request n
+constexpr size_t kFrameSize = 10;
+
+// A 64KB read full of length-prefixed REQUEST_N sized frames.
+std::unique_ptr<folly::IOBuf> createRead() {
+  auto buf = folly::IOBuf::create(kReadSize);
+  folly::io::Appender appender(buf.get(), 0);
+  while (buf->length() + 3 + kFrameSize <= kReadSize) {
+    appender.write<uint8_t>(0);
+    appender.write<uint8_t>(0);
+    appender.write<uint8_t>(kFrameSize);
+    for (size_t i = 0; i < kFrameSize; ++i) {
+      appender.write<uint8_t>(0);
+    }
+  }
+  return buf;
+}
+
+// What the transport did before: find frames one at a time with a Cursor.
+size_t splitWithCursor(
+    folly::IOBufQueue& queue,
+    std::vector<std::unique_ptr<folly::IOBuf>>& frames) {
+  size_t count = 0;
+  while (queue.chainLength() >= FrameSplitter::kFrameLengthFieldSize) {
+    folly::io::Cursor cur(queue.front());
+    uint32_t length = 0;
+    length |= static_cast<uint32_t>(cur.read<uint8_t>() << 16);
+    length |= static_cast<uint32_t>(cur.read<uint8_t>() << 8);
+    length |= cur.read<uint8_t>();
+    if (queue.chainLength() < FrameSplitter::kFrameLengthFieldSize + length) {
+      break;
+    }
+    queue.trimStart(FrameSplitter::kFrameLengthFieldSize);
+    frames.push_back(queue.split(length));
+    ++count;
+  }
+  return count;
+}
+
+} // namespace
+
+BENCHMARK(SplitWithCursor, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto read = createRead();
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+    queue.append(read->clone());
+    frames.clear();
+    folly::doNotOptimizeAway(splitWithCursor(queue, frames));
+  }
+}
+
+BENCHMARK_RELATIVE(SplitWithFrameSplitter, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto read = createRead();
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    FrameSplitter splitter;
+    splitter.append(read->clone());
+    frames.clear();
+    folly::doNotOptimizeAway(splitter.split(frames));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ScanOnly, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto read = createRead();
+  std::vector<folly::ByteRange> frames;
+  frames.reserve(kReadSize / kFrameSize);
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    frames.clear();
+    folly::doNotOptimizeAway(FrameSplitter::scan(
+        folly::ByteRange(read->data(), read->length()), frames));
+  }
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
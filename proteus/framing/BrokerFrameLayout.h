@@ -0,0 +1,103 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "proteus/framing/FrameLayout.h"
+#include "proteus/framing/FrameType.h"
+
+namespace proteus {
+
+/// Wire layouts of the broker frames, see BrokerFrameView.h for a
+/// description of the format. Encoding a frame is a matter of
+///
+///   BrokerSetupLayout::encode(
+///       appender, major, minor, FrameType::BROKER_SETUP, ...);
+
+using BrokerString = layout::
+    LengthPrefixed<layout::BigEndian<uint32_t>, folly::StringPiece>;
+using BrokerBytes = layout::LengthPrefixed<layout::BigEndian<uint32_t>>;
+using BrokerMetadata = layout::Trailing<>;
+
+/// Broker frame type, stored as its 16 bit wire value. Values that don't
+/// name a broker frame type load as FrameType::UNDEFINED.
+struct BrokerFrameTypeField : layout::BigEndian<uint16_t> {
+  using Type = FrameType;
+
+  static size_t size(FrameType) {
+    return kSize;
+  }
+
+  static FrameType load(const uint8_t* data) {
+    return fromBrokerWireType(layout::BigEndian<uint16_t>::load(data));
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, FrameType type) {
+    appender.template writeBE<uint16_t>(toBrokerWireType(type));
+  }
+
+  static bool decode(folly::ByteRange& in, FrameType& type) {
+    if (in.size() < kSize) {
+      return false;
+    }
+    type = load(in.data());
+    in.uncheckedAdvance(kSize);
+    return true;
+  }
+};
+
+template <typename... Fields>
+using BrokerFrameLayout = layout::Layout<
+    layout::BigEndian<uint16_t>, // major version
+    layout::BigEndian<uint16_t>, // minor version
+    BrokerFrameTypeField,
+    Fields...>;
+
+using BrokerFrameHeaderLayout = BrokerFrameLayout<>;
+
+using BrokerSetupLayout = BrokerFrameLayout<
+    BrokerString, // broker id
+    BrokerString, // cluster id
+    layout::BigEndian<uint64_t>, // access key
+    BrokerBytes>; // access token
+
+using DestinationSetupLayout = BrokerFrameLayout<
+    BrokerString, // destination
+    BrokerString, // group
+    layout::BigEndian<uint64_t>, // access key
+    BrokerBytes>; // access token
+
+using DestinationLayout = BrokerFrameLayout<
+    BrokerString, // from destination
+    BrokerString, // from group
+    BrokerString, // to destination
+    BrokerString, // to group
+    BrokerMetadata>;
+
+/// Shared by GROUP and BROADCAST frames.
+using GroupLayout = BrokerFrameLayout<
+    BrokerString, // from destination
+    BrokerString, // from group
+    BrokerString, // to group
+    BrokerMetadata>;
+
+using ShardLayout = BrokerFrameLayout<
+    BrokerString, // from destination
+    BrokerString, // from group
+    BrokerString, // to group
+    BrokerBytes, // shard key
+    BrokerMetadata>;
+
+} // namespace proteus
@@ -0,0 +1,144 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/BrokerFrameRewrite.h"
+
+#include <cstring>
+
+#include <folly/Bits.h>
+#include <folly/small_vector.h>
+#include <glog/logging.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/BrokerFrameView.h"
+
+namespace proteus {
+
+namespace {
+
+// Routing headers are encoded here before they replace the old ones, as the
+// new field values may point into the old header.
+class HeaderScratch {
+ public:
+  explicit HeaderScratch(size_t size) : bytes_(size) {}
+
+  template <typename T>
+  void writeBE(T value) {
+    DCHECK_LE(offset_ + sizeof(T), bytes_.size());
+    folly::storeUnaligned(bytes_.data() + offset_, folly::Endian::big(value));
+    offset_ += sizeof(T);
+  }
+
+  void push(const uint8_t* data, size_t length) {
+    DCHECK_LE(offset_ + length, bytes_.size());
+    if (length > 0) {
+      std::memcpy(bytes_.data() + offset_, data, length);
+    }
+    offset_ += length;
+  }
+
+  folly::ByteRange range() const {
+    DCHECK_EQ(offset_, bytes_.size());
+    return folly::ByteRange(bytes_.data(), bytes_.size());
+  }
+
+ private:
+  folly::small_vector<uint8_t, 128> bytes_;
+  size_t offset_{0};
+};
+
+} // namespace
+
+bool rewriteDestination(
+    LazyFrame& frame,
+    rsocket::StreamId streamId,
+    folly::StringPiece fromDestination,
+    folly::StringPiece fromGroup,
+    folly::StringPiece toDestination,
+    folly::StringPiece toGroup) {
+  auto metadata = frame.metadataRange();
+  if (!metadata) {
+    return false;
+  }
+  auto view = DestinationView::tryParse(*metadata);
+  if (!view) {
+    return false;
+  }
+
+  const folly::ByteRange noMetadata;
+  HeaderScratch header(DestinationLayout::serializedSize(
+      view->majorVersion(),
+      view->minorVersion(),
+      FrameType::DESTINATION,
+      fromDestination,
+      fromGroup,
+      toDestination,
+      toGroup,
+      noMetadata));
+  DestinationLayout::encode(
+      header,
+      view->majorVersion(),
+      view->minorVersion(),
+      FrameType::DESTINATION,
+      fromDestination,
+      fromGroup,
+      toDestination,
+      toGroup,
+      noMetadata);
+
+  frame.replaceMetadataPrefix(view->metadataOffset(), header.range());
+  frame.setStreamId(streamId);
+  return true;
+}
+
+bool rewriteGroup(
+    LazyFrame& frame,
+    rsocket::StreamId streamId,
+    folly::StringPiece fromDestination,
+    folly::StringPiece fromGroup,
+    folly::StringPiece toGroup) {
+  auto metadata = frame.metadataRange();
+  if (!metadata) {
+    return false;
+  }
+  auto view = GroupView::tryParse(*metadata);
+  if (!view) {
+    return false;
+  }
+
+  const folly::ByteRange noMetadata;
+  HeaderScratch header(GroupLayout::serializedSize(
+      view->majorVersion(),
+      view->minorVersion(),
+      FrameType::GROUP,
+      fromDestination,
+      fromGroup,
+      toGroup,
+      noMetadata));
+  GroupLayout::encode(
+      header,
+      view->majorVersion(),
+      view->minorVersion(),
+      FrameType::GROUP,
+      fromDestination,
+      fromGroup,
+      toGroup,
+      noMetadata);
+
+  frame.replaceMetadataPrefix(view->metadataOffset(), header.range());
+  frame.setStreamId(streamId);
+  return true;
+}
+
+} // namespace proteus
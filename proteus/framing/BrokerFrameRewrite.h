@@ -0,0 +1,57 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Range.h>
+
+#include "proteus/framing/LazyFrame.h"
+
+namespace proteus {
+
+/// Forwarding of payload frames whose metadata is a broker routing frame.
+///
+/// The routing frame is re-encoded with the new fields and swapped for the
+/// old one in the received buffer, see LazyFrame::replaceMetadataPrefix().
+/// The application metadata behind it and the data are left where they
+/// are, so forwarding costs O(routing header) regardless of the payload.
+///
+/// Both functions return false, leaving the frame untouched, if its metadata
+/// doesn't start with a routing frame of the expected type or isn't in the
+/// head buffer (see LazyFrame::metadataRange()). The new field values may
+/// point into the frame, e.g. to keep the sender as is.
+///
+/// The payload is forwarded as it was received. Between connections that
+/// compress payloads differently, decompress it first, which also makes
+/// compressed metadata readable, and compress it for the destination
+/// after, see FrameSerializer::decompressPayload().
+
+/// Readdresses a DESTINATION frame and moves it to stream `streamId`.
+bool rewriteDestination(
+    LazyFrame& frame,
+    rsocket::StreamId streamId,
+    folly::StringPiece fromDestination,
+    folly::StringPiece fromGroup,
+    folly::StringPiece toDestination,
+    folly::StringPiece toGroup);
+
+/// Readdresses a GROUP frame and moves it to stream `streamId`.
+bool rewriteGroup(
+    LazyFrame& frame,
+    rsocket::StreamId streamId,
+    folly::StringPiece fromDestination,
+    folly::StringPiece fromGroup,
+    folly::StringPiece toGroup);
+
+} // namespace proteus
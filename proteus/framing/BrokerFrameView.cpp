@@ -0,0 +1,205 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/BrokerFrameView.h"
+
+#include <folly/io/Cursor.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+
+namespace proteus {
+
+static_assert(
+    BrokerFrameHeaderLayout::kMinSize == kBrokerFrameHeaderSize,
+    "broker frame header size mismatch");
+static_assert(
+    BrokerString::kSize == kBrokerFieldLengthSize,
+    "broker field length size mismatch");
+
+namespace {
+
+folly::ByteRange headRange(const folly::IOBuf& in) {
+  return folly::ByteRange(in.data(), in.length());
+}
+
+template <typename View>
+folly::Optional<View> parsed(View& view, bool ok) {
+  if (!ok) {
+    return folly::none;
+  }
+  return folly::make_optional(std::move(view));
+}
+
+} // namespace
+
+FrameType peekBrokerFrameType(folly::ByteRange in) {
+  if (in.size() < kBrokerFrameHeaderSize) {
+    return FrameType::UNDEFINED;
+  }
+  return BrokerFrameHeaderLayout::load<2>(in);
+}
+
+bool BrokerFrameView::accept(folly::ByteRange in, FrameType expected) {
+  if (peekBrokerFrameType(in) != expected) {
+    return false;
+  }
+  frame_ = in;
+  return true;
+}
+
+std::unique_ptr<folly::IOBuf> BrokerRoutingFrameView::cloneMetadata(
+    const folly::IOBuf& frame) const {
+  folly::io::Cursor cur(&frame);
+  cur.skip(metadataOffset_);
+  auto length = cur.totalLength();
+  if (length == 0) {
+    return nullptr;
+  }
+  std::unique_ptr<folly::IOBuf> metadata;
+  cur.clone(metadata, length);
+  return metadata;
+}
+
+folly::Optional<BrokerSetupView> BrokerSetupView::tryParse(
+    folly::ByteRange in) {
+  BrokerSetupView view;
+  return parsed(
+      view,
+      view.accept(in, FrameType::BROKER_SETUP) &&
+          BrokerSetupLayout::decode(
+              in,
+              view.majorVersion_,
+              view.minorVersion_,
+              view.frameType_,
+              view.brokerId_,
+              view.clusterId_,
+              view.accessKey_,
+              view.accessToken_));
+}
+
+folly::Optional<BrokerSetupView> BrokerSetupView::tryParse(
+    const folly::IOBuf& in) {
+  return tryParse(headRange(in));
+}
+
+folly::Optional<DestinationSetupView> DestinationSetupView::tryParse(
+    folly::ByteRange in) {
+  DestinationSetupView view;
+  return parsed(
+      view,
+      view.accept(in, FrameType::DESTINATION_SETUP) &&
+          DestinationSetupLayout::decode(
+              in,
+              view.majorVersion_,
+              view.minorVersion_,
+              view.frameType_,
+              view.destination_,
+              view.group_,
+              view.accessKey_,
+              view.accessToken_));
+}
+
+folly::Optional<DestinationSetupView> DestinationSetupView::tryParse(
+    const folly::IOBuf& in) {
+  return tryParse(headRange(in));
+}
+
+folly::Optional<DestinationView> DestinationView::tryParse(
+    folly::ByteRange in) {
+  DestinationView view;
+  folly::ByteRange metadata;
+  if (!view.accept(in, FrameType::DESTINATION) ||
+      !DestinationLayout::decode(
+          in,
+          view.majorVersion_,
+          view.minorVersion_,
+          view.frameType_,
+          view.fromDestination_,
+          view.fromGroup_,
+          view.toDestination_,
+          view.toGroup_,
+          metadata)) {
+    return folly::none;
+  }
+  view.metadataOffset_ = metadata.data() - in.data();
+  return folly::make_optional(std::move(view));
+}
+
+folly::Optional<DestinationView> DestinationView::tryParse(
+    const folly::IOBuf& in) {
+  return tryParse(headRange(in));
+}
+
+bool GroupView::parse(folly::ByteRange in, FrameType expected) {
+  folly::ByteRange metadata;
+  if (!accept(in, expected) ||
+      !GroupLayout::decode(
+          in,
+          majorVersion_,
+          minorVersion_,
+          frameType_,
+          fromDestination_,
+          fromGroup_,
+          toGroup_,
+          metadata)) {
+    return false;
+  }
+  metadataOffset_ = metadata.data() - in.data();
+  return true;
+}
+
+folly::Optional<GroupView> GroupView::tryParse(folly::ByteRange in) {
+  GroupView view;
+  return parsed(view, view.parse(in, FrameType::GROUP));
+}
+
+folly::Optional<GroupView> GroupView::tryParse(const folly::IOBuf& in) {
+  return tryParse(headRange(in));
+}
+
+folly::Optional<BroadcastView> BroadcastView::tryParse(folly::ByteRange in) {
+  BroadcastView view;
+  return parsed(view, view.parse(in, FrameType::BROADCAST));
+}
+
+folly::Optional<BroadcastView> BroadcastView::tryParse(
+    const folly::IOBuf& in) {
+  return tryParse(headRange(in));
+}
+
+folly::Optional<ShardView> ShardView::tryParse(folly::ByteRange in) {
+  ShardView view;
+  folly::ByteRange metadata;
+  if (!view.accept(in, FrameType::SHARD) ||
+      !ShardLayout::decode(
+          in,
+          view.majorVersion_,
+          view.minorVersion_,
+          view.frameType_,
+          view.fromDestination_,
+          view.fromGroup_,
+          view.toGroup_,
+          view.shardKey_,
+          metadata)) {
+    return folly::none;
+  }
+  view.metadataOffset_ = metadata.data() - in.data();
+  return folly::make_optional(std::move(view));
+}
+
+folly::Optional<ShardView> ShardView::tryParse(const folly::IOBuf& in) {
+  return tryParse(headRange(in));
+}
+
+} // namespace proteus
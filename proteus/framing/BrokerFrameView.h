@@ -0,0 +1,258 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/FrameType.h"
+
+namespace proteus {
+
+/// Every broker frame starts with the same header:
+///
+///  0                   1                   2                   3
+///  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+///  +-------------------------------+-------------------------------+
+///  |         Major Version         |         Minor Version         |
+///  +-------------------------------+-------------------------------+
+///  |          Frame Type           |
+///  +-------------------------------+
+///
+/// String and byte fields that follow are prefixed with a 32-bit big endian
+/// length. Frames carrying application metadata (DESTINATION, GROUP,
+/// BROADCAST and SHARD) end with it, its length is implied by the frame
+/// length.
+constexpr const size_t kBrokerFrameHeaderSize = 6; // bytes
+constexpr const size_t kBrokerFieldLengthSize = 4; // bytes
+
+/// Returns the type of a serialized broker frame, or FrameType::UNDEFINED if
+/// the range is too short to hold a header.
+FrameType peekBrokerFrameType(folly::ByteRange in);
+
+/// Read-only views over serialized broker frames.
+///
+/// A view points straight into the bytes of a received frame, so routing on
+/// it costs neither a Frame_* object nor any IOBuf clones. The view is valid
+/// only for as long as the underlying buffer is alive and unmodified.
+///
+/// Views parse the contiguous range they are given. When built from a
+/// chained IOBuf only the head buffer is parsed, so the routing fields must
+/// live there; metadata() then covers the head buffer only and
+/// cloneMetadata() should be used to get all of it.
+class BrokerFrameView {
+ public:
+  uint16_t majorVersion() const {
+    return majorVersion_;
+  }
+
+  uint16_t minorVersion() const {
+    return minorVersion_;
+  }
+
+  FrameType frameType() const {
+    return frameType_;
+  }
+
+  /// Whole frame this view was parsed from.
+  folly::ByteRange frame() const {
+    return frame_;
+  }
+
+ protected:
+  BrokerFrameView() = default;
+
+  // Cheap check, before decoding, that `in` holds a frame of type
+  // `expected`. Makes it the frame of this view.
+  bool accept(folly::ByteRange in, FrameType expected);
+
+  folly::ByteRange frame_;
+  uint16_t majorVersion_{};
+  uint16_t minorVersion_{};
+  FrameType frameType_{FrameType::UNDEFINED};
+};
+
+/// Base for views over frames that end with application metadata.
+class BrokerRoutingFrameView : public BrokerFrameView {
+ public:
+  /// Application metadata found in the parsed range.
+  folly::ByteRange metadata() const {
+    return frame_.subpiece(metadataOffset_);
+  }
+
+  /// Offset of the application metadata from the start of the frame.
+  size_t metadataOffset() const {
+    return metadataOffset_;
+  }
+
+  /// Clones the application metadata out of `frame`, which must be the
+  /// buffer this view was parsed from. Returns nullptr if there is none.
+  std::unique_ptr<folly::IOBuf> cloneMetadata(const folly::IOBuf& frame) const;
+
+ protected:
+  size_t metadataOffset_{0};
+};
+
+class BrokerSetupView : public BrokerFrameView {
+ public:
+  static folly::Optional<BrokerSetupView> tryParse(folly::ByteRange in);
+  static folly::Optional<BrokerSetupView> tryParse(const folly::IOBuf& in);
+
+  folly::StringPiece brokerId() const {
+    return brokerId_;
+  }
+
+  folly::StringPiece clusterId() const {
+    return clusterId_;
+  }
+
+  uint64_t accessKey() const {
+    return accessKey_;
+  }
+
+  folly::ByteRange accessToken() const {
+    return accessToken_;
+  }
+
+ private:
+  folly::StringPiece brokerId_;
+  folly::StringPiece clusterId_;
+  uint64_t accessKey_{};
+  folly::ByteRange accessToken_;
+};
+
+class DestinationSetupView : public BrokerFrameView {
+ public:
+  static folly::Optional<DestinationSetupView> tryParse(folly::ByteRange in);
+  static folly::Optional<DestinationSetupView> tryParse(
+      const folly::IOBuf& in);
+
+  folly::StringPiece destination() const {
+    return destination_;
+  }
+
+  folly::StringPiece group() const {
+    return group_;
+  }
+
+  uint64_t accessKey() const {
+    return accessKey_;
+  }
+
+  folly::ByteRange accessToken() const {
+    return accessToken_;
+  }
+
+ private:
+  folly::StringPiece destination_;
+  folly::StringPiece group_;
+  uint64_t accessKey_{};
+  folly::ByteRange accessToken_;
+};
+
+class DestinationView : public BrokerRoutingFrameView {
+ public:
+  static folly::Optional<DestinationView> tryParse(folly::ByteRange in);
+  static folly::Optional<DestinationView> tryParse(const folly::IOBuf& in);
+
+  folly::StringPiece fromDestination() const {
+    return fromDestination_;
+  }
+
+  folly::StringPiece fromGroup() const {
+    return fromGroup_;
+  }
+
+  folly::StringPiece toDestination() const {
+    return toDestination_;
+  }
+
+  folly::StringPiece toGroup() const {
+    return toGroup_;
+  }
+
+ private:
+  folly::StringPiece fromDestination_;
+  folly::StringPiece fromGroup_;
+  folly::StringPiece toDestination_;
+  folly::StringPiece toGroup_;
+};
+
+/// GROUP and BROADCAST frames share the same layout.
+class GroupView : public BrokerRoutingFrameView {
+ public:
+  static folly::Optional<GroupView> tryParse(folly::ByteRange in);
+  static folly::Optional<GroupView> tryParse(const folly::IOBuf& in);
+
+  folly::StringPiece fromDestination() const {
+    return fromDestination_;
+  }
+
+  folly::StringPiece fromGroup() const {
+    return fromGroup_;
+  }
+
+  folly::StringPiece toGroup() const {
+    return toGroup_;
+  }
+
+ protected:
+  bool parse(folly::ByteRange in, FrameType expected);
+
+ private:
+  folly::StringPiece fromDestination_;
+  folly::StringPiece fromGroup_;
+  folly::StringPiece toGroup_;
+};
+
+class BroadcastView : public GroupView {
+ public:
+  static folly::Optional<BroadcastView> tryParse(folly::ByteRange in);
+  static folly::Optional<BroadcastView> tryParse(const folly::IOBuf& in);
+};
+
+class ShardView : public BrokerRoutingFrameView {
+ public:
+  static folly::Optional<ShardView> tryParse(folly::ByteRange in);
+  static folly::Optional<ShardView> tryParse(const folly::IOBuf& in);
+
+  folly::StringPiece fromDestination() const {
+    return fromDestination_;
+  }
+
+  folly::StringPiece fromGroup() const {
+    return fromGroup_;
+  }
+
+  folly::StringPiece toGroup() const {
+    return toGroup_;
+  }
+
+  folly::ByteRange shardKey() const {
+    return shardKey_;
+  }
+
+ private:
+  folly::StringPiece fromDestination_;
+  folly::StringPiece fromGroup_;
+  folly::StringPiece toGroup_;
+  folly::ByteRange shardKey_;
+};
+
+} // namespace proteus
@@ -0,0 +1,184 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/CompactBrokerFrame.h"
+
+#include <algorithm>
+
+#include "proteus/framing/BrokerFrameView.h"
+
+namespace proteus {
+
+constexpr uint8_t CompactBrokerCodec::kCompactMarker;
+constexpr uint8_t CompactBrokerCodec::kTypeMask;
+constexpr size_t CompactBrokerCodec::kMaxRoutes;
+constexpr size_t CompactBrokerCodec::kDefaultMaxNewNames;
+
+namespace {
+// Most route references a routing frame holds (DESTINATION).
+constexpr const size_t kMaxFrameRoutes = 4;
+
+template <typename View>
+folly::Optional<BrokerWireFormat> negotiated(const View& view) {
+  const auto major = view.majorVersion();
+  const auto minor = view.minorVersion();
+  if (major > kCompactBrokerMajorVersion ||
+      (major == kCompactBrokerMajorVersion &&
+       minor >= kCompactBrokerMinorVersion)) {
+    return BrokerWireFormat::COMPACT;
+  }
+  return BrokerWireFormat::V1_0;
+}
+} // namespace
+
+folly::Optional<BrokerWireFormat> detectBrokerWireFormat(
+    folly::ByteRange setupFrame) {
+  if (auto view = BrokerSetupView::tryParse(setupFrame)) {
+    return negotiated(*view);
+  }
+  if (auto view = DestinationSetupView::tryParse(setupFrame)) {
+    return negotiated(*view);
+  }
+  return folly::none;
+}
+
+bool isCompactBrokerFrame(folly::ByteRange frame) {
+  return !frame.empty() &&
+      (frame[0] & CompactBrokerCodec::kCompactMarker) != 0;
+}
+
+CompactBrokerCodec::CompactBrokerCodec(NameTable& names, size_t maxNewNames)
+    : names_(names), maxNewNames_(maxNewNames) {}
+
+DecodeError CompactBrokerCodec::decode(
+    folly::ByteRange in,
+    CompactRoutingFrame& frame) {
+  if (!isCompactBrokerFrame(in)) {
+    return DecodeError::UNEXPECTED_FRAME_TYPE;
+  }
+  const auto frameType = fromBrokerWireType(in[0] & kTypeMask);
+  in.uncheckedAdvance(1);
+
+  size_t routeCount;
+  switch (frameType) {
+    case FrameType::DESTINATION:
+      routeCount = 4;
+      break;
+    case FrameType::GROUP:
+    case FrameType::BROADCAST:
+    case FrameType::SHARD:
+      routeCount = 3;
+      break;
+    default:
+      return DecodeError::UNEXPECTED_FRAME_TYPE;
+  }
+
+  RouteRef routes[kMaxFrameRoutes];
+  for (size_t i = 0; i < routeCount; ++i) {
+    if (!decodeRoute(in, routes[i])) {
+      return DecodeError::TRUNCATED;
+    }
+  }
+  folly::ByteRange shardKey;
+  if (frameType == FrameType::SHARD && !Bytes::decode(in, shardKey)) {
+    return DecodeError::TRUNCATED;
+  }
+
+  NameId ids[kMaxFrameRoutes] = {};
+  auto error = resolve(routes, routeCount, ids);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  frame.frameType = frameType;
+  frame.fromDestination = ids[0];
+  frame.fromGroup = ids[1];
+  if (frameType == FrameType::DESTINATION) {
+    frame.toDestination = ids[2];
+    frame.toGroup = ids[3];
+  } else {
+    frame.toDestination = 0;
+    frame.toGroup = ids[2];
+  }
+  frame.shardKey = shardKey;
+  frame.metadata = in;
+  return DecodeError::NONE;
+}
+
+bool CompactBrokerCodec::decodeRoute(folly::ByteRange& in, RouteRef& route) {
+  uint32_t value;
+  if (!Route::decode(in, value)) {
+    return false;
+  }
+  route.isLiteral = (value & 1) != 0;
+  if (!route.isLiteral) {
+    route.id = value >> 1;
+    return true;
+  }
+  const auto length = value >> 1;
+  if (in.size() < length) {
+    return false;
+  }
+  route.literal = folly::StringPiece(in.subpiece(0, length));
+  in.uncheckedAdvance(length);
+  return true;
+}
+
+DecodeError CompactBrokerCodec::resolve(
+    RouteRef* routes,
+    size_t count,
+    NameId* ids) {
+  // Check the references and resolve the literals first, so a bad frame
+  // doesn't advance the numbering. A reference may point to a literal
+  // earlier in the frame.
+  auto known = receivedRoutes_.size();
+  for (size_t i = 0; i < count; ++i) {
+    if (routes[i].isLiteral) {
+      auto id = resolveLiteral(routes[i].literal);
+      if (!id) {
+        return DecodeError::TOO_MANY_NAMES;
+      }
+      ids[i] = *id;
+      known = std::min(known + 1, kMaxRoutes);
+    } else if (routes[i].id >= known) {
+      return DecodeError::INVALID_ROUTING_HEADER;
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!routes[i].isLiteral) {
+      ids[i] = receivedRoutes_[routes[i].id];
+    } else if (receivedRoutes_.size() < kMaxRoutes) {
+      receivedRoutes_.push_back(ids[i]);
+    }
+  }
+  return DecodeError::NONE;
+}
+
+folly::Optional<NameId> CompactBrokerCodec::resolveLiteral(
+    folly::StringPiece name) {
+  if (auto id = names_.find(name)) {
+    return id;
+  }
+  if (newNames_ >= maxNewNames_) {
+    return folly::none;
+  }
+  auto id = names_.tryIntern(name);
+  if (id) {
+    ++newNames_;
+  }
+  return id;
+}
+
+} // namespace proteus
@@ -0,0 +1,236 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+
+#include "proteus/framing/DecodeError.h"
+#include "proteus/framing/FrameLayout.h"
+#include "proteus/framing/FrameType.h"
+#include "proteus/framing/NameTable.h"
+
+namespace proteus {
+
+/// Wire formats of the broker frames.
+enum class BrokerWireFormat : uint8_t {
+  // The format described in BrokerFrameView.h.
+  V1_0,
+  // Compact routing frames, see CompactBrokerCodec.
+  COMPACT,
+};
+
+/// Broker protocol version that introduced the compact format. Setup frames
+/// are always sent in the v1.0 format; a peer announcing this version or a
+/// later one in its BROKER_SETUP or DESTINATION_SETUP frame sends and
+/// accepts compact routing frames for the rest of the connection.
+constexpr const uint16_t kCompactBrokerMajorVersion = 1;
+constexpr const uint16_t kCompactBrokerMinorVersion = 1;
+
+/// Wire format negotiated by the setup frame a connection starts with.
+/// Returns folly::none if `setupFrame` is not a BROKER_SETUP or
+/// DESTINATION_SETUP frame.
+folly::Optional<BrokerWireFormat> detectBrokerWireFormat(
+    folly::ByteRange setupFrame);
+
+/// Whether `frame` is in the compact format, judging by its first byte.
+bool isCompactBrokerFrame(folly::ByteRange frame);
+
+/// Routing frame (DESTINATION, GROUP, BROADCAST or SHARD) decoded from the
+/// compact format. Names are resolved to IDs of the codec's NameTable;
+/// toDestination is only set for DESTINATION frames and shardKey only for
+/// SHARD frames. shardKey and metadata point into the frame.
+struct CompactRoutingFrame {
+  FrameType frameType{FrameType::UNDEFINED};
+  NameId fromDestination{0};
+  NameId fromGroup{0};
+  NameId toDestination{0};
+  NameId toGroup{0};
+  folly::ByteRange shardKey;
+  folly::ByteRange metadata;
+};
+
+/// Encodes and decodes the routing frames of one connection in the compact
+/// format:
+///
+///   +-+-----+-------+
+///   |1|Flags| Type  |  route references...  [shard key]  metadata...
+///   +-+-----+-------+
+///
+/// The first byte has the high bit set, no flags defined yet, and the
+/// frame type in the low 4 bits. v1.0 frames start with the high byte of
+/// the major version, which stays below 0x80.
+///
+/// Names are sent as route references instead of strings: a varint holding
+/// (id << 1) for a name already sent on the connection, or (length << 1 | 1)
+/// followed by the name on its first use. Both ends number names in the
+/// order they first appear, so route IDs never have to be declared and a
+/// typical routing header takes 5 bytes. The shard key is prefixed with its
+/// varint length, metadata runs to the end of the frame.
+///
+/// Each direction keeps its own numbering, so one codec encodes the frames
+/// a connection sends and decodes the ones it receives. Frames must be
+/// decoded in the order they were encoded. Only the first kMaxRoutes names
+/// of a direction are numbered; names after that are always sent in full,
+/// so the route tables of a long-lived connection stay bounded.
+///
+/// Names received in full are looked up in the shared NameTable, and only
+/// interned into it while the connection has interned fewer than
+/// `maxNewNames` names. A frame that would go over that, or over the
+/// table's own limit, fails with TOO_MANY_NAMES, so a peer can't fill the
+/// table shared by all connections. Not thread-safe.
+///
+/// Only the routing frames carried in metadata use the compact format, and
+/// the format is picked per connection from the setup frame, see
+/// detectBrokerWireFormat(). FrameSerializerCompact uses a codec to send
+/// them in RSocket frames whose stream IDs and lengths are compact too.
+class CompactBrokerCodec {
+ public:
+  static constexpr uint8_t kCompactMarker = 0x80;
+  static constexpr uint8_t kTypeMask = 0x0F;
+  /// Route IDs handed out per direction, fixed so both ends agree.
+  static constexpr size_t kMaxRoutes = 1 << 16;
+  static constexpr size_t kDefaultMaxNewNames = 1 << 14;
+
+  explicit CompactBrokerCodec(
+      NameTable& names = NameTable::global(),
+      size_t maxNewNames = kDefaultMaxNewNames);
+
+  NameTable& names() const {
+    return names_;
+  }
+
+  /// Appender is as for layout::Layout::encode and must be able to grow,
+  /// e.g. folly::io::QueueAppender. Metadata is either a range, which is
+  /// copied, or an IOBuf chain, which is chained in.
+  template <typename Appender, typename Metadata>
+  void encodeDestination(
+      Appender& appender,
+      NameId fromDestination,
+      NameId fromGroup,
+      NameId toDestination,
+      NameId toGroup,
+      Metadata&& metadata) {
+    encodeHeader(appender, FrameType::DESTINATION);
+    encodeRoute(appender, fromDestination);
+    encodeRoute(appender, fromGroup);
+    encodeRoute(appender, toDestination);
+    encodeRoute(appender, toGroup);
+    Trailing::encode(appender, std::forward<Metadata>(metadata));
+  }
+
+  /// GROUP or BROADCAST.
+  template <typename Appender, typename Metadata>
+  void encodeGroup(
+      Appender& appender,
+      FrameType frameType,
+      NameId fromDestination,
+      NameId fromGroup,
+      NameId toGroup,
+      Metadata&& metadata) {
+    DCHECK(
+        frameType == FrameType::GROUP || frameType == FrameType::BROADCAST);
+    encodeHeader(appender, frameType);
+    encodeRoute(appender, fromDestination);
+    encodeRoute(appender, fromGroup);
+    encodeRoute(appender, toGroup);
+    Trailing::encode(appender, std::forward<Metadata>(metadata));
+  }
+
+  template <typename Appender, typename Metadata>
+  void encodeShard(
+      Appender& appender,
+      NameId fromDestination,
+      NameId fromGroup,
+      NameId toGroup,
+      folly::ByteRange shardKey,
+      Metadata&& metadata) {
+    encodeHeader(appender, FrameType::SHARD);
+    encodeRoute(appender, fromDestination);
+    encodeRoute(appender, fromGroup);
+    encodeRoute(appender, toGroup);
+    Bytes::encode(appender, shardKey);
+    Trailing::encode(appender, std::forward<Metadata>(metadata));
+  }
+
+  /// Decodes a compact routing frame. Fails with UNEXPECTED_FRAME_TYPE for
+  /// frames not in the compact format, TRUNCATED for malformed ones,
+  /// INVALID_ROUTING_HEADER for a reference to a route that wasn't sent and
+  /// TOO_MANY_NAMES as described above. The numbering is only advanced by
+  /// frames that decode.
+  DecodeError decode(folly::ByteRange in, CompactRoutingFrame& frame);
+
+ private:
+  using Route = layout::VarInt<uint32_t>;
+  using Bytes = layout::LengthPrefixed<layout::VarInt<uint32_t>>;
+  using Trailing = layout::Trailing<>;
+
+  // A route reference read from a frame, not yet resolved.
+  struct RouteRef {
+    uint32_t id{0};
+    folly::StringPiece literal;
+    bool isLiteral{false};
+  };
+
+  template <typename Appender>
+  static void encodeHeader(Appender& appender, FrameType frameType) {
+    appender.template writeBE<uint8_t>(
+        kCompactMarker | static_cast<uint8_t>(toBrokerWireType(frameType)));
+  }
+
+  template <typename Appender>
+  void encodeRoute(Appender& appender, NameId id) {
+    auto it = sentRoutes_.find(id);
+    if (it != sentRoutes_.end()) {
+      Route::encode(appender, it->second << 1);
+      return;
+    }
+    const auto name = names_.name(id);
+    DCHECK_LE(name.size(), Route::kMax >> 1) << "name is too long";
+    Route::encode(appender, static_cast<uint32_t>(name.size()) << 1 | 1);
+    appender.push(
+        reinterpret_cast<const uint8_t*>(name.data()), name.size());
+    if (sentRoutes_.size() < kMaxRoutes) {
+      const auto routeId = static_cast<uint32_t>(sentRoutes_.size());
+      sentRoutes_.emplace(id, routeId);
+    }
+  }
+
+  static bool decodeRoute(folly::ByteRange& in, RouteRef& route);
+
+  // Resolves references, numbering literals in the order they appear.
+  DecodeError resolve(RouteRef* routes, size_t count, NameId* ids);
+
+  // Looks up or interns a name received in full.
+  folly::Optional<NameId> resolveLiteral(folly::StringPiece name);
+
+  NameTable& names_;
+  const size_t maxNewNames_;
+  // Names this connection added to names_.
+  size_t newNames_{0};
+  // Name ID -> route ID, for the routes sent so far.
+  std::unordered_map<NameId, uint32_t> sentRoutes_;
+  // Route ID -> name ID, for the routes received so far.
+  std::vector<NameId> receivedRoutes_;
+};
+
+} // namespace proteus
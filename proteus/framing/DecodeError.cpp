@@ -0,0 +1,61 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/DecodeError.h"
+
+#include <ostream>
+
+namespace proteus {
+
+folly::StringPiece toString(DecodeError error) {
+  switch (error) {
+    case DecodeError::NONE:
+      return "NONE";
+    case DecodeError::TRUNCATED:
+      return "TRUNCATED";
+    case DecodeError::INVALID_STREAM_ID:
+      return "INVALID_STREAM_ID";
+    case DecodeError::INVALID_REQUEST_N:
+      return "INVALID_REQUEST_N";
+    case DecodeError::INVALID_KEEPALIVE_TIME:
+      return "INVALID_KEEPALIVE_TIME";
+    case DecodeError::INVALID_MAX_LIFETIME:
+      return "INVALID_MAX_LIFETIME";
+    case DecodeError::INVALID_TTL:
+      return "INVALID_TTL";
+    case DecodeError::INVALID_NUMBER_OF_REQUESTS:
+      return "INVALID_NUMBER_OF_REQUESTS";
+    case DecodeError::INVALID_POSITION:
+      return "INVALID_POSITION";
+    case DecodeError::MISSING_METADATA:
+      return "MISSING_METADATA";
+    case DecodeError::UNEXPECTED_FRAME_TYPE:
+      return "UNEXPECTED_FRAME_TYPE";
+    case DecodeError::CORRUPT_PAYLOAD:
+      return "CORRUPT_PAYLOAD";
+    case DecodeError::INVALID_ROUTING_HEADER:
+      return "INVALID_ROUTING_HEADER";
+    case DecodeError::CHECKSUM_MISMATCH:
+      return "CHECKSUM_MISMATCH";
+    case DecodeError::TOO_MANY_NAMES:
+      return "TOO_MANY_NAMES";
+  }
+  return "UNKNOWN_DECODE_ERROR";
+}
+
+std::ostream& operator<<(std::ostream& os, DecodeError error) {
+  return os << toString(error);
+}
+
+} // namespace proteus
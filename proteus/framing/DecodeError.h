@@ -0,0 +1,63 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+#include <folly/Range.h>
+
+namespace proteus {
+
+/// Why a frame could not be decoded. Returned by the exception-free
+/// deserialization path, see FrameSerializer::tryDeserializeFrom.
+enum class DecodeError : uint8_t {
+  NONE = 0,
+  // The frame ended before all of its fields could be read.
+  TRUNCATED,
+  // Stream ID has the reserved most significant bit set.
+  INVALID_STREAM_ID,
+  // Request N is out of range for the frame type.
+  INVALID_REQUEST_N,
+  // Keepalive time in a SETUP frame is not positive.
+  INVALID_KEEPALIVE_TIME,
+  // Max lifetime in a SETUP frame is not positive.
+  INVALID_MAX_LIFETIME,
+  // TTL in a LEASE frame is not positive.
+  INVALID_TTL,
+  // Number of requests in a LEASE frame is not positive.
+  INVALID_NUMBER_OF_REQUESTS,
+  // Negative resume or keepalive position.
+  INVALID_POSITION,
+  // A frame that must carry metadata has none.
+  MISSING_METADATA,
+  // The frame is of a type the target can't hold.
+  UNEXPECTED_FRAME_TYPE,
+  // A compressed payload field can't be decompressed, see PayloadCompressor.
+  CORRUPT_PAYLOAD,
+  // An indexed routing header isn't in the table, see RoutingHeaderTable.
+  INVALID_ROUTING_HEADER,
+  // The frame doesn't match its checksum trailer, see FrameChecksum.h.
+  CHECKSUM_MISMATCH,
+  // The frame introduces more new names than the connection may intern,
+  // see CompactBrokerCodec.
+  TOO_MANY_NAMES,
+};
+
+folly::StringPiece toString(DecodeError);
+
+std::ostream& operator<<(std::ostream&, DecodeError);
+
+} // namespace proteus
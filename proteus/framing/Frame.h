@@ -336,8 +336,8 @@ class Frame_SETUP {
         keepaliveTime_(keepaliveTime),
         maxLifetime_(maxLifetime),
         token_(token),
-        metadataMimeType_(metadataMimeType),
-        dataMimeType_(dataMimeType),
+        metadataMimeType_(std::move(metadataMimeType)),
+        dataMimeType_(std::move(dataMimeType)),
         payload_(std::move(payload)) {
     detail::checkFlags(payload_, header_.flags);
     DCHECK(keepaliveTime_ > 0);
@@ -0,0 +1,106 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameArena.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t FrameArena::kDefaultBlockSize;
+constexpr size_t FrameArena::kDefaultSlabSize;
+
+namespace {
+uint8_t* alignUp(uint8_t* p, size_t alignment) {
+  auto address = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<uint8_t*>(
+      (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+}
+} // namespace
+
+FrameArena::FrameArena(size_t blockSize, size_t slabSize)
+    : blockSize_(blockSize), slabSize_(slabSize) {}
+
+FrameArena::~FrameArena() {
+  reset();
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+  DCHECK(alignment != 0 && (alignment & (alignment - 1)) == 0)
+      << "alignment must be a power of two";
+  DCHECK_LE(alignment, alignof(std::max_align_t));
+
+  if (cursor_) {
+    auto* p = alignUp(cursor_, alignment);
+    if (p <= end_ && static_cast<size_t>(end_ - p) >= size) {
+      cursor_ = p + size;
+      bytesAllocated_ += size;
+      return p;
+    }
+  }
+  return allocateSlow(size);
+}
+
+void* FrameArena::allocateSlow(size_t size) {
+  // Blocks come from operator new[] and are aligned for any fundamental
+  // type, the first allocation in a block needs no padding.
+  Block block{nullptr, std::max(blockSize_, size)};
+  block.data.reset(new uint8_t[block.size]);
+  cursor_ = block.data.get() + size;
+  end_ = block.data.get() + block.size;
+  bytesAllocated_ += size;
+  auto* p = block.data.get();
+  blocks_.push_back(std::move(block));
+  return p;
+}
+
+void FrameArena::reset() {
+  while (destructors_) {
+    auto* destructor = destructors_;
+    destructors_ = destructor->next;
+    destructor->destroy(destructor->object);
+  }
+
+  if (blocks_.size() > 1) {
+    blocks_.resize(1);
+  }
+  if (blocks_.empty()) {
+    cursor_ = end_ = nullptr;
+  } else {
+    cursor_ = blocks_.front().data.get();
+    end_ = cursor_ + blocks_.front().size;
+  }
+  bytesAllocated_ = 0;
+}
+
+std::unique_ptr<folly::IOBuf> FrameArena::takeSlab(size_t minTailroom) {
+  if (slab_ && slab_->tailroom() >= minTailroom) {
+    return std::move(slab_);
+  }
+  return folly::IOBuf::create(std::max(slabSize_, minTailroom));
+}
+
+void FrameArena::returnSlab(std::unique_ptr<folly::IOBuf> slab) {
+  if (!slab) {
+    return;
+  }
+  slab->trimStart(slab->length());
+  if (!slab_ || slab->tailroom() > slab_->tailroom()) {
+    slab_ = std::move(slab);
+  }
+}
+
+} // namespace proteus
@@ -0,0 +1,135 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/io/IOBuf.h>
+
+namespace proteus {
+
+/// Per-connection arena for the short-lived objects of frame processing.
+///
+/// Objects are bump-allocated from blocks with create<T>() and all released
+/// at once by reset(), typically after a batch of frames was flushed:
+///
+///   auto* frame = arena.create<Frame_REQUEST_N>();
+///   serializer.tryDeserializeFrom(*frame, std::move(buf));
+///   ...
+///   arena.reset(); // destroys frame and everything else created since
+///
+/// The arena also lends the slab that frame headers are written into to
+/// FrameBatch (see FrameSerializer::setArena()), so consecutive batches
+/// and single frames of a connection share slabs instead of allocating a
+/// buffer each. Slabs are reference counted IOBufs, frames handed to the
+/// transport stay valid after reset().
+///
+/// Not thread-safe, an arena belongs to one connection.
+class FrameArena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 4096; // bytes
+  static constexpr size_t kDefaultSlabSize = 4096; // bytes
+
+  explicit FrameArena(
+      size_t blockSize = kDefaultBlockSize,
+      size_t slabSize = kDefaultSlabSize);
+  ~FrameArena();
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /// Returns `size` bytes aligned to `alignment`, which must be a power of
+  /// two no greater than alignof(std::max_align_t). Valid until reset().
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /// Constructs a T in the arena. Its destructor, if not trivial, runs on
+  /// reset(), objects are destroyed in reverse order of creation.
+  template <typename T, typename... Args>
+  T* create(Args&&... args) {
+    if (std::is_trivially_destructible<T>::value) {
+      return new (allocate(sizeof(T), alignof(T)))
+          T(std::forward<Args>(args)...);
+    }
+    auto* destructor = static_cast<Destructor*>(
+        allocate(sizeof(Destructor), alignof(Destructor)));
+    auto* object =
+        new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    // Registered once constructed, a throwing constructor leaves nothing to
+    // destroy.
+    destructor->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+    destructor->object = object;
+    destructor->next = destructors_;
+    destructors_ = destructor;
+    return object;
+  }
+
+  /// Destroys all objects created since the last reset and reclaims their
+  /// memory. The first block is kept for reuse, the others are freed.
+  void reset();
+
+  /// Bytes handed out by allocate() since the last reset.
+  size_t bytesAllocated() const {
+    return bytesAllocated_;
+  }
+
+  size_t blockCount() const {
+    return blocks_.size();
+  }
+
+  size_t slabSize() const {
+    return slabSize_;
+  }
+
+  /// Hands out the slab with at least `minTailroom` bytes of tailroom,
+  /// allocating one if the arena's slab is lent out or too full. Its data()
+  /// is the first free byte.
+  std::unique_ptr<folly::IOBuf> takeSlab(size_t minTailroom);
+
+  /// Takes back a slab from takeSlab(). Bytes written into it that were not
+  /// cloned out are dropped. Of two slabs, the one with more room is kept.
+  void returnSlab(std::unique_ptr<folly::IOBuf> slab);
+
+ private:
+  struct Destructor {
+    void (*destroy)(void*);
+    void* object;
+    Destructor* next;
+  };
+
+  struct Block {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size;
+  };
+
+  void* allocateSlow(size_t size);
+
+  const size_t blockSize_;
+  const size_t slabSize_;
+  std::vector<Block> blocks_;
+  // Free space of the last block.
+  uint8_t* cursor_{nullptr};
+  uint8_t* end_{nullptr};
+  size_t bytesAllocated_{0};
+  Destructor* destructors_{nullptr};
+  std::unique_ptr<folly::IOBuf> slab_;
+};
+
+} // namespace proteus
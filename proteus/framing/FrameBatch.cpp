@@ -0,0 +1,147 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <folly/hash/Checksum.h>
+
+#include "proteus/framing/FrameArena.h"
+#include "proteus/framing/FrameChecksum.h"
+
+namespace proteus {
+
+constexpr size_t FrameBatch::kDefaultSlabSize;
+constexpr size_t FrameBatch::kMaxFrameLength;
+
+FrameBatch::FrameBatch(size_t frameLengthFieldSize, size_t slabSize)
+    : frameLengthFieldSize_(frameLengthFieldSize),
+      slabSize_(slabSize),
+      slab_(folly::IOBuf::create(slabSize)) {
+  DCHECK(frameLengthFieldSize_ == 0 || frameLengthFieldSize_ == 3)
+      << "only 24-bit frame length fields are supported";
+}
+
+FrameBatch::FrameBatch(size_t frameLengthFieldSize, FrameArena& arena)
+    : frameLengthFieldSize_(frameLengthFieldSize),
+      slabSize_(arena.slabSize()),
+      arena_(&arena),
+      slab_(arena.takeSlab(0)) {
+  DCHECK(frameLengthFieldSize_ == 0 || frameLengthFieldSize_ == 3)
+      << "only 24-bit frame length fields are supported";
+}
+
+FrameBatch::~FrameBatch() {
+  // A moved-from batch has no slab.
+  if (arena_ && slab_) {
+    arena_->returnSlab(std::move(slab_));
+  }
+}
+
+void FrameBatch::setChecksumFrames(bool checksumFrames) {
+  DCHECK_EQ(0u, frameCount_);
+  checksumFrames_ = checksumFrames;
+}
+
+void FrameBatch::beginFrame(size_t headerSize, size_t bodySize) {
+  const auto trailerSize = checksumFrames_ ? kFrameChecksumSize : 0;
+  const auto frameLength = headerSize + bodySize + trailerSize;
+  // A length that doesn't fit the field would desync the peer's framing.
+  CHECK(frameLengthFieldSize_ == 0 || frameLength <= kMaxFrameLength)
+      << "frame is too big to serialize: " << frameLength << " bytes";
+
+  endFrame();
+
+  const auto needed = frameLengthFieldSize_ + headerSize + trailerSize;
+  if (slab_->tailroom() < needed) {
+    flushSlab();
+    slab_ = createSlab(needed);
+  }
+
+  if (frameLengthFieldSize_ > 0) {
+    write(static_cast<uint8_t>(frameLength >> 16));
+    write(static_cast<uint8_t>((frameLength >> 8) & 0xFF));
+    write(static_cast<uint8_t>(frameLength & 0xFF));
+  }
+  ++frameCount_;
+  byteCount_ += frameLengthFieldSize_ + frameLength;
+  frameStart_ = slab_->tail();
+
+  if (checksumFrames_) {
+    checksum_ = initialFrameChecksum();
+    checksummed_ = slab_->tail();
+  }
+}
+
+void FrameBatch::push(const uint8_t* data, size_t length) {
+  DCHECK_GE(slab_->tailroom(), length);
+  std::memcpy(slab_->writableTail(), data, length);
+  slab_->append(length);
+}
+
+void FrameBatch::insert(std::unique_ptr<folly::IOBuf> buf) {
+  if (checksumFrames_) {
+    checksumSlab();
+    checksum_ = frameChecksum(*buf, checksum_);
+  }
+  flushSlab();
+  chain_.append(std::move(buf));
+}
+
+std::unique_ptr<folly::IOBuf> FrameBatch::move() {
+  endFrame();
+  flushSlab();
+  frameCount_ = 0;
+  byteCount_ = 0;
+  frameStart_ = nullptr;
+  return chain_.move();
+}
+
+std::unique_ptr<folly::IOBuf> FrameBatch::createSlab(size_t minSize) {
+  if (arena_) {
+    return arena_->takeSlab(minSize);
+  }
+  return folly::IOBuf::create(std::max(slabSize_, minSize));
+}
+
+void FrameBatch::checksumSlab() {
+  DCHECK(checksummed_);
+  checksum_ = folly::crc32c(
+      checksummed_, slab_->tail() - checksummed_, checksum_);
+  checksummed_ = slab_->tail();
+}
+
+void FrameBatch::endFrame() {
+  if (!checksumFrames_ || !checksummed_) {
+    return;
+  }
+  checksumSlab();
+  // beginFrame() left room for the trailer.
+  writeBE<uint32_t>(checksum_);
+  checksummed_ = nullptr;
+}
+
+void FrameBatch::flushSlab() {
+  if (slab_->length() == 0) {
+    return;
+  }
+  // The clone shares the slab, the bytes it covers are never written again
+  // because the slab only ever grows at its tail.
+  chain_.append(slab_->cloneOne());
+  slab_->trimStart(slab_->length());
+}
+
+} // namespace proteus
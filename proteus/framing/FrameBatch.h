@@ -0,0 +1,150 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <folly/Bits.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+class FrameArena;
+
+/// Accumulates many serialized frames into a single IOBuf chain.
+///
+/// Fixed-size frame fields of all frames are written back to back into a
+/// shared slab; payload IOBufs are chained in between them without copying.
+/// Consecutive header-only frames (REQUEST_N, CANCEL, ...) therefore end up
+/// in one chain element, and a whole batch costs one slab allocation instead
+/// of one allocation per frame. The chain returned by move() can be handed
+/// to a single writev (see folly::IOBuf::getIov).
+///
+/// FrameBatch exposes the subset of the folly::io::QueueAppender interface
+/// the serializers use, so the same code writes both single frames and
+/// batches. It is not thread-safe.
+class FrameBatch {
+ public:
+  static constexpr size_t kDefaultSlabSize = 4096; // bytes
+  /// Largest frame a 24-bit length field can describe.
+  static constexpr size_t kMaxFrameLength = 0xFFFFFF; // bytes
+
+  /// `frameLengthFieldSize` is the size of the length prefix written in
+  /// front of every frame, 0 if frames are not length-prefixed.
+  explicit FrameBatch(
+      size_t frameLengthFieldSize = 0,
+      size_t slabSize = kDefaultSlabSize);
+
+  /// Writes into slabs lent by `arena`, which must outlive the batch. The
+  /// slab goes back to the arena when the batch is destroyed.
+  FrameBatch(size_t frameLengthFieldSize, FrameArena& arena);
+
+  FrameBatch(FrameBatch&&) = default;
+  ~FrameBatch();
+
+  /// Ends every frame with a checksum trailer, see FrameChecksum.h. The
+  /// checksum is updated as the frame is written: bytes written into the
+  /// slab are checksummed in one go when a payload is inserted or the frame
+  /// ends, payloads as they are inserted. Must be set before the first
+  /// frame.
+  void setChecksumFrames(bool checksumFrames);
+
+  /// Starts a new frame, whose fixed fields take `headerSize` bytes and
+  /// whose chained payload takes `bodySize` bytes. Guarantees `headerSize`
+  /// contiguous bytes for the write* and push calls that follow. Ends the
+  /// frame before it. Length-prefixed frames must not exceed
+  /// kMaxFrameLength, checked in all builds.
+  void beginFrame(size_t headerSize, size_t bodySize);
+
+  template <class T>
+  void writeBE(T value) {
+    write(folly::Endian::big(value));
+  }
+
+  template <class T>
+  void write(T value) {
+    DCHECK_GE(slab_->tailroom(), sizeof(T));
+    folly::storeUnaligned(slab_->writableTail(), value);
+    slab_->append(sizeof(T));
+  }
+
+  void push(const uint8_t* data, size_t length);
+
+  /// Chains `buf` in after the bytes written so far, without copying it.
+  void insert(std::unique_ptr<folly::IOBuf> buf);
+
+  /// Number of frames started since the last move().
+  size_t frameCount() const {
+    return frameCount_;
+  }
+
+  bool empty() const {
+    return frameCount_ == 0;
+  }
+
+  /// Bytes of the frames started since the last move(), length fields and
+  /// checksum trailers included.
+  size_t byteCount() const {
+    return byteCount_;
+  }
+
+  /// Bytes written so far into the slab for the current frame, i.e. the
+  /// frame without its length field and inserted payloads. Valid until the
+  /// next beginFrame() or move().
+  folly::ByteRange frameBytes() const {
+    if (!frameStart_) {
+      return folly::ByteRange();
+    }
+    return folly::ByteRange(frameStart_, slab_->tail());
+  }
+
+  /// Returns the serialized frames and resets the batch. The slab is kept
+  /// and the next batch continues writing into its free tail.
+  std::unique_ptr<folly::IOBuf> move();
+
+ private:
+  // Moves the bytes written into the slab since the last flush to the chain.
+  void flushSlab();
+
+  // Checksums the bytes written into the slab since the last call.
+  void checksumSlab();
+
+  // Writes the checksum trailer of the frame being written, if any.
+  void endFrame();
+
+  std::unique_ptr<folly::IOBuf> createSlab(size_t minSize);
+
+  const size_t frameLengthFieldSize_;
+  const size_t slabSize_;
+  FrameArena* const arena_{nullptr};
+  // data() points to the first byte not yet in chain_, everything from there
+  // to tail() has been written but not flushed.
+  std::unique_ptr<folly::IOBuf> slab_;
+  folly::IOBufQueue chain_{folly::IOBufQueue::cacheChainLength()};
+  size_t frameCount_{0};
+  size_t byteCount_{0};
+  bool checksumFrames_{false};
+  // Checksum of the frame being written, up to checksummed_ in the slab.
+  uint32_t checksum_{0};
+  const uint8_t* checksummed_{nullptr};
+  // First byte of the current frame in the slab.
+  const uint8_t* frameStart_{nullptr};
+};
+
+} // namespace proteus
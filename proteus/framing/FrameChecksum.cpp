@@ -0,0 +1,88 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameChecksum.h"
+
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/hash/Checksum.h>
+
+#include "proteus/framing/MimeType.h"
+
+namespace proteus {
+
+namespace {
+constexpr const folly::StringPiece kChecksumParameter{"frame-checksum"};
+constexpr const folly::StringPiece kCrc32c{"crc32c"};
+} // namespace
+
+bool frameChecksumFromSetup(const Frame_SETUP& setup) {
+  const auto value =
+      mimeTypeParameter(setup.metadataMimeType_, kChecksumParameter);
+  return value && *value == kCrc32c;
+}
+
+uint32_t initialFrameChecksum() {
+  return ~0U;
+}
+
+uint32_t frameChecksum(const folly::IOBuf& chain, uint32_t crc) {
+  for (const auto range : chain) {
+    crc = folly::crc32c(range.data(), range.size(), crc);
+  }
+  return crc;
+}
+
+DecodeError verifyFrameChecksum(folly::IOBuf& frame) {
+  auto remaining = frame.computeChainDataLength();
+  if (remaining < kFrameChecksumSize) {
+    return DecodeError::TRUNCATED;
+  }
+  remaining -= kFrameChecksumSize;
+
+  // Checksum the body and collect the trailer in the same pass; the trailer
+  // may be split across buffers.
+  auto crc = initialFrameChecksum();
+  uint8_t trailer[kFrameChecksumSize];
+  size_t trailerLength = 0;
+  const auto* buf = &frame;
+  do {
+    const auto* data = buf->data();
+    auto length = buf->length();
+    const auto body = std::min(length, remaining);
+    crc = folly::crc32c(data, body, crc);
+    remaining -= body;
+    data += body;
+    length -= body;
+    std::copy(data, data + length, trailer + trailerLength);
+    trailerLength += length;
+    buf = buf->next();
+  } while (buf != &frame);
+
+  if (folly::Endian::big(folly::loadUnaligned<uint32_t>(trailer)) != crc) {
+    return DecodeError::CHECKSUM_MISMATCH;
+  }
+
+  // Trim the trailer off the end of the chain.
+  auto* tail = frame.prev();
+  for (size_t left = kFrameChecksumSize; left > 0; tail = tail->prev()) {
+    const auto trimmed = std::min(left, tail->length());
+    tail->trimEnd(trimmed);
+    left -= trimmed;
+  }
+  return DecodeError::NONE;
+}
+
+} // namespace proteus
@@ -0,0 +1,52 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/DecodeError.h"
+#include "proteus/framing/Frame.h"
+
+namespace proteus {
+
+/// Optional frame integrity check. When negotiated, every frame ends with a
+/// 4 byte big endian CRC32C of the frame bytes in front of it, not counting
+/// the frame length field. The frame length covers the checksum.
+///
+/// CRC32C uses the SSE4.2 crc32 instruction where the CPU has it and falls
+/// back to a table-driven implementation otherwise.
+constexpr const size_t kFrameChecksumSize = 4; // bytes
+
+/// Whether `setup` asks for frame checksums, with a "frame-checksum=crc32c"
+/// parameter on its metadata mime type. Both ends enable them for all the
+/// frames after SETUP, see FrameSerializer::checksumFrames.
+bool frameChecksumFromSetup(const Frame_SETUP& setup);
+
+/// Continues `crc` over the bytes of the whole chain.
+uint32_t frameChecksum(const folly::IOBuf& chain, uint32_t crc);
+
+/// Initial value to start a checksum with.
+uint32_t initialFrameChecksum();
+
+/// Verifies the checksum trailer of `frame` in one pass over the chain and
+/// trims it off, without copying. Returns DecodeError::CHECKSUM_MISMATCH if
+/// the frame doesn't match its checksum, leaving the frame as it is.
+DecodeError verifyFrameChecksum(folly::IOBuf& frame);
+
+} // namespace proteus
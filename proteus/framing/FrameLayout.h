@@ -0,0 +1,439 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <folly/Bits.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+
+namespace proteus {
+namespace layout {
+
+/// Compile-time descriptions of frame wire layouts.
+///
+/// A frame layout is a list of field descriptors, e.g.
+///
+///   using RequestN = Layout<BigEndian<int32_t>, BigEndian<int32_t>>;
+///
+/// from which the encoder, the decoder, the exact serialized size and the
+/// offsets of fields are derived. Fields that only follow fixed-size fields
+/// sit at an offset known at compile time and can be loaded directly.
+///
+/// A field descriptor provides:
+///
+///  - Type: what the field is encoded from and decoded into.
+///  - kFixed: whether the field always takes kSize bytes. For variable
+///    length fields kSize is the smallest size the field can take.
+///  - size(value), encode(appender, value), decode(in, value), skip(in).
+///  - load(data), for fixed-size fields: reads the field found at `data`.
+///
+/// Appender is anything with writeBE<T>(), push(data, length) and
+/// insert(buf), e.g. folly::io::QueueAppender or FrameBatch.
+
+/// Big endian integer, or an enum stored as the integer type Wire.
+template <typename T, typename Wire = T>
+struct BigEndian {
+  using Type = T;
+  static constexpr bool kFixed = true;
+  static constexpr size_t kSize = sizeof(Wire);
+  static constexpr Wire kMax = std::numeric_limits<Wire>::max();
+
+  static size_t size(T) {
+    return kSize;
+  }
+
+  static T load(const uint8_t* data) {
+    return static_cast<T>(folly::Endian::big(folly::loadUnaligned<Wire>(data)));
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, T value) {
+    appender.template writeBE<Wire>(static_cast<Wire>(value));
+  }
+
+  static bool decode(folly::ByteRange& in, T& value) {
+    if (in.size() < kSize) {
+      return false;
+    }
+    value = load(in.data());
+    in.uncheckedAdvance(kSize);
+    return true;
+  }
+
+  static bool skip(folly::ByteRange& in) {
+    if (in.size() < kSize) {
+      return false;
+    }
+    in.uncheckedAdvance(kSize);
+    return true;
+  }
+};
+
+template <typename T, typename Wire>
+constexpr bool BigEndian<T, Wire>::kFixed;
+template <typename T, typename Wire>
+constexpr size_t BigEndian<T, Wire>::kSize;
+template <typename T, typename Wire>
+constexpr Wire BigEndian<T, Wire>::kMax;
+
+/// 24-bit big endian unsigned integer.
+struct UInt24 {
+  using Type = uint32_t;
+  static constexpr bool kFixed = true;
+  static constexpr size_t kSize = 3;
+  static constexpr uint32_t kMax = 0xFFFFFF;
+
+  static size_t size(uint32_t) {
+    return kSize;
+  }
+
+  static uint32_t load(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) << 16 |
+        static_cast<uint32_t>(data[1]) << 8 | data[2];
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, uint32_t value) {
+    DCHECK(value <= kMax) << "value does not fit in 24 bits";
+    appender.template writeBE<uint8_t>(static_cast<uint8_t>(value >> 16));
+    appender.template writeBE<uint8_t>(static_cast<uint8_t>(value >> 8));
+    appender.template writeBE<uint8_t>(static_cast<uint8_t>(value));
+  }
+
+  static bool decode(folly::ByteRange& in, uint32_t& value) {
+    if (in.size() < kSize) {
+      return false;
+    }
+    value = load(in.data());
+    in.uncheckedAdvance(kSize);
+    return true;
+  }
+
+  static bool skip(folly::ByteRange& in) {
+    if (in.size() < kSize) {
+      return false;
+    }
+    in.uncheckedAdvance(kSize);
+    return true;
+  }
+};
+
+/// Unsigned LEB128 integer: 7 bits per byte, least significant group first,
+/// the high bit set on all but the last byte. Small values take one byte.
+template <typename T>
+struct VarInt {
+  static_assert(std::is_unsigned<T>::value, "varints are unsigned");
+
+  using Type = T;
+  static constexpr bool kFixed = false;
+  static constexpr size_t kSize = 1;
+  static constexpr size_t kMaxSize = (sizeof(T) * 8 + 6) / 7;
+  static constexpr T kMax = std::numeric_limits<T>::max();
+
+  static size_t size(T value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+      value >>= 7;
+      ++size;
+    }
+    return size;
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, T value) {
+    while (value >= 0x80) {
+      appender.template writeBE<uint8_t>(
+          static_cast<uint8_t>(value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    appender.template writeBE<uint8_t>(static_cast<uint8_t>(value));
+  }
+
+  /// Rejects varints longer than kMaxSize bytes and values that don't fit
+  /// into T.
+  static bool decode(folly::ByteRange& in, T& value) {
+    T result = 0;
+    for (size_t i = 0; i < kMaxSize && i < in.size(); ++i) {
+      const auto byte = in[i];
+      const auto shift = 7 * i;
+      const T bits = static_cast<T>(byte & 0x7F);
+      if (shift > 0 && (bits >> (sizeof(T) * 8 - shift)) != 0) {
+        return false;
+      }
+      result |= static_cast<T>(bits << shift);
+      if (!(byte & 0x80)) {
+        value = result;
+        in.uncheckedAdvance(i + 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool skip(folly::ByteRange& in) {
+    T value;
+    return decode(in, value);
+  }
+};
+
+template <typename T>
+constexpr bool VarInt<T>::kFixed;
+template <typename T>
+constexpr size_t VarInt<T>::kSize;
+template <typename T>
+constexpr size_t VarInt<T>::kMaxSize;
+template <typename T>
+constexpr T VarInt<T>::kMax;
+
+/// Bytes prefixed with their length, itself encoded as the field Length.
+/// Decodes into a range pointing into the frame, either folly::ByteRange
+/// or folly::StringPiece.
+template <typename Length, typename Range = folly::ByteRange>
+struct LengthPrefixed {
+  using Type = Range;
+  static constexpr bool kFixed = false;
+  static constexpr size_t kSize = Length::kSize;
+
+  static size_t size(Range value) {
+    return Length::kSize + value.size();
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, Range value) {
+    DCHECK(value.size() <= Length::kMax) << "field is too big to serialize";
+    Length::encode(appender, static_cast<typename Length::Type>(value.size()));
+    auto bytes = folly::ByteRange(value);
+    appender.push(bytes.data(), bytes.size());
+  }
+
+  static bool decode(folly::ByteRange& in, Range& value) {
+    typename Length::Type length;
+    if (!Length::decode(in, length) || in.size() < length) {
+      return false;
+    }
+    value = Range(in.subpiece(0, length));
+    in.uncheckedAdvance(length);
+    return true;
+  }
+
+  static bool skip(folly::ByteRange& in) {
+    Range value;
+    return decode(in, value);
+  }
+};
+
+template <typename Length, typename Range>
+constexpr bool LengthPrefixed<Length, Range>::kFixed;
+template <typename Length, typename Range>
+constexpr size_t LengthPrefixed<Length, Range>::kSize;
+
+/// Everything up to the end of the frame, its length is implied by the
+/// frame length. Must be the last field. Encodes from either a range, which
+/// is copied, or an IOBuf chain, which is chained in.
+template <typename Range = folly::ByteRange>
+struct Trailing {
+  using Type = Range;
+  static constexpr bool kFixed = false;
+  static constexpr size_t kSize = 0;
+
+  static size_t size(Range value) {
+    return value.size();
+  }
+
+  static size_t size(const std::unique_ptr<folly::IOBuf>& value) {
+    return value ? value->computeChainDataLength() : 0;
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, Range value) {
+    auto bytes = folly::ByteRange(value);
+    appender.push(bytes.data(), bytes.size());
+  }
+
+  template <typename Appender>
+  static void encode(Appender& appender, std::unique_ptr<folly::IOBuf> value) {
+    if (value) {
+      appender.insert(std::move(value));
+    }
+  }
+
+  static bool decode(folly::ByteRange& in, Range& value) {
+    value = Range(in);
+    in.uncheckedAdvance(in.size());
+    return true;
+  }
+
+  static bool skip(folly::ByteRange& in) {
+    in.uncheckedAdvance(in.size());
+    return true;
+  }
+};
+
+template <typename Range>
+constexpr bool Trailing<Range>::kFixed;
+template <typename Range>
+constexpr size_t Trailing<Range>::kSize;
+
+namespace detail {
+
+constexpr size_t sum() {
+  return 0;
+}
+
+template <typename... Sizes>
+constexpr size_t sum(size_t first, Sizes... rest) {
+  return first + sum(rest...);
+}
+
+template <typename... Fields>
+struct FieldList;
+
+template <>
+struct FieldList<> {
+  static constexpr size_t prefixSize(size_t) {
+    return 0;
+  }
+
+  static constexpr bool prefixFixed(size_t) {
+    return true;
+  }
+
+  static bool skip(folly::ByteRange&, size_t count) {
+    return count == 0;
+  }
+};
+
+template <typename First, typename... Rest>
+struct FieldList<First, Rest...> {
+  // Sum of the (minimum) sizes of the first `count` fields.
+  static constexpr size_t prefixSize(size_t count) {
+    return count == 0
+        ? 0
+        : First::kSize + FieldList<Rest...>::prefixSize(count - 1);
+  }
+
+  // Whether the first `count` fields all have a fixed size.
+  static constexpr bool prefixFixed(size_t count) {
+    return count == 0 ||
+        (First::kFixed && FieldList<Rest...>::prefixFixed(count - 1));
+  }
+
+  static bool skip(folly::ByteRange& in, size_t count) {
+    return count == 0 ||
+        (First::skip(in) && FieldList<Rest...>::skip(in, count - 1));
+  }
+};
+
+} // namespace detail
+
+template <typename... Fields>
+struct Layout {
+  template <size_t I>
+  using Field = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+  static constexpr size_t kFieldCount = sizeof...(Fields);
+
+  /// Smallest serialized size: all fixed-size fields plus the length
+  /// prefixes of the variable ones.
+  static constexpr size_t kMinSize =
+      detail::FieldList<Fields...>::prefixSize(sizeof...(Fields));
+
+  /// Whether all fields have a fixed size, kMinSize is then the exact size.
+  static constexpr bool kFixed =
+      detail::FieldList<Fields...>::prefixFixed(sizeof...(Fields));
+
+  /// Offset of field I. Only available if all fields before it have a fixed
+  /// size, use findOffset() otherwise.
+  template <size_t I>
+  static constexpr size_t offsetOf() {
+    static_assert(I < sizeof...(Fields), "field index out of range");
+    static_assert(
+        detail::FieldList<Fields...>::prefixFixed(I),
+        "field follows a variable length field, use findOffset()");
+    return detail::FieldList<Fields...>::prefixSize(I);
+  }
+
+  /// Loads field I from its fixed offset in `in`, which must be long enough
+  /// to hold it.
+  template <size_t I>
+  static typename Field<I>::Type load(folly::ByteRange in) {
+    static_assert(Field<I>::kFixed, "only fixed-size fields can be loaded");
+    DCHECK(in.size() >= offsetOf<I>() + Field<I>::kSize);
+    return Field<I>::load(in.data() + offsetOf<I>());
+  }
+
+  /// Offset of field I found by skipping over the fields in front of it, or
+  /// folly::none if the frame ends before field I.
+  template <size_t I>
+  static folly::Optional<size_t> findOffset(folly::ByteRange in) {
+    static_assert(I < sizeof...(Fields), "field index out of range");
+    auto rest = in;
+    if (!detail::FieldList<Fields...>::skip(rest, I)) {
+      return folly::none;
+    }
+    return in.size() - rest.size();
+  }
+
+  template <typename... Values>
+  static size_t serializedSize(const Values&... values) {
+    static_assert(
+        sizeof...(Values) == sizeof...(Fields), "expected a value per field");
+    return detail::sum(Fields::size(values)...);
+  }
+
+  template <typename Appender, typename... Values>
+  static void encode(Appender& appender, Values&&... values) {
+    static_assert(
+        sizeof...(Values) == sizeof...(Fields), "expected a value per field");
+    using expand = int[];
+    (void)expand{
+        0, (Fields::encode(appender, std::forward<Values>(values)), 0)...};
+  }
+
+  /// Decodes every field of the frame in `in`. Returns false if the frame is
+  /// truncated, the values are then unspecified.
+  template <typename... Values>
+  static bool decode(folly::ByteRange in, Values&... values) {
+    static_assert(
+        sizeof...(Values) == sizeof...(Fields), "expected a value per field");
+    if (in.size() < kMinSize) {
+      return false;
+    }
+    bool ok = true;
+    using expand = int[];
+    (void)expand{0, (ok = ok && Fields::decode(in, values), 0)...};
+    return ok;
+  }
+};
+
+template <typename... Fields>
+constexpr size_t Layout<Fields...>::kFieldCount;
+template <typename... Fields>
+constexpr size_t Layout<Fields...>::kMinSize;
+template <typename... Fields>
+constexpr bool Layout<Fields...>::kFixed;
+
+} // namespace layout
+} // namespace proteus
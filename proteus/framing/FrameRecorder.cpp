@@ -0,0 +1,282 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/io/Cursor.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t FrameRecord::kHeaderSize;
+constexpr size_t FrameRecorder::kDefaultCapacity;
+
+namespace {
+
+constexpr size_t kRecordWords = sizeof(FrameRecord) / sizeof(uint64_t);
+
+char* append(char* out, folly::StringPiece str) {
+  std::memcpy(out, str.data(), str.size());
+  return out + str.size();
+}
+
+char* appendDecimal(char* out, uint64_t value) {
+  return out + folly::uint64ToBufferUnsafe(value, out);
+}
+
+char* appendHex(char* out, uint64_t value, size_t digits) {
+  static constexpr const char kDigits[] = "0123456789abcdef";
+  for (size_t i = digits; i > 0; --i) {
+    out[i - 1] = kDigits[value & 0xF];
+    value >>= 4;
+  }
+  return out + digits;
+}
+
+} // namespace
+
+size_t formatFrameRecord(const FrameRecord& record, char* out) {
+  auto* const begin = out;
+  out = appendDecimal(out, static_cast<uint64_t>(std::max<int64_t>(
+      record.timestamp, 0)));
+  out = append(
+      out,
+      record.direction == FrameRecord::Direction::ENCODE ? " ENCODE"
+                                                         : " DECODE");
+  out = append(out, " type=");
+  out = appendDecimal(out, static_cast<uint8_t>(record.type));
+  out = append(out, " flags=0x");
+  out = appendHex(out, static_cast<uint16_t>(record.flags), 4);
+  out = append(out, " stream=");
+  out = appendDecimal(out, record.streamId);
+  out = append(out, " length=");
+  out = appendDecimal(out, record.length);
+  out = append(out, " route=");
+  out = appendDecimal(out, record.routeId);
+  out = append(out, " error=");
+  out = appendDecimal(out, static_cast<uint8_t>(record.error));
+  out = append(out, " header=");
+  const auto headerLength =
+      std::min<size_t>(record.headerLength, FrameRecord::kHeaderSize);
+  for (size_t i = 0; i < headerLength; ++i) {
+    out = appendHex(out, record.header[i], 2);
+  }
+  *out++ = '\n';
+  DCHECK_LE(static_cast<size_t>(out - begin), kMaxFrameRecordLineSize);
+  return out - begin;
+}
+
+folly::ByteRange copyFrameHeader(
+    const folly::IOBuf& frame,
+    std::array<uint8_t, FrameRecord::kHeaderSize>& out) {
+  folly::io::Cursor cur(&frame);
+  const auto length = cur.pullAtMost(out.data(), out.size());
+  return folly::ByteRange(out.data(), length);
+}
+
+// Single-writer ring of records. Each slot is a seqlock: the writer marks
+// it odd while storing the record's words, and a reader keeps what it
+// copied only if the slot held the position it wanted before and after.
+class FrameRecorder::Ring {
+ public:
+  explicit Ring(size_t capacity)
+      : mask_(capacity - 1), slots_(new Slot[capacity]) {}
+
+  bool tryClaim() {
+    bool owned = false;
+    return owned_.compare_exchange_strong(
+        owned, true, std::memory_order_acq_rel);
+  }
+
+  void release() {
+    owned_.store(false, std::memory_order_release);
+  }
+
+  void append(const FrameRecord& record) {
+    const auto position = head_.load(std::memory_order_relaxed);
+    auto& slot = slots_[position & mask_];
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t words[kRecordWords];
+    std::memcpy(words, &record, sizeof(record));
+    for (size_t i = 0; i < kRecordWords; ++i) {
+      slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * position + 2, std::memory_order_release);
+    head_.store(position + 1, std::memory_order_release);
+  }
+
+  // Calls `f` with the records still in the ring, oldest first.
+  template <typename F>
+  void forEach(F&& f) const {
+    const auto head = head_.load(std::memory_order_acquire);
+    const auto capacity = mask_ + 1;
+    FrameRecord record;
+    for (auto position = head > capacity ? head - capacity : 0;
+         position < head;
+         ++position) {
+      if (read(position, record)) {
+        f(record);
+      }
+    }
+  }
+
+  // Rings are only ever pushed, at the front, and freed with the recorder.
+  Ring* next{nullptr};
+
+ private:
+  struct Slot {
+    // 2 * position + 2 once the record at `position` is stored.
+    std::atomic<uint64_t> sequence{0};
+    std::array<std::atomic<uint64_t>, kRecordWords> words{};
+  };
+
+  bool read(uint64_t position, FrameRecord& record) const {
+    const auto& slot = slots_[position & mask_];
+    const auto expected = 2 * position + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+      return false;
+    }
+    uint64_t words[kRecordWords];
+    for (size_t i = 0; i < kRecordWords; ++i) {
+      words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+      return false;
+    }
+    std::memcpy(&record, words, sizeof(record));
+    return true;
+  }
+
+  const size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> head_{0};
+  // Rings are created claimed by the thread that needed one.
+  std::atomic<bool> owned_{true};
+};
+
+FrameRecorder::RingList::~RingList() {
+  auto* ring = head.load(std::memory_order_acquire);
+  while (ring) {
+    auto* next = ring->next;
+    delete ring;
+    ring = next;
+  }
+}
+
+FrameRecorder::RingHandle::~RingHandle() {
+  ring->release();
+}
+
+FrameRecorder::FrameRecorder(size_t capacity)
+    : mask_(folly::nextPowTwo(std::max<size_t>(capacity, 1)) - 1),
+      ring_([this] { return new RingHandle(claimRing()); }) {}
+
+FrameRecorder::~FrameRecorder() = default;
+
+FrameRecorder::Ring* FrameRecorder::claimRing() {
+  auto* head = rings_.head.load(std::memory_order_acquire);
+  for (auto* ring = head; ring; ring = ring->next) {
+    if (ring->tryClaim()) {
+      return ring;
+    }
+  }
+
+  auto* ring = new Ring(capacity());
+  do {
+    ring->next = head;
+  } while (!rings_.head.compare_exchange_weak(
+      head, ring, std::memory_order_release, std::memory_order_acquire));
+  return ring;
+}
+
+template <typename F>
+void FrameRecorder::forEachRing(F&& f) const {
+  for (auto* ring = rings_.head.load(std::memory_order_acquire); ring;
+       ring = ring->next) {
+    f(*ring);
+  }
+}
+
+void FrameRecorder::record(
+    FrameRecord::Direction direction,
+    const FrameHeader& header,
+    size_t length,
+    folly::ByteRange headerBytes,
+    DecodeError error,
+    uint32_t routeId) {
+  FrameRecord record;
+  record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  record.streamId = header.streamId;
+  record.length = static_cast<uint32_t>(
+      std::min<size_t>(length, std::numeric_limits<uint32_t>::max()));
+  record.routeId = routeId;
+  record.flags = header.flags;
+  record.type = header.type;
+  record.direction = direction;
+  record.error = error;
+  record.headerLength = static_cast<uint8_t>(
+      std::min(headerBytes.size(), FrameRecord::kHeaderSize));
+  if (record.headerLength > 0) {
+    std::memcpy(
+        record.header.data(), headerBytes.data(), record.headerLength);
+  }
+  this->record(record);
+}
+
+void FrameRecorder::record(const FrameRecord& record) {
+  ring_->ring->append(record);
+}
+
+std::vector<FrameRecord> FrameRecorder::snapshot() const {
+  std::vector<FrameRecord> records;
+  forEachRing([&](const Ring& ring) {
+    ring.forEach([&](const FrameRecord& record) { records.push_back(record); });
+  });
+  std::stable_sort(
+      records.begin(),
+      records.end(),
+      [](const FrameRecord& a, const FrameRecord& b) {
+        return a.timestamp < b.timestamp;
+      });
+  return records;
+}
+
+void FrameRecorder::dump(int fd) const {
+  char line[kMaxFrameRecordLineSize];
+  uint64_t index = 0;
+  forEachRing([&](const Ring& ring) {
+    auto* end = append(line, "frame recorder ring ");
+    end = appendDecimal(end, index++);
+    *end++ = '\n';
+    folly::writeFull(fd, line, end - line);
+    ring.forEach([&](const FrameRecord& record) {
+      folly::writeFull(fd, line, formatFrameRecord(record, line));
+    });
+  });
+}
+
+} // namespace proteus
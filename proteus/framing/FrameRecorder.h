@@ -0,0 +1,151 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/ThreadLocal.h>
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/DecodeError.h"
+#include "proteus/framing/FrameHeader.h"
+
+namespace proteus {
+
+/// One frame as seen by a FrameRecorder.
+struct FrameRecord {
+  static constexpr size_t kHeaderSize = 22; // bytes
+
+  enum class Direction : uint8_t {
+    ENCODE = 0,
+    DECODE = 1,
+  };
+
+  /// Nanoseconds since the Unix epoch.
+  int64_t timestamp{0};
+  uint32_t streamId{0};
+  uint32_t length{0};
+  /// Set by routing code that records frames it forwards, 0 otherwise.
+  uint32_t routeId{0};
+  FrameFlags flags{FrameFlags::EMPTY};
+  FrameType type{FrameType::UNDEFINED};
+  Direction direction{Direction::ENCODE};
+  DecodeError error{DecodeError::NONE};
+  /// The first headerLength bytes of the frame, payloads aside.
+  uint8_t headerLength{0};
+  std::array<uint8_t, kHeaderSize> header{};
+};
+
+static_assert(
+    std::is_trivially_copyable<FrameRecord>::value &&
+        sizeof(FrameRecord) % sizeof(uint64_t) == 0,
+    "FrameRecord is stored as 64-bit words");
+
+/// Longest line formatFrameRecord() writes.
+constexpr size_t kMaxFrameRecordLineSize = 256;
+
+/// Formats `record` as one line, newline included, into `out`, which holds
+/// at least kMaxFrameRecordLineSize bytes. Returns the line length. Doesn't
+/// allocate, so it can run in a signal handler.
+size_t formatFrameRecord(const FrameRecord& record, char* out);
+
+/// Copies the first bytes of `frame`, up to FrameRecord::kHeaderSize, into
+/// `out` and returns them.
+folly::ByteRange copyFrameHeader(
+    const folly::IOBuf& frame,
+    std::array<uint8_t, FrameRecord::kHeaderSize>& out);
+
+/// Flight recorder keeping the last frames every thread encoded and
+/// decoded, for post-mortem analysis. Serializers record into it once set
+/// with FrameSerializer::setRecorder().
+///
+/// Each thread appends to its own ring of `capacity` records, claimed on
+/// its first record and handed to another thread once it exits, so
+/// recording is wait-free and doesn't allocate after a thread's first
+/// frame. Records stay readable after their thread exits. Readers never
+/// block writers: a record overwritten while it is read is skipped.
+///
+///   FrameRecorder recorder;
+///   serializer->setRecorder(&recorder);
+///   folly::addFatalSignalCallback([] { recorder.dump(STDERR_FILENO); });
+class FrameRecorder {
+ public:
+  static constexpr size_t kDefaultCapacity = 4096; // records per thread
+
+  /// `capacity` is rounded up to a power of two.
+  explicit FrameRecorder(size_t capacity = kDefaultCapacity);
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder&) = delete;
+  FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+  /// Records a frame of `length` bytes starting with `headerBytes`, of
+  /// which up to FrameRecord::kHeaderSize are kept, timestamped now.
+  void record(
+      FrameRecord::Direction direction,
+      const FrameHeader& header,
+      size_t length,
+      folly::ByteRange headerBytes,
+      DecodeError error = DecodeError::NONE,
+      uint32_t routeId = 0);
+
+  void record(const FrameRecord& record);
+
+  /// Records of every thread, oldest first.
+  std::vector<FrameRecord> snapshot() const;
+
+  /// Writes the records of every ring to `fd`, ring by ring and oldest
+  /// first within a ring. Doesn't allocate or lock, so it can run in a
+  /// fatal signal handler.
+  void dump(int fd) const;
+
+  size_t capacity() const {
+    return mask_ + 1;
+  }
+
+ private:
+  class Ring;
+
+  // Owns the rings and outlives the handles that point to them.
+  struct RingList {
+    ~RingList();
+    std::atomic<Ring*> head{nullptr};
+  };
+
+  // A thread's claim on a ring, released when the thread exits.
+  struct RingHandle {
+    explicit RingHandle(Ring* r) : ring(r) {}
+    ~RingHandle();
+    Ring* const ring;
+  };
+
+  Ring* claimRing();
+
+  template <typename F>
+  void forEachRing(F&& f) const;
+
+  const size_t mask_;
+  RingList rings_;
+  folly::ThreadLocal<RingHandle> ring_;
+};
+
+} // namespace proteus
@@ -14,6 +14,9 @@
 
 #include "proteus/framing/FrameSerializer.h"
 
+#include <folly/io/Cursor.h>
+
+#include "proteus/framing/FrameSerializer_compact.h"
 #include "proteus/framing/FrameSerializer_v1_0.h"
 
 namespace proteus {
@@ -23,6 +26,9 @@ std::unique_ptr<FrameSerializer> FrameSerializer::createFrameSerializer(
   if (protocolVersion == FrameSerializerV1_0::Version) {
     return std::make_unique<FrameSerializerV1_0>();
   }
+  if (protocolVersion == FrameSerializerCompact::Version) {
+    return std::make_unique<FrameSerializerCompact>();
+  }
 
   DCHECK(protocolVersion == ProtocolVersion::Unknown);
   LOG_IF(ERROR, protocolVersion != ProtocolVersion::Unknown)
@@ -33,6 +39,9 @@ std::unique_ptr<FrameSerializer> FrameSerializer::createFrameSerializer(
 std::unique_ptr<FrameSerializer> FrameSerializer::createAutodetectedSerializer(
     const folly::IOBuf& firstFrame) {
   auto detectedVersion = FrameSerializerV1_0::detectProtocolVersion(firstFrame);
+  if (detectedVersion == ProtocolVersion::Unknown) {
+    detectedVersion = FrameSerializerCompact::detectProtocolVersion(firstFrame);
+  }
   return createFrameSerializer(detectedVersion);
 }
 
@@ -40,6 +49,145 @@ bool& FrameSerializer::preallocateFrameSizeField() {
   return preallocateFrameSizeField_;
 }
 
+bool& FrameSerializer::checksumFrames() {
+  return checksumFrames_;
+}
+
+DecodeError FrameSerializer::verifyChecksum(folly::IOBuf& frame) const {
+  if (checksumFrames_) {
+    return verifyFrameChecksum(frame);
+  }
+  return DecodeError::NONE;
+}
+
+void FrameSerializer::appendChecksum(folly::IOBufQueue& queue) const {
+  if (!checksumFrames_ || queue.empty()) {
+    return;
+  }
+  const auto checksum =
+      frameChecksum(*queue.front(), initialFrameChecksum());
+  folly::io::QueueAppender appender(&queue, kFrameChecksumSize);
+  appender.writeBE<uint32_t>(checksum);
+}
+
+void FrameSerializer::setStats(FrameStats* stats) {
+  stats_ = stats;
+}
+
+FrameStats* FrameSerializer::stats() const {
+  return stats_;
+}
+
+void FrameSerializer::setRecorder(FrameRecorder* recorder) {
+  recorder_ = recorder;
+}
+
+FrameRecorder* FrameSerializer::recorder() const {
+  return recorder_;
+}
+
+void FrameSerializer::setArena(FrameArena* arena) {
+  arena_ = arena;
+}
+
+FrameArena* FrameSerializer::arena() const {
+  return arena_;
+}
+
+bool FrameSerializer::useArena() const {
+  return arena_ && !preallocateFrameSizeField_;
+}
+
+void FrameSerializer::setPayloadCompressor(PayloadCompressor* compressor) {
+  payloadCompressor_ = compressor;
+  DCHECK(!routingHeaderTable_ || !compressesMetadata())
+      << "routing header tables don't work with compressed metadata";
+}
+
+PayloadCompressor* FrameSerializer::payloadCompressor() const {
+  return payloadCompressor_;
+}
+
+DecodeError FrameSerializer::decompressPayload(LazyFrame& frame) const {
+  if (!payloadCompressor_) {
+    return DecodeError::NONE;
+  }
+  auto payload = frame.clonePayload();
+  auto error = payloadCompressor_->decompress(payload);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  frame.replacePayload(std::move(payload));
+  return DecodeError::NONE;
+}
+
+void FrameSerializer::compressPayload(LazyFrame& frame) const {
+  if (!payloadCompressor_) {
+    return;
+  }
+  auto payload = frame.clonePayload();
+  payloadCompressor_->compress(payload);
+  frame.replacePayload(std::move(payload));
+}
+
+void FrameSerializer::setRoutingHeaderTable(RoutingHeaderTable* table) {
+  routingHeaderTable_ = table;
+  DCHECK(!routingHeaderTable_ || !compressesMetadata())
+      << "routing header tables don't work with compressed metadata";
+}
+
+RoutingHeaderTable* FrameSerializer::routingHeaderTable() const {
+  return routingHeaderTable_;
+}
+
+void FrameSerializer::encodePayload(rsocket::Payload& payload) const {
+  if (routingHeaderTable_) {
+    routingHeaderTable_->encode(payload.metadata);
+  }
+  if (payloadCompressor_) {
+    payloadCompressor_->compress(payload);
+  }
+}
+
+DecodeError FrameSerializer::decodePayload(rsocket::Payload& payload) const {
+  if (payloadCompressor_) {
+    auto error = payloadCompressor_->decompress(payload);
+    if (error != DecodeError::NONE) {
+      return error;
+    }
+  }
+  if (routingHeaderTable_) {
+    return routingHeaderTable_->decode(payload.metadata);
+  }
+  return DecodeError::NONE;
+}
+
+bool FrameSerializer::compressesMetadata() const {
+  return payloadCompressor_ &&
+      payloadCompressor_->metadataCompression() != PayloadCompression::NONE;
+}
+
+DecodeError FrameSerializer::decodeRoutingHeader(LazyFrame& frame) const {
+  if (!routingHeaderTable_) {
+    return DecodeError::NONE;
+  }
+  // Compressed metadata stays compressed in a LazyFrame, so the header
+  // can't be expanded and the table would miss the literals it holds.
+  if (compressesMetadata()) {
+    return DecodeError::INVALID_ROUTING_HEADER;
+  }
+  return routingHeaderTable_->decode(frame);
+}
+
+FrameBatch FrameSerializer::createFrameBatch() const {
+  const auto lengthFieldSize =
+      preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
+  FrameBatch batch = arena_ ? FrameBatch(lengthFieldSize, *arena_)
+                            : FrameBatch(lengthFieldSize);
+  batch.setChecksumFrames(checksumFrames_);
+  return batch;
+}
+
 folly::IOBufQueue FrameSerializer::createBufferQueue(size_t bufferSize) const {
   const auto prependSize =
       preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
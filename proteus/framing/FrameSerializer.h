@@ -16,9 +16,22 @@
 
 #include <folly/Optional.h>
 
+#include <array>
+#include <chrono>
+#include <initializer_list>
 #include <memory>
+#include <utility>
 
+#include "proteus/framing/DecodeError.h"
 #include "proteus/framing/Frame.h"
+#include "proteus/framing/FrameArena.h"
+#include "proteus/framing/FrameBatch.h"
+#include "proteus/framing/FrameChecksum.h"
+#include "proteus/framing/FrameRecorder.h"
+#include "proteus/framing/FrameStats.h"
+#include "proteus/framing/LazyFrame.h"
+#include "proteus/framing/PayloadCompression.h"
+#include "proteus/framing/RoutingHeaderTable.h"
 
 namespace proteus {
 
@@ -62,6 +75,36 @@ class FrameSerializer {
   virtual std::unique_ptr<folly::IOBuf> serializeOut(
       Frame_RESUME_OK&&) const = 0;
 
+  // Append the frame to a batch instead of allocating a buffer for it.
+  virtual void serializeOut(FrameBatch&, Frame_REQUEST_STREAM&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_REQUEST_CHANNEL&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_REQUEST_RESPONSE&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_REQUEST_FNF&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_REQUEST_N&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_METADATA_PUSH&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_CANCEL&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_PAYLOAD&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_ERROR&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_KEEPALIVE&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_SETUP&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_LEASE&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_RESUME&&) const = 0;
+  virtual void serializeOut(FrameBatch&, Frame_RESUME_OK&&) const = 0;
+
+  // Serializes any mix of frames into a single IOBuf chain, ready for one
+  // writev. Frames within a batch can't have their length field filled in
+  // by the caller, so with preallocateFrameSizeField() set it is written
+  // in front of every frame.
+  template <typename... Frames>
+  std::unique_ptr<folly::IOBuf> serializeBatchOut(Frames&&... frames) const {
+    FrameBatch batch(createFrameBatch());
+    (void)std::initializer_list<int>{
+        (serializeOut(batch, std::forward<Frames>(frames)), 0)...};
+    return batch.move();
+  }
+
+  FrameBatch createFrameBatch() const;
+
   virtual bool deserializeFrom(
       Frame_REQUEST_STREAM&,
       std::unique_ptr<folly::IOBuf>) const = 0;
@@ -96,14 +139,262 @@ class FrameSerializer {
   virtual bool deserializeFrom(Frame_RESUME_OK&, std::unique_ptr<folly::IOBuf>)
       const = 0;
 
+  // Exception-free counterparts of deserializeFrom. All bounds are checked
+  // before reading, so a truncated or malformed frame costs a branch instead
+  // of a thrown exception. The frame is only meaningful on DecodeError::NONE.
+  virtual DecodeError tryDeserializeFrom(
+      Frame_REQUEST_STREAM&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_REQUEST_CHANNEL&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_REQUEST_RESPONSE&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_REQUEST_FNF&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_REQUEST_N&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_METADATA_PUSH&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_CANCEL&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_PAYLOAD&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_ERROR&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_KEEPALIVE&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_SETUP&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_LEASE&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_RESUME&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+  virtual DecodeError tryDeserializeFrom(
+      Frame_RESUME_OK&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+
+  // Decodes only the header of a payload-bearing frame, see LazyFrame.
+  // Returns DecodeError::UNEXPECTED_FRAME_TYPE for other frame types.
+  virtual DecodeError tryDeserializeFrom(
+      LazyFrame&,
+      std::unique_ptr<folly::IOBuf>) const = 0;
+
   virtual size_t frameLengthFieldSize() const = 0;
   bool& preallocateFrameSizeField();
 
+  // Per-connection arena the serializer writes frame headers into, nullptr
+  // (the default) to allocate a buffer per frame. Used by the batches of
+  // createFrameBatch() and by the single-frame serializeOut() of
+  // REQUEST_STREAM, the only single-frame overload V1_0 implements. The
+  // arena must outlive the serializer or be unset first.
+  void setArena(FrameArena* arena);
+  FrameArena* arena() const;
+
+  // Per-connection compressor for the payloads of request and PAYLOAD
+  // frames, nullptr (the default) while SETUP hasn't negotiated compression.
+  // LazyFrame payloads are left as they are on the wire, see
+  // decompressPayload(). The compressor must outlive the serializer or be
+  // unset first.
+  void setPayloadCompressor(PayloadCompressor* compressor);
+  PayloadCompressor* payloadCompressor() const;
+
+  // A LazyFrame forwarded from one connection to another carries its
+  // payload as the first connection's compressor encoded it. Unless
+  // PayloadCompressor::sameFormat() says both connections encode payloads
+  // alike, the receiving serializer decompresses it and the sending one
+  // compresses it again:
+  //
+  //   if (!PayloadCompressor::sameFormat(
+  //           in.payloadCompressor(), out.payloadCompressor())) {
+  //     error = in.decompressPayload(frame);  // then route, rewrite, ...
+  //     out.compressPayload(frame);
+  //   }
+  //
+  // Both leave the frame untouched without a compressor. decompressPayload()
+  // returns DecodeError::CORRUPT_PAYLOAD, leaving the frame as it was, if
+  // the payload can't be decompressed.
+  DecodeError decompressPayload(LazyFrame& frame) const;
+  void compressPayload(LazyFrame& frame) const;
+
+  // Per-connection table indexing the routing headers at the front of the
+  // metadata of request and PAYLOAD frames, nullptr (the default) while
+  // SETUP hasn't negotiated one. Unlike compression, indexed headers are
+  // expanded for LazyFrames too. Can't be combined with a compressor that
+  // compresses metadata, see RoutingHeaderTable::fromSetup(). The table
+  // must outlive the serializer or be unset first.
+  void setRoutingHeaderTable(RoutingHeaderTable* table);
+  RoutingHeaderTable* routingHeaderTable() const;
+
+  // Whether frames end with a CRC32C trailer, see FrameChecksum.h. Off by
+  // default, turned on for both directions once SETUP has negotiated it.
+  // The checksum is updated as frames are written into a FrameBatch;
+  // single frames written without an arena get it in one pass at the end.
+  bool& checksumFrames();
+
+  // Verifies and trims the checksum trailer of a received frame when
+  // checksums are on. tryDeserializeFrom() runs it on every frame; frames
+  // that are only peeked at and forwarded keep their trailer and can be
+  // checked here.
+  DecodeError verifyChecksum(folly::IOBuf& frame) const;
+
+  // Stats every frame encoded or decoded is recorded into, nullptr (the
+  // default) to record nothing. Usually shared by all the serializers of a
+  // process, see FrameStats. The stats must outlive the serializer or be
+  // unset first.
+  void setStats(FrameStats* stats);
+  FrameStats* stats() const;
+
+  // Flight recorder every frame encoded or decoded is appended to, nullptr
+  // (the default) to record nothing. Like stats, usually one per process.
+  // The recorder must outlive the serializer or be unset first.
+  void setRecorder(FrameRecorder* recorder);
+  FrameRecorder* recorder() const;
+
  protected:
   folly::IOBufQueue createBufferQueue(size_t bufferSize) const;
 
+  // Whether single frames are written into the arena's slab. Frames written
+  // there share their headroom with the frames before them, so this is off
+  // while the caller expects to prepend the frame length itself.
+  bool useArena() const;
+
+  // Appends the checksum trailer to the single frame in `queue`, when
+  // checksums are on.
+  void appendChecksum(folly::IOBufQueue& queue) const;
+
+  // Indexes the routing header and compresses the payload of a frame about
+  // to be sent, and the other way round for a received frame.
+  void encodePayload(rsocket::Payload& payload) const;
+  DecodeError decodePayload(rsocket::Payload& payload) const;
+  DecodeError decodeRoutingHeader(LazyFrame& frame) const;
+
+  bool compressesMetadata() const;
+
+  // Runs `encode`, which writes the frame with `header` into `batch`, and
+  // records the frame in stats() and recorder(), if set.
+  template <typename Encode>
+  void recordEncode(FrameHeader header, FrameBatch& batch, Encode&& encode)
+      const {
+    if (!stats_ && !recorder_) {
+      encode();
+      return;
+    }
+    const auto bytes = batch.byteCount();
+    const auto start =
+        stats_ ? FrameStats::Clock::now() : FrameStats::Clock::time_point();
+    encode();
+    const auto length = batch.byteCount() - bytes;
+    if (stats_) {
+      stats_->recordEncode(
+          header.type, length, FrameStats::Clock::now() - start);
+    }
+    if (recorder_) {
+      recorder_->record(
+          FrameRecord::Direction::ENCODE, header, length, batch.frameBytes());
+    }
+  }
+
+  template <typename Encode>
+  std::unique_ptr<folly::IOBuf> recordEncode(
+      FrameHeader header,
+      Encode&& encode) const {
+    if (!stats_ && !recorder_) {
+      return encode();
+    }
+    const auto start =
+        stats_ ? FrameStats::Clock::now() : FrameStats::Clock::time_point();
+    auto frame = encode();
+    const auto length = frame ? frame->computeChainDataLength() : 0;
+    if (stats_) {
+      stats_->recordEncode(
+          header.type, length, FrameStats::Clock::now() - start);
+    }
+    if (recorder_ && frame) {
+      std::array<uint8_t, FrameRecord::kHeaderSize> bytes;
+      recorder_->record(
+          FrameRecord::Direction::ENCODE,
+          header,
+          length,
+          copyFrameHeader(*frame, bytes));
+    }
+    return frame;
+  }
+
+  // Verifies the checksum trailer of `in` and runs `decode`, which decodes
+  // `in` as a frame of `type` whose header ends up in `header`. Records the
+  // frame in stats() and recorder(), if set.
+  template <typename Decode>
+  DecodeError recordDecode(
+      FrameType type,
+      const FrameHeader& header,
+      const std::unique_ptr<folly::IOBuf>& in,
+      Decode&& decode) const {
+    auto verifiedDecode = [&] {
+      if (in) {
+        const auto error = verifyChecksum(*in);
+        if (error != DecodeError::NONE) {
+          return error;
+        }
+      }
+      return decode();
+    };
+    if (!stats_ && !recorder_) {
+      return verifiedDecode();
+    }
+    // `decode` takes `in` away.
+    const auto length = in ? in->computeChainDataLength() : 0;
+    std::array<uint8_t, FrameRecord::kHeaderSize> bytes;
+    const auto headerBytes =
+        recorder_ && in ? copyFrameHeader(*in, bytes) : folly::ByteRange();
+    const auto start =
+        stats_ ? FrameStats::Clock::now() : FrameStats::Clock::time_point();
+    const auto error = verifiedDecode();
+    if (stats_) {
+      stats_->recordDecode(
+          type, length, error, FrameStats::Clock::now() - start);
+    }
+    if (recorder_) {
+      // The header of a frame that failed to decode may be incomplete.
+      recorder_->record(
+          FrameRecord::Direction::DECODE,
+          error == DecodeError::NONE
+              ? header
+              : FrameHeader(type, FrameFlags::EMPTY, 0),
+          length,
+          headerBytes,
+          error);
+    }
+    return error;
+  }
+
+  template <typename Frame>
+  std::unique_ptr<folly::IOBuf> serializeToArena(Frame&& frame) const {
+    FrameBatch batch(0, *arena_);
+    batch.setChecksumFrames(checksumFrames_);
+    serializeOut(batch, std::forward<Frame>(frame));
+    return batch.move();
+  }
+
  private:
   bool preallocateFrameSizeField_{false};
+  bool checksumFrames_{false};
+  FrameArena* arena_{nullptr};
+  PayloadCompressor* payloadCompressor_{nullptr};
+  RoutingHeaderTable* routingHeaderTable_{nullptr};
+  FrameStats* stats_{nullptr};
+  FrameRecorder* recorder_{nullptr};
 };
 
 } // namespace proteus
@@ -0,0 +1,926 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameSerializer_compact.h"
+
+#include <initializer_list>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameLayout.h"
+
+namespace proteus {
+
+constexpr const ProtocolVersion FrameSerializerCompact::Version;
+constexpr const size_t FrameSerializerCompact::kMinBytesNeededForAutodetection;
+
+namespace {
+constexpr const auto kMetadataLengthSize = 3; // bytes
+constexpr const auto kMaxMetadataLength = 0xFFFFFF; // 24bit max value
+constexpr const uint32_t kMaxStreamId = 0x7FFFFFFF;
+constexpr const uint32_t kMaxRequestN = 0x7FFFFFFF;
+
+// Flags that fit into the low 4 bits of the type byte, shifted down by 5.
+constexpr const uint16_t kCompactFlags = 0x1E0;
+constexpr const auto kCompactFlagsShift = 5;
+// Frame type bits of a type byte followed by the v1.0 type and flags.
+constexpr const uint8_t kExtendedType = 0xF;
+
+// The v1.0 frames are written into a batch of their own, which only holds
+// their header and the fixed fields behind it.
+constexpr const size_t kV1SlabSize = 64; // bytes
+
+// Left in front of the v1.0 header of a decoded frame, for the frame length
+// field and for LazyFrame rewrites that grow the header.
+constexpr const size_t kDecodeHeadroom = 16; // bytes
+
+using VarInt = layout::VarInt<uint32_t>;
+
+// The fields in front of the payload, which the two formats encode
+// differently.
+struct Header {
+  uint32_t streamId{0};
+  uint16_t typeAndFlags{0}; // as in v1.0
+  uint32_t requestN{0};
+  uint32_t metadataLength{0};
+  bool hasRequestN{false};
+  bool hasMetadataLength{false};
+};
+
+FrameType frameTypeOf(uint16_t typeAndFlags) {
+  const auto type = typeAndFlags >> 10;
+  if (type > static_cast<uint8_t>(FrameType::RESUME_OK) &&
+      type != static_cast<uint8_t>(FrameType::EXT)) {
+    return FrameType::RESERVED;
+  }
+  return static_cast<FrameType>(type);
+}
+
+bool hasRequestNField(FrameType type) {
+  return type == FrameType::REQUEST_STREAM ||
+      type == FrameType::REQUEST_CHANNEL || type == FrameType::REQUEST_N;
+}
+
+bool hasMetadataLengthField(FrameType type, uint16_t typeAndFlags) {
+  if (!(typeAndFlags & static_cast<uint16_t>(FrameFlags::METADATA))) {
+    return false;
+  }
+  switch (type) {
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_FNF:
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL:
+    case FrameType::PAYLOAD:
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t v1HeaderSize(const Header& header) {
+  return FrameSerializerV1_0::kFrameHeaderSize +
+      (header.hasRequestN ? sizeof(uint32_t) : 0) +
+      (header.hasMetadataLength ? kMetadataLengthSize : 0);
+}
+
+bool compactTypeAndFlags(uint16_t typeAndFlags) {
+  return (typeAndFlags >> 10) < kExtendedType &&
+      (typeAndFlags & 0x3FF & ~kCompactFlags) == 0;
+}
+
+size_t compactHeaderSize(const Header& header) {
+  return VarInt::size(header.streamId) + 1 +
+      (compactTypeAndFlags(header.typeAndFlags) ? 0 : sizeof(uint16_t)) +
+      (header.hasRequestN ? VarInt::size(header.requestN) : 0) +
+      (header.hasMetadataLength ? VarInt::size(header.metadataLength) : 0);
+}
+
+// Reads the header of a frame written by FrameSerializerV1_0.
+void readV1Header(folly::io::Cursor& cur, Header& header) {
+  header.streamId = static_cast<uint32_t>(cur.readBE<int32_t>());
+  header.typeAndFlags = cur.readBE<uint16_t>();
+  const auto type = frameTypeOf(header.typeAndFlags);
+  header.hasRequestN = hasRequestNField(type);
+  if (header.hasRequestN) {
+    header.requestN = static_cast<uint32_t>(cur.readBE<int32_t>());
+  }
+  header.hasMetadataLength = hasMetadataLengthField(type, header.typeAndFlags);
+  if (header.hasMetadataLength) {
+    header.metadataLength = static_cast<uint32_t>(cur.read<uint8_t>()) << 16;
+    header.metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>()) << 8;
+    header.metadataLength |= cur.read<uint8_t>();
+  }
+}
+
+template <typename Appender>
+void writeCompactHeader(Appender& appender, const Header& header) {
+  VarInt::encode(appender, header.streamId);
+  if (compactTypeAndFlags(header.typeAndFlags)) {
+    appender.template writeBE<uint8_t>(static_cast<uint8_t>(
+        (header.typeAndFlags >> 10) << 4 |
+        (header.typeAndFlags & kCompactFlags) >> kCompactFlagsShift));
+  } else {
+    appender.template writeBE<uint8_t>(kExtendedType << 4);
+    appender.template writeBE<uint16_t>(header.typeAndFlags);
+  }
+  if (header.hasRequestN) {
+    VarInt::encode(appender, header.requestN);
+  }
+  if (header.hasMetadataLength) {
+    VarInt::encode(appender, header.metadataLength);
+  }
+}
+
+template <typename Appender>
+void writeV1Header(Appender& appender, const Header& header) {
+  appender.template writeBE<int32_t>(static_cast<int32_t>(header.streamId));
+  appender.template writeBE<uint16_t>(header.typeAndFlags);
+  if (header.hasRequestN) {
+    appender.template writeBE<int32_t>(static_cast<int32_t>(header.requestN));
+  }
+  if (header.hasMetadataLength) {
+    appender.template writeBE<uint8_t>(
+        static_cast<uint8_t>(header.metadataLength >> 16));
+    appender.template writeBE<uint8_t>(
+        static_cast<uint8_t>(header.metadataLength >> 8));
+    appender.template writeBE<uint8_t>(
+        static_cast<uint8_t>(header.metadataLength));
+  }
+}
+
+bool tryReadVarInt(folly::io::Cursor& cur, uint32_t& value) {
+  auto in = cur.peekBytes();
+  uint8_t bytes[VarInt::kMaxSize];
+  if (in.size() < VarInt::kMaxSize) {
+    // The varint may continue in the next buffer of the chain.
+    auto copy = cur;
+    in = folly::ByteRange(bytes, copy.pullAtMost(bytes, sizeof(bytes)));
+  }
+  const auto size = in.size();
+  if (!VarInt::decode(in, value)) {
+    return false;
+  }
+  cur.skip(size - in.size());
+  return true;
+}
+
+// Reads the stream ID and the type and flags of a compact frame.
+DecodeError tryReadCompactPrefix(folly::io::Cursor& cur, Header& header) {
+  if (!tryReadVarInt(cur, header.streamId)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (header.streamId > kMaxStreamId) {
+    return DecodeError::INVALID_STREAM_ID;
+  }
+  uint8_t typeAndFlags;
+  if (!cur.tryRead(typeAndFlags)) {
+    return DecodeError::TRUNCATED;
+  }
+  if ((typeAndFlags >> 4) == kExtendedType) {
+    if (!cur.tryReadBE(header.typeAndFlags)) {
+      return DecodeError::TRUNCATED;
+    }
+  } else {
+    header.typeAndFlags = static_cast<uint16_t>(
+        (typeAndFlags >> 4) << 10 |
+        (typeAndFlags & 0x0F) << kCompactFlagsShift);
+  }
+  return DecodeError::NONE;
+}
+
+DecodeError tryReadCompactHeader(folly::io::Cursor& cur, Header& header) {
+  auto error = tryReadCompactPrefix(cur, header);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  const auto type = frameTypeOf(header.typeAndFlags);
+  header.hasRequestN = hasRequestNField(type);
+  if (header.hasRequestN) {
+    if (!tryReadVarInt(cur, header.requestN)) {
+      return DecodeError::TRUNCATED;
+    }
+    if (header.requestN > kMaxRequestN) {
+      return DecodeError::INVALID_REQUEST_N;
+    }
+  }
+  header.hasMetadataLength = hasMetadataLengthField(type, header.typeAndFlags);
+  if (header.hasMetadataLength) {
+    if (!tryReadVarInt(cur, header.metadataLength) ||
+        header.metadataLength > kMaxMetadataLength ||
+        !cur.canAdvance(header.metadataLength)) {
+      return DecodeError::TRUNCATED;
+    }
+  }
+  return DecodeError::NONE;
+}
+
+// Rewrites a received compact frame into the v1.0 format.
+DecodeError expandHeader(std::unique_ptr<folly::IOBuf>& in) {
+  if (!in) {
+    return DecodeError::TRUNCATED;
+  }
+  folly::io::Cursor cur(in.get());
+  Header header;
+  auto error = tryReadCompactHeader(cur, header);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  // The metadata is copied behind the header, where a LazyFrame finds it.
+  const auto metadataLength = header.metadataLength;
+  auto head = folly::IOBuf::create(
+      kDecodeHeadroom + v1HeaderSize(header) + metadataLength);
+  head->advance(kDecodeHeadroom);
+  folly::io::Appender appender(head.get(), 0);
+  writeV1Header(appender, header);
+  cur.pull(head->writableTail(), metadataLength);
+  head->append(metadataLength);
+  if (const auto rest = cur.totalLength()) {
+    std::unique_ptr<folly::IOBuf> data;
+    cur.clone(data, rest);
+    head->prependChain(std::move(data));
+  }
+  in = std::move(head);
+  return DecodeError::NONE;
+}
+
+// The payload of the frames whose metadata may start with a broker routing
+// frame, nullptr for the other frames.
+rsocket::Payload* routedPayload(Frame_REQUEST_STREAM& frame) {
+  return &frame.payload_;
+}
+rsocket::Payload* routedPayload(Frame_REQUEST_CHANNEL& frame) {
+  return &frame.payload_;
+}
+rsocket::Payload* routedPayload(Frame_REQUEST_RESPONSE& frame) {
+  return &frame.payload_;
+}
+rsocket::Payload* routedPayload(Frame_REQUEST_FNF& frame) {
+  return &frame.payload_;
+}
+rsocket::Payload* routedPayload(Frame_PAYLOAD& frame) {
+  return &frame.payload_;
+}
+template <typename Frame>
+rsocket::Payload* routedPayload(Frame&) {
+  return nullptr;
+}
+
+bool tryInternAll(
+    NameTable& names,
+    std::initializer_list<folly::StringPiece> in,
+    NameId* ids) {
+  for (const auto name : in) {
+    auto id = names.tryIntern(name);
+    if (!id) {
+      return false;
+    }
+    *ids++ = *id;
+  }
+  return true;
+}
+
+// Writes `frame` in the v1.0 broker layout, followed by `metadata`. The
+// version is the one that introduced compact routing frames, which don't
+// carry the version of the frame they were made from.
+template <typename Appender>
+void encodeExpanded(
+    Appender& appender,
+    const CompactRoutingFrame& frame,
+    const NameTable& names,
+    folly::ByteRange metadata) {
+  const auto major = kCompactBrokerMajorVersion;
+  const auto minor = kCompactBrokerMinorVersion;
+  switch (frame.frameType) {
+    case FrameType::DESTINATION:
+      DestinationLayout::encode(
+          appender,
+          major,
+          minor,
+          frame.frameType,
+          names.name(frame.fromDestination),
+          names.name(frame.fromGroup),
+          names.name(frame.toDestination),
+          names.name(frame.toGroup),
+          metadata);
+      break;
+    case FrameType::SHARD:
+      ShardLayout::encode(
+          appender,
+          major,
+          minor,
+          frame.frameType,
+          names.name(frame.fromDestination),
+          names.name(frame.fromGroup),
+          names.name(frame.toGroup),
+          frame.shardKey,
+          metadata);
+      break;
+    default:
+      GroupLayout::encode(
+          appender,
+          major,
+          minor,
+          frame.frameType,
+          names.name(frame.fromDestination),
+          names.name(frame.fromGroup),
+          names.name(frame.toGroup),
+          metadata);
+      break;
+  }
+}
+} // namespace
+
+ProtocolVersion FrameSerializerCompact::protocolVersion() const {
+  return Version;
+}
+
+void FrameSerializerCompact::setBrokerCodec(CompactBrokerCodec* codec) {
+  brokerCodec_ = codec;
+  DCHECK(!brokerCodec_ || !routingHeaderTable())
+      << "a broker codec takes the place of a routing header table";
+  DCHECK(!brokerCodec_ || !compressesMetadata())
+      << "broker codecs don't work with compressed metadata";
+}
+
+CompactBrokerCodec* FrameSerializerCompact::brokerCodec() const {
+  return brokerCodec_;
+}
+
+FrameType FrameSerializerCompact::peekFrameType(const folly::IOBuf& in) const {
+  folly::io::Cursor cur(&in);
+  Header header;
+  if (tryReadCompactPrefix(cur, header) != DecodeError::NONE) {
+    return FrameType::RESERVED;
+  }
+  return frameTypeOf(header.typeAndFlags);
+}
+
+folly::Optional<rsocket::StreamId> FrameSerializerCompact::peekStreamId(
+    const folly::IOBuf& in) const {
+  folly::io::Cursor cur(&in);
+  uint32_t streamId;
+  if (!tryReadVarInt(cur, streamId) || streamId > kMaxStreamId) {
+    return folly::none;
+  }
+  return folly::make_optional(static_cast<rsocket::StreamId>(streamId));
+}
+
+template <typename Frame>
+void FrameSerializerCompact::encodeRoutes(Frame& frame) const {
+  if (!brokerCodec_) {
+    return;
+  }
+  if (auto* payload = routedPayload(frame)) {
+    encodeRoutingFrame(payload->metadata);
+  }
+}
+
+template <typename Frame>
+DecodeError FrameSerializerCompact::decodeRoutes(Frame& frame) const {
+  if (!brokerCodec_) {
+    return DecodeError::NONE;
+  }
+  auto* payload = routedPayload(frame);
+  return payload ? decodeRoutingFrame(payload->metadata) : DecodeError::NONE;
+}
+
+DecodeError FrameSerializerCompact::decodeRoutes(LazyFrame& frame) const {
+  if (!brokerCodec_ || !frame.hasMetadata()) {
+    return DecodeError::NONE;
+  }
+  // Compressed metadata stays compressed in a LazyFrame.
+  if (compressesMetadata()) {
+    return DecodeError::INVALID_ROUTING_HEADER;
+  }
+  // Decoding copied the metadata into the head buffer.
+  const auto metadata = frame.metadataRange();
+  DCHECK(metadata);
+  if (!metadata || !isCompactBrokerFrame(*metadata)) {
+    return DecodeError::NONE;
+  }
+  CompactRoutingFrame routing;
+  auto error = brokerCodec_->decode(*metadata, routing);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  folly::io::QueueAppender appender(&queue, 64);
+  encodeExpanded(appender, routing, brokerCodec_->names(), folly::ByteRange());
+  auto fields = queue.move();
+  frame.replaceMetadataPrefix(
+      metadata->size() - routing.metadata.size(), fields->coalesce());
+  return DecodeError::NONE;
+}
+
+void FrameSerializerCompact::encodeRoutingFrame(
+    std::unique_ptr<folly::IOBuf>& metadata) const {
+  if (!metadata) {
+    return;
+  }
+  // Frames the views can't parse, or whose names the table can't hold, are
+  // sent as they are.
+  auto& names = brokerCodec_->names();
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  folly::io::QueueAppender appender(&queue, 64);
+  NameId ids[4];
+  const auto type = peekBrokerFrameType(
+      folly::ByteRange(metadata->data(), metadata->length()));
+  switch (type) {
+    case FrameType::DESTINATION: {
+      auto view = DestinationView::tryParse(*metadata);
+      if (!view ||
+          !tryInternAll(
+              names,
+              {view->fromDestination(),
+               view->fromGroup(),
+               view->toDestination(),
+               view->toGroup()},
+              ids)) {
+        return;
+      }
+      brokerCodec_->encodeDestination(
+          appender,
+          ids[0],
+          ids[1],
+          ids[2],
+          ids[3],
+          view->cloneMetadata(*metadata));
+      break;
+    }
+    case FrameType::GROUP:
+    case FrameType::BROADCAST: {
+      folly::Optional<GroupView> view;
+      if (type == FrameType::GROUP) {
+        view = GroupView::tryParse(*metadata);
+      } else if (auto broadcast = BroadcastView::tryParse(*metadata)) {
+        view = *broadcast;
+      }
+      if (!view ||
+          !tryInternAll(
+              names,
+              {view->fromDestination(), view->fromGroup(), view->toGroup()},
+              ids)) {
+        return;
+      }
+      brokerCodec_->encodeGroup(
+          appender,
+          type,
+          ids[0],
+          ids[1],
+          ids[2],
+          view->cloneMetadata(*metadata));
+      break;
+    }
+    case FrameType::SHARD: {
+      auto view = ShardView::tryParse(*metadata);
+      if (!view ||
+          !tryInternAll(
+              names,
+              {view->fromDestination(), view->fromGroup(), view->toGroup()},
+              ids)) {
+        return;
+      }
+      brokerCodec_->encodeShard(
+          appender,
+          ids[0],
+          ids[1],
+          ids[2],
+          view->shardKey(),
+          view->cloneMetadata(*metadata));
+      break;
+    }
+    default:
+      return;
+  }
+  metadata = queue.move();
+}
+
+DecodeError FrameSerializerCompact::decodeRoutingFrame(
+    std::unique_ptr<folly::IOBuf>& metadata) const {
+  if (!metadata) {
+    return DecodeError::NONE;
+  }
+  const auto in = metadata->coalesce();
+  if (!isCompactBrokerFrame(in)) {
+    return DecodeError::NONE;
+  }
+  CompactRoutingFrame routing;
+  auto error = brokerCodec_->decode(in, routing);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  folly::io::QueueAppender appender(&queue, 64 + routing.metadata.size());
+  encodeExpanded(appender, routing, brokerCodec_->names(), routing.metadata);
+  metadata = queue.move();
+  return DecodeError::NONE;
+}
+
+template <typename Frame>
+void FrameSerializerCompact::encodeCompact(FrameBatch& batch, Frame&& frame)
+    const {
+  encodeRoutes(frame);
+  // Without a length field or a checksum trailer, which `batch` writes.
+  FrameBatch v1(0, kV1SlabSize);
+  encodeFrame(v1, std::forward<Frame>(frame));
+  auto buf = v1.move();
+
+  folly::io::Cursor cur(buf.get());
+  Header header;
+  readV1Header(cur, header);
+  const auto bodySize = cur.totalLength();
+  batch.beginFrame(compactHeaderSize(header), bodySize);
+  writeCompactHeader(batch, header);
+  if (bodySize > 0) {
+    std::unique_ptr<folly::IOBuf> body;
+    cur.clone(body, bodySize);
+    batch.insert(std::move(body));
+  }
+}
+
+template <typename Frame>
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeCompact(
+    Frame&& frame) const {
+  auto batch = createFrameBatch();
+  serializeOut(batch, std::forward<Frame>(frame));
+  return batch.move();
+}
+
+template <typename Frame>
+DecodeError FrameSerializerCompact::decodeCompact(
+    Frame& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  auto error = expandHeader(in);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  error = decodeFrame(frame, std::move(in));
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decodeRoutes(frame);
+}
+
+// The overrides record every frame in stats() and recorder() around the
+// re-encoding.
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_STREAM&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_CHANNEL&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_RESPONSE&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_FNF&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_N&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_METADATA_PUSH&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_CANCEL&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_PAYLOAD&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_ERROR&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_KEEPALIVE&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_SETUP&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_LEASE&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_RESUME&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerCompact::serializeOut(
+    FrameBatch& batch,
+    Frame_RESUME_OK&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeCompact(batch, std::move(frame));
+  });
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_REQUEST_STREAM&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_REQUEST_CHANNEL&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_REQUEST_RESPONSE&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_REQUEST_FNF&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_REQUEST_N&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_METADATA_PUSH&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_CANCEL&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_PAYLOAD&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_ERROR&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_KEEPALIVE&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_SETUP&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_LEASE&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_RESUME&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerCompact::serializeOut(
+    Frame_RESUME_OK&& frame) const {
+  return serializeCompact(std::move(frame));
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_REQUEST_STREAM& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_STREAM, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_REQUEST_CHANNEL& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_CHANNEL, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_REQUEST_RESPONSE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_RESPONSE, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_REQUEST_FNF& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_FNF, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_REQUEST_N& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_N, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_METADATA_PUSH& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::METADATA_PUSH, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_CANCEL& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::CANCEL, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_PAYLOAD& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::PAYLOAD, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_ERROR& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::ERROR, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_KEEPALIVE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::KEEPALIVE, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_SETUP& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::SETUP, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_LEASE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::LEASE, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_RESUME& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::RESUME, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    Frame_RESUME_OK& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::RESUME_OK, frame.header_, in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerCompact::tryDeserializeFrom(
+    LazyFrame& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  // The frame type is only known from the frame, don't peek for nothing.
+  const auto type = in && (stats() || recorder()) ? peekFrameType(*in)
+                                                  : FrameType::RESERVED;
+  return recordDecode(type, frame.header(), in, [&] {
+    return decodeCompact(frame, std::move(in));
+  });
+}
+
+ProtocolVersion FrameSerializerCompact::detectProtocolVersion(
+    const folly::IOBuf& firstFrame,
+    size_t skipBytes) {
+  // SETUP and RESUME frames, with their version where v1.0 has it:
+  //
+  //  +---------------+-------+-------+---------------------------------+
+  //  | Stream ID = 0 | Type  | Flags |  Major Version  |  Minor Version |
+  //  +---------------+-------+-------+---------------------------------+
+  //
+  // The stream ID takes one byte, and SETUP frames with the IGNORE flag
+  // have the 16-bit type and flags of v1.0 behind the type byte.
+  folly::io::Cursor cur(&firstFrame);
+  if (!cur.canAdvance(skipBytes)) {
+    return ProtocolVersion::Unknown;
+  }
+  cur.skip(skipBytes);
+
+  Header header;
+  uint16_t majorVersion;
+  uint16_t minorVersion;
+  if (tryReadCompactPrefix(cur, header) != DecodeError::NONE ||
+      !cur.tryReadBE(majorVersion) || !cur.tryReadBE(minorVersion)) {
+    return ProtocolVersion::Unknown;
+  }
+  const auto frameType = frameTypeOf(header.typeAndFlags);
+
+  VLOG(4) << "frameType=" << frameType << " streamId=" << header.streamId
+          << " majorVersion=" << majorVersion
+          << " minorVersion=" << minorVersion;
+
+  if (header.streamId == 0 &&
+      (frameType == FrameType::SETUP || frameType == FrameType::RESUME) &&
+      majorVersion == Version.major && minorVersion == Version.minor) {
+    return Version;
+  }
+  return ProtocolVersion::Unknown;
+}
+
+} // namespace proteus
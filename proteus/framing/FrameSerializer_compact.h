@@ -0,0 +1,184 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "proteus/framing/CompactBrokerFrame.h"
+#include "proteus/framing/FrameSerializer_v1_0.h"
+
+namespace proteus {
+
+// Compact framing, for connections whose frames are mostly small broker
+// requests. Frames carry the same fields as in v1.0, only the fields in
+// front of the payload are encoded differently:
+//
+//   |Stream ID (varint)|Type|Flags|[Request N (varint)]
+//   |[Metadata Length (varint)]|Metadata|Data
+//
+// Type and flags share one byte: the frame type in the high 4 bits and
+// the METADATA, FOLLOWS, COMPLETE and NEXT flags (RESUME_ENABLE and LEASE
+// in SETUP, RESPOND in KEEPALIVE) in the low 4 bits. Frames with other
+// flags or a type above RESUME_OK set the high 4 bits instead and follow
+// the byte with the 16-bit type and flags of v1.0. Request N is a varint
+// in REQUEST_STREAM, REQUEST_CHANNEL and REQUEST_N frames, the metadata
+// length in REQUEST_RESPONSE, REQUEST_FNF, REQUEST_STREAM, REQUEST_CHANNEL
+// and PAYLOAD frames. Everything else is as in v1.0: a REQUEST_RESPONSE
+// on a stream ID below 128 with less than 128 bytes of metadata has a 3
+// byte header instead of 9, a REQUEST_STREAM one of 4 instead of 13.
+//
+// The second byte of a compact SETUP or RESUME frame holds its type, the
+// second byte of a v1.0 one is part of the zero stream ID, which is how
+// createAutodetectedSerializer() tells them apart.
+//
+// Frames are encoded and decoded by FrameSerializerV1_0 and their header
+// re-encoded. Encoding copies nothing but the header. Decoding copies the
+// v1.0 header and the metadata into a buffer of their own, where
+// LazyFrame::metadataRange() finds them; the data stays where it is. The
+// buffer() of a LazyFrame is thus in the v1.0 layout too, and can only be
+// forwarded as is to a v1.0 connection.
+//
+// With a CompactBrokerCodec set, the broker routing frames at the front of
+// request and PAYLOAD metadata are sent as compact routing frames, whose
+// names are route references, and received ones are expanded back into
+// the v1.0 broker layout of BrokerFrameView.h.
+class FrameSerializerCompact : public FrameSerializerV1_0 {
+ public:
+  constexpr static const ProtocolVersion Version = ProtocolVersion(1, 1);
+  constexpr static const size_t kMinBytesNeededForAutodetection = 6; // bytes
+
+  ProtocolVersion protocolVersion() const override;
+
+  static ProtocolVersion detectProtocolVersion(
+      const folly::IOBuf& firstFrame,
+      size_t skipBytes = 0);
+
+  // Per-connection codec of the broker routing frames in metadata, nullptr
+  // (the default) to leave metadata as it is. Every request and PAYLOAD
+  // frame the connection receives must then carry a broker frame in its
+  // metadata, as a compact routing frame or in the v1.0 layout. Takes the
+  // place of a routing header table, and doesn't work with compressed
+  // metadata either. The codec must outlive the serializer or be unset
+  // first.
+  void setBrokerCodec(CompactBrokerCodec* codec);
+  CompactBrokerCodec* brokerCodec() const;
+
+  FrameType peekFrameType(const folly::IOBuf& in) const override;
+  folly::Optional<rsocket::StreamId> peekStreamId(
+      const folly::IOBuf& in) const override;
+
+  std::unique_ptr<folly::IOBuf> serializeOut(
+      Frame_REQUEST_STREAM&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(
+      Frame_REQUEST_CHANNEL&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(
+      Frame_REQUEST_RESPONSE&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(
+      Frame_REQUEST_FNF&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_REQUEST_N&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(
+      Frame_METADATA_PUSH&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_CANCEL&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_PAYLOAD&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_ERROR&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_KEEPALIVE&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_SETUP&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_LEASE&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_RESUME&&) const override;
+  std::unique_ptr<folly::IOBuf> serializeOut(Frame_RESUME_OK&&) const override;
+
+  void serializeOut(FrameBatch&, Frame_REQUEST_STREAM&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_CHANNEL&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_RESPONSE&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_FNF&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_N&&) const override;
+  void serializeOut(FrameBatch&, Frame_METADATA_PUSH&&) const override;
+  void serializeOut(FrameBatch&, Frame_CANCEL&&) const override;
+  void serializeOut(FrameBatch&, Frame_PAYLOAD&&) const override;
+  void serializeOut(FrameBatch&, Frame_ERROR&&) const override;
+  void serializeOut(FrameBatch&, Frame_KEEPALIVE&&) const override;
+  void serializeOut(FrameBatch&, Frame_SETUP&&) const override;
+  void serializeOut(FrameBatch&, Frame_LEASE&&) const override;
+  void serializeOut(FrameBatch&, Frame_RESUME&&) const override;
+  void serializeOut(FrameBatch&, Frame_RESUME_OK&&) const override;
+
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_STREAM&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_CHANNEL&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_RESPONSE&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_FNF&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_N&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_METADATA_PUSH&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(Frame_CANCEL&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_PAYLOAD&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_ERROR&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(
+      Frame_KEEPALIVE&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(Frame_SETUP&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_LEASE&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_RESUME&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(
+      Frame_RESUME_OK&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(LazyFrame&, std::unique_ptr<folly::IOBuf>)
+      const override;
+
+ private:
+  // Encodes `frame` with FrameSerializerV1_0 and appends it to `batch` with
+  // its header re-encoded.
+  template <typename Frame>
+  void encodeCompact(FrameBatch& batch, Frame&& frame) const;
+
+  // Single frames are written into a batch of their own.
+  template <typename Frame>
+  std::unique_ptr<folly::IOBuf> serializeCompact(Frame&& frame) const;
+
+  // Decodes `in` with FrameSerializerV1_0 once its header is re-encoded.
+  template <typename Frame>
+  DecodeError decodeCompact(Frame& frame, std::unique_ptr<folly::IOBuf> in)
+      const;
+
+  // Compacts the broker routing frame in the metadata of a frame about to
+  // be sent, and expands the one of a received frame, when a broker codec
+  // is set.
+  template <typename Frame>
+  void encodeRoutes(Frame& frame) const;
+  template <typename Frame>
+  DecodeError decodeRoutes(Frame& frame) const;
+  DecodeError decodeRoutes(LazyFrame& frame) const;
+
+  void encodeRoutingFrame(std::unique_ptr<folly::IOBuf>& metadata) const;
+  DecodeError decodeRoutingFrame(std::unique_ptr<folly::IOBuf>& metadata)
+      const;
+
+  CompactBrokerCodec* brokerCodec_{nullptr};
+};
+} // namespace proteus
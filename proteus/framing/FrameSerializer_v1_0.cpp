@@ -16,6 +16,8 @@
 
 #include <folly/io/Cursor.h>
 
+#include "proteus/framing/FrameLayout.h"
+
 namespace proteus {
 
 constexpr const ProtocolVersion FrameSerializerV1_0::Version;
@@ -25,13 +27,40 @@ constexpr const size_t FrameSerializerV1_0::kMinBytesNeededForAutodetection;
 namespace {
 constexpr const auto kMedatadaLengthSize = 3; // bytes
 constexpr const auto kMaxMetadataLength = 0xFFFFFF; // 24bit max value
+
+// |Stream ID|Frame Type (6 bits)|Flags (10 bits)|, followed by Fields.
+template <typename... Fields>
+using FrameLayout = layout::Layout<
+    layout::BigEndian<int32_t>,
+    layout::BigEndian<uint16_t>,
+    Fields...>;
+
+using FrameHeaderLayout = FrameLayout<>;
+using RequestNLayout = FrameLayout<layout::BigEndian<int32_t>>;
+using MetadataPushLayout = FrameLayout<layout::Trailing<>>;
+using KeepaliveLayout =
+    FrameLayout<layout::BigEndian<int64_t>, layout::Trailing<>>;
+using LeaseLayout = FrameLayout<
+    layout::BigEndian<int32_t>, // ttl
+    layout::BigEndian<int32_t>, // number of requests
+    layout::Trailing<>>;
+using ResumeOkLayout = FrameLayout<layout::BigEndian<int64_t>>;
+
+static_assert(
+    FrameHeaderLayout::kMinSize == FrameSerializerV1_0::kFrameHeaderSize,
+    "frame header size mismatch");
+
+uint16_t packTypeAndFlags(const FrameHeader& header) {
+  auto type = static_cast<uint16_t>(header.type); // 6 bit
+  auto flags = static_cast<uint16_t>(header.flags); // 10 bit
+  return static_cast<uint16_t>((type << 10) | (flags & 0x3FF));
+}
 } // namespace
 
 ProtocolVersion FrameSerializerV1_0::protocolVersion() const {
   return Version;
 }
 
-/*
 static FrameType deserializeFrameType(uint16_t frameType) {
   if (frameType > static_cast<uint8_t>(FrameType::RESUME_OK) &&
       frameType != static_cast<uint8_t>(FrameType::EXT)) {
@@ -40,17 +69,15 @@ static FrameType deserializeFrameType(uint16_t frameType) {
   return static_cast<FrameType>(frameType);
 }
 
-static void serializeHeaderInto(
-    folly::io::QueueAppender& appender,
-    const FrameHeader& header) {
-  appender.writeBE<int32_t>(static_cast<int32_t>(header.streamId));
-
-  auto type = static_cast<uint8_t>(header.type); // 6 bit
-  auto flags = static_cast<uint16_t>(header.flags); // 10 bit
-  appender.write(static_cast<uint8_t>((type << 2) | (flags >> 8)));
-  appender.write(static_cast<uint8_t>(flags)); // lower 8 bits
+template <typename Appender>
+static void serializeHeaderInto(Appender& appender, const FrameHeader& header) {
+  FrameHeaderLayout::encode(
+      appender,
+      static_cast<int32_t>(header.streamId),
+      packTypeAndFlags(header));
 }
 
+/*
 static void deserializeHeaderFrom(folly::io::Cursor& cur, FrameHeader& header) {
   auto streamId = cur.readBE<int32_t>();
   if (streamId < 0) {
@@ -64,8 +91,9 @@ static void deserializeHeaderFrom(folly::io::Cursor& cur, FrameHeader& header) {
 }
 */
 
+template <typename Appender>
 static void serializeMetadataInto(
-    folly::io::QueueAppender& appender,
+    Appender& appender,
     std::unique_ptr<folly::IOBuf> metadata) {
   if (metadata == nullptr) {
     return;
@@ -127,8 +155,9 @@ static rsocket::Payload deserializePayloadFrom(
 */
 
 
+template <typename Appender>
 static void serializePayloadInto(
-    folly::io::QueueAppender& appender,
+    Appender& appender,
     rsocket::Payload&& payload) {
   serializeMetadataInto(appender, std::move(payload.metadata));
   if (payload.data) {
@@ -141,8 +170,17 @@ static uint32_t payloadFramingSize(const rsocket::Payload& payload) {
   return (payload.metadata != nullptr ? kMedatadaLengthSize : 0);
 }
 
+static size_t chainLength(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->computeChainDataLength() : 0;
+}
+
+static size_t payloadLength(const rsocket::Payload& payload) {
+  return chainLength(payload.metadata) + chainLength(payload.data);
+}
+
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
     Frame_REQUEST_Base&& frame) const {
+  encodePayload(frame.payload_);
   auto queue = createBufferQueue(
       FrameSerializerV1_0::kFrameHeaderSize + sizeof(uint32_t) +
       payloadFramingSize(frame.payload_));
@@ -152,6 +190,7 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
 
   appender.writeBE<int32_t>(static_cast<int32_t>(frame.requestN_));
   serializePayloadInto(appender, std::move(frame.payload_));
+  appendChecksum(queue);
   return queue.move();
 }
 
@@ -187,33 +226,48 @@ static size_t getResumeIdTokenFramingLength(
 
 
 FrameType FrameSerializerV1_0::peekFrameType(const folly::IOBuf& in) const {
+  if (in.length() >= FrameHeaderLayout::kMinSize) {
+    // the whole header is in the head buffer, load the field directly
+    auto range = folly::ByteRange(in.data(), in.length());
+    return deserializeFrameType(FrameHeaderLayout::load<1>(range) >> 10);
+  }
+
   folly::io::Cursor cur(&in);
-  try {
-    cur.skip(sizeof(int32_t)); // streamId
-    uint8_t type = cur.readBE<uint8_t>(); // |Frame Type |I|M|
-    return deserializeFrameType(type >> 2);
-  } catch (...) {
+  if (!cur.canAdvance(sizeof(int32_t) + sizeof(uint8_t))) {
     return FrameType::RESERVED;
   }
+  cur.skip(sizeof(int32_t)); // streamId
+  uint8_t type = cur.readBE<uint8_t>(); // |Frame Type |I|M|
+  return deserializeFrameType(type >> 2);
 }
 
 folly::Optional<rsocket::StreamId> FrameSerializerV1_0::peekStreamId(
     const folly::IOBuf& in) const {
-  folly::io::Cursor cur(&in);
-  try {
-    auto streamId = cur.readBE<int32_t>();
-    if (streamId < 0) {
+  int32_t streamId;
+  if (in.length() >= FrameHeaderLayout::kMinSize) {
+    streamId = FrameHeaderLayout::load<0>(
+        folly::ByteRange(in.data(), in.length()));
+  } else {
+    folly::io::Cursor cur(&in);
+    if (!cur.tryReadBE(streamId)) {
       return folly::none;
     }
-    return folly::make_optional(static_cast<rsocket::StreamId>(streamId));
-  } catch (...) {
+  }
+  if (streamId < 0) {
     return folly::none;
   }
+  return folly::make_optional(static_cast<rsocket::StreamId>(streamId));
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_STREAM&& frame) const {
-  return serializeOutInternal(std::move(frame));
+  if (useArena()) {
+    // Recorded by the batch serializeOut().
+    return serializeToArena(std::move(frame));
+  }
+  return recordEncode(frame.header_, [&] {
+    return serializeOutInternal(std::move(frame));
+  });
 }
 
 /***************************
@@ -403,6 +457,319 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 END OF SERIALIZE OUTS
 ********************************/
 
+void FrameSerializerV1_0::serializeOutInternal(
+    FrameBatch& batch,
+    Frame_REQUEST_Base&& frame) const {
+  encodePayload(frame.payload_);
+  batch.beginFrame(
+      kFrameHeaderSize + sizeof(uint32_t) + payloadFramingSize(frame.payload_),
+      payloadLength(frame.payload_));
+  serializeHeaderInto(batch, frame.header_);
+  batch.writeBE<int32_t>(static_cast<int32_t>(frame.requestN_));
+  serializePayloadInto(batch, std::move(frame.payload_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_REQUEST_STREAM&& frame) const {
+  serializeOutInternal(batch, std::move(frame));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_REQUEST_CHANNEL&& frame) const {
+  serializeOutInternal(batch, std::move(frame));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_REQUEST_RESPONSE&& frame) const {
+  encodePayload(frame.payload_);
+  batch.beginFrame(
+      kFrameHeaderSize + payloadFramingSize(frame.payload_),
+      payloadLength(frame.payload_));
+  serializeHeaderInto(batch, frame.header_);
+  serializePayloadInto(batch, std::move(frame.payload_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_REQUEST_FNF&& frame) const {
+  encodePayload(frame.payload_);
+  batch.beginFrame(
+      kFrameHeaderSize + payloadFramingSize(frame.payload_),
+      payloadLength(frame.payload_));
+  serializeHeaderInto(batch, frame.header_);
+  serializePayloadInto(batch, std::move(frame.payload_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_REQUEST_N&& frame) const {
+  batch.beginFrame(RequestNLayout::kMinSize, 0);
+  RequestNLayout::encode(
+      batch,
+      static_cast<int32_t>(frame.header_.streamId),
+      packTypeAndFlags(frame.header_),
+      static_cast<int32_t>(frame.requestN_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_METADATA_PUSH&& frame) const {
+  batch.beginFrame(MetadataPushLayout::kMinSize, chainLength(frame.metadata_));
+  MetadataPushLayout::encode(
+      batch,
+      static_cast<int32_t>(frame.header_.streamId),
+      packTypeAndFlags(frame.header_),
+      std::move(frame.metadata_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_CANCEL&& frame) const {
+  batch.beginFrame(FrameHeaderLayout::kMinSize, 0);
+  serializeHeaderInto(batch, frame.header_);
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_PAYLOAD&& frame) const {
+  encodePayload(frame.payload_);
+  batch.beginFrame(
+      kFrameHeaderSize + payloadFramingSize(frame.payload_),
+      payloadLength(frame.payload_));
+  serializeHeaderInto(batch, frame.header_);
+  serializePayloadInto(batch, std::move(frame.payload_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_ERROR&& frame) const {
+  batch.beginFrame(
+      kFrameHeaderSize + sizeof(uint32_t) + payloadFramingSize(frame.payload_),
+      payloadLength(frame.payload_));
+  serializeHeaderInto(batch, frame.header_);
+  batch.writeBE(static_cast<uint32_t>(frame.errorCode_));
+  serializePayloadInto(batch, std::move(frame.payload_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_KEEPALIVE&& frame) const {
+  batch.beginFrame(KeepaliveLayout::kMinSize, chainLength(frame.data_));
+  KeepaliveLayout::encode(
+      batch,
+      static_cast<int32_t>(frame.header_.streamId),
+      packTypeAndFlags(frame.header_),
+      static_cast<int64_t>(frame.position_),
+      std::move(frame.data_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_SETUP&& frame) const {
+  batch.beginFrame(
+      kFrameHeaderSize + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(int32_t) +
+          sizeof(int32_t) +
+          getResumeIdTokenFramingLength(frame.header_.flags, frame.token_) +
+          sizeof(uint8_t) + frame.metadataMimeType_.length() +
+          sizeof(uint8_t) + frame.dataMimeType_.length() +
+          payloadFramingSize(frame.payload_),
+      payloadLength(frame.payload_));
+
+  serializeHeaderInto(batch, frame.header_);
+  CHECK(
+      frame.versionMajor_ != ProtocolVersion::Unknown.major ||
+      frame.versionMinor_ != ProtocolVersion::Unknown.minor);
+  batch.writeBE<uint16_t>(frame.versionMajor_);
+  batch.writeBE<uint16_t>(frame.versionMinor_);
+  batch.writeBE(static_cast<int32_t>(frame.keepaliveTime_));
+  batch.writeBE(static_cast<int32_t>(frame.maxLifetime_));
+
+  if (!!(frame.header_.flags & FrameFlags::RESUME_ENABLE)) {
+    batch.writeBE<uint16_t>(static_cast<uint16_t>(frame.token_.data().size()));
+    batch.push(frame.token_.data().data(), frame.token_.data().size());
+  }
+
+  CHECK(
+      frame.metadataMimeType_.length() <= std::numeric_limits<uint8_t>::max());
+  batch.writeBE(static_cast<uint8_t>(frame.metadataMimeType_.length()));
+  batch.push(
+      reinterpret_cast<const uint8_t*>(frame.metadataMimeType_.data()),
+      frame.metadataMimeType_.length());
+
+  CHECK(frame.dataMimeType_.length() <= std::numeric_limits<uint8_t>::max());
+  batch.writeBE(static_cast<uint8_t>(frame.dataMimeType_.length()));
+  batch.push(
+      reinterpret_cast<const uint8_t*>(frame.dataMimeType_.data()),
+      frame.dataMimeType_.length());
+
+  serializePayloadInto(batch, std::move(frame.payload_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_LEASE&& frame) const {
+  batch.beginFrame(LeaseLayout::kMinSize, chainLength(frame.metadata_));
+  LeaseLayout::encode(
+      batch,
+      static_cast<int32_t>(frame.header_.streamId),
+      packTypeAndFlags(frame.header_),
+      static_cast<int32_t>(frame.ttl_),
+      static_cast<int32_t>(frame.numberOfRequests_),
+      std::move(frame.metadata_));
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_RESUME&& frame) const {
+  batch.beginFrame(
+      kFrameHeaderSize + sizeof(uint16_t) + sizeof(uint16_t) +
+          sizeof(uint16_t) + frame.token_.data().size() + sizeof(int64_t) +
+          sizeof(int64_t),
+      0);
+  serializeHeaderInto(batch, frame.header_);
+
+  CHECK(
+      frame.versionMajor_ != ProtocolVersion::Unknown.major ||
+      frame.versionMinor_ != ProtocolVersion::Unknown.minor);
+  batch.writeBE(static_cast<uint16_t>(frame.versionMajor_));
+  batch.writeBE(static_cast<uint16_t>(frame.versionMinor_));
+
+  batch.writeBE<uint16_t>(static_cast<uint16_t>(frame.token_.data().size()));
+  batch.push(frame.token_.data().data(), frame.token_.data().size());
+
+  batch.writeBE<int64_t>(frame.lastReceivedServerPosition_);
+  batch.writeBE<int64_t>(frame.clientPosition_);
+}
+
+void FrameSerializerV1_0::encodeFrame(
+    FrameBatch& batch,
+    Frame_RESUME_OK&& frame) const {
+  batch.beginFrame(ResumeOkLayout::kMinSize, 0);
+  ResumeOkLayout::encode(
+      batch,
+      static_cast<int32_t>(frame.header_.streamId),
+      packTypeAndFlags(frame.header_),
+      static_cast<int64_t>(frame.position_));
+}
+
+
+// The overrides record every frame in stats() and recorder() around the
+// actual encoding and decoding.
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_STREAM&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_CHANNEL&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_RESPONSE&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_FNF&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_REQUEST_N&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_METADATA_PUSH&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_CANCEL&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_PAYLOAD&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_ERROR&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_KEEPALIVE&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_SETUP&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_LEASE&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_RESUME&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
+
+void FrameSerializerV1_0::serializeOut(
+    FrameBatch& batch,
+    Frame_RESUME_OK&& frame) const {
+  recordEncode(frame.header_, batch, [&] {
+    encodeFrame(batch, std::move(frame));
+  });
+}
 
 /*
 bool FrameSerializerV1_0::deserializeFrom(
@@ -651,6 +1018,565 @@ bool FrameSerializerV1_0::deserializeFrom(
 }
 */
 
+// The tryDeserialize* functions below never throw: every read is preceded by
+// a bounds check and the cursor is only advanced over bytes known to exist.
+
+static DecodeError tryDeserializeHeaderFrom(
+    folly::io::Cursor& cur,
+    FrameHeader& header) {
+  if (!cur.canAdvance(FrameSerializerV1_0::kFrameHeaderSize)) {
+    return DecodeError::TRUNCATED;
+  }
+  auto streamId = cur.readBE<int32_t>();
+  if (streamId < 0) {
+    return DecodeError::INVALID_STREAM_ID;
+  }
+  header.streamId = static_cast<rsocket::StreamId>(streamId);
+  uint16_t type = cur.readBE<uint8_t>(); // |Frame Type |I|M|
+  header.type = deserializeFrameType(type >> 2);
+  header.flags =
+      static_cast<FrameFlags>(((type & 0x3) << 8) | cur.readBE<uint8_t>());
+  return DecodeError::NONE;
+}
+
+static DecodeError tryDeserializeMetadataFrom(
+    folly::io::Cursor& cur,
+    FrameFlags flags,
+    std::unique_ptr<folly::IOBuf>& metadata) {
+  metadata = nullptr;
+  if (!(flags & FrameFlags::METADATA)) {
+    return DecodeError::NONE;
+  }
+  if (!cur.canAdvance(kMedatadaLengthSize)) {
+    return DecodeError::TRUNCATED;
+  }
+
+  uint32_t metadataLength = 0;
+  metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 16);
+  metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 8);
+  metadataLength |= cur.read<uint8_t>();
+
+  if (!cur.canAdvance(metadataLength)) {
+    return DecodeError::TRUNCATED;
+  }
+  cur.clone(metadata, metadataLength);
+  return DecodeError::NONE;
+}
+
+static std::unique_ptr<folly::IOBuf> cloneRemainingFrom(
+    folly::io::Cursor& cur) {
+  std::unique_ptr<folly::IOBuf> data;
+  auto totalLength = cur.totalLength();
+
+  if (totalLength > 0) {
+    cur.clone(data, totalLength);
+  }
+  return data;
+}
+
+static DecodeError tryDeserializePayloadFrom(
+    folly::io::Cursor& cur,
+    FrameFlags flags,
+    rsocket::Payload& payload) {
+  std::unique_ptr<folly::IOBuf> metadata;
+  auto error = tryDeserializeMetadataFrom(cur, flags, metadata);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  payload = rsocket::Payload(cloneRemainingFrom(cur), std::move(metadata));
+  return DecodeError::NONE;
+}
+
+static DecodeError tryDeserializeResumeTokenFrom(
+    folly::io::Cursor& cur,
+    rsocket::ResumeIdentificationToken& token) {
+  uint16_t resumeTokenSize;
+  if (!cur.tryReadBE(resumeTokenSize) || !cur.canAdvance(resumeTokenSize)) {
+    return DecodeError::TRUNCATED;
+  }
+  std::vector<uint8_t> data(resumeTokenSize);
+  cur.pull(data.data(), data.size());
+  token.set(std::move(data));
+  return DecodeError::NONE;
+}
+
+static DecodeError tryDeserializeMimeTypeFrom(
+    folly::io::Cursor& cur,
+    std::string& mimeType) {
+  uint8_t length;
+  if (!cur.tryReadBE(length) || !cur.canAdvance(length)) {
+    return DecodeError::TRUNCATED;
+  }
+  mimeType = cur.readFixedString(length);
+  return DecodeError::NONE;
+}
+
+static DecodeError tryDeserializePositionFrom(
+    folly::io::Cursor& cur,
+    rsocket::ResumePosition& position) {
+  int64_t value;
+  if (!cur.tryReadBE(value)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (value < 0) {
+    return DecodeError::INVALID_POSITION;
+  }
+  position = static_cast<rsocket::ResumePosition>(value);
+  return DecodeError::NONE;
+}
+
+static DecodeError tryDeserializeFromInternal(
+    Frame_REQUEST_Base& frame,
+    std::unique_ptr<folly::IOBuf> in) {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  int32_t requestN;
+  if (!cur.tryReadBE(requestN)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (requestN <= 0) {
+    return DecodeError::INVALID_REQUEST_N;
+  }
+  frame.requestN_ = static_cast<uint32_t>(requestN);
+  return tryDeserializePayloadFrom(cur, frame.header_.flags, frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_REQUEST_STREAM& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  auto error = tryDeserializeFromInternal(frame, std::move(in));
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decodePayload(frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_REQUEST_CHANNEL& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  auto error = tryDeserializeFromInternal(frame, std::move(in));
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decodePayload(frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_REQUEST_RESPONSE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  error = tryDeserializePayloadFrom(cur, frame.header_.flags, frame.payload_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decodePayload(frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_REQUEST_FNF& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  error = tryDeserializePayloadFrom(cur, frame.header_.flags, frame.payload_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decodePayload(frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_REQUEST_N& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  int32_t requestN;
+  if (!cur.tryReadBE(requestN)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (requestN <= 0) {
+    return DecodeError::INVALID_REQUEST_N;
+  }
+  frame.requestN_ = static_cast<uint32_t>(requestN);
+  return DecodeError::NONE;
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_METADATA_PUSH& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  // metadata takes the rest of the frame, just like data in other frames
+  frame.metadata_ = cloneRemainingFrom(cur);
+  return frame.metadata_ ? DecodeError::NONE : DecodeError::MISSING_METADATA;
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_CANCEL& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  return tryDeserializeHeaderFrom(cur, frame.header_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_PAYLOAD& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  error = tryDeserializePayloadFrom(cur, frame.header_.flags, frame.payload_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decodePayload(frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_ERROR& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  uint32_t errorCode;
+  if (!cur.tryReadBE(errorCode)) {
+    return DecodeError::TRUNCATED;
+  }
+  frame.errorCode_ = static_cast<ErrorCode>(errorCode);
+  return tryDeserializePayloadFrom(cur, frame.header_.flags, frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_KEEPALIVE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  error = tryDeserializePositionFrom(cur, frame.position_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  frame.data_ = cloneRemainingFrom(cur);
+  return DecodeError::NONE;
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_SETUP& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  if (!cur.tryReadBE(frame.versionMajor_) ||
+      !cur.tryReadBE(frame.versionMinor_)) {
+    return DecodeError::TRUNCATED;
+  }
+
+  int32_t keepaliveTime;
+  if (!cur.tryReadBE(keepaliveTime)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (keepaliveTime <= 0) {
+    return DecodeError::INVALID_KEEPALIVE_TIME;
+  }
+  frame.keepaliveTime_ = static_cast<uint32_t>(keepaliveTime);
+
+  int32_t maxLifetime;
+  if (!cur.tryReadBE(maxLifetime)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (maxLifetime <= 0) {
+    return DecodeError::INVALID_MAX_LIFETIME;
+  }
+  frame.maxLifetime_ = static_cast<uint32_t>(maxLifetime);
+
+  if (!!(frame.header_.flags & FrameFlags::RESUME_ENABLE)) {
+    error = tryDeserializeResumeTokenFrom(cur, frame.token_);
+    if (error != DecodeError::NONE) {
+      return error;
+    }
+  } else {
+    frame.token_ = rsocket::ResumeIdentificationToken();
+  }
+
+  error = tryDeserializeMimeTypeFrom(cur, frame.metadataMimeType_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  error = tryDeserializeMimeTypeFrom(cur, frame.dataMimeType_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return tryDeserializePayloadFrom(cur, frame.header_.flags, frame.payload_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_LEASE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  int32_t ttl;
+  if (!cur.tryReadBE(ttl)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (ttl <= 0) {
+    return DecodeError::INVALID_TTL;
+  }
+  frame.ttl_ = static_cast<uint32_t>(ttl);
+
+  int32_t numberOfRequests;
+  if (!cur.tryReadBE(numberOfRequests)) {
+    return DecodeError::TRUNCATED;
+  }
+  if (numberOfRequests <= 0) {
+    return DecodeError::INVALID_NUMBER_OF_REQUESTS;
+  }
+  frame.numberOfRequests_ = static_cast<uint32_t>(numberOfRequests);
+  frame.metadata_ = cloneRemainingFrom(cur);
+  return DecodeError::NONE;
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_RESUME& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  if (!cur.tryReadBE(frame.versionMajor_) ||
+      !cur.tryReadBE(frame.versionMinor_)) {
+    return DecodeError::TRUNCATED;
+  }
+  error = tryDeserializeResumeTokenFrom(cur, frame.token_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  error = tryDeserializePositionFrom(cur, frame.lastReceivedServerPosition_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return tryDeserializePositionFrom(cur, frame.clientPosition_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    Frame_RESUME_OK& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  auto error = tryDeserializeHeaderFrom(cur, frame.header_);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return tryDeserializePositionFrom(cur, frame.position_);
+}
+
+DecodeError FrameSerializerV1_0::decodeFrame(
+    LazyFrame& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  folly::io::Cursor cur(in.get());
+  FrameHeader header;
+  auto error = tryDeserializeHeaderFrom(cur, header);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+
+  size_t offset = kFrameHeaderSize;
+  uint32_t requestN = 0;
+  switch (header.type) {
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL: {
+      int32_t value;
+      if (!cur.tryReadBE(value)) {
+        return DecodeError::TRUNCATED;
+      }
+      if (value <= 0) {
+        return DecodeError::INVALID_REQUEST_N;
+      }
+      requestN = static_cast<uint32_t>(value);
+      offset += sizeof(int32_t);
+      break;
+    }
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_FNF:
+    case FrameType::PAYLOAD:
+      break;
+    default:
+      return DecodeError::UNEXPECTED_FRAME_TYPE;
+  }
+
+  uint32_t metadataLength = 0;
+  if (!!(header.flags & FrameFlags::METADATA)) {
+    if (!cur.canAdvance(kMedatadaLengthSize)) {
+      return DecodeError::TRUNCATED;
+    }
+    metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 16);
+    metadataLength |= static_cast<uint32_t>(cur.read<uint8_t>() << 8);
+    metadataLength |= cur.read<uint8_t>();
+    if (!cur.canAdvance(metadataLength)) {
+      return DecodeError::TRUNCATED;
+    }
+    offset += kMedatadaLengthSize;
+  }
+
+  frame = LazyFrame(header, requestN, std::move(in), offset, metadataLength);
+  return decodeRoutingHeader(frame);
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_REQUEST_STREAM& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_STREAM, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_REQUEST_CHANNEL& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_CHANNEL, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_REQUEST_RESPONSE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_RESPONSE, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_REQUEST_FNF& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_FNF, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_REQUEST_N& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::REQUEST_N, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_METADATA_PUSH& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::METADATA_PUSH, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_CANCEL& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::CANCEL, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_PAYLOAD& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::PAYLOAD, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_ERROR& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::ERROR, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_KEEPALIVE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::KEEPALIVE, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_SETUP& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::SETUP, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_LEASE& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::LEASE, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_RESUME& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::RESUME, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    Frame_RESUME_OK& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  return recordDecode(FrameType::RESUME_OK, frame.header_, in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
+DecodeError FrameSerializerV1_0::tryDeserializeFrom(
+    LazyFrame& frame,
+    std::unique_ptr<folly::IOBuf> in) const {
+  // The frame type is only known from the frame, don't peek for nothing.
+  if ((!stats() && !recorder()) || !in) {
+    return decodeFrame(frame, std::move(in));
+  }
+  return recordDecode(peekFrameType(*in), frame.header(), in, [&] {
+    return decodeFrame(frame, std::move(in));
+  });
+}
+
 ProtocolVersion FrameSerializerV1_0::detectProtocolVersion(
     const folly::IOBuf& firstFrame,
     size_t skipBytes) {
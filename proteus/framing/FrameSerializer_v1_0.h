@@ -57,6 +57,21 @@ class FrameSerializerV1_0 : public FrameSerializer {
   std::unique_ptr<folly::IOBuf> serializeOut(Frame_RESUME&&) const override;
   std::unique_ptr<folly::IOBuf> serializeOut(Frame_RESUME_OK&&) const override;
 
+  void serializeOut(FrameBatch&, Frame_REQUEST_STREAM&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_CHANNEL&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_RESPONSE&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_FNF&&) const override;
+  void serializeOut(FrameBatch&, Frame_REQUEST_N&&) const override;
+  void serializeOut(FrameBatch&, Frame_METADATA_PUSH&&) const override;
+  void serializeOut(FrameBatch&, Frame_CANCEL&&) const override;
+  void serializeOut(FrameBatch&, Frame_PAYLOAD&&) const override;
+  void serializeOut(FrameBatch&, Frame_ERROR&&) const override;
+  void serializeOut(FrameBatch&, Frame_KEEPALIVE&&) const override;
+  void serializeOut(FrameBatch&, Frame_SETUP&&) const override;
+  void serializeOut(FrameBatch&, Frame_LEASE&&) const override;
+  void serializeOut(FrameBatch&, Frame_RESUME&&) const override;
+  void serializeOut(FrameBatch&, Frame_RESUME_OK&&) const override;
+
   /*
   bool deserializeFrom(Frame_REQUEST_STREAM&, std::unique_ptr<folly::IOBuf>)
       const override;
@@ -88,6 +103,45 @@ class FrameSerializerV1_0 : public FrameSerializer {
       const override;
   */
 
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_STREAM&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_CHANNEL&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_RESPONSE&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_FNF&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_REQUEST_N&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(
+      Frame_METADATA_PUSH&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(Frame_CANCEL&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_PAYLOAD&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_ERROR&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(
+      Frame_KEEPALIVE&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(Frame_SETUP&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_LEASE&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(Frame_RESUME&, std::unique_ptr<folly::IOBuf>)
+      const override;
+  DecodeError tryDeserializeFrom(
+      Frame_RESUME_OK&,
+      std::unique_ptr<folly::IOBuf>) const override;
+  DecodeError tryDeserializeFrom(LazyFrame&, std::unique_ptr<folly::IOBuf>)
+      const override;
+
   /*
   static std::unique_ptr<folly::IOBuf> deserializeMetadataFrom(
       folly::io::Cursor& cur,
@@ -97,6 +151,72 @@ class FrameSerializerV1_0 : public FrameSerializer {
  private:
   std::unique_ptr<folly::IOBuf> serializeOutInternal(
       Frame_REQUEST_Base&& frame) const;
+  void serializeOutInternal(FrameBatch& batch, Frame_REQUEST_Base&& frame)
+      const;
+
+ protected:
+  // The encoding and decoding proper, see the overrides. Also used by
+  // FrameSerializerCompact, which re-encodes their frame headers.
+  void encodeFrame(FrameBatch&, Frame_REQUEST_STREAM&&) const;
+  void encodeFrame(FrameBatch&, Frame_REQUEST_CHANNEL&&) const;
+  void encodeFrame(FrameBatch&, Frame_REQUEST_RESPONSE&&) const;
+  void encodeFrame(FrameBatch&, Frame_REQUEST_FNF&&) const;
+  void encodeFrame(FrameBatch&, Frame_REQUEST_N&&) const;
+  void encodeFrame(FrameBatch&, Frame_METADATA_PUSH&&) const;
+  void encodeFrame(FrameBatch&, Frame_CANCEL&&) const;
+  void encodeFrame(FrameBatch&, Frame_PAYLOAD&&) const;
+  void encodeFrame(FrameBatch&, Frame_ERROR&&) const;
+  void encodeFrame(FrameBatch&, Frame_KEEPALIVE&&) const;
+  void encodeFrame(FrameBatch&, Frame_SETUP&&) const;
+  void encodeFrame(FrameBatch&, Frame_LEASE&&) const;
+  void encodeFrame(FrameBatch&, Frame_RESUME&&) const;
+  void encodeFrame(FrameBatch&, Frame_RESUME_OK&&) const;
+
+  DecodeError decodeFrame(
+      Frame_REQUEST_STREAM&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_REQUEST_CHANNEL&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_REQUEST_RESPONSE&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_REQUEST_FNF&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_REQUEST_N&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_METADATA_PUSH&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_CANCEL&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_PAYLOAD&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_ERROR&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_KEEPALIVE&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_SETUP&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_LEASE&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_RESUME&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      Frame_RESUME_OK&,
+      std::unique_ptr<folly::IOBuf>) const;
+  DecodeError decodeFrame(
+      LazyFrame&,
+      std::unique_ptr<folly::IOBuf>) const;
 
   size_t frameLengthFieldSize() const override;
 };
@@ -0,0 +1,111 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameSplitter.h"
+
+#include <folly/Bits.h>
+#include <folly/io/Cursor.h>
+
+namespace proteus {
+
+constexpr size_t FrameSplitter::kFrameLengthFieldSize;
+
+namespace {
+
+uint32_t loadFrameLength(const uint8_t* data, size_t available) {
+  if (available >= sizeof(uint32_t)) {
+    // a single unaligned word load, the fourth byte is shifted out
+    return folly::Endian::big(folly::loadUnaligned<uint32_t>(data)) >> 8;
+  }
+  return static_cast<uint32_t>(data[0]) << 16 |
+      static_cast<uint32_t>(data[1]) << 8 | data[2];
+}
+
+} // namespace
+
+size_t FrameSplitter::scan(
+    folly::ByteRange in,
+    std::vector<folly::ByteRange>& frames) {
+  const auto* const begin = in.begin();
+  const auto* const end = in.end();
+  const auto* pos = begin;
+
+  while (static_cast<size_t>(end - pos) >= kFrameLengthFieldSize) {
+    const auto available = static_cast<size_t>(end - pos);
+    const auto length = loadFrameLength(pos, available);
+    if (available - kFrameLengthFieldSize < length) {
+      break;
+    }
+    frames.emplace_back(pos + kFrameLengthFieldSize, length);
+    pos += kFrameLengthFieldSize + length;
+  }
+  return static_cast<size_t>(pos - begin);
+}
+
+void FrameSplitter::append(std::unique_ptr<folly::IOBuf> buf) {
+  queue_.append(std::move(buf));
+}
+
+size_t FrameSplitter::split(
+    std::vector<std::unique_ptr<folly::IOBuf>>& frames) {
+  const auto initialSize = frames.size();
+
+  while (!queue_.empty()) {
+    const auto* head = queue_.front();
+    ranges_.clear();
+    const auto consumed =
+        scan(folly::ByteRange(head->data(), head->length()), ranges_);
+
+    for (auto range : ranges_) {
+      auto frame = head->cloneOne();
+      frame->trimStart(range.begin() - head->data());
+      frame->trimEnd(head->tail() - range.end());
+      frames.push_back(std::move(frame));
+    }
+
+    if (consumed > 0) {
+      queue_.trimStart(consumed);
+      continue;
+    }
+
+    // The head buffer ends with a partial frame.
+    auto frame = splitSlow();
+    if (!frame) {
+      break;
+    }
+    frames.push_back(std::move(frame));
+  }
+
+  return frames.size() - initialSize;
+}
+
+std::unique_ptr<folly::IOBuf> FrameSplitter::splitSlow() {
+  if (queue_.chainLength() < kFrameLengthFieldSize) {
+    return nullptr;
+  }
+
+  folly::io::Cursor cur(queue_.front());
+  uint32_t length = 0;
+  length |= static_cast<uint32_t>(cur.read<uint8_t>() << 16);
+  length |= static_cast<uint32_t>(cur.read<uint8_t>() << 8);
+  length |= cur.read<uint8_t>();
+
+  if (queue_.chainLength() < kFrameLengthFieldSize + length) {
+    return nullptr;
+  }
+  queue_.trimStart(kFrameLengthFieldSize);
+  return queue_.split(length);
+}
+
+} // namespace proteus
@@ -0,0 +1,68 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+
+namespace proteus {
+
+/// Incrementally splits a byte stream of frames, each prefixed with its
+/// 24-bit big endian length, into separate frames.
+///
+/// Bytes are appended as they are read from the transport. split() then
+/// returns every complete frame received so far as an IOBuf sharing the
+/// read buffer, and keeps a trailing partial frame until the rest of it
+/// arrives.
+///
+/// Frame boundaries inside a read buffer are found by a single pass over it
+/// with direct loads, frames spanning read buffers take the slower path.
+class FrameSplitter {
+ public:
+  static constexpr size_t kFrameLengthFieldSize = 3; // bytes
+
+  /// Finds the complete frames at the start of `in` and appends their
+  /// bodies, without the length field, to `frames`. Returns the number of
+  /// bytes they take, including their length fields.
+  static size_t scan(
+      folly::ByteRange in,
+      std::vector<folly::ByteRange>& frames);
+
+  void append(std::unique_ptr<folly::IOBuf> buf);
+
+  /// Moves all complete frames to `frames`, in order. Returns how many
+  /// were added.
+  size_t split(std::vector<std::unique_ptr<folly::IOBuf>>& frames);
+
+  /// Bytes of incomplete frames kept for the next split().
+  size_t pendingBytes() const {
+    return queue_.chainLength();
+  }
+
+ private:
+  // Extracts one frame from the front of the queue, reading its length
+  // across buffers. Returns nullptr if the frame isn't complete yet.
+  std::unique_ptr<folly::IOBuf> splitSlow();
+
+  folly::IOBufQueue queue_{folly::IOBufQueue::cacheChainLength()};
+  // Reused between calls to scan the head buffer.
+  std::vector<folly::ByteRange> ranges_;
+};
+
+} // namespace proteus
@@ -0,0 +1,172 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <folly/Bits.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t FrameStats::kFrameTypes;
+constexpr size_t FrameStats::kLatencyBuckets;
+
+static_assert(
+    static_cast<size_t>(FrameType::SHARD) < FrameStats::kFrameTypes,
+    "every frame type needs counters of its own");
+
+namespace {
+
+// Shards have a single writer, a plain load and store is enough.
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+  counter.store(
+      counter.load(std::memory_order_relaxed) + value,
+      std::memory_order_relaxed);
+}
+
+uint64_t load(const std::atomic<uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+std::chrono::nanoseconds FrameStats::Counters::latencyQuantile(
+    double quantile) const {
+  uint64_t total = 0;
+  for (auto count : latency) {
+    total += count;
+  }
+  if (total == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  const auto rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(quantile * total)));
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+    seen += latency[bucket];
+    if (seen >= rank) {
+      return latencyBucketLimit(bucket);
+    }
+  }
+  return latencyBucketLimit(kLatencyBuckets - 1);
+}
+
+FrameStats::Counters& FrameStats::Counters::operator+=(const Counters& other) {
+  frames += other.frames;
+  bytes += other.bytes;
+  failures += other.failures;
+  for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+    latency[bucket] += other.latency[bucket];
+  }
+  return *this;
+}
+
+FrameStats::FrameStats()
+    : shards_([this] { return new folly::CachelinePadded<Shard>(*this); }) {}
+
+FrameStats::~FrameStats() = default;
+
+void FrameStats::recordEncode(
+    FrameType type,
+    size_t bytes,
+    Clock::duration elapsed) {
+  shards_->get()->record(true, type, bytes, false, elapsed);
+}
+
+void FrameStats::recordDecode(
+    FrameType type,
+    size_t bytes,
+    DecodeError error,
+    Clock::duration elapsed) {
+  shards_->get()->record(
+      false, type, bytes, error != DecodeError::NONE, elapsed);
+}
+
+FrameStats::Snapshot FrameStats::snapshot() const {
+  // Holding the accessor keeps threads from retiring their shard meanwhile,
+  // so no shard is counted twice or missed.
+  auto accessor = shards_.accessAllThreads();
+  Snapshot snapshot;
+  {
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    snapshot = retired_;
+  }
+  for (const auto& shard : accessor) {
+    shard.get()->addTo(snapshot);
+  }
+  return snapshot;
+}
+
+size_t FrameStats::latencyBucket(Clock::duration elapsed) {
+  const auto nanos =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  if (nanos < 128) {
+    return 0;
+  }
+  const auto bucket = folly::findLastSet(static_cast<uint64_t>(nanos)) - 7;
+  return std::min<size_t>(bucket, kLatencyBuckets - 1);
+}
+
+std::chrono::nanoseconds FrameStats::latencyBucketLimit(size_t bucket) {
+  DCHECK_LT(bucket, kLatencyBuckets);
+  if (bucket + 1 >= kLatencyBuckets) {
+    return std::chrono::nanoseconds::max();
+  }
+  return std::chrono::nanoseconds(int64_t{1} << (7 + bucket));
+}
+
+void FrameStats::retire(const Shard& shard) {
+  std::lock_guard<std::mutex> lock(retiredMutex_);
+  shard.addTo(retired_);
+}
+
+FrameStats::Shard::~Shard() {
+  parent_.retire(*this);
+}
+
+void FrameStats::Shard::record(
+    bool encode,
+    FrameType type,
+    size_t bytes,
+    bool failed,
+    Clock::duration elapsed) {
+  auto& counters = (encode ? encodes_ : decodes_)[index(type)];
+  add(counters.frames, 1);
+  add(counters.bytes, bytes);
+  if (failed) {
+    add(counters.failures, 1);
+  }
+  add(counters.latency[latencyBucket(elapsed)], 1);
+}
+
+void FrameStats::Shard::addTo(Snapshot& snapshot) const {
+  auto addCounters = [](const LiveCounters& from, Counters& to) {
+    to.frames += load(from.frames);
+    to.bytes += load(from.bytes);
+    to.failures += load(from.failures);
+    for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+      to.latency[bucket] += load(from.latency[bucket]);
+    }
+  };
+  for (size_t type = 0; type < kFrameTypes; ++type) {
+    addCounters(encodes_[type], snapshot.encodes[type]);
+    addCounters(decodes_[type], snapshot.decodes[type]);
+  }
+}
+
+} // namespace proteus
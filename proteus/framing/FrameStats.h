@@ -0,0 +1,147 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <folly/CachelinePadded.h>
+#include <folly/ThreadLocal.h>
+
+#include "proteus/framing/DecodeError.h"
+#include "proteus/framing/FrameType.h"
+
+namespace proteus {
+
+/// Frames, bytes and failures per FrameType for encode and decode, and
+/// histograms of the time each took, recorded by the serializers the stats
+/// are attached to (see FrameSerializer::setStats()).
+///
+/// Every thread records into its own cache line padded shard without
+/// atomic read-modify-writes, snapshot() sums the shards. Reading is
+/// therefore the expensive side and is meant to be rare, e.g. once per
+/// export interval. A FrameStats is typically shared by every connection
+/// of a process: each one costs a shard per thread that records into it.
+class FrameStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// RSocket frame types take 6 bits on the wire, broker frame types the
+  /// values above them (see FrameType.h).
+  static constexpr size_t kFrameTypes = 128;
+
+  /// Times are counted in power of two buckets: the first holds times below
+  /// 128ns, bucket i those in [2^(6 + i), 2^(7 + i)) ns and the last one
+  /// everything from 2^25ns (~34ms) up.
+  static constexpr size_t kLatencyBuckets = 20;
+
+  struct Counters {
+    /// Every frame, whether it could be decoded or not.
+    uint64_t frames{0};
+    uint64_t bytes{0};
+    /// Frames that failed to decode. Encoding doesn't fail.
+    uint64_t failures{0};
+    std::array<uint64_t, kLatencyBuckets> latency{};
+
+    /// Upper bound of the bucket holding the `quantile` (0 to 1) of the
+    /// recorded times, zero if nothing was recorded.
+    std::chrono::nanoseconds latencyQuantile(double quantile) const;
+
+    Counters& operator+=(const Counters& other);
+  };
+
+  struct Snapshot {
+    const Counters& encoded(FrameType type) const {
+      return encodes[index(type)];
+    }
+    const Counters& decoded(FrameType type) const {
+      return decodes[index(type)];
+    }
+
+    /// Indexed by the value of the FrameType.
+    std::array<Counters, kFrameTypes> encodes;
+    std::array<Counters, kFrameTypes> decodes;
+  };
+
+  FrameStats();
+  ~FrameStats();
+
+  FrameStats(const FrameStats&) = delete;
+  FrameStats& operator=(const FrameStats&) = delete;
+
+  void recordEncode(FrameType type, size_t bytes, Clock::duration elapsed);
+  void recordDecode(
+      FrameType type,
+      size_t bytes,
+      DecodeError error,
+      Clock::duration elapsed);
+
+  /// Sums the shards of every thread, including threads that have exited
+  /// since. Counts recorded concurrently may or may not be included.
+  Snapshot snapshot() const;
+
+  static size_t latencyBucket(Clock::duration elapsed);
+
+  /// Exclusive upper bound of `bucket`, nanoseconds::max() for the last.
+  static std::chrono::nanoseconds latencyBucketLimit(size_t bucket);
+
+ private:
+  static size_t index(FrameType type) {
+    return static_cast<uint8_t>(type);
+  }
+
+  // Written by its thread only, read by snapshot().
+  class Shard {
+   public:
+    explicit Shard(FrameStats& parent) : parent_(parent) {}
+    ~Shard();
+
+    void record(
+        bool encode,
+        FrameType type,
+        size_t bytes,
+        bool failed,
+        Clock::duration elapsed);
+    void addTo(Snapshot& snapshot) const;
+
+   private:
+    struct LiveCounters {
+      std::atomic<uint64_t> frames{0};
+      std::atomic<uint64_t> bytes{0};
+      std::atomic<uint64_t> failures{0};
+      std::array<std::atomic<uint64_t>, kLatencyBuckets> latency{};
+    };
+
+    FrameStats& parent_;
+    std::array<LiveCounters, kFrameTypes> encodes_;
+    std::array<LiveCounters, kFrameTypes> decodes_;
+  };
+
+  struct ShardTag {};
+
+  // Folds the shard of an exiting thread into retired_.
+  void retire(const Shard& shard);
+
+  mutable std::mutex retiredMutex_;
+  Snapshot retired_;
+  // Declared last, shards retire into the members above as it is destroyed.
+  folly::ThreadLocal<folly::CachelinePadded<Shard>, ShardTag> shards_;
+};
+
+} // namespace proteus
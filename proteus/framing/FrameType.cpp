@@ -20,24 +20,42 @@
 
 namespace proteus {
 
-// parameterized constructor????
-FrameType::FrameType()
-
-int getEncodedType()
-{
-  return id;
-}
-
-int getHasDestination()
-{
-  return hasDestination;
-
-}
-
 constexpr folly::StringPiece kUnknown{"UNKNOWN_FRAME_TYPE"};
 
 folly::StringPiece toString(FrameType type) {
   switch (type) {
+    case FrameType::RESERVED:
+      return "RESERVED";
+    case FrameType::SETUP:
+      return "SETUP";
+    case FrameType::LEASE:
+      return "LEASE";
+    case FrameType::KEEPALIVE:
+      return "KEEPALIVE";
+    case FrameType::REQUEST_RESPONSE:
+      return "REQUEST_RESPONSE";
+    case FrameType::REQUEST_FNF:
+      return "REQUEST_FNF";
+    case FrameType::REQUEST_STREAM:
+      return "REQUEST_STREAM";
+    case FrameType::REQUEST_CHANNEL:
+      return "REQUEST_CHANNEL";
+    case FrameType::REQUEST_N:
+      return "REQUEST_N";
+    case FrameType::CANCEL:
+      return "CANCEL";
+    case FrameType::PAYLOAD:
+      return "PAYLOAD";
+    case FrameType::ERROR:
+      return "ERROR";
+    case FrameType::METADATA_PUSH:
+      return "METADATA_PUSH";
+    case FrameType::RESUME:
+      return "RESUME";
+    case FrameType::RESUME_OK:
+      return "RESUME_OK";
+    case FrameType::EXT:
+      return "EXT";
     case FrameType::UNDEFINED:
       return "UNDEFINED";
     case FrameType::BROKER_SETUP:
@@ -55,7 +73,6 @@ folly::StringPiece toString(FrameType type) {
     default:
       DLOG(FATAL) << "Unknown frame type";
       return kUnknown;
-
   }
 }
 
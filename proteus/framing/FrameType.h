@@ -21,15 +21,11 @@
 
 namespace proteus {
 
+/// RSocket frame types keep their 6 bit wire value. Broker frame types sit
+/// above them, at kBrokerFrameTypeBase plus their 16 bit wire value, so the
+/// two families never collide; see toBrokerWireType() and
+/// fromBrokerWireType().
 enum class FrameType : uint8_t {
-  UNDEFINED = 0x00,
-  BROKER_SETUP = 0x01,
-  DESTINATION_SETUP = 0x02,
-  DESTINATION = 0x03,
-  GROUP = 0x04;
-  BROADCAST = 0x05,
-  SHARD = 0x06,
-  /*
   RESERVED = 0x00,
   SETUP = 0x01,
   LEASE = 0x02,
@@ -46,9 +42,33 @@ enum class FrameType : uint8_t {
   RESUME = 0x0D,
   RESUME_OK = 0x0E,
   EXT = 0x3F,
-  */
+
+  UNDEFINED = 0x40,
+  BROKER_SETUP = 0x41,
+  DESTINATION_SETUP = 0x42,
+  DESTINATION = 0x43,
+  GROUP = 0x44,
+  BROADCAST = 0x45,
+  SHARD = 0x46,
 };
 
+constexpr uint8_t kBrokerFrameTypeBase = 0x40;
+
+/// Wire value of a broker frame type.
+inline uint16_t toBrokerWireType(FrameType type) {
+  return static_cast<uint8_t>(type) - kBrokerFrameTypeBase;
+}
+
+/// Broker frame type of a wire value, UNDEFINED for values that don't name
+/// one, including anything that doesn't fit in a byte.
+inline FrameType fromBrokerWireType(uint16_t wire) {
+  if (wire < toBrokerWireType(FrameType::BROKER_SETUP) ||
+      wire > toBrokerWireType(FrameType::SHARD)) {
+    return FrameType::UNDEFINED;
+  }
+  return static_cast<FrameType>(kBrokerFrameTypeBase + wire);
+}
+
 folly::StringPiece toString(FrameType);
 
 std::ostream& operator<<(std::ostream&, FrameType);
@@ -0,0 +1,224 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/LazyFrame.h"
+
+#include <cstring>
+#include <ostream>
+
+#include <folly/Bits.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+namespace {
+constexpr const size_t kStreamIdSize = 4; // bytes
+constexpr const size_t kMetadataLengthSize = 3; // bytes
+constexpr const size_t kMaxMetadataLength = 0xFFFFFF; // 24bit max value
+
+// Left in front of a copied head buffer, for the frame length field and for
+// later rewrites that grow the header.
+constexpr const size_t kRewriteHeadroom = 16; // bytes
+} // namespace
+
+LazyFrame::LazyFrame(
+    FrameHeader header,
+    uint32_t requestN,
+    std::unique_ptr<folly::IOBuf> buffer,
+    size_t metadataOffset,
+    size_t metadataLength)
+    : header_(header),
+      requestN_(requestN),
+      buffer_(std::move(buffer)),
+      frameLength_(buffer_->computeChainDataLength()),
+      metadataOffset_(metadataOffset),
+      metadataLength_(metadataLength) {
+  DCHECK_LE(metadataOffset_ + metadataLength_, frameLength_);
+}
+
+folly::Optional<folly::ByteRange> LazyFrame::metadataRange() const {
+  if (!buffer_ || buffer_->length() < metadataOffset_ + metadataLength_) {
+    return folly::none;
+  }
+  return folly::ByteRange(buffer_->data() + metadataOffset_, metadataLength_);
+}
+
+std::unique_ptr<folly::IOBuf> LazyFrame::cloneMetadata() const {
+  if (!hasMetadata()) {
+    return nullptr;
+  }
+  if (metadataLength_ == 0) {
+    // the METADATA flag is set, so the payload has (empty) metadata
+    return folly::IOBuf::create(0);
+  }
+  return clone(metadataOffset_, metadataLength_);
+}
+
+std::unique_ptr<folly::IOBuf> LazyFrame::cloneData() const {
+  return clone(metadataOffset_ + metadataLength_, dataLength());
+}
+
+rsocket::Payload LazyFrame::clonePayload() const {
+  return rsocket::Payload(cloneData(), cloneMetadata());
+}
+
+LazyFrame LazyFrame::clone() const {
+  DCHECK(buffer_);
+  return LazyFrame(
+      header_, requestN_, buffer_->clone(), metadataOffset_, metadataLength_);
+}
+
+void LazyFrame::setStreamId(rsocket::StreamId streamId) {
+  DCHECK(buffer_);
+  makeHeadWritable(kStreamIdSize, 0);
+  folly::storeUnaligned(
+      buffer_->writableData(),
+      folly::Endian::big(static_cast<uint32_t>(streamId)));
+  header_.streamId = streamId;
+}
+
+void LazyFrame::replaceMetadataPrefix(
+    size_t length,
+    folly::ByteRange replacement) {
+  DCHECK(buffer_);
+  DCHECK(hasMetadata());
+  DCHECK_LE(length, metadataLength_);
+  const auto newLength = replacement.size();
+  const auto newMetadataLength = metadataLength_ - length + newLength;
+  DCHECK_LE(newMetadataLength, kMaxMetadataLength);
+
+  const auto grow = newLength > length ? newLength - length : 0;
+  makeHeadWritable(metadataOffset_ + length, grow);
+
+  // Move the frame header over the space freed up, or into the headroom
+  // taken up, so the bytes after the prefix stay where they are.
+  if (newLength < length) {
+    const auto shrink = length - newLength;
+    auto* data = buffer_->writableData();
+    std::memmove(data + shrink, data, metadataOffset_);
+    buffer_->trimStart(shrink);
+  } else if (grow > 0) {
+    buffer_->prepend(grow);
+    auto* data = buffer_->writableData();
+    std::memmove(data, data + grow, metadataOffset_);
+  }
+
+  auto* metadata = buffer_->writableData() + metadataOffset_;
+  std::memcpy(metadata, replacement.data(), newLength);
+  auto* lengthField = metadata - kMetadataLengthSize;
+  lengthField[0] = static_cast<uint8_t>(newMetadataLength >> 16);
+  lengthField[1] = static_cast<uint8_t>(newMetadataLength >> 8);
+  lengthField[2] = static_cast<uint8_t>(newMetadataLength);
+
+  frameLength_ = frameLength_ - metadataLength_ + newMetadataLength;
+  metadataLength_ = newMetadataLength;
+}
+
+void LazyFrame::replacePayload(rsocket::Payload payload) {
+  DCHECK(buffer_);
+  const auto prefix =
+      metadataOffset_ - (hasMetadata() ? kMetadataLengthSize : 0);
+  const auto metadataLength =
+      payload.metadata ? payload.metadata->computeChainDataLength() : 0;
+  // The metadata is copied into the head buffer, where metadataRange()
+  // finds it.
+  auto head = folly::IOBuf::create(
+      kRewriteHeadroom + prefix + kMetadataLengthSize + metadataLength);
+  head->advance(kRewriteHeadroom);
+  folly::io::Cursor cur(buffer_.get());
+  cur.pull(head->writableData(), prefix);
+  head->append(prefix);
+
+  if (payload.metadata) {
+    header_.flags |= FrameFlags::METADATA;
+    metadataLength_ = metadataLength;
+    DCHECK_LE(metadataLength_, kMaxMetadataLength);
+    auto* lengthField = head->writableTail();
+    lengthField[0] = static_cast<uint8_t>(metadataLength_ >> 16);
+    lengthField[1] = static_cast<uint8_t>(metadataLength_ >> 8);
+    lengthField[2] = static_cast<uint8_t>(metadataLength_);
+    head->append(kMetadataLengthSize);
+  } else {
+    header_.flags &= ~FrameFlags::METADATA;
+    metadataLength_ = 0;
+  }
+  // The flags are the low 10 bits of the 16 behind the stream ID.
+  auto* typeAndFlags = head->writableData() + kStreamIdSize;
+  typeAndFlags[0] = static_cast<uint8_t>(
+      (typeAndFlags[0] & ~(raw(FrameFlags::METADATA) >> 8)) |
+      (raw(header_.flags & FrameFlags::METADATA) >> 8));
+  metadataOffset_ = head->length();
+  if (payload.metadata) {
+    folly::io::Cursor(payload.metadata.get())
+        .pull(head->writableTail(), metadataLength);
+    head->append(metadataLength);
+  }
+
+  folly::IOBufQueue frame(folly::IOBufQueue::cacheChainLength());
+  frame.append(std::move(head));
+  if (payload.data) {
+    frame.append(std::move(payload.data));
+  }
+  frameLength_ = frame.chainLength();
+  buffer_ = frame.move();
+}
+
+std::unique_ptr<folly::IOBuf> LazyFrame::releaseBuffer() {
+  frameLength_ = metadataOffset_ = metadataLength_ = 0;
+  return std::move(buffer_);
+}
+
+void LazyFrame::makeHeadWritable(size_t length, size_t headroom) {
+  DCHECK_LE(length, frameLength_);
+  if (!buffer_->isSharedOne() && buffer_->length() >= length &&
+      buffer_->headroom() >= headroom) {
+    return;
+  }
+
+  auto head = folly::IOBuf::create(kRewriteHeadroom + headroom + length);
+  head->advance(kRewriteHeadroom + headroom);
+  folly::io::Cursor cur(buffer_.get());
+  cur.pull(head->writableData(), length);
+  head->append(length);
+
+  folly::IOBufQueue rest;
+  rest.append(std::move(buffer_));
+  rest.trimStart(length);
+  if (!rest.empty()) {
+    head->appendChain(rest.move());
+  }
+  buffer_ = std::move(head);
+}
+
+std::unique_ptr<folly::IOBuf> LazyFrame::clone(size_t offset, size_t length)
+    const {
+  if (length == 0) {
+    return nullptr;
+  }
+  folly::io::Cursor cur(buffer_.get());
+  cur.skip(offset);
+  std::unique_ptr<folly::IOBuf> buf;
+  cur.clone(buf, length);
+  return buf;
+}
+
+std::ostream& operator<<(std::ostream& os, const LazyFrame& frame) {
+  return os << frame.header() << "(" << frame.requestN() << ", "
+            << "metadata: " << frame.metadataLength()
+            << ", data: " << frame.dataLength() << ")";
+}
+
+} // namespace proteus
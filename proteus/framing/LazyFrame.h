@@ -0,0 +1,131 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/FrameHeader.h"
+#include "rsocket/Payload.h"
+
+namespace proteus {
+
+/// A payload-bearing frame (REQUEST_RESPONSE, REQUEST_FNF, REQUEST_STREAM,
+/// REQUEST_CHANNEL or PAYLOAD) of which only the header has been decoded.
+///
+/// Instead of splitting the payload into metadata and data IOBufs, the frame
+/// records where they are in the received buffer. A relay routes on the
+/// header and metadataRange(), then forwards buffer() as is; the payload
+/// IOBufs are only built for application code that asks for them.
+///
+/// Filled in by FrameSerializer::tryDeserializeFrom(LazyFrame&, ...).
+class LazyFrame {
+ public:
+  LazyFrame() = default;
+  LazyFrame(
+      FrameHeader header,
+      uint32_t requestN,
+      std::unique_ptr<folly::IOBuf> buffer,
+      size_t metadataOffset,
+      size_t metadataLength);
+
+  const FrameHeader& header() const {
+    return header_;
+  }
+
+  /// Initial request N of REQUEST_STREAM and REQUEST_CHANNEL frames, 0 for
+  /// the other frame types.
+  uint32_t requestN() const {
+    return requestN_;
+  }
+
+  bool hasMetadata() const {
+    return !!(header_.flags & FrameFlags::METADATA);
+  }
+
+  size_t metadataLength() const {
+    return metadataLength_;
+  }
+
+  size_t dataLength() const {
+    return frameLength_ - metadataOffset_ - metadataLength_;
+  }
+
+  /// Metadata bytes, if they all are in the head buffer of the frame, which
+  /// is where a transport puts them unless the frame is fragmented.
+  folly::Optional<folly::ByteRange> metadataRange() const;
+
+  /// Payload parts cloned out of the frame buffer, nullptr if empty.
+  std::unique_ptr<folly::IOBuf> cloneMetadata() const;
+  std::unique_ptr<folly::IOBuf> cloneData() const;
+  rsocket::Payload clonePayload() const;
+
+  /// A frame sharing the buffer of this one, to be rewritten on its own.
+  LazyFrame clone() const;
+
+  /// The whole serialized frame, untouched.
+  const folly::IOBuf& buffer() const {
+    return *buffer_;
+  }
+
+  /// Rewriting for forwarding. Only the bytes in front of the application
+  /// data are touched, the payload is neither copied nor moved.
+  ///
+  /// The bytes are rewritten in place when the head buffer is not shared; a
+  /// longer replacement is prepended into the headroom in front of the
+  /// frame. Otherwise the frame header and the replaced bytes are copied
+  /// into a buffer of their own, chained in front of the rest of the frame.
+
+  /// Sets the stream ID of the frame.
+  void setStreamId(rsocket::StreamId streamId);
+
+  /// Replaces the first `length` bytes of the metadata with `replacement`
+  /// and updates the metadata length. `replacement` must not point into the
+  /// frame.
+  void replaceMetadataPrefix(size_t length, folly::ByteRange replacement);
+
+  /// Replaces the payload of the frame, setting or clearing the METADATA
+  /// flag as `payload` has metadata or not. Unlike the rewrites above this
+  /// rebuilds everything behind the frame header and request N: the
+  /// metadata is copied into the head buffer and the data chained in. Used
+  /// to change how the payload is encoded, see
+  /// FrameSerializer::decompressPayload().
+  void replacePayload(rsocket::Payload payload);
+
+  /// Takes the serialized frame out, leaving this frame empty.
+  std::unique_ptr<folly::IOBuf> releaseBuffer();
+
+ private:
+  std::unique_ptr<folly::IOBuf> clone(size_t offset, size_t length) const;
+
+  // Makes the first `length` bytes of the frame writable and contiguous in
+  // the head buffer, with at least `headroom` bytes free in front of them.
+  void makeHeadWritable(size_t length, size_t headroom);
+
+  FrameHeader header_;
+  uint32_t requestN_{0};
+  std::unique_ptr<folly::IOBuf> buffer_;
+  size_t frameLength_{0};
+  size_t metadataOffset_{0};
+  size_t metadataLength_{0};
+};
+
+std::ostream& operator<<(std::ostream&, const LazyFrame&);
+
+} // namespace proteus
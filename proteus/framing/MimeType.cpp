@@ -0,0 +1,35 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/MimeType.h"
+
+#include <folly/String.h>
+
+namespace proteus {
+
+folly::Optional<folly::StringPiece> mimeTypeParameter(
+    folly::StringPiece mimeType,
+    folly::StringPiece name) {
+  mimeType.split_step(';');
+  while (!mimeType.empty()) {
+    auto value = mimeType.split_step(';');
+    const auto key = folly::trimWhitespace(value.split_step('='));
+    if (key == name) {
+      return folly::trimWhitespace(value);
+    }
+  }
+  return folly::none;
+}
+
+} // namespace proteus
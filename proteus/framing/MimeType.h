@@ -0,0 +1,29 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+namespace proteus {
+
+/// Value of parameter `name` of `mimeType`, e.g. "utf-8" for "charset" of
+/// "text/plain; charset=utf-8". SETUP negotiates connection options through
+/// parameters of its metadata mime type.
+folly::Optional<folly::StringPiece> mimeTypeParameter(
+    folly::StringPiece mimeType,
+    folly::StringPiece name);
+
+} // namespace proteus
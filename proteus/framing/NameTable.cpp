@@ -0,0 +1,157 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/NameTable.h"
+
+#include <folly/hash/SpookyHashV2.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t NameTable::kMaxNames;
+constexpr size_t NameTable::kChunkSize;
+constexpr size_t NameTable::kChunkCount;
+
+namespace {
+constexpr const size_t kInitialIndexCapacity = 1024; // slots
+} // namespace
+
+NameTable::Index::Index(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<uint64_t>[capacity]) {
+  DCHECK_EQ(0u, capacity & mask) << "capacity must be a power of two";
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+NameTable::NameTable() {
+  for (auto& chunk : chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+  indexes_.push_back(std::make_unique<Index>(kInitialIndexCapacity));
+  index_.store(indexes_.back().get(), std::memory_order_release);
+}
+
+NameTable::~NameTable() {
+  for (auto& chunk : chunks_) {
+    delete chunk.load(std::memory_order_relaxed);
+  }
+}
+
+NameTable& NameTable::global() {
+  static auto* table = new NameTable();
+  return *table;
+}
+
+NameId NameTable::intern(folly::StringPiece name) {
+  auto id = tryIntern(name);
+  CHECK(id.hasValue()) << "too many names interned";
+  return *id;
+}
+
+folly::Optional<NameId> NameTable::tryIntern(folly::StringPiece name) {
+  const auto hash = hashName(name);
+  if (auto id = find(name, hash)) {
+    return *id;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Another thread may have interned the name since the lookup above.
+  if (auto id = find(name, hash)) {
+    return *id;
+  }
+
+  const auto id = static_cast<NameId>(size_.load(std::memory_order_relaxed));
+  if (id >= kMaxNames) {
+    return folly::none;
+  }
+
+  auto* chunk = chunks_[id / kChunkSize].load(std::memory_order_relaxed);
+  if (!chunk) {
+    chunk = new Chunk();
+    chunks_[id / kChunkSize].store(chunk, std::memory_order_release);
+  }
+  chunk->names[id % kChunkSize] = name.str();
+
+  // Keep the index at most half full, so probe sequences stay short.
+  auto* index = index_.load(std::memory_order_relaxed);
+  const auto capacity = index->mask + 1;
+  if (2 * (id + 1) > capacity) {
+    auto grown = std::make_unique<Index>(2 * capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+      const auto slot = index->slots[i].load(std::memory_order_relaxed);
+      if (slot != 0) {
+        insert(
+            *grown,
+            static_cast<uint32_t>(slot >> 32),
+            static_cast<NameId>(slot) - 1);
+      }
+    }
+    index = grown.get();
+    indexes_.push_back(std::move(grown));
+  }
+
+  // Publishing the slot (and the grown index) with release semantics makes
+  // the name stored above visible to readers that find it.
+  size_.store(id + 1, std::memory_order_release);
+  insert(*index, hash, id);
+  index_.store(index, std::memory_order_release);
+  return id;
+}
+
+folly::Optional<NameId> NameTable::find(folly::StringPiece name) const {
+  return find(name, hashName(name));
+}
+
+folly::StringPiece NameTable::name(NameId id) const {
+  DCHECK_LT(id, size());
+  const auto* chunk = chunks_[id / kChunkSize].load(std::memory_order_acquire);
+  DCHECK(chunk);
+  return chunk->names[id % kChunkSize];
+}
+
+uint32_t NameTable::hashName(folly::StringPiece name) {
+  return folly::hash::SpookyHashV2::Hash32(name.data(), name.size(), 0);
+}
+
+folly::Optional<NameId> NameTable::find(
+    folly::StringPiece name,
+    uint32_t hash) const {
+  const auto* index = index_.load(std::memory_order_acquire);
+  for (auto i = hash & index->mask;; i = (i + 1) & index->mask) {
+    const auto slot = index->slots[i].load(std::memory_order_acquire);
+    if (slot == 0) {
+      return folly::none;
+    }
+    if (static_cast<uint32_t>(slot >> 32) == hash) {
+      const auto id = static_cast<NameId>(slot) - 1;
+      if (this->name(id) == name) {
+        return id;
+      }
+    }
+  }
+}
+
+void NameTable::insert(Index& index, uint32_t hash, NameId id) {
+  for (auto i = hash & index.mask;; i = (i + 1) & index.mask) {
+    if (index.slots[i].load(std::memory_order_relaxed) == 0) {
+      index.slots[i].store(
+          static_cast<uint64_t>(hash) << 32 | (static_cast<uint64_t>(id) + 1),
+          std::memory_order_release);
+      return;
+    }
+  }
+}
+
+} // namespace proteus
@@ -0,0 +1,113 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+namespace proteus {
+
+/// Small dense integer standing for an interned name.
+using NameId = uint32_t;
+
+/// Interns group, destination and mime type names.
+///
+/// Every distinct name is stored once and numbered from 0 in the order it
+/// was first interned. Routing tables key on the NameId, so a name received
+/// in a frame is hashed once, by find() or intern(), instead of on every
+/// table lookup, and comparing two names is an integer compare.
+///
+/// find() and name() never lock: they read an open-addressing index that
+/// intern() republishes, grown, when it fills up. Interning a name that is
+/// not in the table yet takes a mutex. Names and IDs live as long as the
+/// table, so the StringPiece returned by name() never dangles.
+class NameTable {
+ public:
+  static constexpr size_t kMaxNames = 1 << 20;
+
+  NameTable();
+  ~NameTable();
+
+  NameTable(const NameTable&) = delete;
+  NameTable& operator=(const NameTable&) = delete;
+
+  /// Table shared by the whole process. Never destroyed.
+  static NameTable& global();
+
+  /// Returns the ID of `name`, interning it if it is new. At most kMaxNames
+  /// names can be interned.
+  NameId intern(folly::StringPiece name);
+
+  /// Like intern(), but returns folly::none instead of failing when `name`
+  /// is new and the table is full. For names received from peers.
+  folly::Optional<NameId> tryIntern(folly::StringPiece name);
+
+  /// Returns the ID of `name` if it was interned, without allocating.
+  folly::Optional<NameId> find(folly::StringPiece name) const;
+
+  /// Returns the name interned as `id`, which must have come from this
+  /// table.
+  folly::StringPiece name(NameId id) const;
+
+  /// Number of names interned so far.
+  size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t kChunkSize = 1024;
+  static constexpr size_t kChunkCount = kMaxNames / kChunkSize;
+
+  struct Chunk {
+    std::array<std::string, kChunkSize> names;
+  };
+
+  // Slots hold the hash of the name in the upper and ID + 1 in the lower 32
+  // bits, 0 for an empty slot.
+  struct Index {
+    explicit Index(size_t capacity);
+
+    const size_t mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+  };
+
+  static uint32_t hashName(folly::StringPiece name);
+
+  folly::Optional<NameId> find(folly::StringPiece name, uint32_t hash) const;
+
+  // Inserts an entry into `index`, which must have a free slot. Called with
+  // mutex_ held.
+  static void insert(Index& index, uint32_t hash, NameId id);
+
+  std::array<std::atomic<Chunk*>, kChunkCount> chunks_;
+  std::atomic<Index*> index_;
+  std::atomic<size_t> size_{0};
+
+  std::mutex mutex_;
+  // Indexes replaced by a bigger one. Readers may still be probing them, so
+  // they are only freed with the table.
+  std::vector<std::unique_ptr<Index>> indexes_;
+};
+
+} // namespace proteus
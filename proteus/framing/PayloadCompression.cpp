@@ -0,0 +1,239 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/PayloadCompression.h"
+
+#include <ostream>
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/io/Compression.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t PayloadCompressor::kMaxMarkersSize;
+constexpr size_t PayloadCompressor::kDefaultMinCompressSize;
+constexpr size_t PayloadCompressor::kDefaultMaxUncompressedSize;
+
+namespace {
+constexpr const folly::StringPiece kLz4Suffix{"+lz4"};
+constexpr const folly::StringPiece kZstdSuffix{"+zstd"};
+
+std::unique_ptr<folly::io::Codec> createCodec(PayloadCompression compression) {
+  switch (compression) {
+    case PayloadCompression::NONE:
+      return nullptr;
+    case PayloadCompression::LZ4:
+      // The varint size prefix lets the receiver check the size up front.
+      return folly::io::getCodec(folly::io::CodecType::LZ4_VARINT_SIZE);
+    case PayloadCompression::ZSTD:
+      return folly::io::getCodec(folly::io::CodecType::ZSTD);
+  }
+  LOG(FATAL) << "unknown payload compression "
+             << static_cast<int>(compression);
+}
+
+void prependMarker(
+    std::unique_ptr<folly::IOBuf>& buf,
+    PayloadCompression compression) {
+  if (buf->headroom() == 0 || buf->isSharedOne()) {
+    auto head = folly::IOBuf::create(1);
+    head->advance(1);
+    head->prependChain(std::move(buf));
+    buf = std::move(head);
+  }
+  buf->prepend(1);
+  buf->writableData()[0] = static_cast<uint8_t>(compression);
+}
+} // namespace
+
+folly::StringPiece toString(PayloadCompression compression) {
+  switch (compression) {
+    case PayloadCompression::NONE:
+      return "NONE";
+    case PayloadCompression::LZ4:
+      return "LZ4";
+    case PayloadCompression::ZSTD:
+      return "ZSTD";
+  }
+  return "UNKNOWN_PAYLOAD_COMPRESSION";
+}
+
+std::ostream& operator<<(std::ostream& os, PayloadCompression compression) {
+  return os << toString(compression);
+}
+
+PayloadCompression parseMimeTypeCompression(
+    folly::StringPiece mimeType,
+    folly::StringPiece* baseMimeType) {
+  mimeType = folly::rtrimWhitespace(mimeType.split_step(';'));
+  auto compression = PayloadCompression::NONE;
+  if (mimeType.endsWith(kLz4Suffix)) {
+    compression = PayloadCompression::LZ4;
+    mimeType.subtract(kLz4Suffix.size());
+  } else if (mimeType.endsWith(kZstdSuffix)) {
+    compression = PayloadCompression::ZSTD;
+    mimeType.subtract(kZstdSuffix.size());
+  }
+  if (baseMimeType) {
+    *baseMimeType = mimeType;
+  }
+  return compression;
+}
+
+std::string withCompression(
+    folly::StringPiece mimeType,
+    PayloadCompression compression) {
+  // The suffix goes in front of the parameters, if any.
+  const auto parameters = mimeType.find(';');
+  const auto type = mimeType.subpiece(0, parameters);
+  const auto rest = parameters == folly::StringPiece::npos
+      ? folly::StringPiece()
+      : mimeType.subpiece(parameters);
+  switch (compression) {
+    case PayloadCompression::NONE:
+      return mimeType.str();
+    case PayloadCompression::LZ4:
+      return folly::to<std::string>(type, kLz4Suffix, rest);
+    case PayloadCompression::ZSTD:
+      return folly::to<std::string>(type, kZstdSuffix, rest);
+  }
+  LOG(FATAL) << "unknown payload compression "
+             << static_cast<int>(compression);
+}
+
+PayloadCompressor::Field::Field(PayloadCompression compression)
+    : compression(compression), codec(createCodec(compression)) {}
+
+PayloadCompressor::PayloadCompressor(
+    PayloadCompression metadataCompression,
+    PayloadCompression dataCompression,
+    size_t minCompressSize,
+    size_t maxUncompressedSize)
+    : metadata_(metadataCompression),
+      data_(dataCompression),
+      minCompressSize_(minCompressSize),
+      maxUncompressedSize_(maxUncompressedSize) {}
+
+PayloadCompressor::~PayloadCompressor() = default;
+
+std::unique_ptr<PayloadCompressor> PayloadCompressor::fromSetup(
+    const Frame_SETUP& setup,
+    size_t minCompressSize,
+    size_t maxUncompressedSize) {
+  const auto metadataCompression =
+      parseMimeTypeCompression(setup.metadataMimeType_);
+  const auto dataCompression = parseMimeTypeCompression(setup.dataMimeType_);
+  if (metadataCompression == PayloadCompression::NONE &&
+      dataCompression == PayloadCompression::NONE) {
+    return nullptr;
+  }
+  return std::make_unique<PayloadCompressor>(
+      metadataCompression,
+      dataCompression,
+      minCompressSize,
+      maxUncompressedSize);
+}
+
+bool PayloadCompressor::sameFormat(
+    const PayloadCompressor* a,
+    const PayloadCompressor* b) {
+  const auto metadata = [](const PayloadCompressor* compressor) {
+    return compressor ? compressor->metadataCompression()
+                      : PayloadCompression::NONE;
+  };
+  const auto data = [](const PayloadCompressor* compressor) {
+    return compressor ? compressor->dataCompression()
+                      : PayloadCompression::NONE;
+  };
+  return metadata(a) == metadata(b) && data(a) == data(b);
+}
+
+void PayloadCompressor::compress(rsocket::Payload& payload) {
+  compress(metadata_, payload.metadata);
+  compress(data_, payload.data);
+}
+
+DecodeError PayloadCompressor::decompress(rsocket::Payload& payload) {
+  auto error = decompress(metadata_, payload.metadata);
+  if (error != DecodeError::NONE) {
+    return error;
+  }
+  return decompress(data_, payload.data);
+}
+
+void PayloadCompressor::compress(
+    Field& field,
+    std::unique_ptr<folly::IOBuf>& buf) {
+  // Fields that negotiated no compression go out as they are, so broker
+  // routing headers in uncompressed metadata stay readable in place.
+  if (!field.codec || !buf || buf->empty()) {
+    return;
+  }
+  const auto length = buf->computeChainDataLength();
+  if (length >= minCompressSize_) {
+    auto compressed = field.codec->compress(buf.get());
+    if (compressed->computeChainDataLength() < length) {
+      buf = std::move(compressed);
+      prependMarker(buf, field.compression);
+      return;
+    }
+  }
+  prependMarker(buf, PayloadCompression::NONE);
+}
+
+DecodeError PayloadCompressor::decompress(
+    Field& field,
+    std::unique_ptr<folly::IOBuf>& buf) {
+  if (!field.codec || !buf || buf->empty()) {
+    return DecodeError::NONE;
+  }
+  const auto marker = folly::io::Cursor(buf.get()).read<uint8_t>();
+
+  folly::IOBufQueue queue;
+  queue.append(std::move(buf));
+  queue.trimStart(1);
+  buf = queue.move();
+  if (!buf) {
+    buf = folly::IOBuf::create(0);
+  }
+
+  if (marker == static_cast<uint8_t>(PayloadCompression::NONE)) {
+    return DecodeError::NONE;
+  }
+  if (marker != static_cast<uint8_t>(field.compression)) {
+    return DecodeError::CORRUPT_PAYLOAD;
+  }
+  try {
+    // Without the size up front the codec would grow its output without
+    // bound. Both codecs record it when compressing a whole field.
+    const auto length = field.codec->getUncompressedLength(buf.get());
+    if (!length || *length > maxUncompressedSize_) {
+      return DecodeError::CORRUPT_PAYLOAD;
+    }
+    auto uncompressed = field.codec->uncompress(buf.get(), length);
+    if (uncompressed->computeChainDataLength() > maxUncompressedSize_) {
+      return DecodeError::CORRUPT_PAYLOAD;
+    }
+    buf = std::move(uncompressed);
+  } catch (const std::exception&) {
+    return DecodeError::CORRUPT_PAYLOAD;
+  }
+  return DecodeError::NONE;
+}
+
+} // namespace proteus
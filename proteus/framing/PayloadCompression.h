@@ -0,0 +1,137 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/DecodeError.h"
+#include "proteus/framing/Frame.h"
+
+namespace folly {
+namespace io {
+class Codec;
+} // namespace io
+} // namespace folly
+
+namespace proteus {
+
+/// Compression of the data or metadata of payloads, negotiated by SETUP.
+enum class PayloadCompression : uint8_t {
+  NONE = 0,
+  LZ4 = 1,
+  ZSTD = 2,
+};
+
+folly::StringPiece toString(PayloadCompression);
+
+std::ostream& operator<<(std::ostream&, PayloadCompression);
+
+/// A SETUP frame asks for compression by suffixing the mime type of data or
+/// metadata with "+lz4" or "+zstd", e.g. "application/json+zstd". Returns
+/// the compression named by `mimeType`, and the mime type without the
+/// suffix and any parameters in `baseMimeType` if given.
+PayloadCompression parseMimeTypeCompression(
+    folly::StringPiece mimeType,
+    folly::StringPiece* baseMimeType = nullptr);
+
+/// `mimeType` with the suffix asking for `compression`.
+std::string withCompression(
+    folly::StringPiece mimeType,
+    PayloadCompression compression);
+
+/// Compresses the payloads a connection sends and decompresses the ones it
+/// receives, once SETUP has negotiated compression for data, metadata or
+/// both, see FrameSerializer::setPayloadCompressor.
+///
+/// Every non-empty data or metadata field of a kind that negotiated a codec
+/// starts with a byte holding the PayloadCompression it was sent with.
+/// Fields smaller than minCompressSize, or that don't get smaller, are sent
+/// as NONE, so small payloads only cost that byte. Fields of a kind that
+/// negotiated NONE are sent without a marker.
+///
+/// The marker bytes count against the frame size: fragmenting for such a
+/// connection leaves kMaxMarkersSize bytes of each frame for them. Codecs
+/// are created once per connection and reused for every payload. Not
+/// thread-safe: use one instance per connection.
+class PayloadCompressor {
+ public:
+  static constexpr size_t kMaxMarkersSize = 2; // bytes
+  static constexpr size_t kDefaultMinCompressSize = 256; // bytes
+  static constexpr size_t kDefaultMaxUncompressedSize = 16 << 20; // bytes
+
+  /// Fields that would decompress to more than `maxUncompressedSize` bytes
+  /// are rejected.
+  PayloadCompressor(
+      PayloadCompression metadataCompression,
+      PayloadCompression dataCompression,
+      size_t minCompressSize = kDefaultMinCompressSize,
+      size_t maxUncompressedSize = kDefaultMaxUncompressedSize);
+  ~PayloadCompressor();
+
+  /// Compressor for the mime types of `setup`, nullptr if it doesn't ask
+  /// for compression.
+  static std::unique_ptr<PayloadCompressor> fromSetup(
+      const Frame_SETUP& setup,
+      size_t minCompressSize = kDefaultMinCompressSize,
+      size_t maxUncompressedSize = kDefaultMaxUncompressedSize);
+
+  PayloadCompression metadataCompression() const {
+    return metadata_.compression;
+  }
+
+  PayloadCompression dataCompression() const {
+    return data_.compression;
+  }
+
+  /// Whether connections compressing payloads with `a` and `b`, nullptr
+  /// for none, put payloads on the wire alike, so that a frame received on
+  /// one can be forwarded to the other as it is.
+  static bool sameFormat(
+      const PayloadCompressor* a,
+      const PayloadCompressor* b);
+
+  void compress(rsocket::Payload& payload);
+
+  /// Returns DecodeError::CORRUPT_PAYLOAD if a field can't be decompressed,
+  /// doesn't record its uncompressed size, is bigger than
+  /// maxUncompressedSize or was compressed with a codec that wasn't
+  /// negotiated; the payload is left half decoded then.
+  DecodeError decompress(rsocket::Payload& payload);
+
+ private:
+  struct Field {
+    explicit Field(PayloadCompression compression);
+
+    PayloadCompression compression;
+    std::unique_ptr<folly::io::Codec> codec;
+  };
+
+  void compress(Field& field, std::unique_ptr<folly::IOBuf>& buf);
+  DecodeError decompress(Field& field, std::unique_ptr<folly::IOBuf>& buf);
+
+  Field metadata_;
+  Field data_;
+  const size_t minCompressSize_;
+  const size_t maxUncompressedSize_;
+};
+
+} // namespace proteus
@@ -0,0 +1,152 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/PayloadFragmenter.h"
+
+#include <algorithm>
+
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t PayloadFragmenter::kMaxFramingSize;
+
+namespace {
+constexpr const size_t kFrameHeaderSize = 6; // bytes
+constexpr const size_t kRequestNSize = 4; // bytes
+constexpr const size_t kMetadataLengthSize = 3; // bytes
+constexpr const size_t kMaxMetadataLength = 0xFFFFFF; // 24bit max value
+
+static_assert(
+    PayloadFragmenter::kMaxFramingSize ==
+        kFrameHeaderSize + kRequestNSize + kMetadataLengthSize,
+    "fragment framing size mismatch");
+
+size_t chainLength(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->computeChainDataLength() : 0;
+}
+
+// Cuts the next fragment, of at most `budget` bytes including the metadata
+// length field, off the front of the metadata and data left. The serializer
+// rejects metadata of exactly kMaxMetadataLength bytes, so one less is cut.
+rsocket::Payload takeFragment(
+    folly::IOBufQueue& metadata,
+    bool& metadataLeft,
+    folly::IOBufQueue& data,
+    size_t budget) {
+  rsocket::Payload fragment;
+  if (metadataLeft) {
+    DCHECK_GT(budget, kMetadataLengthSize);
+    budget -= kMetadataLengthSize;
+    const auto length = std::min(
+        std::min(budget, kMaxMetadataLength - 1), metadata.chainLength());
+    fragment.metadata =
+        length > 0 ? metadata.split(length) : folly::IOBuf::create(0);
+    budget -= length;
+    metadataLeft = !metadata.empty();
+  }
+  if (!metadataLeft && budget > 0 && !data.empty()) {
+    fragment.data = data.split(std::min(budget, data.chainLength()));
+  }
+  return fragment;
+}
+
+} // namespace
+
+PayloadFragmenter::PayloadFragmenter(
+    size_t maxFrameSize,
+    size_t maxPayloadSize)
+    : maxFrameSize_(maxFrameSize), maxPayloadSize_(maxPayloadSize) {
+  CHECK_GT(maxFrameSize_, kMaxFramingSize)
+      << "fragments must have room for some payload";
+}
+
+bool PayloadFragmenter::fragment(
+    Frame_REQUEST_STREAM& frame,
+    std::vector<Frame_PAYLOAD>& followers) const {
+  return fragmentFrame(frame, kFrameHeaderSize + kRequestNSize, followers);
+}
+
+bool PayloadFragmenter::fragment(
+    Frame_REQUEST_CHANNEL& frame,
+    std::vector<Frame_PAYLOAD>& followers) const {
+  return fragmentFrame(frame, kFrameHeaderSize + kRequestNSize, followers);
+}
+
+bool PayloadFragmenter::fragment(
+    Frame_REQUEST_RESPONSE& frame,
+    std::vector<Frame_PAYLOAD>& followers) const {
+  return fragmentFrame(frame, kFrameHeaderSize, followers);
+}
+
+bool PayloadFragmenter::fragment(
+    Frame_REQUEST_FNF& frame,
+    std::vector<Frame_PAYLOAD>& followers) const {
+  return fragmentFrame(frame, kFrameHeaderSize, followers);
+}
+
+bool PayloadFragmenter::fragment(
+    Frame_PAYLOAD& frame,
+    std::vector<Frame_PAYLOAD>& followers) const {
+  return fragmentFrame(frame, kFrameHeaderSize, followers);
+}
+
+template <typename Frame>
+bool PayloadFragmenter::fragmentFrame(
+    Frame& frame,
+    size_t headerSize,
+    std::vector<Frame_PAYLOAD>& followers) const {
+  auto& payload = frame.payload_;
+  const auto metadataLength = chainLength(payload.metadata);
+  const auto payloadSize = metadataLength + chainLength(payload.data);
+  if (payloadSize > maxPayloadSize_) {
+    return false;
+  }
+  const auto framingSize =
+      headerSize + (payload.metadata ? kMetadataLengthSize : 0);
+  if (framingSize + payloadSize <= maxFrameSize_ &&
+      metadataLength < kMaxMetadataLength) {
+    return true;
+  }
+
+  folly::IOBufQueue metadata(folly::IOBufQueue::cacheChainLength());
+  folly::IOBufQueue data(folly::IOBufQueue::cacheChainLength());
+  bool metadataLeft = payload.metadata != nullptr;
+  metadata.append(std::move(payload.metadata));
+  data.append(std::move(payload.data));
+
+  const auto flags = frame.header_.flags;
+  payload =
+      takeFragment(metadata, metadataLeft, data, maxFrameSize_ - headerSize);
+  frame.header_.flags =
+      (flags & ~(FrameFlags::COMPLETE | FrameFlags::METADATA)) |
+      FrameFlags::FOLLOWS | detail::getFlags(payload);
+
+  const auto streamId = frame.header_.streamId;
+  while (metadataLeft || !data.empty()) {
+    auto fragment = takeFragment(
+        metadata, metadataLeft, data, maxFrameSize_ - kFrameHeaderSize);
+    auto fragmentFlags = FrameFlags::NEXT;
+    if (metadataLeft || !data.empty()) {
+      fragmentFlags |= FrameFlags::FOLLOWS;
+    } else {
+      fragmentFlags |= flags & FrameFlags::COMPLETE;
+    }
+    followers.emplace_back(streamId, fragmentFlags, std::move(fragment));
+  }
+  return true;
+}
+
+} // namespace proteus
@@ -0,0 +1,80 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "proteus/framing/Frame.h"
+
+namespace proteus {
+
+/// Splits payloads that don't fit into one frame into fragments.
+///
+/// The frame passed to fragment() keeps its type and the first fragment of
+/// the payload, with FOLLOWS set. The rest of the payload goes into PAYLOAD
+/// frames on the same stream, to be sent right after it, in order; all but
+/// the last of them have FOLLOWS set. Metadata is sent before data, a
+/// fragment finishing the metadata starts the data. COMPLETE moves from the
+/// frame to the last fragment.
+///
+/// Fragments are slices of the payload IOBufs, cut by cloning, so the bytes
+/// are never copied. Every fragment serializes to at most maxFrameSize
+/// bytes, not counting the frame length field, which also keeps metadata
+/// under the 24-bit limit of the metadata length field.
+class PayloadFragmenter {
+ public:
+  /// Bytes of framing a fragment needs besides its payload, at most.
+  static constexpr size_t kMaxFramingSize = 13; // bytes
+
+  /// `maxPayloadSize` caps the payload of a single frame, as it is all
+  /// referenced by the fragments until they have been written.
+  PayloadFragmenter(size_t maxFrameSize, size_t maxPayloadSize);
+
+  size_t maxFrameSize() const {
+    return maxFrameSize_;
+  }
+
+  size_t maxPayloadSize() const {
+    return maxPayloadSize_;
+  }
+
+  /// Fragments the payload of `frame` if it doesn't fit into maxFrameSize,
+  /// appending the fragments that follow it to `followers`. Returns false,
+  /// leaving `frame` untouched, if the payload is bigger than
+  /// maxPayloadSize.
+  bool fragment(Frame_REQUEST_STREAM&, std::vector<Frame_PAYLOAD>& followers)
+      const;
+  bool fragment(Frame_REQUEST_CHANNEL&, std::vector<Frame_PAYLOAD>& followers)
+      const;
+  bool fragment(
+      Frame_REQUEST_RESPONSE&,
+      std::vector<Frame_PAYLOAD>& followers) const;
+  bool fragment(Frame_REQUEST_FNF&, std::vector<Frame_PAYLOAD>& followers)
+      const;
+  bool fragment(Frame_PAYLOAD&, std::vector<Frame_PAYLOAD>& followers) const;
+
+ private:
+  template <typename Frame>
+  bool fragmentFrame(
+      Frame& frame,
+      size_t headerSize,
+      std::vector<Frame_PAYLOAD>& followers) const;
+
+  const size_t maxFrameSize_;
+  const size_t maxPayloadSize_;
+};
+
+} // namespace proteus
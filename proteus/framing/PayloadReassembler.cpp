@@ -0,0 +1,169 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/PayloadReassembler.h"
+
+#include <ostream>
+
+#include <glog/logging.h>
+
+namespace proteus {
+
+namespace {
+size_t chainLength(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->computeChainDataLength() : 0;
+}
+} // namespace
+
+folly::StringPiece toString(ReassemblyStatus status) {
+  switch (status) {
+    case ReassemblyStatus::UNFRAGMENTED:
+      return "UNFRAGMENTED";
+    case ReassemblyStatus::PENDING:
+      return "PENDING";
+    case ReassemblyStatus::COMPLETE:
+      return "COMPLETE";
+    case ReassemblyStatus::TOO_LARGE:
+      return "TOO_LARGE";
+    case ReassemblyStatus::UNEXPECTED_FRAME:
+      return "UNEXPECTED_FRAME";
+  }
+  return "UNKNOWN_REASSEMBLY_STATUS";
+}
+
+std::ostream& operator<<(std::ostream& os, ReassemblyStatus status) {
+  return os << toString(status);
+}
+
+PayloadReassembler::PayloadReassembler(
+    size_t maxPayloadSize,
+    size_t maxBufferedSize)
+    : maxPayloadSize_(maxPayloadSize), maxBufferedSize_(maxBufferedSize) {}
+
+ReassemblyStatus PayloadReassembler::add(Frame_REQUEST_STREAM& frame) {
+  return addRequest(frame.header_, frame.requestN_, frame.payload_);
+}
+
+ReassemblyStatus PayloadReassembler::add(Frame_REQUEST_CHANNEL& frame) {
+  return addRequest(frame.header_, frame.requestN_, frame.payload_);
+}
+
+ReassemblyStatus PayloadReassembler::add(Frame_REQUEST_RESPONSE& frame) {
+  return addRequest(frame.header_, 0, frame.payload_);
+}
+
+ReassemblyStatus PayloadReassembler::add(Frame_REQUEST_FNF& frame) {
+  return addRequest(frame.header_, 0, frame.payload_);
+}
+
+ReassemblyStatus PayloadReassembler::add(
+    Frame_PAYLOAD& frame,
+    ReassembledFrame& out) {
+  const auto streamId = frame.header_.streamId;
+  auto it = streams_.find(streamId);
+  if (it == streams_.end()) {
+    // A PAYLOAD frame can start a fragmented frame of its own.
+    return addRequest(frame.header_, 0, frame.payload_);
+  }
+
+  auto& pending = it->second;
+  if (!append(streamId, pending, frame.payload_)) {
+    return ReassemblyStatus::TOO_LARGE;
+  }
+  if (frame.header_.flagsFollows()) {
+    return ReassemblyStatus::PENDING;
+  }
+
+  // The last fragment tells whether the frame completes the stream.
+  auto flags =
+      pending.header.flags | (frame.header_.flags & FrameFlags::COMPLETE);
+  if (pending.header.type == FrameType::PAYLOAD) {
+    flags |= frame.header_.flags & FrameFlags::NEXT;
+  }
+
+  bufferedSize_ -= pending.size();
+  out.header = pending.header;
+  out.requestN = pending.requestN;
+  out.payload.metadata = nullptr;
+  if (pending.hasMetadata) {
+    out.payload.metadata =
+        pending.metadata.empty() ? folly::IOBuf::create(0)
+                                 : pending.metadata.move();
+  }
+  out.payload.data = pending.data.move();
+  out.header.flags =
+      (flags & ~FrameFlags::METADATA) | detail::getFlags(out.payload);
+
+  streams_.erase(it);
+  return ReassemblyStatus::COMPLETE;
+}
+
+void PayloadReassembler::cancel(rsocket::StreamId streamId) {
+  erase(streamId);
+}
+
+ReassemblyStatus PayloadReassembler::addRequest(
+    const FrameHeader& header,
+    uint32_t requestN,
+    rsocket::Payload& payload) {
+  const auto streamId = header.streamId;
+  if (streams_.count(streamId) != 0) {
+    erase(streamId);
+    return ReassemblyStatus::UNEXPECTED_FRAME;
+  }
+  if (!header.flagsFollows()) {
+    return ReassemblyStatus::UNFRAGMENTED;
+  }
+
+  auto& pending = streams_[streamId];
+  pending.header = header;
+  pending.header.flags &= ~FrameFlags::FOLLOWS;
+  pending.requestN = requestN;
+  if (!append(streamId, pending, payload)) {
+    return ReassemblyStatus::TOO_LARGE;
+  }
+  return ReassemblyStatus::PENDING;
+}
+
+bool PayloadReassembler::append(
+    rsocket::StreamId streamId,
+    Pending& pending,
+    rsocket::Payload& payload) {
+  const auto size = chainLength(payload.metadata) + chainLength(payload.data);
+  if (pending.size() + size > maxPayloadSize_ ||
+      bufferedSize_ + size > maxBufferedSize_) {
+    erase(streamId);
+    return false;
+  }
+
+  if (payload.metadata) {
+    pending.hasMetadata = true;
+    pending.metadata.append(std::move(payload.metadata));
+  }
+  pending.data.append(std::move(payload.data));
+  bufferedSize_ += size;
+  return true;
+}
+
+void PayloadReassembler::erase(rsocket::StreamId streamId) {
+  auto it = streams_.find(streamId);
+  if (it == streams_.end()) {
+    return;
+  }
+  DCHECK_GE(bufferedSize_, it->second.size());
+  bufferedSize_ -= it->second.size();
+  streams_.erase(it);
+}
+
+} // namespace proteus
@@ -0,0 +1,125 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <unordered_map>
+
+#include <folly/Range.h>
+#include <folly/io/IOBufQueue.h>
+
+#include "proteus/framing/Frame.h"
+
+namespace proteus {
+
+enum class ReassemblyStatus : uint8_t {
+  // The frame isn't fragmented, it is left as is.
+  UNFRAGMENTED,
+  // The fragment was kept, more are to follow.
+  PENDING,
+  // The last fragment arrived, the whole frame was put back together.
+  COMPLETE,
+  // The payload would exceed a memory cap. The fragments of the stream
+  // were dropped.
+  TOO_LARGE,
+  // A request frame arrived on a stream whose fragments are being
+  // reassembled. The fragments of the stream were dropped.
+  UNEXPECTED_FRAME,
+};
+
+folly::StringPiece toString(ReassemblyStatus);
+
+std::ostream& operator<<(std::ostream&, ReassemblyStatus);
+
+/// A frame put back together from its fragments: the type, stream and
+/// request N of the first fragment, with the payload of all of them.
+struct ReassembledFrame {
+  FrameHeader header;
+  uint32_t requestN{0};
+  rsocket::Payload payload;
+};
+
+/// Reassembles the payloads of fragmented frames, per stream.
+///
+/// Fragments are chained together as they arrive, never coalesced, so a
+/// reassembled payload references the buffers the fragments were received
+/// in. maxPayloadSize caps the payload of one frame, maxBufferedSize the
+/// payload bytes held for all streams of the connection together.
+///
+/// Not thread-safe, a reassembler belongs to one connection.
+class PayloadReassembler {
+ public:
+  PayloadReassembler(size_t maxPayloadSize, size_t maxBufferedSize);
+
+  /// Feeds a frame received on a stream. The payload of `frame` is taken
+  /// unless the status is UNFRAGMENTED.
+  ReassemblyStatus add(Frame_REQUEST_STREAM& frame);
+  ReassemblyStatus add(Frame_REQUEST_CHANNEL& frame);
+  ReassemblyStatus add(Frame_REQUEST_RESPONSE& frame);
+  ReassemblyStatus add(Frame_REQUEST_FNF& frame);
+
+  /// Fragments after the first are PAYLOAD frames. On COMPLETE, `out`
+  /// holds the reassembled frame, of the type of the first fragment.
+  ReassemblyStatus add(Frame_PAYLOAD& frame, ReassembledFrame& out);
+
+  /// Drops the fragments of a stream, e.g. when it is cancelled.
+  void cancel(rsocket::StreamId streamId);
+
+  /// Payload bytes held for all streams.
+  size_t bufferedSize() const {
+    return bufferedSize_;
+  }
+
+  /// Number of streams with a frame being reassembled.
+  size_t pendingStreams() const {
+    return streams_.size();
+  }
+
+ private:
+  struct Pending {
+    FrameHeader header;
+    uint32_t requestN{0};
+    bool hasMetadata{false};
+    folly::IOBufQueue metadata{folly::IOBufQueue::cacheChainLength()};
+    folly::IOBufQueue data{folly::IOBufQueue::cacheChainLength()};
+
+    size_t size() const {
+      return metadata.chainLength() + data.chainLength();
+    }
+  };
+
+  ReassemblyStatus addRequest(
+      const FrameHeader& header,
+      uint32_t requestN,
+      rsocket::Payload& payload);
+
+  // Appends the payload of a fragment. Returns false and drops the stream
+  // if that would exceed a cap.
+  bool append(
+      rsocket::StreamId streamId,
+      Pending& pending,
+      rsocket::Payload& payload);
+
+  void erase(rsocket::StreamId streamId);
+
+  const size_t maxPayloadSize_;
+  const size_t maxBufferedSize_;
+  size_t bufferedSize_{0};
+  std::unordered_map<rsocket::StreamId, Pending> streams_;
+};
+
+} // namespace proteus
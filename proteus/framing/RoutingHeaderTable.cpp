@@ -0,0 +1,280 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/framing/RoutingHeaderTable.h"
+
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameLayout.h"
+#include "proteus/framing/MimeType.h"
+#include "proteus/framing/PayloadCompression.h"
+
+namespace proteus {
+
+constexpr uint8_t RoutingHeaderTable::kIndexed;
+constexpr uint8_t RoutingHeaderTable::kLiteralWithIndexing;
+constexpr uint8_t RoutingHeaderTable::kLiteral;
+constexpr size_t RoutingHeaderTable::kEntryOverhead;
+constexpr size_t RoutingHeaderTable::kDefaultCapacity;
+constexpr size_t RoutingHeaderTable::kMaxCapacity;
+
+namespace {
+using Index = layout::VarInt<uint32_t>;
+
+// Major version, minor version and frame type.
+constexpr const size_t kBrokerHeaderSize = 6; // bytes
+constexpr const folly::StringPiece kTableSizeParameter{"routing-table-size"};
+
+bool isMarker(uint8_t byte) {
+  return byte >= RoutingHeaderTable::kIndexed &&
+      byte <= RoutingHeaderTable::kLiteral;
+}
+
+void prependByte(std::unique_ptr<folly::IOBuf>& buf, uint8_t byte) {
+  if (buf->headroom() == 0 || buf->isSharedOne()) {
+    auto head = folly::IOBuf::create(1);
+    head->advance(1);
+    head->prependChain(std::move(buf));
+    buf = std::move(head);
+  }
+  buf->prepend(1);
+  buf->writableData()[0] = byte;
+}
+} // namespace
+
+RoutingHeaderTable::RoutingHeaderTable(size_t capacity)
+    : capacity_(std::min(capacity, kMaxCapacity)) {}
+
+std::unique_ptr<RoutingHeaderTable> RoutingHeaderTable::fromSetup(
+    const Frame_SETUP& setup) {
+  const auto value =
+      mimeTypeParameter(setup.metadataMimeType_, kTableSizeParameter);
+  if (!value) {
+    return nullptr;
+  }
+  const auto capacity = folly::tryTo<size_t>(*value);
+  if (!capacity) {
+    LOG(WARNING) << "invalid " << kTableSizeParameter << ": " << *value;
+    return nullptr;
+  }
+  // Relays read the routing header of a LazyFrame in place, which they
+  // can't do behind a compression marker.
+  if (parseMimeTypeCompression(setup.metadataMimeType_) !=
+      PayloadCompression::NONE) {
+    LOG(WARNING) << kTableSizeParameter
+                 << " ignored, metadata is compressed: "
+                 << setup.metadataMimeType_;
+    return nullptr;
+  }
+  return std::make_unique<RoutingHeaderTable>(*capacity);
+}
+
+folly::Optional<size_t> RoutingHeaderTable::routingHeaderLength(
+    folly::ByteRange metadata) {
+  if (metadata.size() < kBrokerHeaderSize || isMarker(metadata[0])) {
+    return folly::none;
+  }
+  switch (peekBrokerFrameType(metadata)) {
+    case FrameType::DESTINATION:
+      if (auto view = DestinationView::tryParse(metadata)) {
+        return view->metadataOffset();
+      }
+      break;
+    case FrameType::GROUP:
+      if (auto view = GroupView::tryParse(metadata)) {
+        return view->metadataOffset();
+      }
+      break;
+    case FrameType::BROADCAST:
+      if (auto view = BroadcastView::tryParse(metadata)) {
+        return view->metadataOffset();
+      }
+      break;
+    default:
+      break;
+  }
+  return folly::none;
+}
+
+void RoutingHeaderTable::encode(std::unique_ptr<folly::IOBuf>& metadata) {
+  if (!metadata || metadata->empty()) {
+    return;
+  }
+  // Views only parse the head buffer; a header split across buffers is
+  // sent as it is.
+  const auto head = folly::ByteRange(metadata->data(), metadata->length());
+  const auto length = routingHeaderLength(head);
+  if (!length) {
+    if (isMarker(folly::io::Cursor(metadata.get()).read<uint8_t>())) {
+      prependByte(metadata, kLiteral);
+    }
+    return;
+  }
+
+  std::string header(reinterpret_cast<const char*>(head.data()), *length);
+  auto it = encoderIndex_.find(header);
+  if (it != encoderIndex_.end()) {
+    const auto index =
+        static_cast<uint32_t>(encoder_.inserted - 1 - it->second);
+    auto prefix = folly::IOBuf::create(1 + Index::kMaxSize);
+    folly::io::Appender appender(prefix.get(), 0);
+    appender.writeBE<uint8_t>(kIndexed);
+    Index::encode(appender, index);
+
+    metadata->trimStart(*length);
+    if (!metadata->empty()) {
+      prefix->prependChain(std::move(metadata));
+    }
+    metadata = std::move(prefix);
+    return;
+  }
+
+  if (*length + kEntryOverhead > capacity_) {
+    return;
+  }
+  insert(encoder_, head.subpiece(0, *length), [this](const std::string& e) {
+    encoderIndex_.erase(e);
+  });
+  encoderIndex_.emplace(std::move(header), encoder_.inserted - 1);
+  prependByte(metadata, kLiteralWithIndexing);
+}
+
+DecodeError RoutingHeaderTable::decode(
+    std::unique_ptr<folly::IOBuf>& metadata) {
+  if (!metadata || metadata->empty()) {
+    return DecodeError::NONE;
+  }
+  metadata->gather(
+      std::min(metadata->computeChainDataLength(), 1 + Index::kMaxSize));
+  folly::ByteRange in(metadata->data(), metadata->length());
+  const auto marker = in[0];
+  in.uncheckedAdvance(1);
+
+  switch (marker) {
+    case kIndexed: {
+      uint32_t index;
+      if (!Index::decode(in, index)) {
+        return DecodeError::INVALID_ROUTING_HEADER;
+      }
+      const auto* entry = lookup(index);
+      if (!entry) {
+        return DecodeError::INVALID_ROUTING_HEADER;
+      }
+      auto header = folly::IOBuf::copyBuffer(entry->data(), entry->size());
+      metadata->trimStart(metadata->length() - in.size());
+      if (!metadata->empty()) {
+        header->prependChain(std::move(metadata));
+      }
+      metadata = std::move(header);
+      return DecodeError::NONE;
+    }
+    case kLiteralWithIndexing: {
+      metadata->trimStart(1);
+      if (metadata->isChained()) {
+        metadata->coalesce();
+      }
+      const auto head = folly::ByteRange(metadata->data(), metadata->length());
+      const auto length = routingHeaderLength(head);
+      if (!length || *length + kEntryOverhead > capacity_) {
+        return DecodeError::INVALID_ROUTING_HEADER;
+      }
+      insert(decoder_, head.subpiece(0, *length), [](const std::string&) {});
+      return DecodeError::NONE;
+    }
+    case kLiteral:
+      metadata->trimStart(1);
+      return DecodeError::NONE;
+    default:
+      return DecodeError::NONE;
+  }
+}
+
+DecodeError RoutingHeaderTable::decode(LazyFrame& frame) {
+  if (!frame.hasMetadata() || frame.metadataLength() == 0) {
+    return DecodeError::NONE;
+  }
+  auto metadata = frame.metadataRange();
+  if (!metadata) {
+    // Only fragmented frames have metadata outside of the head buffer.
+    return DecodeError::INVALID_ROUTING_HEADER;
+  }
+
+  folly::ByteRange in = metadata->subpiece(1);
+  switch ((*metadata)[0]) {
+    case kIndexed: {
+      uint32_t index;
+      if (!Index::decode(in, index)) {
+        return DecodeError::INVALID_ROUTING_HEADER;
+      }
+      const auto* entry = lookup(index);
+      if (!entry) {
+        return DecodeError::INVALID_ROUTING_HEADER;
+      }
+      frame.replaceMetadataPrefix(
+          metadata->size() - in.size(),
+          folly::ByteRange(folly::StringPiece(*entry)));
+      return DecodeError::NONE;
+    }
+    case kLiteralWithIndexing: {
+      const auto length = routingHeaderLength(in);
+      if (!length || *length + kEntryOverhead > capacity_) {
+        return DecodeError::INVALID_ROUTING_HEADER;
+      }
+      insert(decoder_, in.subpiece(0, *length), [](const std::string&) {});
+      frame.replaceMetadataPrefix(1, folly::ByteRange());
+      return DecodeError::NONE;
+    }
+    case kLiteral:
+      frame.replaceMetadataPrefix(1, folly::ByteRange());
+      return DecodeError::NONE;
+    default:
+      return DecodeError::NONE;
+  }
+}
+
+template <typename Evicted>
+void RoutingHeaderTable::insert(
+    Table& table,
+    folly::ByteRange header,
+    Evicted&& evicted) {
+  const auto entrySize = header.size() + kEntryOverhead;
+  DCHECK_LE(entrySize, capacity_);
+  while (table.size + entrySize > capacity_) {
+    DCHECK(!table.entries.empty());
+    const auto& oldest = table.entries.front();
+    evicted(oldest);
+    table.size -= oldest.size() + kEntryOverhead;
+    table.entries.pop_front();
+  }
+  table.entries.emplace_back(
+      reinterpret_cast<const char*>(header.data()), header.size());
+  table.size += entrySize;
+  ++table.inserted;
+}
+
+const std::string* RoutingHeaderTable::lookup(uint32_t index) const {
+  if (index >= decoder_.entries.size()) {
+    return nullptr;
+  }
+  return &decoder_.entries[decoder_.entries.size() - 1 - index];
+}
+
+} // namespace proteus
@@ -0,0 +1,126 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/DecodeError.h"
+#include "proteus/framing/Frame.h"
+#include "proteus/framing/LazyFrame.h"
+
+namespace proteus {
+
+/// Per-connection dynamic table of routing headers, in the spirit of HPACK.
+///
+/// The routing header is the DESTINATION, GROUP or BROADCAST frame in front
+/// of the application metadata (see BrokerFrameView.h). The first time a
+/// header is sent it goes out in full, behind a kLiteralWithIndexing byte,
+/// and both ends add it to their table. After that it is sent as a
+/// kIndexed byte and a varint index, 0 being the header added last.
+/// Headers that don't fit into the table, SHARD headers, whose shard key
+/// changes from request to request, and other metadata are sent as they
+/// are, behind a kLiteral byte if they would otherwise start with one of
+/// these markers. Routing headers never do, the high byte of their major
+/// version is below kIndexed.
+///
+/// An entry costs its header length plus kEntryOverhead bytes of the table
+/// capacity. Entries are evicted oldest first to make room for a new one,
+/// so both ends evict the same entries without talking about it. A header
+/// bigger than the whole table is sent as a literal and leaves the table
+/// as it is. The capacity is negotiated by SETUP, see fromSetup().
+///
+/// Each direction has a table of its own, so one instance encodes the
+/// headers a connection sends and decodes the ones it receives. Not
+/// thread-safe.
+class RoutingHeaderTable {
+ public:
+  static constexpr uint8_t kIndexed = 0x40;
+  static constexpr uint8_t kLiteralWithIndexing = 0x41;
+  static constexpr uint8_t kLiteral = 0x42;
+  static constexpr size_t kEntryOverhead = 32; // bytes
+  static constexpr size_t kDefaultCapacity = 4096; // bytes
+  static constexpr size_t kMaxCapacity = 1 << 20; // bytes
+
+  explicit RoutingHeaderTable(size_t capacity = kDefaultCapacity);
+
+  /// A SETUP frame asks for a routing header table by adding a
+  /// "routing-table-size" parameter to its metadata mime type, e.g.
+  /// "application/x.netifi; routing-table-size=4096". Returns a table of
+  /// that capacity, capped at kMaxCapacity, or nullptr if there is no such
+  /// parameter or the metadata mime type also asks for compression.
+  static std::unique_ptr<RoutingHeaderTable> fromSetup(const Frame_SETUP&);
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /// Replaces the routing header at the front of `metadata` with its
+  /// index, if already sent, or marks it for indexing.
+  void encode(std::unique_ptr<folly::IOBuf>& metadata);
+
+  /// Expands an indexed routing header at the front of `metadata` back into
+  /// the full header. Returns DecodeError::INVALID_ROUTING_HEADER for an
+  /// index that isn't in the table or a literal that isn't a routing
+  /// header.
+  DecodeError decode(std::unique_ptr<folly::IOBuf>& metadata);
+  DecodeError decode(LazyFrame& frame);
+
+  /// Bytes of the capacity in use by the headers sent and received.
+  size_t encoderSize() const {
+    return encoder_.size;
+  }
+
+  size_t decoderSize() const {
+    return decoder_.size;
+  }
+
+  /// Length of the routing header at the front of `metadata`, none if it
+  /// doesn't start with one that can be indexed.
+  static folly::Optional<size_t> routingHeaderLength(
+      folly::ByteRange metadata);
+
+ private:
+  struct Table {
+    // Oldest entry first.
+    std::deque<std::string> entries;
+    size_t size{0};
+    // Entries ever added, the insertion number of the next one.
+    uint64_t inserted{0};
+  };
+
+  // Adds `header` to `table`, evicting the oldest entries to make room.
+  // Calls `evicted` with each evicted entry.
+  template <typename Evicted>
+  void insert(Table& table, folly::ByteRange header, Evicted&& evicted);
+
+  const std::string* lookup(uint32_t index) const;
+
+  const size_t capacity_;
+  Table encoder_;
+  Table decoder_;
+  // Header -> insertion number, for the entries of encoder_.
+  std::unordered_map<std::string, uint64_t> encoderIndex_;
+};
+
+} // namespace proteus
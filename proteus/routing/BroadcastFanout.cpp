@@ -0,0 +1,122 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/BroadcastFanout.h"
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t BroadcastFanout::kFrameHeaderSize;
+
+BroadcastFanout::BroadcastFanout(
+    LazyFrame&& frame,
+    PayloadCompressor* compressor)
+    : frame_(std::move(frame)), source_(compressor) {
+  if (source_ &&
+      source_->metadataCompression() != PayloadCompression::NONE) {
+    auto payload = frame_.clonePayload();
+    if (source_->decompress(payload) == DecodeError::NONE) {
+      frame_.replacePayload(std::move(payload));
+      source_ = nullptr;
+    } else {
+      // Still copied as received by writeTo(), but routed nowhere.
+      corrupt_ = true;
+    }
+  }
+
+  // The view points into the buffer of frame_, which the bodies share.
+  if (!corrupt_) {
+    if (auto metadata = frame_.metadataRange()) {
+      view_ = BroadcastView::tryParse(*metadata);
+    }
+  }
+  encodings_.push_back(split(frame_.clone(), formatOf(source_)));
+}
+
+bool BroadcastFanout::writeTo(
+    FrameBatch& batch,
+    rsocket::StreamId streamId,
+    PayloadCompressor* compressor) {
+  const auto* encoding = findEncoding(compressor);
+  if (!encoding) {
+    return false;
+  }
+  batch.beginFrame(kFrameHeaderSize, encoding->bodyLength);
+  batch.writeBE<uint32_t>(static_cast<uint32_t>(streamId));
+  batch.writeBE<uint16_t>(encoding->typeAndFlags);
+  if (encoding->body) {
+    batch.insert(encoding->body->clone());
+  }
+  return true;
+}
+
+BroadcastFanout::Format BroadcastFanout::formatOf(
+    const PayloadCompressor* compressor) {
+  if (!compressor) {
+    return Format(PayloadCompression::NONE, PayloadCompression::NONE);
+  }
+  return Format(
+      compressor->metadataCompression(), compressor->dataCompression());
+}
+
+BroadcastFanout::Encoding BroadcastFanout::split(
+    LazyFrame frame,
+    Format format) {
+  Encoding encoding;
+  encoding.format = format;
+  auto buffer = frame.releaseBuffer();
+  DCHECK(buffer);
+  folly::io::Cursor cur(buffer.get());
+  cur.skip(sizeof(uint32_t));
+  encoding.typeAndFlags = cur.readBE<uint16_t>();
+
+  folly::IOBufQueue body;
+  body.append(std::move(buffer));
+  body.trimStart(kFrameHeaderSize);
+  encoding.body = body.move();
+  encoding.bodyLength =
+      encoding.body ? encoding.body->computeChainDataLength() : 0;
+  return encoding;
+}
+
+const BroadcastFanout::Encoding* BroadcastFanout::findEncoding(
+    PayloadCompressor* compressor) {
+  const auto format = formatOf(compressor);
+  for (const auto& encoding : encodings_) {
+    if (encoding.format == format) {
+      return &encoding;
+    }
+  }
+  if (corrupt_) {
+    return nullptr;
+  }
+
+  auto payload = frame_.clonePayload();
+  if (source_ && source_->decompress(payload) != DecodeError::NONE) {
+    corrupt_ = true;
+    return nullptr;
+  }
+  if (compressor) {
+    compressor->compress(payload);
+  }
+  auto frame = frame_.clone();
+  frame.replacePayload(std::move(payload));
+  encodings_.push_back(split(std::move(frame), format));
+  return &encodings_.back();
+}
+
+} // namespace proteus
@@ -0,0 +1,170 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameBatch.h"
+#include "proteus/framing/LazyFrame.h"
+#include "proteus/framing/NameTable.h"
+#include "proteus/framing/PayloadCompression.h"
+#include "proteus/routing/GroupRoutingTable.h"
+#include "rsocket/internal/Common.h"
+
+namespace proteus {
+
+/// Sends one received BROADCAST frame to every destination of its group.
+///
+/// The frame is serialized once: everything after its frame header is kept
+/// as a shared body, and each copy is the frame header with the stream ID of
+/// the destination's connection, written into that connection's FrameBatch,
+/// followed by a clone of the body. Broadcasting to n destinations costs n
+/// frame headers and n IOBuf clones, not n copies of the payload, and every
+/// connection gets its copy in the batch it writes with its next writev.
+///
+/// Connections whose batch checksums frames still read the whole body for
+/// every copy.
+///
+/// The frame must come from FrameSerializer::tryDeserializeFrom, which has
+/// already verified and trimmed the checksum trailer and expanded any
+/// indexed routing header. Each batch adds its own trailer, and a routing
+/// header table on a destination connection reads the full header as plain
+/// metadata.
+///
+/// Destination connections that compress payloads like the source
+/// connection share the received body. For each other payload compression
+/// the payload is decompressed and compressed again once, into a body the
+/// destinations compressing that way share. A payload whose metadata is
+/// compressed is decompressed up front, as the routing header must be read.
+/// Destinations the payload can't be re-encoded for, because it doesn't
+/// decompress, are skipped.
+///
+///   BroadcastFanout fanout(std::move(frame), source->payloadCompressor());
+///   fanout.fanOut(table, [&](NameId destination) {
+///     auto* connection = connections.find(destination);
+///     return BroadcastFanout::Target{&connection->pendingWrites(),
+///                                    connection->nextStreamId(),
+///                                    connection->payloadCompressor()};
+///   });
+class BroadcastFanout {
+ public:
+  /// Where the copy for a destination goes: the pending batch of its
+  /// connection, the stream ID to send it on and the connection's payload
+  /// compressor, if any. A null batch skips the destination.
+  struct Target {
+    FrameBatch* batch{nullptr};
+    rsocket::StreamId streamId{0};
+    PayloadCompressor* compressor{nullptr};
+  };
+
+  /// Takes the serialized frame out of `frame`, leaving it empty.
+  /// `compressor` is the payload compressor of the connection the frame was
+  /// received on, if any. A frame whose metadata isn't a BROADCAST routing
+  /// header can still be copied with writeTo(), but fanOut() sends it
+  /// nowhere.
+  explicit BroadcastFanout(
+      LazyFrame&& frame,
+      PayloadCompressor* compressor = nullptr);
+
+  BroadcastFanout(const BroadcastFanout&) = delete;
+  BroadcastFanout& operator=(const BroadcastFanout&) = delete;
+
+  /// Routing header of the frame, pointing into the shared body.
+  const folly::Optional<BroadcastView>& view() const {
+    return view_;
+  }
+
+  /// Size of the copies sharing the received body, without the length
+  /// field written by the batch.
+  size_t frameLength() const {
+    return kFrameHeaderSize + encodings_.front().bodyLength;
+  }
+
+  /// Appends a copy of the frame sent on `streamId` to `batch`, whose
+  /// connection compresses payloads with `compressor`, if any. Returns
+  /// false, leaving the batch as it is, if the payload can't be re-encoded
+  /// for `compressor`.
+  bool writeTo(
+      FrameBatch& batch,
+      rsocket::StreamId streamId,
+      PayloadCompressor* compressor = nullptr);
+
+  /// Appends a copy of the frame to the batch `target` returns for every
+  /// destination of the frame's group. Returns the number of copies, which
+  /// leaves out the destinations writeTo() skipped. Like the
+  /// GroupRoutingTable lookup it runs in, `target` must not block nor
+  /// change the table.
+  template <typename F>
+  size_t fanOut(const GroupRoutingTable& table, F&& target) {
+    if (!view_) {
+      return 0;
+    }
+    size_t copies = 0;
+    table.withDestinations(
+        *view_, [&](folly::Range<const NameId*> destinations) {
+          for (const auto destination : destinations) {
+            const Target to = target(destination);
+            if (to.batch && writeTo(*to.batch, to.streamId, to.compressor)) {
+              ++copies;
+            }
+          }
+        });
+    return copies;
+  }
+
+ private:
+  static constexpr size_t kFrameHeaderSize = 6; // bytes
+
+  // Metadata and data compression of a connection's payloads.
+  using Format = std::pair<PayloadCompression, PayloadCompression>;
+
+  static Format formatOf(const PayloadCompressor* compressor);
+
+  // Everything after the frame header of the copies in one format.
+  struct Encoding {
+    Format format;
+    // Frame type and flags, as they are on the wire.
+    uint16_t typeAndFlags{0};
+    std::unique_ptr<folly::IOBuf> body;
+    size_t bodyLength{0};
+  };
+
+  static Encoding split(LazyFrame frame, Format format);
+
+  // The body for connections compressing with `compressor`, re-encoded on
+  // first use. nullptr if the payload doesn't decompress.
+  const Encoding* findEncoding(PayloadCompressor* compressor);
+
+  // The frame as received, or with its payload decompressed.
+  LazyFrame frame_;
+  // Compresses like the connection `frame_` was received on.
+  PayloadCompressor* source_{nullptr};
+  // Set once the payload failed to decompress.
+  bool corrupt_{false};
+  // The received body comes first.
+  std::vector<Encoding> encodings_;
+  folly::Optional<BroadcastView> view_;
+};
+
+} // namespace proteus
@@ -0,0 +1,140 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/CreditManager.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include "proteus/framing/Frame.h"
+
+namespace proteus {
+
+namespace {
+constexpr uint32_t kMaxRequestN =
+    static_cast<uint32_t>(Frame_REQUEST_N::kMaxRequestN);
+
+uint32_t addRequestN(uint32_t demand, uint32_t requestN) {
+  return static_cast<uint32_t>(
+      std::min<uint64_t>(uint64_t(demand) + requestN, kMaxRequestN));
+}
+} // namespace
+
+CreditManager::CreditManager(
+    uint32_t maxBufferedFrames,
+    uint32_t minRequestN,
+    Clock::duration maxDelay)
+    : maxBufferedFrames_(std::min(maxBufferedFrames, kMaxRequestN)),
+      minRequestN_(minRequestN),
+      maxDelay_(maxDelay) {
+  DCHECK_GT(maxBufferedFrames_, 0u);
+}
+
+uint32_t CreditManager::open(rsocket::StreamId streamId, uint32_t requestN) {
+  auto& stream = streams_[streamId];
+  DCHECK_EQ(0u, stream.outstanding + stream.buffered);
+  stream.demand = addRequestN(0, requestN);
+  stream.unbounded = stream.demand == kMaxRequestN;
+  // The request frame carries it right away, there is nothing to coalesce
+  // it with.
+  return grant(streamId, stream, Clock::time_point(), true);
+}
+
+void CreditManager::close(rsocket::StreamId streamId) {
+  auto it = streams_.find(streamId);
+  if (it == streams_.end()) {
+    return;
+  }
+  bufferedFrames_ -= it->second.buffered;
+  streams_.erase(it);
+}
+
+uint32_t CreditManager::request(
+    rsocket::StreamId streamId,
+    uint32_t requestN,
+    Clock::time_point now) {
+  auto it = streams_.find(streamId);
+  if (it == streams_.end()) {
+    return requestN;
+  }
+  auto& stream = it->second;
+  stream.demand = addRequestN(stream.demand, requestN);
+  stream.unbounded = stream.unbounded || stream.demand == kMaxRequestN;
+  return grant(streamId, stream, now, false);
+}
+
+bool CreditManager::receive(rsocket::StreamId streamId) {
+  auto it = streams_.find(streamId);
+  if (it == streams_.end()) {
+    return true;
+  }
+  auto& stream = it->second;
+  if (stream.outstanding == 0) {
+    return false;
+  }
+  --stream.outstanding;
+  ++stream.buffered;
+  ++bufferedFrames_;
+  return true;
+}
+
+uint32_t CreditManager::deliver(
+    rsocket::StreamId streamId,
+    uint32_t frames,
+    Clock::time_point now) {
+  auto it = streams_.find(streamId);
+  if (it == streams_.end()) {
+    return 0;
+  }
+  auto& stream = it->second;
+  DCHECK_LE(frames, stream.buffered);
+  frames = std::min(frames, stream.buffered);
+  stream.buffered -= frames;
+  bufferedFrames_ -= frames;
+  return grant(streamId, stream, now, false);
+}
+
+uint32_t CreditManager::grant(
+    rsocket::StreamId streamId,
+    Stream& stream,
+    Clock::time_point now,
+    bool force) {
+  const auto inFlight = stream.outstanding + stream.buffered;
+  const auto room =
+      maxBufferedFrames_ > inFlight ? maxBufferedFrames_ - inFlight : 0;
+  const auto requestN = std::min(stream.demand, room);
+  if (requestN == 0) {
+    // Either nothing is asked for or the buffer is full, in which case
+    // deliver() grants the demand as it drains.
+    stream.waiting = false;
+    return 0;
+  }
+  if (!force && requestN < minRequestN_ && stream.outstanding > 0) {
+    if (!stream.waiting) {
+      stream.waiting = true;
+      stream.waitingSince = now;
+      waiting_.emplace_back(streamId, now);
+    }
+    return 0;
+  }
+  if (!stream.unbounded) {
+    stream.demand -= requestN;
+  }
+  stream.outstanding += requestN;
+  stream.waiting = false;
+  return requestN;
+}
+
+} // namespace proteus
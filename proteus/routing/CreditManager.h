@@ -0,0 +1,145 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include "rsocket/internal/Common.h"
+
+namespace proteus {
+
+/// Flow control of the streams a broker relays from one upstream
+/// connection, per stream.
+///
+/// REQUEST_N frames from a subscriber aren't relayed one for one. Their
+/// demand is added up, and only granted upstream once at least minRequestN
+/// of it can be granted, or once the upstream has no credit left, or once
+/// it has waited maxDelay, whichever comes first. Payloads relayed to a
+/// subscriber that reads slowly are buffered by the broker: no more than
+/// maxBufferedFrames are ever granted upstream ahead of what the subscriber
+/// was delivered, so the upstream stalls instead of broker memory growing.
+/// A stream whose requests add up to kMaxRequestN is unbounded: it becomes
+/// a sliding window of maxBufferedFrames that never runs out.
+///
+/// Streams are keyed by their stream ID on the upstream connection. Not
+/// thread-safe, a credit manager belongs to one connection.
+class CreditManager {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  CreditManager(
+      uint32_t maxBufferedFrames,
+      uint32_t minRequestN,
+      Clock::duration maxDelay);
+
+  /// Starts tracking a stream relayed upstream by a REQUEST_STREAM or
+  /// REQUEST_CHANNEL frame asking for `requestN`. Returns the request N to
+  /// relay in that frame, the rest is granted as payloads are delivered.
+  uint32_t open(rsocket::StreamId streamId, uint32_t requestN);
+
+  /// Stops tracking a stream, completed, cancelled or errored.
+  void close(rsocket::StreamId streamId);
+
+  /// Adds the demand of a REQUEST_N frame from the subscriber. Returns the
+  /// request N to relay upstream now, 0 to relay nothing yet.
+  uint32_t request(
+      rsocket::StreamId streamId,
+      uint32_t requestN,
+      Clock::time_point now);
+
+  /// Accounts a PAYLOAD frame received from upstream, buffered until it is
+  /// delivered. Returns false if the upstream wasn't granted it, which is a
+  /// protocol error. Payloads of untracked streams are always accepted.
+  bool receive(rsocket::StreamId streamId);
+
+  /// Accounts `frames` payloads written to the subscriber. Returns the
+  /// request N to relay upstream now, 0 to relay nothing yet.
+  uint32_t deliver(
+      rsocket::StreamId streamId,
+      uint32_t frames,
+      Clock::time_point now);
+
+  /// Grants the demand that waited maxDelay or more, calling
+  /// `f(streamId, requestN)` for each REQUEST_N to relay upstream. Meant to
+  /// be called once per event loop iteration. Returns how many there were.
+  template <typename F>
+  size_t flush(Clock::time_point now, F&& f) {
+    size_t flushed = 0;
+    while (!waiting_.empty() && waiting_.front().second + maxDelay_ <= now) {
+      const auto streamId = waiting_.front().first;
+      const auto since = waiting_.front().second;
+      waiting_.pop_front();
+      auto it = streams_.find(streamId);
+      // Skips streams granted, closed or waiting again since then.
+      if (it == streams_.end() || !it->second.waiting ||
+          it->second.waitingSince != since) {
+        continue;
+      }
+      if (const auto requestN = grant(streamId, it->second, now, true)) {
+        f(streamId, requestN);
+        ++flushed;
+      }
+    }
+    return flushed;
+  }
+
+  /// Payloads buffered for all streams.
+  size_t bufferedFrames() const {
+    return bufferedFrames_;
+  }
+
+  size_t streamCount() const {
+    return streams_.size();
+  }
+
+ private:
+  struct Stream {
+    // Requested by the subscriber, not granted upstream yet. Stays at
+    // kMaxRequestN once unbounded.
+    uint32_t demand{0};
+    bool unbounded{false};
+    // Granted upstream, not received yet.
+    uint32_t outstanding{0};
+    // Received, not delivered yet.
+    uint32_t buffered{0};
+    // Whether demand is held back to be coalesced, since when.
+    bool waiting{false};
+    Clock::time_point waitingSince;
+  };
+
+  // Grants as much demand as the buffer has room for. Unless `force`, a
+  // grant smaller than minRequestN is held back while the upstream still
+  // has credit.
+  uint32_t grant(
+      rsocket::StreamId streamId,
+      Stream& stream,
+      Clock::time_point now,
+      bool force);
+
+  const uint32_t maxBufferedFrames_;
+  const uint32_t minRequestN_;
+  const Clock::duration maxDelay_;
+  size_t bufferedFrames_{0};
+  std::unordered_map<rsocket::StreamId, Stream> streams_;
+  // Streams holding demand back, oldest first.
+  std::deque<std::pair<rsocket::StreamId, Clock::time_point>> waiting_;
+};
+
+} // namespace proteus
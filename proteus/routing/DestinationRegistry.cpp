@@ -0,0 +1,347 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/DestinationRegistry.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+#include <folly/portability/Asm.h>
+#include <folly/synchronization/Rcu.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+namespace {
+
+// Control bytes: 0x80 for an empty slot, 0xFE for a removed one, the low 7
+// bits of the hash for a full one. A control word holds the bytes of a
+// group of 8 slots.
+constexpr size_t kGroupSize = 8; // slots
+constexpr size_t kMinCapacity = 2 * kGroupSize; // slots
+constexpr uint8_t kEmpty = 0x80;
+constexpr uint8_t kRemoved = 0xFE;
+constexpr uint64_t kLsbs = 0x0101010101010101;
+constexpr uint64_t kMsbs = 0x8080808080808080;
+
+// Top bit of every control byte of `group` equal to `tag`. Bytes above a
+// match may match spuriously, which the key compare weeds out.
+uint64_t matchTag(uint64_t group, uint8_t tag) {
+  const auto bytes = group ^ (kLsbs * tag);
+  return (bytes - kLsbs) & ~bytes & kMsbs;
+}
+
+uint64_t matchEmpty(uint64_t group) {
+  return group & ~(group << 6) & kMsbs;
+}
+
+// Empty and removed slots, the ones with the top bit set.
+uint64_t matchFree(uint64_t group) {
+  return group & kMsbs;
+}
+
+size_t firstMatch(uint64_t matches) {
+  return (folly::findFirstSet(matches) - 1) / 8;
+}
+
+uint8_t tagOf(uint64_t hash) {
+  return hash & 0x7F;
+}
+
+} // namespace
+
+constexpr size_t DestinationRegistry::kShardBits;
+constexpr size_t DestinationRegistry::kShards;
+
+// Read concurrently with the writer that owns it: every field lookups read
+// is an atomic, the sequence lock of the shard makes what they read
+// consistent. Counters only the writer reads are plain.
+class DestinationRegistry::Table {
+ public:
+  explicit Table(size_t capacity)
+      : groupMask_(capacity / kGroupSize - 1),
+        control_(capacity / kGroupSize),
+        slots_(capacity) {
+    DCHECK_EQ(capacity, folly::nextPowTwo(capacity));
+    DCHECK_GE(capacity, kMinCapacity);
+    for (auto& group : control_) {
+      group.store(kLsbs * kEmpty, std::memory_order_relaxed);
+    }
+  }
+
+  size_t capacity() const {
+    return slots_.size();
+  }
+
+  // Whether one more entry fits without dropping under 1/8 free slots.
+  bool hasRoom() const {
+    return (size_ + removed_ + 1) * 8 <= capacity() * 7;
+  }
+
+  folly::Optional<Handle> find(uint64_t key, uint64_t hash) const {
+    auto index = lookup(key, hash);
+    if (index == kNotFound) {
+      return folly::none;
+    }
+    return slots_[index].handle.load(std::memory_order_relaxed);
+  }
+
+  // Returns false, and replaces the handle, if `key` is already in.
+  bool insert(uint64_t key, uint64_t hash, Handle handle) {
+    auto index = lookup(key, hash);
+    if (index != kNotFound) {
+      slots_[index].handle.store(handle, std::memory_order_relaxed);
+      return false;
+    }
+    DCHECK(hasRoom());
+    forEachGroup(hash, [&](size_t group, uint64_t bytes) {
+      const auto matches = matchFree(bytes);
+      if (!matches) {
+        return false;
+      }
+      index = group * kGroupSize + firstMatch(matches);
+      return true;
+    });
+    if (controlByte(index) == kRemoved) {
+      --removed_;
+    }
+    slots_[index].key.store(key, std::memory_order_relaxed);
+    slots_[index].handle.store(handle, std::memory_order_relaxed);
+    setControlByte(index, tagOf(hash));
+    ++size_;
+    return true;
+  }
+
+  bool remove(uint64_t key, uint64_t hash) {
+    const auto index = lookup(key, hash);
+    if (index == kNotFound) {
+      return false;
+    }
+    setControlByte(index, kRemoved);
+    --size_;
+    ++removed_;
+    return true;
+  }
+
+  template <typename F>
+  void forEach(F&& f) const {
+    for (size_t index = 0; index < capacity(); ++index) {
+      if (!(controlByte(index) & kEmpty)) {
+        const auto& slot = slots_[index];
+        f(slot.key.load(std::memory_order_relaxed),
+          slot.handle.load(std::memory_order_relaxed));
+      }
+    }
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  static constexpr size_t kNotFound = ~size_t(0);
+
+  struct Slot {
+    std::atomic<uint64_t> key{0};
+    std::atomic<Handle> handle{0};
+  };
+
+  // Calls `f(group, controlWord)` along the probe sequence of `hash` until
+  // it returns true. Groups are probed at triangular offsets, which visit
+  // every group of a power of two sized table.
+  template <typename F>
+  void forEachGroup(uint64_t hash, F&& f) const {
+    auto group = (hash >> 7) & groupMask_;
+    for (size_t step = 1;; ++step) {
+      if (f(group, control_[group].load(std::memory_order_relaxed))) {
+        return;
+      }
+      group = (group + step) & groupMask_;
+    }
+  }
+
+  size_t lookup(uint64_t key, uint64_t hash) const {
+    auto index = kNotFound;
+    forEachGroup(hash, [&](size_t group, uint64_t bytes) {
+      for (auto matches = matchTag(bytes, tagOf(hash)); matches;
+           matches &= matches - 1) {
+        const auto candidate = group * kGroupSize + firstMatch(matches);
+        if (slots_[candidate].key.load(std::memory_order_relaxed) == key) {
+          index = candidate;
+          return true;
+        }
+      }
+      // A key is never probed for past a group with an empty slot, where
+      // its insertion would have stopped.
+      return matchEmpty(bytes) != 0;
+    });
+    return index;
+  }
+
+  uint8_t controlByte(size_t index) const {
+    const auto bytes =
+        control_[index / kGroupSize].load(std::memory_order_relaxed);
+    return bytes >> (8 * (index % kGroupSize));
+  }
+
+  void setControlByte(size_t index, uint8_t byte) {
+    auto& group = control_[index / kGroupSize];
+    const auto shift = 8 * (index % kGroupSize);
+    auto bytes = group.load(std::memory_order_relaxed);
+    bytes = (bytes & ~(uint64_t(0xFF) << shift)) | (uint64_t(byte) << shift);
+    group.store(bytes, std::memory_order_relaxed);
+  }
+
+  const size_t groupMask_;
+  std::vector<std::atomic<uint64_t>> control_;
+  std::vector<Slot> slots_;
+  size_t size_{0};
+  size_t removed_{0};
+};
+
+constexpr size_t DestinationRegistry::Table::kNotFound;
+
+DestinationRegistry::DestinationRegistry(NameTable& names) : names_(names) {
+  for (auto& shard : shards_) {
+    shard->table.store(new Table(kMinCapacity), std::memory_order_relaxed);
+  }
+}
+
+DestinationRegistry::~DestinationRegistry() {
+  for (auto& shard : shards_) {
+    delete shard->table.load(std::memory_order_acquire);
+  }
+}
+
+bool DestinationRegistry::add(
+    NameId group,
+    NameId destination,
+    Handle handle) {
+  const auto k = key(group, destination);
+  const auto hash = folly::hash::twang_mix64(k);
+  auto& s = shard(hash);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto* table = s.table.load(std::memory_order_relaxed);
+
+  if (!table->hasRoom()) {
+    // Sized for the live entries only, so a table full of removed slots is
+    // cleaned up rather than grown.
+    auto next = std::make_unique<Table>(std::max(
+        kMinCapacity, folly::nextPowTwo(2 * (table->size() + 1))));
+    table->forEach([&](uint64_t otherKey, Handle otherHandle) {
+      next->insert(
+          otherKey, folly::hash::twang_mix64(otherKey), otherHandle);
+    });
+    s.table.store(next.get(), std::memory_order_release);
+    // Lookups that loaded the old table may still be probing it.
+    folly::rcu_retire(table);
+    table = next.release();
+  }
+
+  const auto version = s.version.load(std::memory_order_relaxed);
+  s.version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  const auto added = table->insert(k, hash, handle);
+  s.version.store(version + 2, std::memory_order_release);
+
+  if (added) {
+    s.size.store(table->size(), std::memory_order_relaxed);
+  }
+  return added;
+}
+
+bool DestinationRegistry::remove(NameId group, NameId destination) {
+  const auto k = key(group, destination);
+  const auto hash = folly::hash::twang_mix64(k);
+  auto& s = shard(hash);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto* table = s.table.load(std::memory_order_relaxed);
+
+  const auto version = s.version.load(std::memory_order_relaxed);
+  s.version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  const auto removed = table->remove(k, hash);
+  s.version.store(version + 2, std::memory_order_release);
+
+  if (removed) {
+    s.size.store(table->size(), std::memory_order_relaxed);
+  }
+  return removed;
+}
+
+folly::Optional<DestinationRegistry::Handle> DestinationRegistry::find(
+    NameId group,
+    NameId destination) const {
+  const auto k = key(group, destination);
+  const auto hash = folly::hash::twang_mix64(k);
+  const auto& s = shard(hash);
+
+  folly::rcu_reader guard;
+  for (;;) {
+    const auto version = s.version.load(std::memory_order_acquire);
+    if (version & 1) {
+      folly::asm_volatile_pause();
+      continue;
+    }
+    const auto handle =
+        s.table.load(std::memory_order_acquire)->find(k, hash);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.version.load(std::memory_order_relaxed) == version) {
+      return handle;
+    }
+  }
+}
+
+bool DestinationRegistry::add(
+    const DestinationSetupView& setup,
+    Handle handle) {
+  // The names come from a peer, the table of names may be full.
+  const auto group = names_.tryIntern(setup.group());
+  const auto destination =
+      group ? names_.tryIntern(setup.destination()) : folly::none;
+  if (!destination) {
+    return false;
+  }
+  add(*group, *destination, handle);
+  return true;
+}
+
+bool DestinationRegistry::remove(const DestinationSetupView& setup) {
+  const auto group = names_.find(setup.group());
+  const auto destination = names_.find(setup.destination());
+  return group && destination && remove(*group, *destination);
+}
+
+folly::Optional<DestinationRegistry::Handle> DestinationRegistry::find(
+    const DestinationView& frame) const {
+  const auto group = names_.find(frame.toGroup());
+  const auto destination = names_.find(frame.toDestination());
+  if (!group || !destination) {
+    return folly::none;
+  }
+  return find(*group, *destination);
+}
+
+size_t DestinationRegistry::size() const {
+  size_t size = 0;
+  for (const auto& shard : shards_) {
+    size += shard->size.load(std::memory_order_relaxed);
+  }
+  return size;
+}
+
+} // namespace proteus
@@ -0,0 +1,111 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <folly/CachelinePadded.h>
+#include <folly/Optional.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/NameTable.h"
+
+namespace proteus {
+
+/// Connection of every registered destination, which DESTINATION frames are
+/// routed to.
+///
+/// Destinations register with DESTINATION_SETUP frames and are looked up on
+/// every DESTINATION frame, by every IO thread. Entries are keyed by the
+/// interned (group, destination) pair and hold a dense connection handle,
+/// in flat open-addressing tables: a lookup hashes the key once, then scans
+/// the control bytes of 8 slots at a time with word-wide compares and only
+/// touches slots whose control byte matches 7 bits of the hash.
+///
+/// The registry is split into shards, each with its own table and writer
+/// mutex, so registrations landing in different shards don't contend.
+/// Lookups take no lock: a shard's table is changed in place inside a
+/// sequence lock, which lookups retry on, and replaced by a bigger one
+/// through RCU.
+class DestinationRegistry {
+ public:
+  /// Index of a connection in the broker's connection table.
+  using Handle = uint32_t;
+
+  static constexpr size_t kShardBits = 6;
+  static constexpr size_t kShards = size_t(1) << kShardBits;
+
+  explicit DestinationRegistry(NameTable& names = NameTable::global());
+  ~DestinationRegistry();
+
+  DestinationRegistry(const DestinationRegistry&) = delete;
+  DestinationRegistry& operator=(const DestinationRegistry&) = delete;
+
+  /// Registers `destination` of `group` on `handle`, replacing the handle of
+  /// an earlier registration. Returns false if there was one.
+  bool add(NameId group, NameId destination, Handle handle);
+
+  /// Unregisters `destination` of `group`. Returns false if it wasn't
+  /// registered.
+  bool remove(NameId group, NameId destination);
+
+  folly::Optional<Handle> find(NameId group, NameId destination) const;
+
+  /// Registers the destination a DESTINATION_SETUP frame announces,
+  /// replacing an earlier registration. Returns false, registering
+  /// nothing, if its names can't be interned because the NameTable is full;
+  /// the setup should then be rejected.
+  bool add(const DestinationSetupView& setup, Handle handle);
+  bool remove(const DestinationSetupView& setup);
+
+  /// Connection of the destination a DESTINATION frame is addressed to.
+  /// Never interns the names.
+  folly::Optional<Handle> find(const DestinationView& frame) const;
+
+  /// Number of registered destinations.
+  size_t size() const;
+
+ private:
+  class Table;
+
+  struct Shard {
+    // Odd while a writer changes the table in place.
+    std::atomic<uint64_t> version{0};
+    std::atomic<Table*> table{nullptr};
+    std::atomic<size_t> size{0};
+    std::mutex mutex;
+  };
+
+  static uint64_t key(NameId group, NameId destination) {
+    return (uint64_t(group) << 32) | destination;
+  }
+
+  Shard& shard(uint64_t hash) {
+    return *shards_[hash >> (64 - kShardBits)].get();
+  }
+
+  const Shard& shard(uint64_t hash) const {
+    return *shards_[hash >> (64 - kShardBits)].get();
+  }
+
+  NameTable& names_;
+  std::array<folly::CachelinePadded<Shard>, kShards> shards_;
+};
+
+} // namespace proteus
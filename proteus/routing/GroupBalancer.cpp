@@ -0,0 +1,164 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/GroupBalancer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include <folly/CachelinePadded.h>
+#include <folly/Random.h>
+#include <glog/logging.h>
+
+#include "proteus/routing/NameIdArray.h"
+
+namespace proteus {
+
+namespace {
+
+// Two distinct random indexes below `size`, which is at least 2.
+std::pair<size_t, size_t> pickTwo(size_t size) {
+  DCHECK_GE(size, 2u);
+  const auto first = folly::Random::rand32(static_cast<uint32_t>(size));
+  auto second = folly::Random::rand32(static_cast<uint32_t>(size - 1));
+  if (second >= first) {
+    ++second;
+  }
+  return {first, second};
+}
+
+uint64_t gcd(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    a = std::exchange(b, a % b);
+  }
+  return a;
+}
+
+class LeastOutstanding : public GroupBalancer {
+ public:
+  using GroupBalancer::GroupBalancer;
+
+  NameId select(
+      NameId,
+      folly::Range<const NameId*> destinations,
+      LoadStats::Clock::time_point) override {
+    DCHECK(!destinations.empty());
+    if (destinations.size() == 1) {
+      return destinations[0];
+    }
+    const auto picked = pickTwo(destinations.size());
+    const auto first = destinations[picked.first];
+    const auto second = destinations[picked.second];
+    return stats().outstanding(second) < stats().outstanding(first) ? second
+                                                                    : first;
+  }
+};
+
+class PeakEwma : public GroupBalancer {
+ public:
+  using GroupBalancer::GroupBalancer;
+
+  NameId select(
+      NameId,
+      folly::Range<const NameId*> destinations,
+      LoadStats::Clock::time_point now) override {
+    DCHECK(!destinations.empty());
+    if (destinations.size() == 1) {
+      return destinations[0];
+    }
+    const auto picked = pickTwo(destinations.size());
+    const auto first = destinations[picked.first];
+    const auto second = destinations[picked.second];
+    return stats().cost(second, now) < stats().cost(first, now) ? second
+                                                                : first;
+  }
+};
+
+class WeightedRoundRobin : public GroupBalancer {
+ public:
+  using GroupBalancer::GroupBalancer;
+
+  NameId select(
+      NameId group,
+      folly::Range<const NameId*> destinations,
+      LoadStats::Clock::time_point) override {
+    DCHECK(!destinations.empty());
+    const auto turn =
+        (*turns_[group]).fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t total = 0;
+    for (const auto destination : destinations) {
+      total += stats().weight(destination);
+    }
+    if (total == 0) {
+      return destinations[turn % destinations.size()];
+    }
+
+    // Turns step through the slots by a stride coprime with the total, so
+    // every slot comes up once per round. A stride near the golden section
+    // of the total spreads a destination's slots over the round instead of
+    // taking them back to back.
+    auto stride = std::max<uint64_t>(1, static_cast<uint64_t>(total * 0.618));
+    while (gcd(stride, total) != 1) {
+      ++stride;
+    }
+    auto slot = (turn % total) * stride % total;
+    for (const auto destination : destinations) {
+      const auto weight = stats().weight(destination);
+      if (slot < weight) {
+        return destination;
+      }
+      slot -= weight;
+    }
+    // Weights changed under us.
+    return destinations[turn % destinations.size()];
+  }
+
+ private:
+  NameIdArray<folly::CachelinePadded<std::atomic<uint64_t>>> turns_;
+};
+
+} // namespace
+
+std::unique_ptr<GroupBalancer> GroupBalancer::create(
+    Policy policy,
+    LoadStats& stats) {
+  switch (policy) {
+    case Policy::LEAST_OUTSTANDING:
+      return std::make_unique<LeastOutstanding>(stats);
+    case Policy::PEAK_EWMA:
+      return std::make_unique<PeakEwma>(stats);
+    case Policy::WEIGHTED_ROUND_ROBIN:
+      return std::make_unique<WeightedRoundRobin>(stats);
+  }
+  LOG(FATAL) << "unknown policy " << static_cast<int>(policy);
+  return nullptr;
+}
+
+folly::Optional<NameId> GroupBalancer::route(
+    const GroupRoutingTable& table,
+    NameId group,
+    LoadStats::Clock::time_point now) {
+  folly::Optional<NameId> destination;
+  table.withDestinations(group, [&](folly::Range<const NameId*> ids) {
+    destination = select(group, ids, now);
+  });
+  if (destination) {
+    stats_.start(*destination);
+  }
+  return destination;
+}
+
+} // namespace proteus
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include "proteus/framing/NameTable.h"
+#include "proteus/routing/GroupRoutingTable.h"
+#include "proteus/routing/LoadStats.h"
+
+namespace proteus {
+
+/// Picks which destination of a group a GROUP frame is routed to.
+///
+/// Policies select on the LoadStats they are created with and never lock:
+///  - LEAST_OUTSTANDING: the power of two choices, the one of two random
+///    destinations with fewer requests outstanding.
+///  - PEAK_EWMA: the same, comparing LoadStats::cost(), latency times
+///    outstanding requests. Steers away from a destination as soon as it
+///    slows down, e.g. in a GC pause, and back to it as its latency decays.
+///  - WEIGHTED_ROUND_ROBIN: every destination in turn, as many times as
+///    its weight, from a counter per group.
+///
+///   auto balancer = GroupBalancer::create(Policy::PEAK_EWMA, stats);
+///   if (auto destination = balancer->route(table, group, Clock::now())) {
+///     ...
+///     stats.complete(*destination, Clock::now() - start, Clock::now());
+///   }
+class GroupBalancer {
+ public:
+  enum class Policy : uint8_t {
+    LEAST_OUTSTANDING,
+    PEAK_EWMA,
+    WEIGHTED_ROUND_ROBIN,
+  };
+
+  static std::unique_ptr<GroupBalancer> create(Policy, LoadStats& stats);
+
+  explicit GroupBalancer(LoadStats& stats) : stats_(stats) {}
+  virtual ~GroupBalancer() = default;
+
+  GroupBalancer(const GroupBalancer&) = delete;
+  GroupBalancer& operator=(const GroupBalancer&) = delete;
+
+  /// Picks one of `destinations`, which must not be empty, for a request
+  /// to `group` at `now`.
+  virtual NameId select(
+      NameId group,
+      folly::Range<const NameId*> destinations,
+      LoadStats::Clock::time_point now) = 0;
+
+  /// Picks a destination of `group` in `table` and counts the request as
+  /// started on it. Returns none if the group has no destination.
+  folly::Optional<NameId> route(
+      const GroupRoutingTable& table,
+      NameId group,
+      LoadStats::Clock::time_point now);
+
+  LoadStats& stats() const {
+    return stats_;
+  }
+
+ private:
+  LoadStats& stats_;
+};
+
+} // namespace proteus
@@ -0,0 +1,144 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/GroupRoutingTable.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+#include <folly/Bits.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+GroupRoutingTable::Snapshot::Snapshot(size_t groupCount)
+    : mask_(folly::nextPowTwo(std::max<size_t>(2 * groupCount, 8)) - 1),
+      slots_(mask_ + 1) {}
+
+void GroupRoutingTable::Snapshot::insert(
+    NameId group,
+    Destinations* destinations) {
+  DCHECK(destinations);
+  DCHECK(!find(group));
+  for (auto i = group & mask_;; i = (i + 1) & mask_) {
+    auto& slot = slots_[i];
+    if (!slot.destinations) {
+      slot.group = group;
+      slot.destinations = destinations;
+      ++size_;
+      return;
+    }
+  }
+}
+
+GroupRoutingTable::GroupRoutingTable(NameTable& names)
+    : names_(names), snapshot_(new Snapshot(0)) {}
+
+GroupRoutingTable::~GroupRoutingTable() {
+  auto* snapshot = snapshot_.load(std::memory_order_acquire);
+  snapshot->forEach(
+      [](NameId, Destinations* destinations) { delete destinations; });
+  delete snapshot;
+}
+
+bool GroupRoutingTable::add(NameId group, NameId destination) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto* current = snapshot_.load(std::memory_order_relaxed)->find(group);
+  auto destinations =
+      current ? std::make_unique<Destinations>(*current)
+              : std::make_unique<Destinations>();
+  auto it = std::lower_bound(
+      destinations->begin(), destinations->end(), destination);
+  if (it != destinations->end() && *it == destination) {
+    return false;
+  }
+  destinations->insert(it, destination);
+  publish(group, destinations.release());
+  return true;
+}
+
+bool GroupRoutingTable::remove(NameId group, NameId destination) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto* current = snapshot_.load(std::memory_order_relaxed)->find(group);
+  if (!current ||
+      !std::binary_search(current->begin(), current->end(), destination)) {
+    return false;
+  }
+  if (current->size() == 1) {
+    publish(group, nullptr);
+    return true;
+  }
+  auto destinations = std::make_unique<Destinations>();
+  destinations->reserve(current->size() - 1);
+  std::remove_copy(
+      current->begin(),
+      current->end(),
+      std::back_inserter(*destinations),
+      destination);
+  publish(group, destinations.release());
+  return true;
+}
+
+bool GroupRoutingTable::add(const DestinationSetupView& setup) {
+  // The names come from a peer, the table of names may be full.
+  const auto group = names_.tryIntern(setup.group());
+  const auto destination =
+      group ? names_.tryIntern(setup.destination()) : folly::none;
+  return destination && add(*group, *destination);
+}
+
+bool GroupRoutingTable::remove(const DestinationSetupView& setup) {
+  const auto group = names_.find(setup.group());
+  const auto destination = names_.find(setup.destination());
+  return group && destination && remove(*group, *destination);
+}
+
+std::vector<NameId> GroupRoutingTable::destinations(NameId group) const {
+  std::vector<NameId> copy;
+  withDestinations(group, [&](folly::Range<const NameId*> destinations) {
+    copy.assign(destinations.begin(), destinations.end());
+  });
+  return copy;
+}
+
+size_t GroupRoutingTable::groupCount() const {
+  folly::rcu_reader guard;
+  return snapshot_.load(std::memory_order_acquire)->size();
+}
+
+void GroupRoutingTable::publish(NameId group, Destinations* destinations) {
+  auto* current = snapshot_.load(std::memory_order_relaxed);
+  auto* replaced = current->find(group);
+  auto* next = new Snapshot(
+      current->size() + (destinations ? 1 : 0) - (replaced ? 1 : 0));
+  current->forEach([&](NameId id, Destinations* other) {
+    if (id != group) {
+      next->insert(id, other);
+    }
+  });
+  if (destinations) {
+    next->insert(group, destinations);
+  }
+
+  snapshot_.store(next, std::memory_order_release);
+  // Lookups that loaded the old snapshot may still be reading it and the
+  // destinations it replaced.
+  folly::rcu_retire(current);
+  if (replaced) {
+    folly::rcu_retire(replaced);
+  }
+}
+
+} // namespace proteus
@@ -0,0 +1,151 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/synchronization/Rcu.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/NameTable.h"
+
+namespace proteus {
+
+/// Live destinations of every group, which GROUP frames are routed to.
+///
+/// Looked up on every GROUP frame by every IO thread, changed only when a
+/// destination connects (DESTINATION_SETUP) or goes away. Lookups read an
+/// immutable snapshot published through an atomic pointer and take no
+/// lock. Every change copies the snapshot and replaces the changed group's
+/// destinations, serialized by a mutex. What it replaces is freed through
+/// RCU, once no lookup can still be reading it.
+///
+///   table.withDestinations(groupView, [&](folly::Range<const NameId*> ds) {
+///     route(ds[pick(ds.size())]);
+///   });
+class GroupRoutingTable {
+ public:
+  explicit GroupRoutingTable(NameTable& names = NameTable::global());
+  ~GroupRoutingTable();
+
+  GroupRoutingTable(const GroupRoutingTable&) = delete;
+  GroupRoutingTable& operator=(const GroupRoutingTable&) = delete;
+
+  /// Adds `destination` to `group`. Returns false if it already was in it.
+  bool add(NameId group, NameId destination);
+
+  /// Removes `destination` from `group`, and the group once it has no
+  /// destination left. Returns false if it wasn't in it.
+  bool remove(NameId group, NameId destination);
+
+  /// Adds the destination a DESTINATION_SETUP frame announces to its group.
+  /// Also returns false, adding nothing, if its names can't be interned
+  /// because the NameTable is full; the setup should then be rejected.
+  bool add(const DestinationSetupView& setup);
+  bool remove(const DestinationSetupView& setup);
+
+  /// Calls `f` with the destinations of `group`, sorted by NameId, unless
+  /// it has none. Returns whether `f` was called. The range is only valid
+  /// inside `f`, which runs in an RCU read-side critical section and must
+  /// not block nor change the table.
+  template <typename F>
+  bool withDestinations(NameId group, F&& f) const {
+    folly::rcu_reader guard;
+    const auto* destinations =
+        snapshot_.load(std::memory_order_acquire)->find(group);
+    if (!destinations) {
+      return false;
+    }
+    f(folly::Range<const NameId*>(
+        destinations->data(), destinations->size()));
+    return true;
+  }
+
+  /// Same for the group a GROUP or BROADCAST frame is addressed to. Never
+  /// interns the group name.
+  template <typename F>
+  bool withDestinations(const GroupView& frame, F&& f) const {
+    const auto group = names_.find(frame.toGroup());
+    return group && withDestinations(*group, std::forward<F>(f));
+  }
+
+  /// Copy of the destinations of `group`.
+  std::vector<NameId> destinations(NameId group) const;
+
+  /// Number of groups with at least one destination.
+  size_t groupCount() const;
+
+ private:
+  using Destinations = std::vector<NameId>;
+
+  // Open-addressing map from group to its destinations. Snapshots share
+  // the Destinations of the groups a change didn't touch; the current
+  // snapshot owns them.
+  class Snapshot {
+   public:
+    explicit Snapshot(size_t groupCount);
+
+    Destinations* find(NameId group) const {
+      for (auto i = group & mask_;; i = (i + 1) & mask_) {
+        const auto& slot = slots_[i];
+        if (!slot.destinations || slot.group == group) {
+          return slot.destinations;
+        }
+      }
+    }
+
+    // Only while the snapshot is built, `group` must not be in it yet.
+    void insert(NameId group, Destinations* destinations);
+
+    template <typename F>
+    void forEach(F&& f) const {
+      for (const auto& slot : slots_) {
+        if (slot.destinations) {
+          f(slot.group, slot.destinations);
+        }
+      }
+    }
+
+    size_t size() const {
+      return size_;
+    }
+
+   private:
+    struct Slot {
+      NameId group{0};
+      Destinations* destinations{nullptr};
+    };
+
+    // NameIds are dense, their low bits are as good as a hash.
+    const size_t mask_;
+    size_t size_{0};
+    std::vector<Slot> slots_;
+  };
+
+  // Publishes a snapshot where `group` has `destinations`, nullptr to drop
+  // it, and retires what it replaces. Called with mutex_ held.
+  void publish(NameId group, Destinations* destinations);
+
+  NameTable& names_;
+  std::atomic<Snapshot*> snapshot_;
+  std::mutex mutex_;
+};
+
+} // namespace proteus
@@ -0,0 +1,49 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/LeaseIssuer.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace proteus {
+
+LeaseIssuer::LeaseIssuer(uint32_t maxQueueDepth, std::chrono::milliseconds ttl)
+    : maxQueueDepth_(std::min(maxQueueDepth, Frame_LEASE::kMaxNumRequests)),
+      ttl_(std::min<std::chrono::milliseconds::rep>(
+          ttl.count(), Frame_LEASE::kMaxTtl)) {
+  DCHECK_GT(maxQueueDepth_, 0u);
+  DCHECK_GT(ttl_.count(), 0);
+}
+
+folly::Optional<Frame_LEASE> LeaseIssuer::update(
+    size_t queueDepth,
+    Clock::time_point now) {
+  if (queueDepth >= maxQueueDepth_) {
+    return folly::none;
+  }
+  const auto requests = static_cast<uint32_t>(maxQueueDepth_ - queueDepth);
+  const bool stale = !issued_ || now >= issuedAt_ + ttl_ / 2;
+  const bool grown = 2 * uint64_t(requests) >= 3 * uint64_t(issuedRequests_);
+  if (!stale && !grown) {
+    return folly::none;
+  }
+  issued_ = true;
+  issuedAt_ = now;
+  issuedRequests_ = requests;
+  return Frame_LEASE(static_cast<uint32_t>(ttl_.count()), requests);
+}
+
+} // namespace proteus
@@ -0,0 +1,59 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <folly/Optional.h>
+
+#include "proteus/framing/Frame.h"
+
+namespace proteus {
+
+/// Issues the leases a destination grants the broker, from the depth of
+/// its request queue.
+///
+/// A destination that can have maxQueueDepth requests queued allows as many
+/// requests as it has room for, for one ttl. The lease is renewed once half
+/// of its ttl has passed, or earlier once the queue drained enough that the
+/// budget would grow by half. A full queue renews nothing, the lease the
+/// broker has runs out and it routes to other instances until there is
+/// room again.
+///
+///   if (auto lease = issuer.update(queue.size(), Clock::now())) {
+///     send(serializer.serializeOut(std::move(*lease)));
+///   }
+class LeaseIssuer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  LeaseIssuer(uint32_t maxQueueDepth, std::chrono::milliseconds ttl);
+
+  /// Lease to send for `queueDepth` requests queued at `now`, none if the
+  /// current one is still good enough or there is no room.
+  folly::Optional<Frame_LEASE> update(size_t queueDepth, Clock::time_point now);
+
+ private:
+  const uint32_t maxQueueDepth_;
+  const std::chrono::milliseconds ttl_;
+  // The last lease issued, if any.
+  bool issued_{false};
+  Clock::time_point issuedAt_;
+  uint32_t issuedRequests_{0};
+};
+
+} // namespace proteus
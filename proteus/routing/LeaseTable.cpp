@@ -0,0 +1,100 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/LeaseTable.h"
+
+namespace proteus {
+
+namespace {
+LeaseTable::Clock::rep ticks(LeaseTable::Clock::time_point time) {
+  return time.time_since_epoch().count();
+}
+} // namespace
+
+void LeaseTable::grant(
+    NameId destination,
+    const Frame_LEASE& lease,
+    Clock::time_point now) {
+  auto& entry = leases_[destination];
+  entry.remaining.store(lease.numberOfRequests_, std::memory_order_relaxed);
+  entry.expiresAt.store(
+      ticks(now + std::chrono::milliseconds(lease.ttl_)),
+      std::memory_order_release);
+}
+
+void LeaseTable::revoke(NameId destination) {
+  if (auto* lease = leases_.find(destination)) {
+    lease->expiresAt.store(0, std::memory_order_relaxed);
+    lease->remaining.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool LeaseTable::tryAcquire(NameId destination, Clock::time_point now) {
+  auto* lease = leases_.find(destination);
+  if (!lease ||
+      lease->expiresAt.load(std::memory_order_acquire) <= ticks(now)) {
+    return false;
+  }
+  auto remaining = lease->remaining.load(std::memory_order_relaxed);
+  while (remaining > 0 &&
+         !lease->remaining.compare_exchange_weak(
+             remaining, remaining - 1, std::memory_order_relaxed)) {
+  }
+  return remaining > 0;
+}
+
+uint32_t LeaseTable::remaining(NameId destination, Clock::time_point now)
+    const {
+  const auto* lease = leases_.find(destination);
+  if (!lease ||
+      lease->expiresAt.load(std::memory_order_acquire) <= ticks(now)) {
+    return 0;
+  }
+  return lease->remaining.load(std::memory_order_relaxed);
+}
+
+folly::Optional<NameId> LeaseTable::acquire(
+    folly::Range<const NameId*> destinations,
+    Clock::time_point now) {
+  // Requests racing for the same budget may spend it between the scan and
+  // the acquire, the scan is then repeated.
+  for (;;) {
+    folly::Optional<NameId> best;
+    uint32_t bestRemaining = 0;
+    for (const auto destination : destinations) {
+      const auto left = remaining(destination, now);
+      if (left > bestRemaining) {
+        best = destination;
+        bestRemaining = left;
+      }
+    }
+    if (!best || tryAcquire(*best, now)) {
+      return best;
+    }
+  }
+}
+
+folly::Optional<NameId> LeaseTable::acquire(
+    const GroupRoutingTable& groups,
+    const GroupView& frame,
+    Clock::time_point now) {
+  folly::Optional<NameId> destination;
+  groups.withDestinations(
+      frame, [&](folly::Range<const NameId*> destinations) {
+        destination = acquire(destinations, now);
+      });
+  return destination;
+}
+
+} // namespace proteus
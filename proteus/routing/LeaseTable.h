@@ -0,0 +1,89 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/Frame.h"
+#include "proteus/framing/NameTable.h"
+#include "proteus/routing/GroupRoutingTable.h"
+#include "proteus/routing/NameIdArray.h"
+
+namespace proteus {
+
+/// Leases destinations grant the broker, which GROUP requests are only
+/// routed within.
+///
+/// A destination sends a LEASE frame allowing numberOfRequests requests
+/// within ttl milliseconds, and a new lease replaces the one before. Every
+/// request routed to a destination takes one from its budget; once that is
+/// spent or the lease expired, the destination gets no more requests until
+/// it grants a new lease. Saturated instances thereby shed load themselves,
+/// see LeaseIssuer.
+///
+/// Budgets are atomics in an array indexed by NameId, so requests routed
+/// from any thread take from them without a lock. A lease is replaced with
+/// two stores, which requests racing with it may see half done: they then
+/// take from the new budget within the old ttl, or the other way around.
+class LeaseTable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Replaces the lease of `destination` with one received at `now`.
+  void grant(
+      NameId destination,
+      const Frame_LEASE& lease,
+      Clock::time_point now);
+
+  /// Drops the lease of `destination`, e.g. when it disconnects.
+  void revoke(NameId destination);
+
+  /// Takes one request from the budget of `destination`. Returns false if
+  /// it has no lease or none left.
+  bool tryAcquire(NameId destination, Clock::time_point now);
+
+  /// Requests `destination` still allows.
+  uint32_t remaining(NameId destination, Clock::time_point now) const;
+
+  /// Takes one request from the destination with the most requests left,
+  /// which is returned. Returns none if no destination has any.
+  folly::Optional<NameId> acquire(
+      folly::Range<const NameId*> destinations,
+      Clock::time_point now);
+
+  /// Same, among the destinations of the group a GROUP frame is addressed
+  /// to.
+  folly::Optional<NameId> acquire(
+      const GroupRoutingTable& groups,
+      const GroupView& frame,
+      Clock::time_point now);
+
+ private:
+  struct Lease {
+    // Clock ticks, 0 without a lease.
+    std::atomic<Clock::rep> expiresAt{0};
+    std::atomic<uint32_t> remaining{0};
+  };
+
+  NameIdArray<Lease> leases_;
+};
+
+} // namespace proteus
@@ -0,0 +1,138 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/LoadStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace proteus {
+
+namespace {
+// Cost of a destination with requests outstanding and no response yet.
+constexpr double kUnknownLatencyCost = 1e12; // nanoseconds
+
+uint64_t toBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double fromBits(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+} // namespace
+
+constexpr uint32_t LoadStats::kDefaultWeight;
+
+LoadStats::LoadStats(Clock::duration decay)
+    : decay_(static_cast<double>(decay.count())) {
+  DCHECK_GT(decay_, 0);
+}
+
+void LoadStats::start(NameId destination) {
+  destinations_[destination]->outstanding.fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void LoadStats::complete(
+    NameId destination,
+    Clock::duration latency,
+    Clock::time_point now) {
+  auto& stats = *destinations_[destination];
+
+  auto outstanding = stats.outstanding.load(std::memory_order_relaxed);
+  DCHECK_GT(outstanding, 0u);
+  while (outstanding > 0 &&
+         !stats.outstanding.compare_exchange_weak(
+             outstanding, outstanding - 1, std::memory_order_relaxed)) {
+  }
+
+  const auto sample = std::max(
+      0.0, std::chrono::duration<double, std::nano>(latency).count());
+  const auto nowTicks = now.time_since_epoch().count();
+  const auto last =
+      stats.updatedAt.exchange(nowTicks, std::memory_order_relaxed);
+  const auto elapsed = std::max<Clock::rep>(nowTicks - last, 0);
+  const auto weight = std::exp(-static_cast<double>(elapsed) / decay_);
+
+  auto bits = stats.latency.load(std::memory_order_relaxed);
+  for (;;) {
+    // What cost() has been reading since the last update.
+    const auto current = fromBits(bits) * weight;
+    const auto next =
+        sample > current ? sample : current + sample * (1 - weight);
+    if (stats.latency.compare_exchange_weak(
+            bits, toBits(next), std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+void LoadStats::setWeight(NameId destination, uint32_t weight) {
+  destinations_[destination]->weight.store(weight, std::memory_order_relaxed);
+}
+
+uint32_t LoadStats::outstanding(NameId destination) const {
+  const auto* stats = destinations_.find(destination);
+  return stats ? (*stats)->outstanding.load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t LoadStats::weight(NameId destination) const {
+  const auto* stats = destinations_.find(destination);
+  return stats ? (*stats)->weight.load(std::memory_order_relaxed)
+               : kDefaultWeight;
+}
+
+std::chrono::nanoseconds LoadStats::latency(NameId destination) const {
+  const auto* stats = destinations_.find(destination);
+  if (!stats) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::nanoseconds(static_cast<int64_t>(
+      fromBits((*stats)->latency.load(std::memory_order_relaxed))));
+}
+
+double LoadStats::cost(NameId destination, Clock::time_point now) const {
+  const auto* stats = destinations_.find(destination);
+  if (!stats) {
+    return 0;
+  }
+  const auto outstanding =
+      (*stats)->outstanding.load(std::memory_order_relaxed);
+  if ((*stats)->latency.load(std::memory_order_relaxed) == toBits(0) &&
+      outstanding > 0) {
+    return kUnknownLatencyCost + outstanding;
+  }
+  return decayedLatency(**stats, now) * (outstanding + 1);
+}
+
+double LoadStats::decayedLatency(
+    const Destination& stats,
+    Clock::time_point now) const {
+  const auto latency = fromBits(stats.latency.load(std::memory_order_relaxed));
+  const auto elapsed = now.time_since_epoch().count() -
+      stats.updatedAt.load(std::memory_order_relaxed);
+  if (elapsed <= 0) {
+    return latency;
+  }
+  return latency * std::exp(-static_cast<double>(elapsed) / decay_);
+}
+
+} // namespace proteus
@@ -0,0 +1,94 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <folly/CachelinePadded.h>
+
+#include "proteus/framing/NameTable.h"
+#include "proteus/routing/NameIdArray.h"
+
+namespace proteus {
+
+/// Load of every destination, which GroupBalancer policies select on.
+///
+/// Tracks per destination the requests routed to it and not answered yet,
+/// the peak EWMA of its response latency and its weight. Every destination
+/// has its atomics on a cache line of its own: IO threads routing to and
+/// completing requests of different destinations don't share lines, and
+/// no update takes a lock.
+///
+/// The EWMA follows a latency above it right away and decays towards one
+/// below it with time constant `decay`, so a destination that slowed down
+/// is avoided at once and only slowly trusted again. It also decays towards
+/// 0 while no response comes in, as cost() reads it: a destination avoided
+/// since a latency spike gets requests again after a few `decay` instead
+/// of being starved for good.
+class LoadStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr uint32_t kDefaultWeight = 1;
+
+  explicit LoadStats(Clock::duration decay = std::chrono::seconds(10));
+
+  /// A request was routed to `destination`.
+  void start(NameId destination);
+
+  /// A request of `destination` completed, with a response or an error,
+  /// `latency` after it started.
+  void complete(
+      NameId destination,
+      Clock::duration latency,
+      Clock::time_point now);
+
+  /// Weight of `destination` for weighted policies, 0 to route it nothing.
+  void setWeight(NameId destination, uint32_t weight);
+
+  uint32_t outstanding(NameId destination) const;
+  uint32_t weight(NameId destination) const;
+
+  /// Peak EWMA of the latency of `destination` as of its last response, 0
+  /// before its first one.
+  std::chrono::nanoseconds latency(NameId destination) const;
+
+  /// Expected cost of one more request to `destination` at `now`: its
+  /// latency, decayed since its last response, times its outstanding
+  /// requests plus one. A destination with requests outstanding but no
+  /// response yet costs a lot, as it may be stuck.
+  double cost(NameId destination, Clock::time_point now) const;
+
+ private:
+  struct Destination {
+    std::atomic<uint32_t> outstanding{0};
+    std::atomic<uint32_t> weight{kDefaultWeight};
+    // Nanoseconds, as a double's bits.
+    std::atomic<uint64_t> latency{0};
+    // Clock ticks of the last update of latency.
+    std::atomic<Clock::rep> updatedAt{0};
+  };
+
+  // Nanoseconds of latency left of `stats` at `now`.
+  double decayedLatency(const Destination& stats, Clock::time_point now)
+      const;
+
+  const double decay_; // clock ticks
+  NameIdArray<folly::CachelinePadded<Destination>> destinations_;
+};
+
+} // namespace proteus
@@ -0,0 +1,97 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include <glog/logging.h>
+
+#include "proteus/framing/NameTable.h"
+
+namespace proteus {
+
+/// Array of T indexed by NameId, for per-group and per-destination state
+/// read and updated from every IO thread.
+///
+/// Elements are allocated a chunk at a time, default-constructed, the
+/// first time an ID of the chunk is asked for, and live as long as the
+/// array. Looking an element up takes no lock, only allocating a chunk
+/// takes a mutex. T must make its own updates thread-safe.
+template <typename T>
+class NameIdArray {
+ public:
+  static constexpr size_t kChunkSize = 1024;
+
+  NameIdArray() {
+    for (auto& chunk : chunks_) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~NameIdArray() {
+    for (auto& chunk : chunks_) {
+      delete chunk.load(std::memory_order_relaxed);
+    }
+  }
+
+  NameIdArray(const NameIdArray&) = delete;
+  NameIdArray& operator=(const NameIdArray&) = delete;
+
+  /// Element of `id`, allocating it if needed.
+  T& operator[](NameId id) {
+    DCHECK_LT(id, NameTable::kMaxNames);
+    auto& slot = chunks_[id / kChunkSize];
+    auto* chunk = slot.load(std::memory_order_acquire);
+    if (!chunk) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      chunk = slot.load(std::memory_order_relaxed);
+      if (!chunk) {
+        chunk = new Chunk();
+        slot.store(chunk, std::memory_order_release);
+      }
+    }
+    return chunk->elements[id % kChunkSize];
+  }
+
+  /// Element of `id`, nullptr if it was never allocated.
+  T* find(NameId id) const {
+    if (id >= NameTable::kMaxNames) {
+      return nullptr;
+    }
+    auto* chunk = chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    return chunk ? &chunk->elements[id % kChunkSize] : nullptr;
+  }
+
+ private:
+  static constexpr size_t kChunkCount = NameTable::kMaxNames / kChunkSize;
+
+  struct Chunk {
+    std::array<T, kChunkSize> elements;
+  };
+
+  std::array<std::atomic<Chunk*>, kChunkCount> chunks_;
+  std::mutex mutex_;
+};
+
+template <typename T>
+constexpr size_t NameIdArray<T>::kChunkSize;
+
+template <typename T>
+constexpr size_t NameIdArray<T>::kChunkCount;
+
+} // namespace proteus
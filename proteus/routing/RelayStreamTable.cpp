@@ -0,0 +1,313 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/RelayStreamTable.h"
+
+#include <glog/logging.h>
+
+namespace proteus {
+
+namespace {
+constexpr size_t kMinInboundWindow = 16; // streams
+constexpr rsocket::StreamId kMaxStreamId = 0x7FFFFFFF;
+} // namespace
+
+constexpr size_t RelayStreamTable::kMaxInboundStreams;
+constexpr size_t RelayStreamTable::kStreamIdQuarantine;
+
+void RelayStreamTable::open(ConnectionId connection, Role role) {
+  if (connection >= connections_.size()) {
+    connections_.resize(connection + 1);
+  }
+  auto& c = connections_[connection];
+  DCHECK(!c.open);
+  c.open = true;
+  c.role = role;
+}
+
+size_t RelayStreamTable::close(ConnectionId connection) {
+  auto* c = openConnection(connection);
+  if (!c) {
+    return 0;
+  }
+  const auto count = streamCount(connection);
+  // The other ends of the streams see the new generation and drop their
+  // end when they are next looked up.
+  ++c->generation;
+  c->open = false;
+  std::vector<Inbound>().swap(c->inbound);
+  std::unordered_map<rsocket::StreamId, Peer>().swap(c->inboundOverflow);
+  std::vector<Outbound>().swap(c->outbound);
+  std::deque<uint32_t>().swap(c->freeOutbound);
+  c->inboundCount = 0;
+  return count;
+}
+
+folly::Optional<rsocket::StreamId> RelayStreamTable::relay(
+    Endpoint from,
+    ConnectionId to) {
+  auto* source = openConnection(from.connection);
+  auto* target = openConnection(to);
+  if (!source || !target || from.streamId == 0 ||
+      from.streamId > kMaxStreamId || isOutbound(*source, from.streamId)) {
+    return folly::none;
+  }
+  auto* existing = findInbound(*source, from.streamId);
+  if (existing && isLive(*existing)) {
+    return folly::none;
+  }
+
+  // A freed stream ID is reused once enough others were freed after it
+  // that the peer is done with it, or when the stream IDs run out.
+  auto index = target->outbound.size();
+  const bool exhausted = outboundStreamId(target->role, index) > kMaxStreamId;
+  const bool reuse = target->freeOutbound.size() > kStreamIdQuarantine ||
+      (exhausted && !target->freeOutbound.empty());
+  if (reuse) {
+    index = target->freeOutbound.front();
+  } else if (exhausted) {
+    return folly::none;
+  }
+  const auto streamId = outboundStreamId(target->role, index);
+
+  Inbound inbound;
+  inbound.streamId = from.streamId;
+  inbound.peer = Peer{to, target->generation, streamId};
+  if (!insertInbound(*source, inbound)) {
+    return folly::none;
+  }
+
+  if (reuse) {
+    target->freeOutbound.pop_front();
+  } else {
+    target->outbound.emplace_back();
+  }
+  auto& outbound = target->outbound[index];
+  outbound.used = true;
+  outbound.peer = Peer{from.connection, source->generation, from.streamId};
+  return streamId;
+}
+
+folly::Optional<RelayStreamTable::Endpoint> RelayStreamTable::route(
+    Endpoint from) {
+  const auto* peer = find(from);
+  if (!peer) {
+    return folly::none;
+  }
+  if (!isLive(*peer)) {
+    erase(from);
+    return folly::none;
+  }
+  return Endpoint{peer->connection, peer->streamId};
+}
+
+bool RelayStreamTable::release(Endpoint either) {
+  const auto* peer = find(either);
+  if (!peer) {
+    return false;
+  }
+  const auto other = *peer;
+  erase(either);
+  if (isLive(other)) {
+    erase(Endpoint{other.connection, other.streamId});
+  }
+  return true;
+}
+
+size_t RelayStreamTable::reclaim(ConnectionId connection) {
+  auto* c = openConnection(connection);
+  if (!c) {
+    return 0;
+  }
+  size_t dropped = 0;
+  for (auto& stream : c->inbound) {
+    if (stream.streamId != 0 && !isLive(stream.peer)) {
+      stream.streamId = 0;
+      --c->inboundCount;
+      ++dropped;
+    }
+  }
+  for (auto it = c->inboundOverflow.begin();
+       it != c->inboundOverflow.end();) {
+    if (!isLive(it->second)) {
+      it = c->inboundOverflow.erase(it);
+      --c->inboundCount;
+      ++dropped;
+    } else {
+      ++it;
+    }
+  }
+  for (size_t index = 0; index < c->outbound.size(); ++index) {
+    auto& stream = c->outbound[index];
+    if (stream.used && !isLive(stream.peer)) {
+      stream.used = false;
+      c->freeOutbound.push_back(static_cast<uint32_t>(index));
+      ++dropped;
+    }
+  }
+  return dropped;
+}
+
+size_t RelayStreamTable::streamCount(ConnectionId connection) const {
+  if (connection >= connections_.size()) {
+    return 0;
+  }
+  const auto& c = connections_[connection];
+  return c.inboundCount + c.outbound.size() - c.freeOutbound.size();
+}
+
+size_t RelayStreamTable::inboundWindow(ConnectionId connection) const {
+  if (connection >= connections_.size()) {
+    return 0;
+  }
+  return connections_[connection].inbound.size();
+}
+
+RelayStreamTable::Connection* RelayStreamTable::openConnection(
+    ConnectionId connection) {
+  if (connection >= connections_.size() || !connections_[connection].open) {
+    return nullptr;
+  }
+  return &connections_[connection];
+}
+
+bool RelayStreamTable::isOutbound(
+    const Connection& connection,
+    rsocket::StreamId streamId) {
+  return (streamId & 1) == (connection.role == Role::CLIENT ? 1u : 0u);
+}
+
+RelayStreamTable::Peer* RelayStreamTable::findInbound(
+    Connection& connection,
+    rsocket::StreamId streamId) {
+  if (connection.inbound.empty()) {
+    return nullptr;
+  }
+  auto& slot = inboundSlot(connection, streamId);
+  if (slot.streamId == streamId) {
+    return &slot.peer;
+  }
+  if (connection.inboundOverflow.empty()) {
+    return nullptr;
+  }
+  auto it = connection.inboundOverflow.find(streamId);
+  return it != connection.inboundOverflow.end() ? &it->second : nullptr;
+}
+
+bool RelayStreamTable::insertInbound(
+    Connection& connection,
+    const Inbound& stream) {
+  if (connection.inbound.empty()) {
+    growInbound(connection, kMinInboundWindow);
+  }
+  auto overflow = connection.inboundOverflow.find(stream.streamId);
+  if (overflow != connection.inboundOverflow.end()) {
+    // Taking over a stream whose other end is gone.
+    overflow->second = stream.peer;
+    return true;
+  }
+  for (;;) {
+    auto& slot = inboundSlot(connection, stream.streamId);
+    const bool added = slot.streamId == 0;
+    if (added || slot.streamId == stream.streamId || !isLive(slot.peer)) {
+      // A free slot, or taking over a stream whose other end is gone.
+      if (added && connection.inboundCount >= kMaxInboundStreams) {
+        return false;
+      }
+      slot = stream;
+      connection.inboundCount += added ? 1 : 0;
+      return true;
+    }
+    if (connection.inboundCount >= kMaxInboundStreams) {
+      return false;
+    }
+    const auto size = 2 * connection.inbound.size();
+    if (2 * connection.inboundCount < connection.inbound.size() ||
+        size > kMaxInboundStreams) {
+      // A sparse window would double for every stream the long-lived ones
+      // collide with. Keep them aside instead.
+      connection.inboundOverflow.emplace(stream.streamId, stream.peer);
+      ++connection.inboundCount;
+      return true;
+    }
+    growInbound(connection, size);
+  }
+}
+
+void RelayStreamTable::growInbound(Connection& connection, size_t size) {
+  // Live stream IDs in different slots of a window are in different slots
+  // of a bigger one, so nothing collides.
+  std::vector<Inbound> inbound(size);
+  for (const auto& stream : connection.inbound) {
+    if (stream.streamId != 0) {
+      inbound[(stream.streamId >> 1) & (size - 1)] = stream;
+    }
+  }
+  connection.inbound.swap(inbound);
+  // Overflowing streams move to the window when their slot is free.
+  auto& overflow = connection.inboundOverflow;
+  for (auto it = overflow.begin(); it != overflow.end();) {
+    auto& slot = inboundSlot(connection, it->first);
+    if (slot.streamId == 0) {
+      slot.streamId = it->first;
+      slot.peer = it->second;
+      it = overflow.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+RelayStreamTable::Peer* RelayStreamTable::find(Endpoint end) {
+  auto* connection = openConnection(end.connection);
+  if (!connection) {
+    return nullptr;
+  }
+  if (isOutbound(*connection, end.streamId)) {
+    const auto index = outboundIndex(end.streamId);
+    if (index >= connection->outbound.size() ||
+        !connection->outbound[index].used) {
+      return nullptr;
+    }
+    return &connection->outbound[index].peer;
+  }
+  return findInbound(*connection, end.streamId);
+}
+
+void RelayStreamTable::erase(Endpoint end) {
+  auto& connection = connections_[end.connection];
+  if (isOutbound(connection, end.streamId)) {
+    const auto index = outboundIndex(end.streamId);
+    DCHECK(connection.outbound[index].used);
+    connection.outbound[index].used = false;
+    connection.freeOutbound.push_back(static_cast<uint32_t>(index));
+    return;
+  }
+  auto& slot = inboundSlot(connection, end.streamId);
+  if (slot.streamId == end.streamId) {
+    slot.streamId = 0;
+  } else {
+    const auto erased = connection.inboundOverflow.erase(end.streamId);
+    DCHECK_EQ(1u, erased);
+  }
+  --connection.inboundCount;
+}
+
+bool RelayStreamTable::isLive(const Peer& peer) const {
+  return peer.connection < connections_.size() &&
+      connections_[peer.connection].open &&
+      connections_[peer.connection].generation == peer.generation;
+}
+
+} // namespace proteus
@@ -0,0 +1,176 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Optional.h>
+
+#include "rsocket/internal/Common.h"
+
+namespace proteus {
+
+/// Stream IDs of the streams a broker relays between its connections.
+///
+/// A request received on a connection is relayed on a stream the broker
+/// opens on the destination's connection. Every later frame of the stream
+/// (PAYLOAD, REQUEST_N, CANCEL, ERROR) is relayed on the other end's
+/// connection and stream ID, which route() looks up from the connection and
+/// the stream ID FrameSerializer::peekStreamId() reads:
+///
+///   auto streamId = serializer.peekStreamId(*frame);
+///   if (auto to = table.route({connection, *streamId})) {
+///     forward(to->connection, to->streamId, std::move(frame));
+///   }
+///
+/// Stream IDs the broker allocates on a connection index an array of the
+/// connection directly. Freed ones are handed out again oldest first, and
+/// only once kStreamIdQuarantine more have been freed, so that frames still
+/// in flight on a released stream don't reach the stream reusing its ID.
+/// Stream IDs the peer allocated, which grow one by one, index a
+/// direct-mapped window. The window doubles when two live IDs collide in it
+/// while it is at least half full; sparser collisions, e.g. with one
+/// long-lived stream, go to a small overflow map instead.
+///
+/// Closing a connection releases its streams at once: it only bumps the
+/// connection's generation, and the other ends of its streams are dropped
+/// lazily, when their generation no longer matches, or all at once by
+/// reclaim(). Not thread-safe.
+class RelayStreamTable {
+ public:
+  /// Dense connection handle, an index into the broker's connections.
+  using ConnectionId = uint32_t;
+
+  /// Role of the broker on a connection. Clients allocate odd stream IDs,
+  /// servers even ones.
+  enum class Role : uint8_t { CLIENT, SERVER };
+
+  struct Endpoint {
+    ConnectionId connection;
+    rsocket::StreamId streamId;
+  };
+
+  /// Streams the peer of a connection can have relayed at once, and the
+  /// largest size of their window.
+  static constexpr size_t kMaxInboundStreams = size_t(1) << 20;
+
+  /// Stream IDs freed on a connection before the oldest of them is handed
+  /// out again.
+  static constexpr size_t kStreamIdQuarantine = 16;
+
+  /// Starts relaying on `connection`, which must not be open. Its stream
+  /// IDs from an earlier incarnation are no longer routed.
+  void open(ConnectionId connection, Role role);
+
+  /// Stops relaying on `connection` and releases all its streams. Returns
+  /// how many there were.
+  size_t close(ConnectionId connection);
+
+  /// Relays the stream the peer of `from` opened to a new stream on `to`,
+  /// whose stream ID is returned. Returns none if the stream is already
+  /// relayed, if a connection isn't open, if `from` relays
+  /// kMaxInboundStreams already or if `to` is out of stream IDs.
+  folly::Optional<rsocket::StreamId> relay(Endpoint from, ConnectionId to);
+
+  /// Other end of the stream a frame received on `from` belongs to, none if
+  /// the stream isn't relayed.
+  folly::Optional<Endpoint> route(Endpoint from);
+
+  /// Stops relaying the stream, from either end. Returns false if it wasn't
+  /// relayed.
+  bool release(Endpoint either);
+
+  /// Drops the streams of `connection` whose other connection closed, in
+  /// one pass over its streams. Returns how many were dropped.
+  size_t reclaim(ConnectionId connection);
+
+  /// Number of streams relayed on `connection`, counting those whose other
+  /// connection closed until they are looked up.
+  size_t streamCount(ConnectionId connection) const;
+
+  /// Size of the window of the stream IDs the peer of `connection`
+  /// allocated, 0 before the first one.
+  size_t inboundWindow(ConnectionId connection) const;
+
+ private:
+  // One end of a relayed stream, as seen from the other end.
+  struct Peer {
+    ConnectionId connection{0};
+    uint32_t generation{0};
+    rsocket::StreamId streamId{0};
+  };
+
+  // A stream the peer allocated the ID of.
+  struct Inbound {
+    rsocket::StreamId streamId{0}; // 0 if the slot is free
+    Peer peer;
+  };
+
+  // A stream the broker allocated the ID of.
+  struct Outbound {
+    bool used{false};
+    Peer peer;
+  };
+
+  struct Connection {
+    bool open{false};
+    Role role{Role::CLIENT};
+    uint32_t generation{0};
+    std::vector<Inbound> inbound;
+    // Peer stream IDs whose slot in the window is taken.
+    std::unordered_map<rsocket::StreamId, Peer> inboundOverflow;
+    size_t inboundCount{0}; // in the window and the overflow
+    std::vector<Outbound> outbound;
+    std::deque<uint32_t> freeOutbound; // oldest first
+  };
+
+  Connection* openConnection(ConnectionId connection);
+
+  // Whether the broker allocated `streamId` on `connection`.
+  static bool isOutbound(const Connection& connection, rsocket::StreamId id);
+
+  // Slot of a stream ID in the outbound array, and back.
+  static size_t outboundIndex(rsocket::StreamId streamId) {
+    return (streamId - 1) / 2;
+  }
+  static rsocket::StreamId outboundStreamId(Role role, size_t index) {
+    return static_cast<rsocket::StreamId>(
+        2 * index + (role == Role::CLIENT ? 1 : 2));
+  }
+
+  static Inbound& inboundSlot(Connection& connection, rsocket::StreamId id) {
+    return connection.inbound[(id >> 1) & (connection.inbound.size() - 1)];
+  }
+  static Peer* findInbound(Connection& connection, rsocket::StreamId id);
+  bool insertInbound(Connection& connection, const Inbound& stream);
+  static void growInbound(Connection& connection, size_t size);
+
+  // The stream's own end, or nullptr.
+  Peer* find(Endpoint end);
+
+  // Frees `end`, without touching its peer.
+  void erase(Endpoint end);
+
+  // Whether `peer` is still the same incarnation of its connection.
+  bool isLive(const Peer& peer) const;
+
+  std::vector<Connection> connections_;
+};
+
+} // namespace proteus
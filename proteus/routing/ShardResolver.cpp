@@ -0,0 +1,143 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "proteus/routing/ShardResolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <glog/logging.h>
+
+namespace proteus {
+
+constexpr size_t ShardResolver::kDefaultSlots;
+constexpr uint32_t ShardResolver::kMaxWeight;
+
+namespace {
+
+// Seeds keep key, slot and name hashes independent of each other.
+constexpr uint64_t kKeySeed = 0x5348415244u; // "SHARD"
+constexpr uint64_t kSlotSeed = 0x534c4f54u; // "SLOT"
+
+uint64_t hashBytes(folly::ByteRange bytes, uint64_t seed) {
+  return folly::hash::SpookyHashV2::Hash64(bytes.data(), bytes.size(), seed);
+}
+
+// Maps a hash to (0, 1).
+double toUnitInterval(uint64_t hash) {
+  return (static_cast<double>(hash >> 11) + 0.5) * (1.0 / (1ULL << 53));
+}
+
+} // namespace
+
+ShardResolver::ShardResolver(
+    Algorithm algorithm,
+    const std::vector<Destination>& destinations,
+    const NameTable& names,
+    size_t slots)
+    : algorithm_(algorithm) {
+  switch (algorithm_) {
+    case Algorithm::JUMP:
+      buildJump(destinations);
+      break;
+    case Algorithm::RENDEZVOUS:
+      buildRendezvous(destinations, names, slots);
+      break;
+  }
+}
+
+folly::Optional<NameId> ShardResolver::resolveHash(uint64_t keyHash) const {
+  if (table_.empty()) {
+    return folly::none;
+  }
+  if (algorithm_ == Algorithm::JUMP) {
+    return table_[jumpHash(keyHash, static_cast<uint32_t>(table_.size()))];
+  }
+  // The slot count is a power of two.
+  return table_[keyHash & (table_.size() - 1)];
+}
+
+uint64_t ShardResolver::hashKey(folly::ByteRange shardKey) {
+  return hashBytes(shardKey, kKeySeed);
+}
+
+uint32_t ShardResolver::jumpHash(uint64_t key, uint32_t buckets) {
+  DCHECK_GT(buckets, 0u);
+  int64_t bucket = -1;
+  int64_t next = 0;
+  while (next < buckets) {
+    bucket = next;
+    key = key * 2862933555777941757ULL + 1;
+    next = static_cast<int64_t>(
+        (bucket + 1) *
+        (static_cast<double>(1LL << 31) /
+         static_cast<double>((key >> 33) + 1)));
+  }
+  return static_cast<uint32_t>(bucket);
+}
+
+void ShardResolver::buildJump(const std::vector<Destination>& destinations) {
+  for (const auto& destination : destinations) {
+    table_.insert(
+        table_.end(),
+        std::min(destination.weight, kMaxWeight),
+        destination.id);
+  }
+}
+
+void ShardResolver::buildRendezvous(
+    const std::vector<Destination>& destinations,
+    const NameTable& names,
+    size_t slots) {
+  struct Candidate {
+    NameId id;
+    uint64_t hash;
+    double weight;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto& destination : destinations) {
+    if (destination.weight > 0) {
+      candidates.push_back(Candidate{
+          destination.id,
+          hashBytes(folly::ByteRange(names.name(destination.id)), 0),
+          static_cast<double>(destination.weight)});
+    }
+  }
+  if (candidates.empty()) {
+    return;
+  }
+
+  table_.resize(folly::nextPowTwo(std::max<size_t>(slots, 1)));
+  for (size_t slot = 0; slot < table_.size(); ++slot) {
+    const auto slotHash = folly::hash::twang_mix64(slot ^ kSlotSeed);
+    // Weighted rendezvous: the highest -weight / ln(u) wins, which gives
+    // every destination a share of the slots proportional to its weight.
+    auto best = -std::numeric_limits<double>::infinity();
+    for (const auto& candidate : candidates) {
+      const auto u = toUnitInterval(
+          folly::hash::hash_128_to_64(slotHash, candidate.hash));
+      const auto score = -candidate.weight / std::log(u);
+      if (score > best) {
+        best = score;
+        table_[slot] = candidate.id;
+      }
+    }
+  }
+}
+
+} // namespace proteus
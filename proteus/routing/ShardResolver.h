@@ -0,0 +1,108 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/NameTable.h"
+
+namespace proteus {
+
+/// Maps the shard key of a SHARD frame to one of a group's destinations,
+/// so that a key keeps reaching the same destination while the group
+/// changes, weighted by the share of keys each destination should take.
+///
+/// A resolver is immutable and built from a precomputed table of
+/// destination NameIds, rebuilt when the group changes:
+///
+/// - JUMP gives every destination `weight` consecutive buckets, in the
+///   order given, and picks a bucket with jump consistent hash in
+///   O(log buckets) without touching more than one table entry. Only
+///   appending destinations (or weight to the last one) moves the minimum
+///   of keys, which suits shards numbered by ordinal.
+/// - RENDEZVOUS splits the key space into a fixed number of slots, each
+///   owned by the destination with the highest weighted rendezvous score.
+///   Lookups are one table read. Any change only moves the slots whose
+///   owner changed, wherever the destination was in the group; building
+///   costs O(slots * destinations).
+///
+/// Destinations are hashed by name rather than NameId, so every broker
+/// resolves a key the same way whatever order it interned the names in.
+/// For JUMP they must also be given in the same order.
+class ShardResolver {
+ public:
+  enum class Algorithm : uint8_t {
+    JUMP,
+    RENDEZVOUS,
+  };
+
+  struct Destination {
+    NameId id;
+    /// Relative share of the keys, 0 for none.
+    uint32_t weight{1};
+  };
+
+  static constexpr size_t kDefaultSlots = 4096;
+  /// Caps the buckets a destination takes with JUMP.
+  static constexpr uint32_t kMaxWeight = 1024;
+
+  /// `slots` is rounded up to a power of two, only RENDEZVOUS uses it.
+  ShardResolver(
+      Algorithm algorithm,
+      const std::vector<Destination>& destinations,
+      const NameTable& names = NameTable::global(),
+      size_t slots = kDefaultSlots);
+
+  /// Returns none when no destination has a weight.
+  folly::Optional<NameId> resolve(folly::ByteRange shardKey) const {
+    return resolveHash(hashKey(shardKey));
+  }
+
+  folly::Optional<NameId> resolve(const ShardView& frame) const {
+    return resolve(frame.shardKey());
+  }
+
+  folly::Optional<NameId> resolveHash(uint64_t keyHash) const;
+
+  Algorithm algorithm() const {
+    return algorithm_;
+  }
+
+  /// Stable across processes and releases.
+  static uint64_t hashKey(folly::ByteRange shardKey);
+
+  /// Jump consistent hash (Lamping and Veach): a bucket in [0, buckets).
+  /// Going from n to n + 1 buckets only moves keys to bucket n.
+  static uint32_t jumpHash(uint64_t key, uint32_t buckets);
+
+ private:
+  void buildJump(const std::vector<Destination>& destinations);
+  void buildRendezvous(
+      const std::vector<Destination>& destinations,
+      const NameTable& names,
+      size_t slots);
+
+  const Algorithm algorithm_;
+  // Owner of every bucket (JUMP) or slot (RENDEZVOUS).
+  std::vector<NameId> table_;
+};
+
+} // namespace proteus
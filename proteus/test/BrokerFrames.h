@@ -0,0 +1,86 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include <folly/Range.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+
+namespace proteus {
+namespace test {
+
+/// Builders of the broker frames tests route, sent by "client-1" of
+/// "clients" at broker protocol version 1.0.
+
+/// Serializes `values` as laid out by `FieldLayout`.
+template <typename FieldLayout, typename... Values>
+std::unique_ptr<folly::IOBuf> encode(Values&&... values) {
+  folly::IOBufQueue queue;
+  folly::io::QueueAppender appender(&queue, 256);
+  FieldLayout::encode(appender, std::forward<Values>(values)...);
+  return queue.move();
+}
+
+inline std::unique_ptr<folly::IOBuf> destinationSetup(
+    folly::StringPiece destination,
+    folly::StringPiece group) {
+  return encode<DestinationSetupLayout>(
+      uint16_t{1},
+      uint16_t{0},
+      FrameType::DESTINATION_SETUP,
+      destination,
+      group,
+      uint64_t{42},
+      folly::ByteRange(folly::StringPiece("token")));
+}
+
+inline std::unique_ptr<folly::IOBuf> destinationFrame(
+    folly::StringPiece toDestination,
+    folly::StringPiece toGroup) {
+  return encode<DestinationLayout>(
+      uint16_t{1},
+      uint16_t{0},
+      FrameType::DESTINATION,
+      folly::StringPiece("client-1"),
+      folly::StringPiece("clients"),
+      toDestination,
+      toGroup,
+      folly::ByteRange(folly::StringPiece("metadata")));
+}
+
+/// GROUP or BROADCAST frame, `type`, whose application metadata is chained
+/// in behind the routing fields.
+inline std::unique_ptr<folly::IOBuf> groupFrame(
+    FrameType type,
+    folly::StringPiece toGroup,
+    folly::StringPiece metadata = "metadata") {
+  return encode<GroupLayout>(
+      uint16_t{1},
+      uint16_t{0},
+      type,
+      folly::StringPiece("client-1"),
+      folly::StringPiece("clients"),
+      toGroup,
+      folly::IOBuf::copyBuffer(metadata));
+}
+
+} // namespace test
+} // namespace proteus
@@ -0,0 +1,150 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/BrokerFrameRewrite.h"
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameSerializer.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+constexpr const size_t kMaxTestFrameSize = 256;
+
+std::unique_ptr<folly::IOBuf> destinationFrame(
+    folly::StringPiece toDestination) {
+  auto buf = folly::IOBuf::create(kMaxTestFrameSize);
+  folly::io::Appender appender(buf.get(), 0);
+  DestinationLayout::encode(
+      appender,
+      uint16_t{0},
+      uint16_t{1},
+      FrameType::DESTINATION,
+      folly::StringPiece("client"),
+      folly::StringPiece("clients"),
+      toDestination,
+      folly::StringPiece("services"),
+      folly::ByteRange(folly::StringPiece("app-metadata")));
+  return buf;
+}
+
+std::unique_ptr<folly::IOBuf> groupFrame() {
+  auto buf = folly::IOBuf::create(kMaxTestFrameSize);
+  folly::io::Appender appender(buf.get(), 0);
+  GroupLayout::encode(
+      appender,
+      uint16_t{0},
+      uint16_t{1},
+      FrameType::GROUP,
+      folly::StringPiece("client"),
+      folly::StringPiece("clients"),
+      folly::StringPiece("services"),
+      folly::ByteRange(folly::StringPiece("app-metadata")));
+  return buf;
+}
+
+LazyFrame receive(
+    const FrameSerializer& serializer,
+    std::unique_ptr<folly::IOBuf> routing) {
+  auto serializedFrame = serializer.serializeOut(Frame_REQUEST_RESPONSE(
+      42,
+      FrameFlags::METADATA,
+      rsocket::Payload(
+          folly::IOBuf::copyBuffer("424242"), std::move(routing))));
+  serializedFrame->coalesce();
+  LazyFrame frame;
+  EXPECT_EQ(
+      DecodeError::NONE,
+      serializer.tryDeserializeFrom(frame, std::move(serializedFrame)));
+  return frame;
+}
+
+} // namespace
+
+TEST(BrokerFrameRewriteTest, Destination) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto frame = receive(*serializer, destinationFrame("service-instance-1"));
+  const auto* buffer = &frame.buffer();
+
+  // The new header is shorter, so it's rewritten in place.
+  auto view = DestinationView::tryParse(*frame.metadataRange());
+  ASSERT_TRUE(view.hasValue());
+  ASSERT_TRUE(rewriteDestination(
+      frame,
+      7,
+      view->fromDestination(),
+      view->fromGroup(),
+      "instance-2",
+      "services"));
+  EXPECT_EQ(buffer, &frame.buffer());
+  EXPECT_EQ(7u, frame.header().streamId);
+
+  view = DestinationView::tryParse(*frame.metadataRange());
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("client", view->fromDestination());
+  EXPECT_EQ("clients", view->fromGroup());
+  EXPECT_EQ("instance-2", view->toDestination());
+  EXPECT_EQ("services", view->toGroup());
+  EXPECT_EQ("app-metadata", folly::StringPiece(view->metadata()));
+
+  // Growing it back takes the headroom freed up.
+  ASSERT_TRUE(rewriteDestination(
+      frame, 9, "client", "clients", "service-instance-3", "services"));
+  EXPECT_EQ(buffer, &frame.buffer());
+
+  Frame_REQUEST_RESPONSE forwarded;
+  ASSERT_TRUE(serializer->deserializeFrom(forwarded, frame.releaseBuffer()));
+  EXPECT_EQ(9u, forwarded.header_.streamId);
+  EXPECT_EQ(
+      "424242",
+      forwarded.payload_.data->cloneCoalescedAsValue().moveToFbString());
+  auto metadata = forwarded.payload_.metadata->cloneCoalescedAsValue();
+  view = DestinationView::tryParse(metadata);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("service-instance-3", view->toDestination());
+  EXPECT_EQ("app-metadata", folly::StringPiece(view->metadata()));
+}
+
+TEST(BrokerFrameRewriteTest, Group) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto frame = receive(*serializer, groupFrame());
+
+  ASSERT_TRUE(rewriteGroup(frame, 7, "broker-1", "brokers", "services-v2"));
+  EXPECT_EQ(7u, frame.header().streamId);
+
+  auto view = GroupView::tryParse(*frame.metadataRange());
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("broker-1", view->fromDestination());
+  EXPECT_EQ("brokers", view->fromGroup());
+  EXPECT_EQ("services-v2", view->toGroup());
+  EXPECT_EQ("app-metadata", folly::StringPiece(view->metadata()));
+}
+
+TEST(BrokerFrameRewriteTest, UnexpectedFrameType) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto frame = receive(*serializer, groupFrame());
+
+  EXPECT_FALSE(rewriteDestination(frame, 7, "a", "b", "c", "d"));
+  EXPECT_EQ(42u, frame.header().streamId);
+  EXPECT_TRUE(GroupView::tryParse(*frame.metadataRange()).hasValue());
+}
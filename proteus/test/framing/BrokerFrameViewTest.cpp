@@ -0,0 +1,225 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+class FrameBuilder {
+ public:
+  explicit FrameBuilder(FrameType type)
+      : buf_(folly::IOBuf::create(256)), appender_(buf_.get(), 256) {
+    appender_.writeBE<uint16_t>(0);
+    appender_.writeBE<uint16_t>(1);
+    appender_.writeBE<uint16_t>(toBrokerWireType(type));
+  }
+
+  FrameBuilder& string(folly::StringPiece value) {
+    appender_.writeBE<uint32_t>(static_cast<uint32_t>(value.size()));
+    appender_.push(folly::ByteRange(value));
+    return *this;
+  }
+
+  FrameBuilder& int64(uint64_t value) {
+    appender_.writeBE<uint64_t>(value);
+    return *this;
+  }
+
+  FrameBuilder& raw(folly::StringPiece value) {
+    appender_.push(folly::ByteRange(value));
+    return *this;
+  }
+
+  std::unique_ptr<folly::IOBuf> build() {
+    return std::move(buf_);
+  }
+
+ private:
+  std::unique_ptr<folly::IOBuf> buf_;
+  folly::io::Appender appender_;
+};
+
+} // namespace
+
+TEST(BrokerFrameViewTest, BrokerSetup) {
+  auto buf = FrameBuilder(FrameType::BROKER_SETUP)
+                 .string("broker-1")
+                 .string("cluster")
+                 .int64(42)
+                 .string("token")
+                 .build();
+
+  auto view = BrokerSetupView::tryParse(*buf);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ(0, view->majorVersion());
+  EXPECT_EQ(1, view->minorVersion());
+  EXPECT_EQ(FrameType::BROKER_SETUP, view->frameType());
+  EXPECT_EQ("broker-1", view->brokerId());
+  EXPECT_EQ("cluster", view->clusterId());
+  EXPECT_EQ(42, view->accessKey());
+  EXPECT_EQ("token", folly::StringPiece(view->accessToken()));
+}
+
+TEST(BrokerFrameViewTest, DestinationSetup) {
+  auto buf = FrameBuilder(FrameType::DESTINATION_SETUP)
+                 .string("dest")
+                 .string("group")
+                 .int64(7)
+                 .string("")
+                 .build();
+
+  auto view = DestinationSetupView::tryParse(*buf);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("dest", view->destination());
+  EXPECT_EQ("group", view->group());
+  EXPECT_EQ(7, view->accessKey());
+  EXPECT_TRUE(view->accessToken().empty());
+}
+
+TEST(BrokerFrameViewTest, Destination) {
+  auto buf = FrameBuilder(FrameType::DESTINATION)
+                 .string("fromDest")
+                 .string("fromGroup")
+                 .string("toDest")
+                 .string("toGroup")
+                 .raw("metadata")
+                 .build();
+
+  auto view = DestinationView::tryParse(*buf);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("fromDest", view->fromDestination());
+  EXPECT_EQ("fromGroup", view->fromGroup());
+  EXPECT_EQ("toDest", view->toDestination());
+  EXPECT_EQ("toGroup", view->toGroup());
+  EXPECT_EQ("metadata", folly::StringPiece(view->metadata()));
+
+  // Fields point into the received buffer, nothing is copied.
+  EXPECT_EQ(
+      reinterpret_cast<const char*>(buf->data()) + kBrokerFrameHeaderSize +
+          kBrokerFieldLengthSize,
+      view->fromDestination().data());
+}
+
+TEST(BrokerFrameViewTest, GroupAndBroadcast) {
+  auto group = FrameBuilder(FrameType::GROUP)
+                   .string("fromDest")
+                   .string("fromGroup")
+                   .string("toGroup")
+                   .build();
+  auto broadcast = FrameBuilder(FrameType::BROADCAST)
+                       .string("fromDest")
+                       .string("fromGroup")
+                       .string("toGroup")
+                       .raw("md")
+                       .build();
+
+  auto groupView = GroupView::tryParse(*group);
+  ASSERT_TRUE(groupView.hasValue());
+  EXPECT_EQ("toGroup", groupView->toGroup());
+  EXPECT_TRUE(groupView->metadata().empty());
+  EXPECT_EQ(nullptr, groupView->cloneMetadata(*group));
+
+  auto broadcastView = BroadcastView::tryParse(*broadcast);
+  ASSERT_TRUE(broadcastView.hasValue());
+  EXPECT_EQ(FrameType::BROADCAST, broadcastView->frameType());
+  EXPECT_EQ("toGroup", broadcastView->toGroup());
+  EXPECT_EQ("md", folly::StringPiece(broadcastView->metadata()));
+
+  // Views check the frame type.
+  EXPECT_FALSE(GroupView::tryParse(*broadcast).hasValue());
+  EXPECT_FALSE(BroadcastView::tryParse(*group).hasValue());
+}
+
+TEST(BrokerFrameViewTest, Shard) {
+  auto buf = FrameBuilder(FrameType::SHARD)
+                 .string("fromDest")
+                 .string("fromGroup")
+                 .string("toGroup")
+                 .string("key")
+                 .raw("metadata")
+                 .build();
+
+  auto view = ShardView::tryParse(*buf);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("toGroup", view->toGroup());
+  EXPECT_EQ("key", folly::StringPiece(view->shardKey()));
+  EXPECT_EQ("metadata", folly::StringPiece(view->metadata()));
+}
+
+TEST(BrokerFrameViewTest, ChainedMetadata) {
+  auto buf = FrameBuilder(FrameType::GROUP)
+                 .string("fromDest")
+                 .string("fromGroup")
+                 .string("toGroup")
+                 .raw("meta")
+                 .build();
+  buf->prependChain(folly::IOBuf::copyBuffer("data"));
+
+  auto view = GroupView::tryParse(*buf);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("meta", folly::StringPiece(view->metadata()));
+
+  auto metadata = view->cloneMetadata(*buf);
+  ASSERT_NE(nullptr, metadata);
+  EXPECT_TRUE(folly::IOBufEqualTo()(
+      *folly::IOBuf::copyBuffer("metadata"), *metadata));
+}
+
+TEST(BrokerFrameViewTest, Truncated) {
+  auto buf = FrameBuilder(FrameType::DESTINATION)
+                 .string("fromDest")
+                 .string("fromGroup")
+                 .string("toDest")
+                 .string("toGroup")
+                 .build();
+  const auto length = buf->length();
+
+  for (size_t i = 0; i < length; ++i) {
+    folly::ByteRange truncated(buf->data(), i);
+    EXPECT_FALSE(DestinationView::tryParse(truncated).hasValue()) << i;
+  }
+  EXPECT_TRUE(
+      DestinationView::tryParse(folly::ByteRange(buf->data(), length))
+          .hasValue());
+  EXPECT_EQ(
+      FrameType::UNDEFINED,
+      peekBrokerFrameType(folly::ByteRange(buf->data(), 5)));
+  EXPECT_EQ(
+      FrameType::DESTINATION,
+      peekBrokerFrameType(folly::ByteRange(buf->data(), 6)));
+}
+
+TEST(BrokerFrameViewTest, UnknownFrameType) {
+  // 0x0104 must not be taken for GROUP (0x04).
+  const uint8_t wide[] = {0x00, 0x00, 0x00, 0x01, 0x01, 0x04};
+  EXPECT_EQ(FrameType::UNDEFINED, peekBrokerFrameType(folly::range(wide)));
+  EXPECT_FALSE(GroupView::tryParse(folly::range(wide)).hasValue());
+
+  const uint8_t rsocket[] = {0x00, 0x00, 0x00, 0x01, 0x00, 0x3F};
+  EXPECT_EQ(FrameType::UNDEFINED, peekBrokerFrameType(folly::range(rsocket)));
+
+  EXPECT_EQ(
+      FrameType::GROUP,
+      fromBrokerWireType(toBrokerWireType(FrameType::GROUP)));
+  EXPECT_EQ(4, toBrokerWireType(FrameType::GROUP));
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/CompactBrokerFrame.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+class CompactBrokerFrameTest : public Test {
+ protected:
+  std::unique_ptr<folly::IOBuf> encodeDestination(
+      folly::StringPiece toDestination,
+      folly::StringPiece metadata) {
+    folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+    folly::io::QueueAppender appender(&queue, 64);
+    sender.encodeDestination(
+        appender,
+        names.intern("client"),
+        names.intern("clients"),
+        names.intern(toDestination),
+        names.intern("services"),
+        folly::ByteRange(metadata));
+    auto buf = queue.move();
+    buf->coalesce();
+    return buf;
+  }
+
+  static folly::ByteRange range(const folly::IOBuf& buf) {
+    return folly::ByteRange(buf.data(), buf.length());
+  }
+
+  NameTable names;
+  CompactBrokerCodec sender{names};
+  CompactBrokerCodec receiver{names};
+};
+
+std::unique_ptr<folly::IOBuf> setupFrame(uint16_t major, uint16_t minor) {
+  auto buf = folly::IOBuf::create(64);
+  folly::io::Appender appender(buf.get(), 0);
+  BrokerSetupLayout::encode(
+      appender,
+      major,
+      minor,
+      FrameType::BROKER_SETUP,
+      folly::StringPiece("broker"),
+      folly::StringPiece("cluster"),
+      uint64_t{7},
+      folly::ByteRange(folly::StringPiece("token")));
+  return buf;
+}
+
+} // namespace
+
+TEST_F(CompactBrokerFrameTest, Destination) {
+  auto first = encodeDestination("instance-1", "md");
+  // Names are sent in full the first time.
+  EXPECT_EQ(
+      1 + 1 + 6 + 1 + 7 + 1 + 10 + 1 + 8 + 2, first->length());
+  EXPECT_TRUE(isCompactBrokerFrame(range(*first)));
+
+  CompactRoutingFrame frame;
+  ASSERT_EQ(DecodeError::NONE, receiver.decode(range(*first), frame));
+  EXPECT_EQ(FrameType::DESTINATION, frame.frameType);
+  EXPECT_EQ("client", names.name(frame.fromDestination));
+  EXPECT_EQ("clients", names.name(frame.fromGroup));
+  EXPECT_EQ("instance-1", names.name(frame.toDestination));
+  EXPECT_EQ("services", names.name(frame.toGroup));
+  EXPECT_EQ("md", folly::StringPiece(frame.metadata));
+
+  // And as route IDs after that.
+  auto second = encodeDestination("instance-1", "md");
+  EXPECT_EQ(1 + 4 + 2, second->length());
+  ASSERT_EQ(DecodeError::NONE, receiver.decode(range(*second), frame));
+  EXPECT_EQ("instance-1", names.name(frame.toDestination));
+  EXPECT_EQ("md", folly::StringPiece(frame.metadata));
+
+  // A new name among known ones.
+  auto third = encodeDestination("instance-2", "");
+  EXPECT_EQ(1 + 3 + 1 + 10, third->length());
+  ASSERT_EQ(DecodeError::NONE, receiver.decode(range(*third), frame));
+  EXPECT_EQ("instance-2", names.name(frame.toDestination));
+  EXPECT_EQ("services", names.name(frame.toGroup));
+  EXPECT_TRUE(frame.metadata.empty());
+}
+
+TEST_F(CompactBrokerFrameTest, GroupAndShard) {
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  folly::io::QueueAppender appender(&queue, 64);
+  const auto services = names.intern("services");
+  sender.encodeGroup(
+      appender,
+      FrameType::BROADCAST,
+      names.intern("client"),
+      services,
+      services,
+      folly::IOBuf::copyBuffer("md"));
+  auto broadcast = queue.move();
+  broadcast->coalesce();
+
+  CompactRoutingFrame frame;
+  ASSERT_EQ(DecodeError::NONE, receiver.decode(range(*broadcast), frame));
+  EXPECT_EQ(FrameType::BROADCAST, frame.frameType);
+  EXPECT_EQ(services, frame.fromGroup);
+  EXPECT_EQ(services, frame.toGroup);
+  EXPECT_EQ("md", folly::StringPiece(frame.metadata));
+
+  sender.encodeShard(
+      appender,
+      names.intern("client"),
+      services,
+      services,
+      folly::ByteRange(folly::StringPiece("key")),
+      folly::ByteRange());
+  auto shard = queue.move();
+  shard->coalesce();
+  EXPECT_EQ(1 + 3 + 1 + 3, shard->length());
+  ASSERT_EQ(DecodeError::NONE, receiver.decode(range(*shard), frame));
+  EXPECT_EQ(FrameType::SHARD, frame.frameType);
+  EXPECT_EQ("key", folly::StringPiece(frame.shardKey));
+  EXPECT_TRUE(frame.metadata.empty());
+}
+
+TEST_F(CompactBrokerFrameTest, Malformed) {
+  auto buf = encodeDestination("instance-1", "");
+  CompactRoutingFrame frame;
+  for (size_t i = 0; i + 1 < buf->length(); ++i) {
+    EXPECT_NE(
+        DecodeError::NONE, receiver.decode(range(*buf).subpiece(0, i), frame))
+        << i;
+  }
+
+  // A route that was never sent.
+  const uint8_t unknownRoute[] = {0x83, 0x00, 0x02, 0x04, 0x06};
+  EXPECT_EQ(
+      DecodeError::INVALID_ROUTING_HEADER,
+      receiver.decode(
+          folly::ByteRange(unknownRoute, sizeof(unknownRoute)), frame));
+
+  // Failed frames didn't advance the numbering.
+  ASSERT_EQ(DecodeError::NONE, receiver.decode(range(*buf), frame));
+  EXPECT_EQ("instance-1", names.name(frame.toDestination));
+}
+
+TEST_F(CompactBrokerFrameTest, LimitsNewNames) {
+  // The receiving end has its own table. Names it already knows don't
+  // count against the limit.
+  NameTable remote;
+  remote.intern("client");
+  remote.intern("clients");
+  remote.intern("services");
+  CompactBrokerCodec limited(remote, 2);
+
+  CompactRoutingFrame frame;
+  auto first = encodeDestination("instance-1", "");
+  ASSERT_EQ(DecodeError::NONE, limited.decode(range(*first), frame));
+  auto second = encodeDestination("instance-2", "");
+  ASSERT_EQ(DecodeError::NONE, limited.decode(range(*second), frame));
+  EXPECT_EQ(5, remote.size());
+
+  auto third = encodeDestination("instance-3", "");
+  EXPECT_EQ(DecodeError::TOO_MANY_NAMES, limited.decode(range(*third), frame));
+  EXPECT_EQ(5, remote.size());
+
+  auto fourth = encodeDestination("instance-1", "");
+  ASSERT_EQ(DecodeError::NONE, limited.decode(range(*fourth), frame));
+  EXPECT_EQ("instance-1", remote.name(frame.toDestination));
+}
+
+TEST_F(CompactBrokerFrameTest, DetectWireFormat) {
+  EXPECT_EQ(
+      BrokerWireFormat::V1_0,
+      detectBrokerWireFormat(range(*setupFrame(1, 0))).value());
+  EXPECT_EQ(
+      BrokerWireFormat::COMPACT,
+      detectBrokerWireFormat(
+          range(*setupFrame(
+              kCompactBrokerMajorVersion, kCompactBrokerMinorVersion)))
+          .value());
+  EXPECT_FALSE(detectBrokerWireFormat(range(*encodeDestination("a", ""))));
+  EXPECT_FALSE(isCompactBrokerFrame(range(*setupFrame(1, 0))));
+}
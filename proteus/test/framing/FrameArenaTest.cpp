@@ -0,0 +1,124 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameArena.h"
+#include "proteus/framing/FrameBatch.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+struct Tracked {
+  Tracked(std::vector<int>& destroyed, int id)
+      : destroyed_(destroyed), id_(id) {}
+  ~Tracked() {
+    destroyed_.push_back(id_);
+  }
+
+  std::vector<int>& destroyed_;
+  int id_;
+};
+
+} // namespace
+
+TEST(FrameArenaTest, BumpAllocates) {
+  FrameArena arena(256);
+  auto* a = arena.create<uint64_t>(1);
+  auto* b = arena.create<uint64_t>(2);
+  EXPECT_EQ(1, *a);
+  EXPECT_EQ(2, *b);
+  EXPECT_EQ(
+      reinterpret_cast<uint8_t*>(a) + sizeof(uint64_t),
+      reinterpret_cast<uint8_t*>(b));
+  EXPECT_EQ(2 * sizeof(uint64_t), arena.bytesAllocated());
+  EXPECT_EQ(1, arena.blockCount());
+
+  auto* c = static_cast<uint8_t*>(arena.allocate(1, 1));
+  auto* d = arena.allocate(sizeof(uint32_t), alignof(uint32_t));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(d) % alignof(uint32_t));
+  EXPECT_LT(c, d);
+}
+
+TEST(FrameArenaTest, ResetRunsDestructorsInReverse) {
+  std::vector<int> destroyed;
+  FrameArena arena;
+  arena.create<Tracked>(destroyed, 1);
+  arena.create<Tracked>(destroyed, 2);
+  EXPECT_TRUE(destroyed.empty());
+
+  arena.reset();
+  EXPECT_EQ((std::vector<int>{2, 1}), destroyed);
+  EXPECT_EQ(0, arena.bytesAllocated());
+
+  arena.reset();
+  EXPECT_EQ(2, destroyed.size());
+}
+
+TEST(FrameArenaTest, ResetKeepsFirstBlock) {
+  FrameArena arena(64);
+  auto* first = arena.allocate(32);
+  arena.allocate(48);
+  arena.allocate(1024);
+  EXPECT_EQ(3, arena.blockCount());
+
+  arena.reset();
+  EXPECT_EQ(1, arena.blockCount());
+  EXPECT_EQ(first, arena.allocate(32));
+}
+
+TEST(FrameArenaTest, BatchesShareSlab) {
+  FrameArena arena;
+  std::unique_ptr<folly::IOBuf> first;
+  std::unique_ptr<folly::IOBuf> second;
+  {
+    FrameBatch batch(0, arena);
+    batch.beginFrame(sizeof(uint32_t), 0);
+    batch.writeBE<uint32_t>(1);
+    first = batch.move();
+  }
+  {
+    FrameBatch batch(0, arena);
+    batch.beginFrame(sizeof(uint32_t), 0);
+    batch.writeBE<uint32_t>(2);
+    second = batch.move();
+  }
+  EXPECT_EQ(first->buffer(), second->buffer());
+  EXPECT_EQ(first->tail(), second->data());
+
+  // Frames stay valid once the arena is reset.
+  arena.reset();
+  EXPECT_EQ(std::string("\x00\x00\x00\x01", 4), first->toString());
+  EXPECT_EQ(std::string("\x00\x00\x00\x02", 4), second->toString());
+}
+
+TEST(FrameArenaTest, UnflushedBytesAreDropped) {
+  FrameArena arena;
+  {
+    FrameBatch batch(0, arena);
+    batch.beginFrame(sizeof(uint32_t), 0);
+    batch.writeBE<uint32_t>(1);
+  }
+  FrameBatch batch(0, arena);
+  batch.beginFrame(sizeof(uint32_t), 0);
+  batch.writeBE<uint32_t>(2);
+  EXPECT_EQ(std::string("\x00\x00\x00\x02", 4), batch.move()->toString());
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameBatch.h"
+#include "proteus/framing/FrameChecksum.h"
+#include "proteus/framing/FrameSplitter.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+TEST(FrameBatchTest, HeadersShareOneBuffer) {
+  FrameBatch batch;
+  for (uint32_t i = 0; i < 10; ++i) {
+    batch.beginFrame(sizeof(uint32_t), 0);
+    batch.writeBE<uint32_t>(i);
+  }
+  EXPECT_EQ(10, batch.frameCount());
+
+  auto chain = batch.move();
+  EXPECT_EQ(1, chain->countChainElements());
+  EXPECT_EQ(10 * sizeof(uint32_t), chain->computeChainDataLength());
+  EXPECT_EQ(9, chain->data()[sizeof(uint32_t) * 10 - 1]);
+  EXPECT_TRUE(batch.empty());
+}
+
+TEST(FrameBatchTest, PayloadsAreChainedWithoutCopy) {
+  auto data = folly::IOBuf::copyBuffer("424242");
+  const auto* dataPtr = data->data();
+
+  FrameBatch batch;
+  batch.beginFrame(2, data->length());
+  batch.writeBE<uint16_t>(1);
+  batch.insert(std::move(data));
+  batch.beginFrame(2, 0);
+  batch.writeBE<uint16_t>(2);
+
+  auto chain = batch.move();
+  ASSERT_EQ(3, chain->countChainElements());
+  EXPECT_EQ(dataPtr, chain->next()->data());
+  EXPECT_EQ(
+      std::string("\x00\x01" "424242" "\x00\x02", 10), chain->toString());
+  // Both header segments live in the same slab.
+  EXPECT_EQ(chain->buffer(), chain->prev()->buffer());
+}
+
+TEST(FrameBatchTest, FrameLengthField) {
+  FrameBatch batch(3);
+  batch.beginFrame(2, 6);
+  batch.writeBE<uint16_t>(7);
+  batch.insert(folly::IOBuf::copyBuffer("424242"));
+
+  auto chain = batch.move();
+  EXPECT_EQ(
+      std::string("\x00\x00\x08\x00\x07" "424242", 11), chain->toString());
+}
+
+TEST(FrameBatchTest, SlabOverflow) {
+  FrameBatch batch(0, 16);
+  for (uint64_t i = 0; i < 5; ++i) {
+    batch.beginFrame(sizeof(uint64_t), 0);
+    batch.writeBE<uint64_t>(i);
+  }
+  // Headers bigger than a slab get a buffer of their own.
+  std::string big(100, 'x');
+  batch.beginFrame(big.size(), 0);
+  batch.push(reinterpret_cast<const uint8_t*>(big.data()), big.size());
+
+  auto chain = batch.move();
+  EXPECT_EQ(5 * sizeof(uint64_t) + big.size(), chain->computeChainDataLength());
+  EXPECT_EQ(4, chain->countChainElements());
+}
+
+TEST(FrameBatchTest, SlabIsReusedAcrossBatches) {
+  FrameBatch batch;
+  batch.beginFrame(sizeof(uint32_t), 0);
+  batch.writeBE<uint32_t>(1);
+  auto first = batch.move();
+
+  batch.beginFrame(sizeof(uint32_t), 0);
+  batch.writeBE<uint32_t>(2);
+  auto second = batch.move();
+
+  EXPECT_EQ(first->buffer(), second->buffer());
+  EXPECT_EQ(first->tail(), second->data());
+  EXPECT_EQ(std::string("\x00\x00\x00\x01", 4), first->toString());
+  EXPECT_EQ(std::string("\x00\x00\x00\x02", 4), second->toString());
+}
+
+TEST(FrameBatchTest, ChecksumTrailer) {
+  FrameBatch batch(3);
+  batch.setChecksumFrames(true);
+  batch.beginFrame(2, 6);
+  batch.writeBE<uint16_t>(1);
+  batch.insert(folly::IOBuf::copyBuffer("424242"));
+  batch.writeBE<uint16_t>(2);
+  batch.beginFrame(2, 0);
+  batch.writeBE<uint16_t>(3);
+
+  FrameSplitter splitter;
+  splitter.append(batch.move());
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  ASSERT_EQ(2, splitter.split(frames));
+
+  // The checksum covers header and payload, written apart.
+  EXPECT_EQ(
+      2 + 6 + 2 + kFrameChecksumSize, frames[0]->computeChainDataLength());
+  EXPECT_EQ(DecodeError::NONE, verifyFrameChecksum(*frames[0]));
+  EXPECT_EQ(
+      std::string("\x00\x01" "424242" "\x00\x02", 10),
+      frames[0]->toString());
+
+  EXPECT_EQ(DecodeError::NONE, verifyFrameChecksum(*frames[1]));
+  EXPECT_EQ(std::string("\x00\x03", 2), frames[1]->toString());
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameChecksum.h"
+#include "proteus/framing/FrameSerializer.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+// `body` followed by its checksum, cut into buffers of `pieceSize` bytes.
+std::unique_ptr<folly::IOBuf> checksummed(
+    folly::StringPiece body,
+    size_t pieceSize) {
+  const auto crc = frameChecksum(
+      *folly::IOBuf::copyBuffer(body), initialFrameChecksum());
+  auto flat = folly::IOBuf::copyBuffer(body, 0, kFrameChecksumSize);
+  folly::storeUnaligned(flat->writableTail(), folly::Endian::big(crc));
+  flat->append(kFrameChecksumSize);
+
+  folly::IOBufQueue queue;
+  for (size_t offset = 0; offset < flat->length(); offset += pieceSize) {
+    queue.append(folly::IOBuf::copyBuffer(
+        flat->data() + offset, std::min(pieceSize, flat->length() - offset)));
+  }
+  return queue.move();
+}
+
+} // namespace
+
+TEST(FrameChecksumTest, Incremental) {
+  const auto whole = frameChecksum(
+      *folly::IOBuf::copyBuffer("frame header and payload"),
+      initialFrameChecksum());
+  auto chain = folly::IOBuf::copyBuffer("frame header");
+  chain->prependChain(folly::IOBuf::copyBuffer(" and payload"));
+  EXPECT_EQ(whole, frameChecksum(*chain, initialFrameChecksum()));
+  EXPECT_NE(
+      whole,
+      frameChecksum(
+          *folly::IOBuf::copyBuffer("frame header and paylaod"),
+          initialFrameChecksum()));
+}
+
+TEST(FrameChecksumTest, Verify) {
+  // The trailer split across buffers in every possible way.
+  for (size_t pieceSize = 1; pieceSize < 12; ++pieceSize) {
+    auto frame = checksummed("424242", pieceSize);
+    EXPECT_EQ(DecodeError::NONE, verifyFrameChecksum(*frame)) << pieceSize;
+    EXPECT_EQ("424242", frame->toString()) << pieceSize;
+  }
+
+  auto frame = checksummed("424242", 3);
+  frame->writableData()[0] ^= 1;
+  EXPECT_EQ(DecodeError::CHECKSUM_MISMATCH, verifyFrameChecksum(*frame));
+  EXPECT_EQ(6 + kFrameChecksumSize, frame->computeChainDataLength());
+
+  EXPECT_EQ(
+      DecodeError::TRUNCATED,
+      verifyFrameChecksum(*folly::IOBuf::copyBuffer("abc")));
+}
+
+TEST(FrameChecksumTest, FromSetup) {
+  Frame_SETUP setup(
+      FrameFlags::EMPTY,
+      1,
+      0,
+      500,
+      1000,
+      rsocket::ResumeIdentificationToken(),
+      "application/x.netifi",
+      "application/json",
+      rsocket::Payload());
+  EXPECT_FALSE(frameChecksumFromSetup(setup));
+  setup.metadataMimeType_ = "application/x.netifi; frame-checksum=crc32c";
+  EXPECT_TRUE(frameChecksumFromSetup(setup));
+  setup.metadataMimeType_ = "application/x.netifi; frame-checksum=md5";
+  EXPECT_FALSE(frameChecksumFromSetup(setup));
+}
+
+TEST(FrameChecksumTest, Serializer) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  serializer->checksumFrames() = true;
+
+  auto serializedFrame = serializer->serializeBatchOut(Frame_PAYLOAD(
+      3,
+      FrameFlags::NEXT,
+      rsocket::Payload(folly::IOBuf::copyBuffer("424242"))));
+  serializedFrame->coalesce();
+  // Corrupt the data.
+  serializedFrame->writableData()[serializedFrame->length() - 5] ^= 1;
+  EXPECT_EQ(
+      DecodeError::CHECKSUM_MISMATCH,
+      serializer->verifyChecksum(*serializedFrame));
+  serializedFrame->writableData()[serializedFrame->length() - 5] ^= 1;
+
+  // Decoding verifies and trims the trailer.
+  Frame_PAYLOAD frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      serializer->tryDeserializeFrom(frame, serializedFrame->clone()));
+  EXPECT_EQ("424242", frame.payload_.data->toString());
+  LazyFrame lazy;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      serializer->tryDeserializeFrom(lazy, serializedFrame->clone()));
+  EXPECT_EQ("424242", lazy.cloneData()->toString());
+
+  // And rejects corrupted frames.
+  serializedFrame->unshare();
+  serializedFrame->writableData()[serializedFrame->length() - 5] ^= 1;
+  EXPECT_EQ(
+      DecodeError::CHECKSUM_MISMATCH,
+      serializer->tryDeserializeFrom(frame, serializedFrame->clone()));
+  EXPECT_EQ(
+      DecodeError::CHECKSUM_MISMATCH,
+      serializer->tryDeserializeFrom(lazy, serializedFrame->clone()));
+
+  // Single frames get a trailer too.
+  auto request = serializer->serializeOut(Frame_REQUEST_STREAM(
+      5,
+      FrameFlags::EMPTY,
+      10,
+      rsocket::Payload(folly::IOBuf::copyBuffer("424242"))));
+  EXPECT_EQ(DecodeError::NONE, serializer->verifyChecksum(*request));
+}
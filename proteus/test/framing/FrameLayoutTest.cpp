@@ -0,0 +1,212 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameBatch.h"
+#include "proteus/framing/FrameLayout.h"
+#include "proteus/test/BrokerFrames.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+using namespace ::proteus::layout;
+using namespace ::proteus::test;
+
+namespace {
+
+using TestLayout = Layout<
+    BigEndian<int32_t>,
+    UInt24,
+    LengthPrefixed<BigEndian<uint8_t>, folly::StringPiece>,
+    BigEndian<uint16_t>,
+    Trailing<>>;
+
+using FixedLayout = Layout<BigEndian<int32_t>, BigEndian<uint16_t>, UInt24>;
+
+static_assert(FixedLayout::kFixed, "");
+static_assert(FixedLayout::kMinSize == 9, "");
+static_assert(FixedLayout::offsetOf<2>() == 6, "");
+static_assert(!TestLayout::kFixed, "");
+static_assert(TestLayout::kMinSize == 4 + 3 + 1 + 2, "");
+static_assert(TestLayout::offsetOf<2>() == 7, "");
+static_assert(BrokerFrameHeaderLayout::offsetOf<2>() == 4, "");
+
+folly::ByteRange range(const folly::IOBuf& buf) {
+  return folly::ByteRange(buf.data(), buf.length());
+}
+
+} // namespace
+
+TEST(FrameLayoutTest, RoundTrip) {
+  auto buf = encode<TestLayout>(
+      -7,
+      0x123456u,
+      folly::StringPiece("hello"),
+      uint16_t(42),
+      folly::ByteRange(folly::StringPiece("rest")));
+  EXPECT_EQ(4 + 3 + 1 + 5 + 2 + 4, buf->length());
+
+  int32_t a;
+  uint32_t b;
+  folly::StringPiece c;
+  uint16_t d;
+  folly::ByteRange e;
+  ASSERT_TRUE(TestLayout::decode(range(*buf), a, b, c, d, e));
+  EXPECT_EQ(-7, a);
+  EXPECT_EQ(0x123456u, b);
+  EXPECT_EQ("hello", c);
+  EXPECT_EQ(42, d);
+  EXPECT_EQ("rest", folly::StringPiece(e));
+
+  // Strings point into the frame.
+  EXPECT_EQ(reinterpret_cast<const char*>(buf->data()) + 8, c.data());
+}
+
+TEST(FrameLayoutTest, FixedOffsets) {
+  auto buf = encode<FixedLayout>(1, uint16_t(2), 3u);
+  EXPECT_EQ(FixedLayout::kMinSize, buf->length());
+  EXPECT_EQ(
+      FixedLayout::kMinSize, FixedLayout::serializedSize(1, uint16_t(2), 3u));
+  EXPECT_EQ(1, FixedLayout::load<0>(range(*buf)));
+  EXPECT_EQ(2, FixedLayout::load<1>(range(*buf)));
+  EXPECT_EQ(3, FixedLayout::load<2>(range(*buf)));
+}
+
+TEST(FrameLayoutTest, FindOffset) {
+  auto buf = encode<TestLayout>(
+      1,
+      2u,
+      folly::StringPiece("abc"),
+      uint16_t(3),
+      folly::ByteRange());
+
+  auto offset = TestLayout::findOffset<3>(range(*buf));
+  ASSERT_TRUE(offset.hasValue());
+  EXPECT_EQ(4 + 3 + 1 + 3, *offset);
+  EXPECT_FALSE(TestLayout::findOffset<3>(range(*buf).subpiece(0, 9)));
+}
+
+TEST(FrameLayoutTest, Truncated) {
+  auto buf = encode<TestLayout>(
+      1,
+      2u,
+      folly::StringPiece("abc"),
+      uint16_t(3),
+      folly::ByteRange());
+
+  int32_t a;
+  uint32_t b;
+  folly::StringPiece c;
+  uint16_t d;
+  folly::ByteRange e;
+  for (size_t i = 0; i < buf->length(); ++i) {
+    EXPECT_FALSE(TestLayout::decode(range(*buf).subpiece(0, i), a, b, c, d, e))
+        << i;
+  }
+}
+
+TEST(FrameLayoutTest, TrailingIOBufIsChained) {
+  FrameBatch batch;
+  auto metadata = folly::IOBuf::copyBuffer("metadata");
+  auto* metadataBuf = metadata.get();
+  batch.beginFrame(
+      GroupLayout::kMinSize + sizeof("fromfromGrouptoGroup") - 1,
+      metadata->length());
+  GroupLayout::encode(
+      batch,
+      uint16_t(0),
+      uint16_t(1),
+      FrameType::GROUP,
+      folly::StringPiece("from"),
+      folly::StringPiece("fromGroup"),
+      folly::StringPiece("toGroup"),
+      std::move(metadata));
+
+  auto buf = batch.move();
+  EXPECT_EQ(metadataBuf, buf->next());
+
+  auto view = GroupView::tryParse(range(*buf));
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("toGroup", view->toGroup());
+  EXPECT_TRUE(folly::IOBufEqualTo()(
+      *folly::IOBuf::copyBuffer("metadata"), *view->cloneMetadata(*buf)));
+}
+
+TEST(FrameLayoutTest, BrokerFramesRoundTrip) {
+  auto setup = encode<BrokerSetupLayout>(
+      uint16_t(0),
+      uint16_t(1),
+      FrameType::BROKER_SETUP,
+      folly::StringPiece("broker"),
+      folly::StringPiece("cluster"),
+      uint64_t(7),
+      folly::ByteRange(folly::StringPiece("token")));
+  auto setupView = BrokerSetupView::tryParse(*setup);
+  ASSERT_TRUE(setupView.hasValue());
+  EXPECT_EQ("broker", setupView->brokerId());
+  EXPECT_EQ(7, setupView->accessKey());
+
+  auto shard = encode<ShardLayout>(
+      uint16_t(0),
+      uint16_t(1),
+      FrameType::SHARD,
+      folly::StringPiece("from"),
+      folly::StringPiece("fromGroup"),
+      folly::StringPiece("toGroup"),
+      folly::ByteRange(folly::StringPiece("key")),
+      folly::ByteRange(folly::StringPiece("md")));
+  auto shardView = ShardView::tryParse(*shard);
+  ASSERT_TRUE(shardView.hasValue());
+  EXPECT_EQ("key", folly::StringPiece(shardView->shardKey()));
+  EXPECT_EQ("md", folly::StringPiece(shardView->metadata()));
+  EXPECT_EQ(
+      ShardLayout::findOffset<7>(range(*shard)).value(),
+      shardView->metadataOffset());
+}
+
+TEST(FrameLayoutTest, VarInt) {
+  using Varint = VarInt<uint32_t>;
+  for (uint32_t value :
+       {0u, 1u, 127u, 128u, 300u, 16383u, 16384u, 0xFFFFFFFFu}) {
+    auto buf = encode<Layout<Varint>>(value);
+    EXPECT_EQ(Varint::size(value), buf->length()) << value;
+    EXPECT_EQ(buf->length(), Layout<Varint>::serializedSize(value));
+
+    uint32_t decoded;
+    auto in = range(*buf);
+    ASSERT_TRUE(Varint::decode(in, decoded)) << value;
+    EXPECT_EQ(value, decoded);
+    EXPECT_TRUE(in.empty());
+  }
+  EXPECT_EQ(1u, Varint::size(127));
+  EXPECT_EQ(2u, Varint::size(128));
+  EXPECT_EQ(Varint::kMaxSize, Varint::size(0xFFFFFFFF));
+
+  uint32_t value;
+  // Truncated.
+  const uint8_t truncated[] = {0x80, 0x80};
+  folly::ByteRange in(truncated, sizeof(truncated));
+  EXPECT_FALSE(Varint::decode(in, value));
+  // Too long, or too big for 32 bits.
+  const uint8_t tooLong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  in = folly::ByteRange(tooLong, sizeof(tooLong));
+  EXPECT_FALSE(Varint::decode(in, value));
+  const uint8_t tooBig[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x1F};
+  in = folly::ByteRange(tooBig, sizeof(tooBig));
+  EXPECT_FALSE(Varint::decode(in, value));
+}
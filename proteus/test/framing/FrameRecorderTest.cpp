@@ -0,0 +1,148 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <thread>
+
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameRecorder.h"
+#include "proteus/framing/FrameSerializer.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+FrameHeader header(rsocket::StreamId streamId) {
+  return FrameHeader(FrameType::PAYLOAD, FrameFlags::NEXT, streamId);
+}
+
+std::vector<uint32_t> streamIds(const std::vector<FrameRecord>& records) {
+  std::vector<uint32_t> ids;
+  for (const auto& record : records) {
+    ids.push_back(record.streamId);
+  }
+  return ids;
+}
+
+} // namespace
+
+TEST(FrameRecorderTest, KeepsLastRecords) {
+  FrameRecorder recorder(3);
+  EXPECT_EQ(4u, recorder.capacity());
+  EXPECT_TRUE(recorder.snapshot().empty());
+
+  for (rsocket::StreamId id = 1; id <= 6; ++id) {
+    recorder.record(
+        FrameRecord::Direction::ENCODE,
+        header(id),
+        100,
+        folly::ByteRange(folly::StringPiece("header")),
+        DecodeError::NONE,
+        7);
+  }
+
+  const auto records = recorder.snapshot();
+  EXPECT_THAT(streamIds(records), ElementsAre(3, 4, 5, 6));
+  EXPECT_EQ(FrameType::PAYLOAD, records[0].type);
+  EXPECT_EQ(FrameFlags::NEXT, records[0].flags);
+  EXPECT_EQ(100u, records[0].length);
+  EXPECT_EQ(7u, records[0].routeId);
+  EXPECT_EQ(
+      "header",
+      folly::StringPiece(folly::ByteRange(
+          records[0].header.data(), records[0].headerLength)));
+}
+
+TEST(FrameRecorderTest, TruncatesHeader) {
+  FrameRecorder recorder;
+  const std::string bytes(2 * FrameRecord::kHeaderSize, 'h');
+  recorder.record(
+      FrameRecord::Direction::DECODE,
+      header(1),
+      bytes.size(),
+      folly::ByteRange(folly::StringPiece(bytes)),
+      DecodeError::TRUNCATED);
+
+  const auto records = recorder.snapshot();
+  ASSERT_EQ(1u, records.size());
+  EXPECT_EQ(FrameRecord::kHeaderSize, records[0].headerLength);
+  EXPECT_EQ(FrameRecord::Direction::DECODE, records[0].direction);
+  EXPECT_EQ(DecodeError::TRUNCATED, records[0].error);
+}
+
+TEST(FrameRecorderTest, ThreadsReuseRings) {
+  FrameRecorder recorder(16);
+  for (rsocket::StreamId id = 1; id <= 3; ++id) {
+    std::thread([&] {
+      recorder.record(
+          FrameRecord::Direction::ENCODE, header(id), 6, folly::ByteRange());
+    }).join();
+  }
+  // One ring was enough, records of exited threads are kept.
+  EXPECT_THAT(streamIds(recorder.snapshot()), ElementsAre(1, 2, 3));
+}
+
+TEST(FrameRecorderTest, Format) {
+  FrameRecord record;
+  record.timestamp = 1234;
+  record.streamId = 5;
+  record.length = 10;
+  record.type = FrameType::REQUEST_N;
+  record.flags = FrameFlags::EMPTY;
+  record.headerLength = 2;
+  record.header[0] = 0xAB;
+  record.header[1] = 0x01;
+
+  char line[kMaxFrameRecordLineSize];
+  const auto length = formatFrameRecord(record, line);
+  EXPECT_EQ(
+      "1234 ENCODE type=8 flags=0x0000 stream=5 length=10 route=0 error=0 "
+      "header=ab01\n",
+      std::string(line, length));
+}
+
+TEST(FrameRecorderTest, Serializer) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion(1, 0));
+  FrameRecorder recorder;
+  serializer->setRecorder(&recorder);
+
+  auto frame = serializer->serializeBatchOut(Frame_REQUEST_N(3, 10));
+  Frame_REQUEST_N requestN;
+  EXPECT_EQ(
+      DecodeError::NONE,
+      serializer->tryDeserializeFrom(requestN, frame->clone()));
+  EXPECT_EQ(
+      DecodeError::TRUNCATED,
+      serializer->tryDeserializeFrom(
+          requestN, folly::IOBuf::copyBuffer("\x00\x00", 2)));
+
+  const auto records = recorder.snapshot();
+  ASSERT_EQ(3u, records.size());
+  frame->coalesce();
+  for (size_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(FrameType::REQUEST_N, records[i].type);
+    EXPECT_EQ(3u, records[i].streamId);
+    EXPECT_EQ(10u, records[i].length);
+    EXPECT_EQ(
+        frame->coalesce(),
+        folly::ByteRange(records[i].header.data(), records[i].headerLength));
+  }
+  EXPECT_EQ(FrameRecord::Direction::ENCODE, records[0].direction);
+  EXPECT_EQ(FrameRecord::Direction::DECODE, records[1].direction);
+  EXPECT_EQ(DecodeError::TRUNCATED, records[2].error);
+  EXPECT_EQ(0u, records[2].streamId);
+  EXPECT_EQ(2u, records[2].length);
+}
@@ -0,0 +1,240 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameSerializer_compact.h"
+#include "proteus/test/BrokerFrames.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+std::string toString(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->cloneCoalescedAsValue().moveToFbString().toStdString()
+             : std::string();
+}
+
+Frame_REQUEST_STREAM requestStream() {
+  return Frame_REQUEST_STREAM(
+      5, FrameFlags::METADATA, 10, rsocket::Payload("data", "metadata"));
+}
+
+Frame_SETUP setup(uint16_t major, uint16_t minor) {
+  return Frame_SETUP(
+      FrameFlags::EMPTY,
+      major,
+      minor,
+      500,
+      1000,
+      rsocket::ResumeIdentificationToken(),
+      "application/json",
+      "application/json",
+      rsocket::Payload());
+}
+
+Frame_REQUEST_FNF routedRequest(rsocket::StreamId streamId) {
+  return Frame_REQUEST_FNF(
+      streamId,
+      FrameFlags::EMPTY,
+      rsocket::Payload(
+          folly::IOBuf::copyBuffer("data"),
+          test::groupFrame(FrameType::GROUP, "services")));
+}
+
+} // namespace
+
+TEST(FrameSerializerCompactTest, RoundTrip) {
+  FrameSerializerCompact compact;
+  FrameSerializerV1_0 v1;
+
+  auto frame = compact.serializeBatchOut(requestStream());
+  // Stream ID, type and flags, request N and metadata length take a byte
+  // each instead of 13.
+  EXPECT_EQ(
+      v1.serializeBatchOut(requestStream())->computeChainDataLength() - 9,
+      frame->computeChainDataLength());
+  EXPECT_EQ(FrameType::REQUEST_STREAM, compact.peekFrameType(*frame));
+  EXPECT_EQ(5u, compact.peekStreamId(*frame).value());
+
+  Frame_REQUEST_STREAM decoded;
+  ASSERT_EQ(
+      DecodeError::NONE, compact.tryDeserializeFrom(decoded, std::move(frame)));
+  EXPECT_EQ(5u, decoded.header_.streamId);
+  EXPECT_EQ(10u, decoded.requestN_);
+  EXPECT_EQ("data", toString(decoded.payload_.data));
+  EXPECT_EQ("metadata", toString(decoded.payload_.metadata));
+
+  // Single frames, whose stream ID and request N take two bytes each.
+  auto single = compact.serializeOut(Frame_REQUEST_N(300, 1000));
+  EXPECT_EQ(2u + 1 + 2, single->computeChainDataLength());
+  Frame_REQUEST_N requestN;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      compact.tryDeserializeFrom(requestN, std::move(single)));
+  EXPECT_EQ(300u, requestN.header_.streamId);
+  EXPECT_EQ(1000u, requestN.requestN_);
+
+  // Truncated in the metadata.
+  frame = compact.serializeBatchOut(requestStream());
+  frame->coalesce();
+  frame->trimEnd(6);
+  EXPECT_EQ(
+      DecodeError::TRUNCATED,
+      compact.tryDeserializeFrom(decoded, std::move(frame)));
+}
+
+TEST(FrameSerializerCompactTest, OtherFlagsAreEscaped) {
+  FrameSerializerCompact compact;
+  // PAYLOAD with the IGNORE flag, which doesn't fit the type byte.
+  const uint16_t typeAndFlags = static_cast<uint16_t>(FrameType::PAYLOAD)
+          << 10 |
+      static_cast<uint16_t>(FrameFlags::IGNORE) |
+      static_cast<uint16_t>(FrameFlags::NEXT);
+  const uint8_t bytes[] = {
+      7, 0xF0, uint8_t(typeAndFlags >> 8), uint8_t(typeAndFlags), 'd'};
+  auto frame = folly::IOBuf::copyBuffer(bytes, sizeof(bytes));
+  EXPECT_EQ(FrameType::PAYLOAD, compact.peekFrameType(*frame));
+  EXPECT_EQ(7u, compact.peekStreamId(*frame).value());
+
+  Frame_PAYLOAD payload;
+  ASSERT_EQ(
+      DecodeError::NONE, compact.tryDeserializeFrom(payload, std::move(frame)));
+  EXPECT_EQ(7u, payload.header_.streamId);
+  EXPECT_EQ("d", toString(payload.payload_.data));
+
+  // Stream IDs are at most 31 bits.
+  const uint8_t tooLarge[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0x90};
+  EXPECT_FALSE(compact.peekStreamId(
+      *folly::IOBuf::copyBuffer(tooLarge, sizeof(tooLarge))));
+}
+
+TEST(FrameSerializerCompactTest, Autodetection) {
+  FrameSerializerCompact compact;
+  FrameSerializerV1_0 v1;
+
+  auto serializer = FrameSerializer::createAutodetectedSerializer(
+      *compact.serializeOut(setup(1, 1)));
+  ASSERT_NE(nullptr, serializer);
+  EXPECT_EQ(FrameSerializerCompact::Version, serializer->protocolVersion());
+
+  serializer = FrameSerializer::createAutodetectedSerializer(
+      *v1.serializeBatchOut(setup(1, 0)));
+  ASSERT_NE(nullptr, serializer);
+  EXPECT_EQ(FrameSerializerV1_0::Version, serializer->protocolVersion());
+
+  // Only the compact format at its own version.
+  EXPECT_EQ(
+      ProtocolVersion::Unknown,
+      FrameSerializerCompact::detectProtocolVersion(
+          *v1.serializeBatchOut(setup(1, 1))));
+  EXPECT_EQ(
+      ProtocolVersion::Unknown,
+      FrameSerializerCompact::detectProtocolVersion(
+          *compact.serializeOut(setup(1, 0))));
+  EXPECT_EQ(
+      ProtocolVersion::Unknown,
+      FrameSerializerCompact::detectProtocolVersion(
+          *compact.serializeOut(requestStream())));
+
+  EXPECT_NE(
+      nullptr,
+      FrameSerializer::createFrameSerializer(FrameSerializerCompact::Version));
+}
+
+TEST(FrameSerializerCompactTest, LazyFrame) {
+  FrameSerializerCompact compact;
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      compact.tryDeserializeFrom(
+          frame, compact.serializeBatchOut(requestStream())));
+  EXPECT_EQ(5u, frame.header().streamId);
+  EXPECT_EQ(10u, frame.requestN());
+  ASSERT_TRUE(frame.metadataRange().hasValue());
+  EXPECT_EQ("metadata", folly::StringPiece(*frame.metadataRange()));
+  EXPECT_EQ("data", toString(frame.cloneData()));
+
+  // Forwarded to a v1.0 connection as is.
+  FrameSerializerV1_0 v1;
+  Frame_REQUEST_STREAM forwarded;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      v1.tryDeserializeFrom(forwarded, frame.buffer().clone()));
+  EXPECT_EQ(10u, forwarded.requestN_);
+  EXPECT_EQ("metadata", toString(forwarded.payload_.metadata));
+}
+
+TEST(FrameSerializerCompactTest, BrokerCodec) {
+  NameTable names;
+  CompactBrokerCodec senderCodec(names);
+  CompactBrokerCodec receiverCodec(names);
+  FrameSerializerCompact sender;
+  FrameSerializerCompact receiver;
+  sender.setBrokerCodec(&senderCodec);
+  receiver.setBrokerCodec(&receiverCodec);
+  FrameSerializerCompact plain;
+
+  const auto plainLength =
+      plain.serializeBatchOut(routedRequest(1))->computeChainDataLength();
+  auto first = sender.serializeBatchOut(routedRequest(1));
+  auto second = sender.serializeBatchOut(routedRequest(3));
+  EXPECT_LT(first->computeChainDataLength(), plainLength);
+  // The names were sent with the first frame.
+  EXPECT_LT(
+      second->computeChainDataLength(), first->computeChainDataLength());
+
+  for (auto* frame : {&first, &second}) {
+    Frame_REQUEST_FNF decoded;
+    ASSERT_EQ(
+        DecodeError::NONE,
+        receiver.tryDeserializeFrom(decoded, std::move(*frame)));
+    EXPECT_EQ("data", toString(decoded.payload_.data));
+    ASSERT_TRUE(decoded.payload_.metadata);
+    auto view = GroupView::tryParse(*decoded.payload_.metadata);
+    ASSERT_TRUE(view.hasValue());
+    EXPECT_EQ("client-1", view->fromDestination());
+    EXPECT_EQ("clients", view->fromGroup());
+    EXPECT_EQ("services", view->toGroup());
+    EXPECT_EQ(
+        "metadata",
+        toString(view->cloneMetadata(*decoded.payload_.metadata)));
+  }
+
+  // Expanded in place for a relay.
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      receiver.tryDeserializeFrom(
+          frame, sender.serializeBatchOut(routedRequest(5))));
+  ASSERT_TRUE(frame.metadataRange().hasValue());
+  auto view = GroupView::tryParse(*frame.metadataRange());
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ("services", view->toGroup());
+  EXPECT_EQ("data", toString(frame.cloneData()));
+
+  // Metadata that isn't a broker frame is sent as it is.
+  auto other = sender.serializeBatchOut(Frame_REQUEST_FNF(
+      7, FrameFlags::EMPTY, rsocket::Payload("data", "metadata")));
+  Frame_REQUEST_FNF decoded;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      receiver.tryDeserializeFrom(decoded, std::move(other)));
+  EXPECT_EQ("metadata", toString(decoded.payload_.metadata));
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameSplitter.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+std::string lengthPrefixed(const std::string& frame) {
+  std::string out;
+  out.push_back(static_cast<char>(frame.size() >> 16));
+  out.push_back(static_cast<char>(frame.size() >> 8));
+  out.push_back(static_cast<char>(frame.size()));
+  return out + frame;
+}
+
+std::vector<std::string> toStrings(
+    const std::vector<std::unique_ptr<folly::IOBuf>>& frames) {
+  std::vector<std::string> out;
+  for (const auto& frame : frames) {
+    out.push_back(frame->toString());
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(FrameSplitterTest, Scan) {
+  auto stream = lengthPrefixed("abc") + lengthPrefixed("") +
+      lengthPrefixed(std::string(300, 'x')) + lengthPrefixed("partial");
+  stream.resize(stream.size() - 2);
+
+  std::vector<folly::ByteRange> frames;
+  auto consumed = FrameSplitter::scan(folly::range(stream), frames);
+  ASSERT_EQ(3, frames.size());
+  EXPECT_EQ("abc", folly::StringPiece(frames[0]));
+  EXPECT_TRUE(frames[1].empty());
+  EXPECT_EQ(300, frames[2].size());
+  EXPECT_EQ(3 + 3 + 3 + 3 + 300, consumed);
+}
+
+TEST(FrameSplitterTest, FramesShareReadBuffer) {
+  auto read = folly::IOBuf::copyBuffer(
+      lengthPrefixed("first") + lengthPrefixed("second"));
+
+  FrameSplitter splitter;
+  const auto* data = read->data();
+  splitter.append(std::move(read));
+
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  EXPECT_EQ(2, splitter.split(frames));
+  EXPECT_THAT(toStrings(frames), ElementsAre("first", "second"));
+  EXPECT_EQ(data + 3, frames[0]->data());
+  EXPECT_EQ(0, splitter.pendingBytes());
+}
+
+TEST(FrameSplitterTest, FramesSpanningReads) {
+  auto stream = lengthPrefixed("first") + lengthPrefixed("second") +
+      lengthPrefixed("third");
+
+  // Feed the stream in every possible pair of reads.
+  for (size_t cut = 0; cut <= stream.size(); ++cut) {
+    FrameSplitter splitter;
+    std::vector<std::unique_ptr<folly::IOBuf>> frames;
+
+    splitter.append(folly::IOBuf::copyBuffer(stream.substr(0, cut)));
+    splitter.split(frames);
+    splitter.append(folly::IOBuf::copyBuffer(stream.substr(cut)));
+    splitter.split(frames);
+
+    EXPECT_THAT(toStrings(frames), ElementsAre("first", "second", "third"))
+        << cut;
+    EXPECT_EQ(0, splitter.pendingBytes()) << cut;
+  }
+}
+
+TEST(FrameSplitterTest, ByteAtATime) {
+  auto stream = lengthPrefixed("first") + lengthPrefixed("") +
+      lengthPrefixed("third");
+
+  FrameSplitter splitter;
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  for (char c : stream) {
+    splitter.append(folly::IOBuf::copyBuffer(std::string(1, c)));
+    splitter.split(frames);
+  }
+  EXPECT_THAT(toStrings(frames), ElementsAre("first", "", "third"));
+}
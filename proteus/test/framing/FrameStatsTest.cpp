@@ -0,0 +1,132 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameSerializer.h"
+#include "proteus/framing/FrameStats.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+using std::chrono::nanoseconds;
+
+TEST(FrameStatsTest, LatencyBuckets) {
+  EXPECT_EQ(0u, FrameStats::latencyBucket(nanoseconds(0)));
+  EXPECT_EQ(0u, FrameStats::latencyBucket(nanoseconds(127)));
+  EXPECT_EQ(1u, FrameStats::latencyBucket(nanoseconds(128)));
+  EXPECT_EQ(1u, FrameStats::latencyBucket(nanoseconds(255)));
+  EXPECT_EQ(2u, FrameStats::latencyBucket(nanoseconds(256)));
+  EXPECT_EQ(
+      FrameStats::kLatencyBuckets - 1,
+      FrameStats::latencyBucket(std::chrono::seconds(10)));
+
+  EXPECT_EQ(nanoseconds(128), FrameStats::latencyBucketLimit(0));
+  EXPECT_EQ(nanoseconds(256), FrameStats::latencyBucketLimit(1));
+  EXPECT_EQ(
+      nanoseconds::max(),
+      FrameStats::latencyBucketLimit(FrameStats::kLatencyBuckets - 1));
+}
+
+TEST(FrameStatsTest, Record) {
+  FrameStats stats;
+  stats.recordEncode(FrameType::REQUEST_N, 10, nanoseconds(100));
+  stats.recordEncode(FrameType::REQUEST_N, 10, nanoseconds(200));
+  stats.recordDecode(
+      FrameType::PAYLOAD, 30, DecodeError::NONE, nanoseconds(300));
+  stats.recordDecode(
+      FrameType::PAYLOAD, 5, DecodeError::TRUNCATED, nanoseconds(300));
+
+  const auto snapshot = stats.snapshot();
+  const auto& encoded = snapshot.encoded(FrameType::REQUEST_N);
+  EXPECT_EQ(2u, encoded.frames);
+  EXPECT_EQ(20u, encoded.bytes);
+  EXPECT_EQ(0u, encoded.failures);
+  EXPECT_EQ(1u, encoded.latency[0]);
+  EXPECT_EQ(1u, encoded.latency[1]);
+  EXPECT_EQ(nanoseconds(128), encoded.latencyQuantile(0.5));
+  EXPECT_EQ(nanoseconds(256), encoded.latencyQuantile(0.99));
+
+  const auto& decoded = snapshot.decoded(FrameType::PAYLOAD);
+  EXPECT_EQ(2u, decoded.frames);
+  EXPECT_EQ(35u, decoded.bytes);
+  EXPECT_EQ(1u, decoded.failures);
+
+  EXPECT_EQ(0u, snapshot.decoded(FrameType::REQUEST_N).frames);
+  EXPECT_EQ(0u, snapshot.encoded(FrameType::PAYLOAD).frames);
+  EXPECT_EQ(nanoseconds(0), FrameStats::Counters().latencyQuantile(0.5));
+}
+
+TEST(FrameStatsTest, BrokerFrameTypes) {
+  FrameStats stats;
+  stats.recordDecode(
+      FrameType::GROUP, 40, DecodeError::NONE, nanoseconds(100));
+  stats.recordEncode(FrameType::SHARD, 50, nanoseconds(100));
+
+  const auto snapshot = stats.snapshot();
+  EXPECT_EQ(1u, snapshot.decoded(FrameType::GROUP).frames);
+  EXPECT_EQ(40u, snapshot.decoded(FrameType::GROUP).bytes);
+  EXPECT_EQ(0u, snapshot.decoded(FrameType::REQUEST_RESPONSE).frames);
+  EXPECT_EQ(1u, snapshot.encoded(FrameType::SHARD).frames);
+  EXPECT_EQ(0u, snapshot.encoded(FrameType::REQUEST_STREAM).frames);
+}
+
+TEST(FrameStatsTest, ExitedThreads) {
+  FrameStats stats;
+  std::thread([&] {
+    stats.recordEncode(FrameType::CANCEL, 6, nanoseconds(50));
+  }).join();
+  stats.recordEncode(FrameType::CANCEL, 6, nanoseconds(50));
+
+  const auto& encoded = stats.snapshot().encoded(FrameType::CANCEL);
+  EXPECT_EQ(2u, encoded.frames);
+  EXPECT_EQ(12u, encoded.bytes);
+}
+
+TEST(FrameStatsTest, Serializer) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion(1, 0));
+  FrameStats stats;
+  serializer->setStats(&stats);
+
+  auto frames = serializer->serializeBatchOut(
+      Frame_REQUEST_N(1, 10), Frame_REQUEST_N(3, 10), Frame_CANCEL(1));
+  EXPECT_EQ(2u, stats.snapshot().encoded(FrameType::REQUEST_N).frames);
+  EXPECT_EQ(
+      frames->computeChainDataLength(),
+      stats.snapshot().encoded(FrameType::REQUEST_N).bytes +
+          stats.snapshot().encoded(FrameType::CANCEL).bytes);
+
+  Frame_REQUEST_N requestN;
+  EXPECT_EQ(
+      DecodeError::NONE,
+      serializer->tryDeserializeFrom(
+          requestN,
+          serializer->serializeBatchOut(Frame_REQUEST_N(1, 10))));
+  EXPECT_EQ(
+      DecodeError::TRUNCATED,
+      serializer->tryDeserializeFrom(
+          requestN, folly::IOBuf::copyBuffer("\x00\x00", 2)));
+
+  const auto decoded = stats.snapshot().decoded(FrameType::REQUEST_N);
+  EXPECT_EQ(2u, decoded.frames);
+  EXPECT_EQ(1u, decoded.failures);
+  EXPECT_EQ(12u, decoded.bytes);
+
+  serializer->setStats(nullptr);
+  serializer->serializeBatchOut(Frame_CANCEL(1));
+  EXPECT_EQ(1u, stats.snapshot().encoded(FrameType::CANCEL).frames);
+}
@@ -12,12 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <utility>
 
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 #include <gmock/gmock.h>
 
 #include "proteus/framing/Frame.h"
+#include "proteus/framing/FrameArena.h"
 #include "proteus/framing/FrameSerializer.h"
 
 using namespace ::testing;
@@ -303,3 +306,268 @@ TEST(FrameTest, Frame_PreallocatedFrameLengthField) {
 
   EXPECT_LT(0, serializedFrame->headroom());
 }
+
+TEST(FrameTest, TryDeserialize) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::COMPLETE | FrameFlags::METADATA;
+  uint32_t requestN = 3;
+  auto metadata = folly::IOBuf::copyBuffer("i'm so meta even this acronym");
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_STREAM(
+      streamId,
+      flags,
+      requestN,
+      rsocket::Payload(data->clone(), metadata->clone())));
+  Frame_REQUEST_STREAM frame;
+  EXPECT_EQ(
+      DecodeError::NONE,
+      frameSerializer->tryDeserializeFrom(frame, std::move(serializedFrame)));
+
+  expectHeader(FrameType::REQUEST_STREAM, flags, streamId, frame);
+  EXPECT_EQ(requestN, frame.requestN_);
+  EXPECT_TRUE(folly::IOBufEqualTo()(*metadata, *frame.payload_.metadata));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *frame.payload_.data));
+}
+
+TEST(FrameTest, TryDeserializeTruncated) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_STREAM(
+      42,
+      FrameFlags::METADATA,
+      3,
+      rsocket::Payload(
+          folly::IOBuf::copyBuffer("424242"),
+          folly::IOBuf::copyBuffer("i'm so meta even this acronym"))));
+  serializedFrame->coalesce();
+  const auto length = serializedFrame->length();
+
+  // Every prefix short of the metadata is rejected, without throwing.
+  for (size_t i = 0; i < length - 6; ++i) {
+    auto truncated = serializedFrame->clone();
+    truncated->trimEnd(length - i);
+    Frame_REQUEST_STREAM frame;
+    EXPECT_EQ(
+        DecodeError::TRUNCATED,
+        frameSerializer->tryDeserializeFrom(frame, std::move(truncated)))
+        << i;
+  }
+}
+
+TEST(FrameTest, TryDeserializeInvalidRequestN) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_N(42, 1));
+  serializedFrame->coalesce();
+  // zero out the requestN field
+  std::memset(serializedFrame->writableData() + 6, 0, sizeof(uint32_t));
+
+  Frame_REQUEST_N frame;
+  EXPECT_EQ(
+      DecodeError::INVALID_REQUEST_N,
+      frameSerializer->tryDeserializeFrom(frame, std::move(serializedFrame)));
+
+  // A stream can't be opened with zero credits either.
+  auto request = frameSerializer->serializeOut(Frame_REQUEST_STREAM(
+      42,
+      FrameFlags::EMPTY,
+      1,
+      rsocket::Payload(folly::IOBuf::copyBuffer("424242"))));
+  request->coalesce();
+  std::memset(request->writableData() + 6, 0, sizeof(uint32_t));
+
+  Frame_REQUEST_STREAM stream;
+  EXPECT_EQ(
+      DecodeError::INVALID_REQUEST_N,
+      frameSerializer->tryDeserializeFrom(stream, request->clone()));
+  LazyFrame lazy;
+  EXPECT_EQ(
+      DecodeError::INVALID_REQUEST_N,
+      frameSerializer->tryDeserializeFrom(lazy, std::move(request)));
+}
+
+TEST(FrameTest, SerializeBatchOut) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto payload = [] {
+    return rsocket::Payload(
+        folly::IOBuf::copyBuffer("424242"),
+        folly::IOBuf::copyBuffer("i'm so meta even this acronym"));
+  };
+
+  auto batch = frameSerializer->serializeBatchOut(
+      Frame_REQUEST_N(42, 1),
+      Frame_PAYLOAD(42, FrameFlags::NEXT, payload()),
+      Frame_CANCEL(42));
+
+  folly::IOBufQueue expected;
+  expected.append(frameSerializer->serializeOut(Frame_REQUEST_N(42, 1)));
+  expected.append(frameSerializer->serializeOut(
+      Frame_PAYLOAD(42, FrameFlags::NEXT, payload())));
+  expected.append(frameSerializer->serializeOut(Frame_CANCEL(42)));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*expected.move(), *batch));
+}
+
+TEST(FrameTest, SerializeOutToArena) {
+  FrameArena arena;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto frame = [] {
+    return Frame_REQUEST_STREAM(
+        42,
+        FrameFlags::EMPTY,
+        3,
+        rsocket::Payload(folly::IOBuf::copyBuffer("424242")));
+  };
+  auto expected = frameSerializer->serializeOut(frame());
+
+  frameSerializer->setArena(&arena);
+  auto first = frameSerializer->serializeOut(frame());
+  auto second = frameSerializer->serializeOut(frame());
+  frameSerializer->setArena(nullptr);
+
+  EXPECT_TRUE(folly::IOBufEqualTo()(*expected, *first));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*expected, *second));
+  // Both headers were written into the arena's slab.
+  EXPECT_EQ(first->buffer(), second->buffer());
+}
+
+TEST(FrameTest, LazyFrame) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::COMPLETE | FrameFlags::METADATA;
+  uint32_t requestN = 3;
+  auto metadata = folly::IOBuf::copyBuffer("i'm so meta even this acronym");
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_STREAM(
+      streamId,
+      flags,
+      requestN,
+      rsocket::Payload(data->clone(), metadata->clone())));
+  serializedFrame->coalesce();
+  const auto* buffer = serializedFrame.get();
+
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      frameSerializer->tryDeserializeFrom(frame, std::move(serializedFrame)));
+  EXPECT_EQ(FrameType::REQUEST_STREAM, frame.header().type);
+  EXPECT_EQ(streamId, frame.header().streamId);
+  EXPECT_EQ(flags, frame.header().flags);
+  EXPECT_EQ(requestN, frame.requestN());
+  EXPECT_EQ(metadata->length(), frame.metadataLength());
+  EXPECT_EQ(data->length(), frame.dataLength());
+
+  // Routing fields are read in place.
+  auto metadataRange = frame.metadataRange();
+  ASSERT_TRUE(metadataRange.hasValue());
+  EXPECT_EQ(metadata->length(), metadataRange->size());
+  EXPECT_EQ(buffer->data() + 6 + 4 + 3, metadataRange->data());
+
+  auto payload = frame.clonePayload();
+  EXPECT_TRUE(folly::IOBufEqualTo()(*metadata, *payload.metadata));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *payload.data));
+
+  // Forwarding hands over the original buffer.
+  EXPECT_EQ(buffer, frame.releaseBuffer().get());
+}
+
+TEST(FrameTest, LazyFrameUnexpectedType) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  LazyFrame frame;
+  EXPECT_EQ(
+      DecodeError::UNEXPECTED_FRAME_TYPE,
+      frameSerializer->tryDeserializeFrom(
+          frame, frameSerializer->serializeOut(Frame_REQUEST_N(42, 1))));
+}
+
+TEST(FrameTest, LazyFrameRewrite) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto metadata = folly::IOBuf::copyBuffer("route:a/rest");
+  auto data = folly::IOBuf::copyBuffer("424242");
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_RESPONSE(
+      42,
+      FrameFlags::METADATA,
+      rsocket::Payload(data->clone(), metadata->clone())));
+  serializedFrame->coalesce();
+  // Received bytes shared with another reader must not change.
+  auto original = serializedFrame->clone();
+  const auto* dataBytes = serializedFrame->tail() - data->length();
+
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      frameSerializer->tryDeserializeFrom(frame, std::move(serializedFrame)));
+
+  frame.setStreamId(7);
+  frame.replaceMetadataPrefix(
+      7, folly::ByteRange(folly::StringPiece("route:longer-name")));
+  EXPECT_EQ(7u, frame.header().streamId);
+  EXPECT_EQ(strlen("route:longer-name/rest"), frame.metadataLength());
+
+  // Only the header was copied, the data is still in the received buffer.
+  EXPECT_EQ(dataBytes, frame.buffer().prev()->tail() - data->length());
+
+  Frame_REQUEST_RESPONSE rewritten;
+  ASSERT_TRUE(
+      frameSerializer->deserializeFrom(rewritten, frame.releaseBuffer()));
+  EXPECT_EQ(7u, rewritten.header_.streamId);
+  EXPECT_EQ(
+      "route:longer-name/rest",
+      rewritten.payload_.metadata->cloneCoalescedAsValue().moveToFbString());
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *rewritten.payload_.data));
+
+  Frame_REQUEST_RESPONSE untouched;
+  ASSERT_TRUE(
+      frameSerializer->deserializeFrom(untouched, std::move(original)));
+  EXPECT_EQ(42u, untouched.header_.streamId);
+  EXPECT_TRUE(folly::IOBufEqualTo()(*metadata, *untouched.payload_.metadata));
+}
+
+TEST(FrameTest, LazyFrameRewriteInPlace) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto data = folly::IOBuf::copyBuffer("424242");
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_RESPONSE(
+      42,
+      FrameFlags::METADATA,
+      rsocket::Payload(
+          data->clone(), folly::IOBuf::copyBuffer("route:long-name/rest"))));
+  serializedFrame->coalesce();
+  const auto* buffer = serializedFrame.get();
+
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      frameSerializer->tryDeserializeFrom(frame, std::move(serializedFrame)));
+
+  // A shorter prefix leaves headroom that a longer one then takes back.
+  frame.replaceMetadataPrefix(
+      15, folly::ByteRange(folly::StringPiece("route:a")));
+  frame.replaceMetadataPrefix(
+      7, folly::ByteRange(folly::StringPiece("route:b-name")));
+  frame.setStreamId(7);
+  EXPECT_EQ(buffer, &frame.buffer());
+  EXPECT_FALSE(frame.buffer().isChained());
+  auto metadataRange = frame.metadataRange();
+  ASSERT_TRUE(metadataRange.hasValue());
+  EXPECT_EQ("route:b-name/rest", folly::StringPiece(*metadataRange));
+
+  Frame_REQUEST_RESPONSE rewritten;
+  ASSERT_TRUE(
+      frameSerializer->deserializeFrom(rewritten, frame.releaseBuffer()));
+  EXPECT_EQ(7u, rewritten.header_.streamId);
+  EXPECT_EQ(
+      "route:b-name/rest",
+      rewritten.payload_.metadata->cloneCoalescedAsValue().moveToFbString());
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *rewritten.payload_.data));
+}
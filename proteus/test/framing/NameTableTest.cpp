@@ -0,0 +1,95 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/NameTable.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+TEST(NameTableTest, Intern) {
+  NameTable table;
+  EXPECT_FALSE(table.find("services").hasValue());
+
+  auto services = table.intern("services");
+  auto clients = table.intern("clients");
+  EXPECT_NE(services, clients);
+  EXPECT_EQ(services, table.intern("services"));
+  EXPECT_EQ(2u, table.size());
+
+  ASSERT_TRUE(table.find("clients").hasValue());
+  EXPECT_EQ(clients, *table.find("clients"));
+  EXPECT_EQ("services", table.name(services));
+  EXPECT_EQ("clients", table.name(clients));
+
+  // The empty name is a name like any other.
+  auto empty = table.intern("");
+  EXPECT_EQ("", table.name(empty));
+  EXPECT_EQ(empty, *table.find(""));
+}
+
+TEST(NameTableTest, Grow) {
+  NameTable table;
+  std::vector<NameId> ids;
+  for (int i = 0; i < 5000; ++i) {
+    ids.push_back(table.intern(folly::to<std::string>("destination-", i)));
+  }
+  EXPECT_EQ(5000u, table.size());
+
+  // IDs are dense and survive the index being replaced.
+  for (int i = 0; i < 5000; ++i) {
+    auto name = folly::to<std::string>("destination-", i);
+    EXPECT_EQ(static_cast<NameId>(i), ids[i]);
+    EXPECT_EQ(ids[i], *table.find(name));
+    EXPECT_EQ(name, table.name(ids[i]));
+  }
+}
+
+TEST(NameTableTest, ConcurrentIntern) {
+  NameTable table;
+  constexpr int kThreads = 4;
+  constexpr int kNames = 2000;
+  std::vector<std::vector<NameId>> ids(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&table, &ids, t] {
+      for (int i = 0; i < kNames; ++i) {
+        ids[t].push_back(table.intern(folly::to<std::string>("group-", i)));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(static_cast<size_t>(kNames), table.size());
+  for (int t = 1; t < kThreads; ++t) {
+    EXPECT_EQ(ids[0], ids[t]);
+  }
+  for (int i = 0; i < kNames; ++i) {
+    EXPECT_EQ(folly::to<std::string>("group-", i), table.name(ids[0][i]));
+  }
+}
+
+TEST(NameTableTest, Global) {
+  auto id = NameTable::global().intern("application/binary");
+  EXPECT_EQ(id, NameTable::global().intern("application/binary"));
+  EXPECT_EQ(&NameTable::global(), &NameTable::global());
+}
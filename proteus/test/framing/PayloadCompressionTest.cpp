@@ -0,0 +1,262 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameSerializer.h"
+#include "proteus/framing/PayloadCompression.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+std::string toString(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->cloneCoalescedAsValue().moveToFbString().toStdString()
+             : std::string();
+}
+
+std::string repetitiveJson(size_t records) {
+  std::string json = "[";
+  for (size_t i = 0; i < records; ++i) {
+    json += R"({"group":"services","destination":"instance-)" +
+        std::to_string(i % 4) + R"(","status":"healthy"},)";
+  }
+  json.back() = ']';
+  return json;
+}
+
+} // namespace
+
+TEST(PayloadCompressionTest, MimeTypes) {
+  folly::StringPiece base;
+  EXPECT_EQ(
+      PayloadCompression::ZSTD,
+      parseMimeTypeCompression("application/json+zstd", &base));
+  EXPECT_EQ("application/json", base);
+  EXPECT_EQ(
+      PayloadCompression::LZ4,
+      parseMimeTypeCompression("application/json+lz4", &base));
+  EXPECT_EQ("application/json", base);
+  EXPECT_EQ(
+      PayloadCompression::NONE,
+      parseMimeTypeCompression("application/json", &base));
+  EXPECT_EQ("application/json", base);
+  EXPECT_EQ(
+      PayloadCompression::ZSTD,
+      parseMimeTypeCompression(
+          "application/json+zstd; routing-table-size=64", &base));
+  EXPECT_EQ("application/json", base);
+
+  EXPECT_EQ(
+      "text/plain+lz4", withCompression("text/plain", PayloadCompression::LZ4));
+  EXPECT_EQ(
+      "text/plain", withCompression("text/plain", PayloadCompression::NONE));
+  EXPECT_EQ(
+      "text/plain+zstd; charset=utf-8",
+      withCompression("text/plain; charset=utf-8", PayloadCompression::ZSTD));
+}
+
+TEST(PayloadCompressionTest, FromSetup) {
+  Frame_SETUP setup(
+      FrameFlags::EMPTY,
+      1,
+      0,
+      500,
+      1000,
+      rsocket::ResumeIdentificationToken(),
+      "application/json",
+      "application/json",
+      rsocket::Payload());
+  EXPECT_EQ(nullptr, PayloadCompressor::fromSetup(setup));
+
+  setup.dataMimeType_ = "application/json+zstd";
+  auto compressor = PayloadCompressor::fromSetup(setup);
+  ASSERT_NE(nullptr, compressor);
+  EXPECT_EQ(PayloadCompression::NONE, compressor->metadataCompression());
+  EXPECT_EQ(PayloadCompression::ZSTD, compressor->dataCompression());
+}
+
+TEST(PayloadCompressionTest, RoundTrip) {
+  for (auto compression : {PayloadCompression::LZ4, PayloadCompression::ZSTD}) {
+    PayloadCompressor sender(compression, compression);
+    PayloadCompressor receiver(compression, compression);
+    const auto json = repetitiveJson(100);
+    rsocket::Payload payload(json, "routing");
+    sender.compress(payload);
+
+    // Big data is compressed, small metadata only gets a marker.
+    EXPECT_LT(payload.data->computeChainDataLength(), json.size() / 4)
+        << compression;
+    EXPECT_EQ(1 + 7u, payload.metadata->computeChainDataLength());
+
+    EXPECT_EQ(DecodeError::NONE, receiver.decompress(payload));
+    EXPECT_EQ(json, toString(payload.data));
+    EXPECT_EQ("routing", toString(payload.metadata));
+  }
+}
+
+TEST(PayloadCompressionTest, EmptyFieldsAreLeftAlone) {
+  PayloadCompressor compressor(
+      PayloadCompression::ZSTD, PayloadCompression::ZSTD);
+  rsocket::Payload payload(folly::IOBuf::create(0), folly::IOBuf::create(0));
+  compressor.compress(payload);
+  EXPECT_EQ(0u, payload.data->computeChainDataLength());
+  EXPECT_EQ(0u, payload.metadata->computeChainDataLength());
+  EXPECT_EQ(DecodeError::NONE, compressor.decompress(payload));
+
+  rsocket::Payload nothing;
+  compressor.compress(nothing);
+  EXPECT_EQ(nullptr, nothing.data);
+  EXPECT_EQ(nullptr, nothing.metadata);
+}
+
+TEST(PayloadCompressionTest, Corrupt) {
+  PayloadCompressor compressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+
+  // Garbage behind a ZSTD marker.
+  rsocket::Payload garbage(std::string("\x02garbage", 8));
+  EXPECT_EQ(DecodeError::CORRUPT_PAYLOAD, compressor.decompress(garbage));
+
+  // Compressed with a codec that wasn't negotiated.
+  rsocket::Payload lz4(std::string("\x01garbage", 8));
+  EXPECT_EQ(DecodeError::CORRUPT_PAYLOAD, compressor.decompress(lz4));
+
+  // Decompresses to more than allowed.
+  PayloadCompressor sender(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  PayloadCompressor receiver(
+      PayloadCompression::NONE, PayloadCompression::ZSTD, 256, 1024);
+  rsocket::Payload big(repetitiveJson(100));
+  sender.compress(big);
+  EXPECT_EQ(DecodeError::CORRUPT_PAYLOAD, receiver.decompress(big));
+
+  // A zstd frame holding "hello" in a raw block, without a content size.
+  rsocket::Payload unsized(std::string(
+      "\x02"
+      "\x28\xB5\x2F\xFD\x00\x00\x29\x00\x00"
+      "hello",
+      15));
+  EXPECT_EQ(DecodeError::CORRUPT_PAYLOAD, compressor.decompress(unsized));
+}
+
+TEST(PayloadCompressionTest, UncompressedFieldsHaveNoMarker) {
+  PayloadCompressor compressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  const auto json = repetitiveJson(100);
+  rsocket::Payload payload(json, json);
+  compressor.compress(payload);
+  EXPECT_EQ(json, toString(payload.metadata));
+  EXPECT_LT(payload.data->computeChainDataLength(), json.size() / 4);
+
+  EXPECT_EQ(DecodeError::NONE, compressor.decompress(payload));
+  EXPECT_EQ(json, toString(payload.metadata));
+  EXPECT_EQ(json, toString(payload.data));
+}
+
+TEST(PayloadCompressionTest, Serializer) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  PayloadCompressor compressor(
+      PayloadCompression::LZ4, PayloadCompression::ZSTD);
+  serializer->setPayloadCompressor(&compressor);
+
+  const auto json = repetitiveJson(100);
+  auto serializedFrame = serializer->serializeBatchOut(Frame_PAYLOAD(
+      3, FrameFlags::NEXT, rsocket::Payload(json, "routing")));
+  EXPECT_LT(serializedFrame->computeChainDataLength(), json.size() / 4);
+
+  Frame_PAYLOAD frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      serializer->tryDeserializeFrom(frame, std::move(serializedFrame)));
+  EXPECT_EQ(3u, frame.header_.streamId);
+  EXPECT_EQ(json, toString(frame.payload_.data));
+  EXPECT_EQ("routing", toString(frame.payload_.metadata));
+}
+
+TEST(PayloadCompressionTest, ForwardLazyFrame) {
+  auto source =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  PayloadCompressor sourceCompressor(
+      PayloadCompression::LZ4, PayloadCompression::ZSTD);
+  source->setPayloadCompressor(&sourceCompressor);
+  auto plain = FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto destination =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  PayloadCompressor destinationCompressor(
+      PayloadCompression::NONE, PayloadCompression::LZ4);
+  destination->setPayloadCompressor(&destinationCompressor);
+  EXPECT_FALSE(PayloadCompressor::sameFormat(&sourceCompressor, nullptr));
+  EXPECT_FALSE(PayloadCompressor::sameFormat(
+      &sourceCompressor, &destinationCompressor));
+  EXPECT_TRUE(PayloadCompressor::sameFormat(nullptr, nullptr));
+
+  const auto json = repetitiveJson(100);
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      source->tryDeserializeFrom(
+          frame,
+          source->serializeBatchOut(Frame_REQUEST_STREAM(
+              7,
+              FrameFlags::METADATA,
+              10,
+              rsocket::Payload(json, "routing")))));
+  // Still compressed, as received.
+  EXPECT_NE(json, toString(frame.cloneData()));
+
+  ASSERT_EQ(DecodeError::NONE, source->decompressPayload(frame));
+  EXPECT_EQ(json, toString(frame.cloneData()));
+  EXPECT_EQ("routing", toString(frame.cloneMetadata()));
+  // Readable in place, for routing.
+  ASSERT_TRUE(frame.metadataRange().hasValue());
+  EXPECT_EQ("routing", folly::StringPiece(*frame.metadataRange()));
+  EXPECT_EQ(10u, frame.requestN());
+
+  // Forwarded as is to a connection without compression.
+  Frame_REQUEST_STREAM forwarded;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      plain->tryDeserializeFrom(forwarded, frame.buffer().clone()));
+  EXPECT_EQ(7u, forwarded.header_.streamId);
+  EXPECT_EQ(10u, forwarded.requestN_);
+  EXPECT_EQ(json, toString(forwarded.payload_.data));
+  EXPECT_EQ("routing", toString(forwarded.payload_.metadata));
+
+  // Compressed again for a connection that compresses differently.
+  destination->compressPayload(frame);
+  EXPECT_LT(frame.dataLength(), json.size() / 4);
+  ASSERT_EQ(
+      DecodeError::NONE,
+      destination->tryDeserializeFrom(forwarded, frame.buffer().clone()));
+  EXPECT_EQ(json, toString(forwarded.payload_.data));
+  EXPECT_EQ("routing", toString(forwarded.payload_.metadata));
+
+  // A payload that wasn't compressed the way the connection expects is
+  // refused, and the frame left alone.
+  ASSERT_EQ(
+      DecodeError::NONE,
+      plain->tryDeserializeFrom(
+          frame,
+          plain->serializeBatchOut(Frame_REQUEST_FNF(
+              9, FrameFlags::EMPTY, rsocket::Payload(json)))));
+  EXPECT_EQ(DecodeError::CORRUPT_PAYLOAD, source->decompressPayload(frame));
+  EXPECT_EQ(json, toString(frame.cloneData()));
+  EXPECT_FALSE(frame.hasMetadata());
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/PayloadFragmenter.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+std::string toString(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->cloneCoalescedAsValue().moveToFbString().toStdString()
+             : std::string();
+}
+
+} // namespace
+
+TEST(PayloadFragmenterTest, SmallPayloadIsLeftAlone) {
+  PayloadFragmenter fragmenter(64, 1024);
+  Frame_REQUEST_RESPONSE frame(
+      1,
+      FrameFlags::EMPTY,
+      rsocket::Payload(
+          folly::IOBuf::copyBuffer("data"),
+          folly::IOBuf::copyBuffer("metadata")));
+
+  std::vector<Frame_PAYLOAD> followers;
+  ASSERT_TRUE(fragmenter.fragment(frame, followers));
+  EXPECT_TRUE(followers.empty());
+  EXPECT_FALSE(frame.header_.flagsFollows());
+  EXPECT_EQ("metadata", toString(frame.payload_.metadata));
+  EXPECT_EQ("data", toString(frame.payload_.data));
+}
+
+TEST(PayloadFragmenterTest, Fragments) {
+  // 20 bytes of payload per fragment after the first, 16 in the first one.
+  PayloadFragmenter fragmenter(26, 1024);
+  const std::string metadata(30, 'm');
+  const std::string data(25, 'd');
+  auto dataBuf = folly::IOBuf::copyBuffer(data);
+  const auto* dataBytes = dataBuf->data();
+
+  Frame_REQUEST_CHANNEL frame(
+      1,
+      FrameFlags::COMPLETE,
+      5,
+      rsocket::Payload(std::move(dataBuf), folly::IOBuf::copyBuffer(metadata)));
+
+  std::vector<Frame_PAYLOAD> followers;
+  ASSERT_TRUE(fragmenter.fragment(frame, followers));
+  ASSERT_EQ(3u, followers.size());
+
+  // First fragment: 4 bytes of request N, 3 of metadata length.
+  EXPECT_EQ(
+      FrameFlags::FOLLOWS | FrameFlags::METADATA, frame.header_.flags);
+  EXPECT_EQ(5u, frame.requestN_);
+  EXPECT_EQ(13u, frame.payload_.metadata->computeChainDataLength());
+  EXPECT_FALSE(frame.payload_.data);
+
+  // The rest of the metadata and the start of the data.
+  EXPECT_EQ(
+      FrameFlags::FOLLOWS | FrameFlags::NEXT | FrameFlags::METADATA,
+      followers[0].header_.flags);
+  EXPECT_EQ(17u, followers[0].payload_.metadata->computeChainDataLength());
+  EXPECT_FALSE(followers[0].payload_.data);
+
+  EXPECT_EQ(
+      FrameFlags::FOLLOWS | FrameFlags::NEXT, followers[1].header_.flags);
+  EXPECT_EQ(std::string(20, 'd'), toString(followers[1].payload_.data));
+  // Data was sliced, not copied.
+  EXPECT_EQ(dataBytes, followers[1].payload_.data->data());
+
+  EXPECT_EQ(
+      FrameFlags::NEXT | FrameFlags::COMPLETE, followers[2].header_.flags);
+  EXPECT_EQ(std::string(5, 'd'), toString(followers[2].payload_.data));
+  EXPECT_EQ(dataBytes + 20, followers[2].payload_.data->data());
+
+  for (const auto& follower : followers) {
+    EXPECT_EQ(FrameType::PAYLOAD, follower.header_.type);
+    EXPECT_EQ(1u, follower.header_.streamId);
+  }
+}
+
+TEST(PayloadFragmenterTest, EmptyMetadata) {
+  PayloadFragmenter fragmenter(26, 1024);
+  Frame_REQUEST_FNF frame(
+      1,
+      FrameFlags::EMPTY,
+      rsocket::Payload(
+          folly::IOBuf::copyBuffer(std::string(40, 'd')),
+          folly::IOBuf::create(0)));
+
+  std::vector<Frame_PAYLOAD> followers;
+  ASSERT_TRUE(fragmenter.fragment(frame, followers));
+  EXPECT_EQ(FrameFlags::FOLLOWS | FrameFlags::METADATA, frame.header_.flags);
+  ASSERT_TRUE(frame.payload_.metadata);
+  EXPECT_EQ(0u, frame.payload_.metadata->computeChainDataLength());
+  EXPECT_EQ(std::string(17, 'd'), toString(frame.payload_.data));
+  ASSERT_EQ(2u, followers.size());
+  EXPECT_FALSE(followers[0].payload_.metadata);
+}
+
+TEST(PayloadFragmenterTest, PayloadTooLarge) {
+  PayloadFragmenter fragmenter(26, 32);
+  Frame_PAYLOAD frame(
+      1,
+      FrameFlags::NEXT,
+      rsocket::Payload(folly::IOBuf::copyBuffer(std::string(40, 'd'))));
+
+  std::vector<Frame_PAYLOAD> followers;
+  EXPECT_FALSE(fragmenter.fragment(frame, followers));
+  EXPECT_TRUE(followers.empty());
+  EXPECT_EQ(40u, frame.payload_.data->computeChainDataLength());
+}
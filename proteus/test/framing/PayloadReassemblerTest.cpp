@@ -0,0 +1,163 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/PayloadFragmenter.h"
+#include "proteus/framing/PayloadReassembler.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+std::string toString(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->cloneCoalescedAsValue().moveToFbString().toStdString()
+             : std::string();
+}
+
+Frame_PAYLOAD fragment(
+    rsocket::StreamId streamId,
+    FrameFlags flags,
+    folly::StringPiece data) {
+  return Frame_PAYLOAD(
+      streamId, flags, rsocket::Payload(folly::IOBuf::copyBuffer(data)));
+}
+
+} // namespace
+
+TEST(PayloadReassemblerTest, Unfragmented) {
+  PayloadReassembler reassembler(1024, 4096);
+  Frame_REQUEST_RESPONSE request(
+      1,
+      FrameFlags::EMPTY,
+      rsocket::Payload(folly::IOBuf::copyBuffer("data")));
+  EXPECT_EQ(ReassemblyStatus::UNFRAGMENTED, reassembler.add(request));
+  EXPECT_EQ("data", toString(request.payload_.data));
+
+  ReassembledFrame out;
+  auto payload = fragment(1, FrameFlags::NEXT, "more");
+  EXPECT_EQ(ReassemblyStatus::UNFRAGMENTED, reassembler.add(payload, out));
+  EXPECT_EQ(0u, reassembler.pendingStreams());
+}
+
+TEST(PayloadReassemblerTest, RoundTrip) {
+  const std::string metadata(50, 'm');
+  std::string data;
+  for (int i = 0; i < 100; ++i) {
+    data += static_cast<char>('a' + i % 26);
+  }
+
+  PayloadFragmenter fragmenter(32, 1024);
+  Frame_REQUEST_CHANNEL frame(
+      3,
+      FrameFlags::COMPLETE,
+      7,
+      rsocket::Payload(
+          folly::IOBuf::copyBuffer(data), folly::IOBuf::copyBuffer(metadata)));
+  std::vector<Frame_PAYLOAD> followers;
+  ASSERT_TRUE(fragmenter.fragment(frame, followers));
+  ASSERT_FALSE(followers.empty());
+
+  PayloadReassembler reassembler(1024, 4096);
+  ReassembledFrame out;
+  ASSERT_EQ(ReassemblyStatus::PENDING, reassembler.add(frame));
+  for (size_t i = 0; i + 1 < followers.size(); ++i) {
+    ASSERT_EQ(ReassemblyStatus::PENDING, reassembler.add(followers[i], out));
+  }
+  EXPECT_EQ(1u, reassembler.pendingStreams());
+  ASSERT_EQ(
+      ReassemblyStatus::COMPLETE, reassembler.add(followers.back(), out));
+
+  EXPECT_EQ(FrameType::REQUEST_CHANNEL, out.header.type);
+  EXPECT_EQ(3u, out.header.streamId);
+  EXPECT_EQ(FrameFlags::METADATA | FrameFlags::COMPLETE, out.header.flags);
+  EXPECT_EQ(7u, out.requestN);
+  EXPECT_EQ(metadata, toString(out.payload.metadata));
+  EXPECT_EQ(data, toString(out.payload.data));
+  // Fragments are chained, not coalesced.
+  EXPECT_TRUE(out.payload.data->isChained());
+
+  EXPECT_EQ(0u, reassembler.pendingStreams());
+  EXPECT_EQ(0u, reassembler.bufferedSize());
+}
+
+TEST(PayloadReassemblerTest, InterleavedStreams) {
+  PayloadReassembler reassembler(1024, 4096);
+  ReassembledFrame out;
+
+  auto first1 = fragment(1, FrameFlags::NEXT | FrameFlags::FOLLOWS, "a");
+  auto first2 = fragment(2, FrameFlags::NEXT | FrameFlags::FOLLOWS, "x");
+  auto last1 = fragment(1, FrameFlags::NEXT | FrameFlags::COMPLETE, "b");
+  auto last2 = fragment(2, FrameFlags::NEXT, "y");
+
+  EXPECT_EQ(ReassemblyStatus::PENDING, reassembler.add(first1, out));
+  EXPECT_EQ(ReassemblyStatus::PENDING, reassembler.add(first2, out));
+  EXPECT_EQ(2u, reassembler.bufferedSize());
+
+  ASSERT_EQ(ReassemblyStatus::COMPLETE, reassembler.add(last1, out));
+  EXPECT_EQ(FrameType::PAYLOAD, out.header.type);
+  EXPECT_EQ(FrameFlags::NEXT | FrameFlags::COMPLETE, out.header.flags);
+  EXPECT_EQ("ab", toString(out.payload.data));
+  EXPECT_FALSE(out.payload.metadata);
+
+  ASSERT_EQ(ReassemblyStatus::COMPLETE, reassembler.add(last2, out));
+  EXPECT_EQ(2u, out.header.streamId);
+  EXPECT_EQ(FrameFlags::NEXT, out.header.flags);
+  EXPECT_EQ("xy", toString(out.payload.data));
+}
+
+TEST(PayloadReassemblerTest, Caps) {
+  PayloadReassembler reassembler(4, 6);
+  ReassembledFrame out;
+
+  // Per payload.
+  auto first = fragment(1, FrameFlags::FOLLOWS, "abc");
+  auto second = fragment(1, FrameFlags::FOLLOWS, "de");
+  EXPECT_EQ(ReassemblyStatus::PENDING, reassembler.add(first, out));
+  EXPECT_EQ(ReassemblyStatus::TOO_LARGE, reassembler.add(second, out));
+  EXPECT_EQ(0u, reassembler.pendingStreams());
+  EXPECT_EQ(0u, reassembler.bufferedSize());
+
+  // Over all streams.
+  auto stream1 = fragment(1, FrameFlags::FOLLOWS, "abcd");
+  auto stream2 = fragment(2, FrameFlags::FOLLOWS, "abc");
+  EXPECT_EQ(ReassemblyStatus::PENDING, reassembler.add(stream1, out));
+  EXPECT_EQ(ReassemblyStatus::TOO_LARGE, reassembler.add(stream2, out));
+  EXPECT_EQ(1u, reassembler.pendingStreams());
+
+  reassembler.cancel(1);
+  EXPECT_EQ(0u, reassembler.pendingStreams());
+  EXPECT_EQ(0u, reassembler.bufferedSize());
+}
+
+TEST(PayloadReassemblerTest, UnexpectedFrame) {
+  PayloadReassembler reassembler(1024, 4096);
+  Frame_REQUEST_FNF first(
+      1,
+      FrameFlags::FOLLOWS,
+      rsocket::Payload(folly::IOBuf::copyBuffer("abc")));
+  Frame_REQUEST_FNF second(
+      1,
+      FrameFlags::EMPTY,
+      rsocket::Payload(folly::IOBuf::copyBuffer("def")));
+
+  EXPECT_EQ(ReassemblyStatus::PENDING, reassembler.add(first));
+  EXPECT_EQ(ReassemblyStatus::UNEXPECTED_FRAME, reassembler.add(second));
+  EXPECT_EQ(0u, reassembler.pendingStreams());
+}
@@ -0,0 +1,244 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "proteus/framing/BrokerFrameLayout.h"
+#include "proteus/framing/BrokerFrameView.h"
+#include "proteus/framing/FrameSerializer.h"
+#include "proteus/framing/RoutingHeaderTable.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+constexpr const size_t kMaxTestFrameSize = 256;
+// Routing header of destinationFrame("instance-N").
+constexpr const size_t kHeaderSize = 6 + 10 + 11 + 14 + 12;
+
+std::unique_ptr<folly::IOBuf> destinationFrame(
+    folly::StringPiece toDestination) {
+  auto buf = folly::IOBuf::create(kMaxTestFrameSize);
+  folly::io::Appender appender(buf.get(), 0);
+  DestinationLayout::encode(
+      appender,
+      uint16_t{0},
+      uint16_t{1},
+      FrameType::DESTINATION,
+      folly::StringPiece("client"),
+      folly::StringPiece("clients"),
+      toDestination,
+      folly::StringPiece("services"),
+      folly::ByteRange(folly::StringPiece("app-metadata")));
+  return buf;
+}
+
+std::string toString(const std::unique_ptr<folly::IOBuf>& buf) {
+  return buf ? buf->cloneCoalescedAsValue().moveToFbString().toStdString()
+             : std::string();
+}
+
+// Sends `metadata` from `sender` to `receiver`, returning its size on the
+// wire.
+size_t roundTrip(
+    RoutingHeaderTable& sender,
+    RoutingHeaderTable& receiver,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  const auto expected = toString(metadata);
+  sender.encode(metadata);
+  const auto size = metadata->computeChainDataLength();
+  EXPECT_EQ(DecodeError::NONE, receiver.decode(metadata));
+  EXPECT_EQ(expected, toString(metadata));
+  return size;
+}
+
+} // namespace
+
+TEST(RoutingHeaderTableTest, IndexesRepeatedHeaders) {
+  RoutingHeaderTable sender, receiver;
+  const auto frameSize = kHeaderSize + 12;
+  ASSERT_EQ(frameSize, destinationFrame("instance-1")->length());
+
+  EXPECT_EQ(
+      1 + frameSize,
+      roundTrip(sender, receiver, destinationFrame("instance-1")));
+  EXPECT_EQ(
+      2 + 12u, roundTrip(sender, receiver, destinationFrame("instance-1")));
+  EXPECT_EQ(
+      1 + frameSize,
+      roundTrip(sender, receiver, destinationFrame("instance-2")));
+  EXPECT_EQ(
+      2 + 12u, roundTrip(sender, receiver, destinationFrame("instance-1")));
+  EXPECT_EQ(
+      2 + 12u, roundTrip(sender, receiver, destinationFrame("instance-2")));
+
+  const auto entrySize = kHeaderSize + RoutingHeaderTable::kEntryOverhead;
+  EXPECT_EQ(2 * entrySize, sender.encoderSize());
+  EXPECT_EQ(2 * entrySize, receiver.decoderSize());
+  EXPECT_EQ(0u, sender.decoderSize());
+}
+
+TEST(RoutingHeaderTableTest, EvictsOldestFirst) {
+  const auto entrySize = kHeaderSize + RoutingHeaderTable::kEntryOverhead;
+  RoutingHeaderTable sender(2 * entrySize + 10);
+  RoutingHeaderTable receiver(2 * entrySize + 10);
+  const auto frameSize = kHeaderSize + 12;
+
+  roundTrip(sender, receiver, destinationFrame("instance-1"));
+  roundTrip(sender, receiver, destinationFrame("instance-2"));
+  roundTrip(sender, receiver, destinationFrame("instance-3"));
+  EXPECT_EQ(2 * entrySize, sender.encoderSize());
+  EXPECT_EQ(2 * entrySize, receiver.decoderSize());
+
+  // instance-1 was evicted to make room for instance-3.
+  EXPECT_EQ(
+      2 + 12u, roundTrip(sender, receiver, destinationFrame("instance-3")));
+  EXPECT_EQ(
+      2 + 12u, roundTrip(sender, receiver, destinationFrame("instance-2")));
+  EXPECT_EQ(
+      1 + frameSize,
+      roundTrip(sender, receiver, destinationFrame("instance-1")));
+  EXPECT_EQ(
+      2 + 12u, roundTrip(sender, receiver, destinationFrame("instance-3")));
+}
+
+TEST(RoutingHeaderTableTest, SendsOtherMetadataAsIs) {
+  RoutingHeaderTable sender(kHeaderSize);
+  RoutingHeaderTable receiver(kHeaderSize);
+
+  // Too big for the table.
+  const auto frameSize = kHeaderSize + 12;
+  EXPECT_EQ(
+      frameSize, roundTrip(sender, receiver, destinationFrame("instance-1")));
+  EXPECT_EQ(0u, sender.encoderSize());
+
+  EXPECT_EQ(5u, roundTrip(sender, receiver, folly::IOBuf::copyBuffer("hello")));
+  // Looks like an indexed header.
+  EXPECT_EQ(
+      7u, roundTrip(sender, receiver, folly::IOBuf::copyBuffer("@hello")));
+  EXPECT_EQ(0u, roundTrip(sender, receiver, folly::IOBuf::create(0)));
+}
+
+TEST(RoutingHeaderTableTest, InvalidIndex) {
+  RoutingHeaderTable receiver;
+  auto metadata = folly::IOBuf::copyBuffer("\x40\x00", 2);
+  EXPECT_EQ(DecodeError::INVALID_ROUTING_HEADER, receiver.decode(metadata));
+
+  metadata = folly::IOBuf::copyBuffer("\x41garbage", 8);
+  EXPECT_EQ(DecodeError::INVALID_ROUTING_HEADER, receiver.decode(metadata));
+}
+
+TEST(RoutingHeaderTableTest, FromSetup) {
+  Frame_SETUP setup(
+      FrameFlags::EMPTY,
+      1,
+      0,
+      500,
+      1000,
+      rsocket::ResumeIdentificationToken(),
+      "application/x.netifi",
+      "application/json",
+      rsocket::Payload());
+  EXPECT_EQ(nullptr, RoutingHeaderTable::fromSetup(setup));
+
+  setup.metadataMimeType_ = "application/x.netifi; routing-table-size=512";
+  auto table = RoutingHeaderTable::fromSetup(setup);
+  ASSERT_NE(nullptr, table);
+  EXPECT_EQ(512u, table->capacity());
+
+  setup.metadataMimeType_ =
+      "application/x.netifi;routing-table-size=1000000000";
+  table = RoutingHeaderTable::fromSetup(setup);
+  ASSERT_NE(nullptr, table);
+  EXPECT_EQ(RoutingHeaderTable::kMaxCapacity, table->capacity());
+
+  setup.metadataMimeType_ = "application/x.netifi; routing-table-size=big";
+  EXPECT_EQ(nullptr, RoutingHeaderTable::fromSetup(setup));
+
+  // Not together with compressed metadata.
+  setup.metadataMimeType_ =
+      "application/x.netifi+zstd; routing-table-size=512";
+  EXPECT_EQ(nullptr, RoutingHeaderTable::fromSetup(setup));
+}
+
+TEST(RoutingHeaderTableTest, Serializer) {
+  auto sender =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto receiver =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  RoutingHeaderTable senderTable, receiverTable;
+  sender->setRoutingHeaderTable(&senderTable);
+  receiver->setRoutingHeaderTable(&receiverTable);
+
+  for (int i = 0; i < 2; ++i) {
+    auto serializedFrame = sender->serializeBatchOut(Frame_REQUEST_RESPONSE(
+        1,
+        FrameFlags::METADATA,
+        rsocket::Payload(
+            folly::IOBuf::copyBuffer("data"),
+            destinationFrame("instance-1"))));
+    serializedFrame->coalesce();
+
+    LazyFrame frame;
+    ASSERT_EQ(
+        DecodeError::NONE,
+        receiver->tryDeserializeFrom(frame, std::move(serializedFrame)));
+    auto view = DestinationView::tryParse(*frame.metadataRange());
+    ASSERT_TRUE(view.hasValue());
+    EXPECT_EQ("instance-1", view->toDestination());
+    EXPECT_EQ("app-metadata", folly::StringPiece(view->metadata()));
+    EXPECT_EQ("data", toString(frame.cloneData()));
+  }
+}
+
+TEST(RoutingHeaderTableTest, SerializerWithDataCompression) {
+  auto sender =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto receiver =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  RoutingHeaderTable senderTable, receiverTable;
+  PayloadCompressor senderCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  PayloadCompressor receiverCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  sender->setRoutingHeaderTable(&senderTable);
+  sender->setPayloadCompressor(&senderCompressor);
+  receiver->setRoutingHeaderTable(&receiverTable);
+  receiver->setPayloadCompressor(&receiverCompressor);
+
+  // The second header is indexed, and only expands if the first one made
+  // it into the receiver's table.
+  for (int i = 0; i < 2; ++i) {
+    auto serializedFrame = sender->serializeBatchOut(Frame_REQUEST_RESPONSE(
+        1,
+        FrameFlags::METADATA,
+        rsocket::Payload(
+            folly::IOBuf::copyBuffer("data"),
+            destinationFrame("instance-1"))));
+    serializedFrame->coalesce();
+
+    LazyFrame frame;
+    ASSERT_EQ(
+        DecodeError::NONE,
+        receiver->tryDeserializeFrom(frame, std::move(serializedFrame)));
+    auto view = DestinationView::tryParse(*frame.metadataRange());
+    ASSERT_TRUE(view.hasValue()) << i;
+    EXPECT_EQ("instance-1", view->toDestination());
+  }
+}
@@ -0,0 +1,339 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "proteus/framing/FrameSerializer.h"
+#include "proteus/framing/FrameSplitter.h"
+#include "proteus/routing/BroadcastFanout.h"
+#include "proteus/test/BrokerFrames.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+using namespace ::proteus::test;
+
+namespace {
+
+std::unique_ptr<folly::IOBuf> broadcastFrame(folly::StringPiece toGroup) {
+  return groupFrame(FrameType::BROADCAST, toGroup, "app-metadata");
+}
+
+LazyFrame receive(
+    const FrameSerializer& serializer,
+    std::unique_ptr<folly::IOBuf> routing,
+    std::unique_ptr<folly::IOBuf> data) {
+  auto serializedFrame = serializer.serializeOut(Frame_REQUEST_FNF(
+      42,
+      FrameFlags::METADATA,
+      rsocket::Payload(std::move(data), std::move(routing))));
+  serializedFrame->coalesce();
+  LazyFrame frame;
+  EXPECT_EQ(
+      DecodeError::NONE,
+      serializer.tryDeserializeFrom(frame, std::move(serializedFrame)));
+  return frame;
+}
+
+} // namespace
+
+TEST(BroadcastFanoutTest, CopiesShareThePayload) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto frame = receive(
+      *serializer,
+      broadcastFrame("services"),
+      folly::IOBuf::copyBuffer("424242"));
+  const auto* data = frame.buffer().data();
+
+  BroadcastFanout fanout(std::move(frame));
+  ASSERT_TRUE(fanout.view().hasValue());
+  EXPECT_EQ("services", fanout.view()->toGroup());
+
+  FrameBatch first;
+  FrameBatch second;
+  fanout.writeTo(first, 1);
+  fanout.writeTo(second, 3);
+
+  std::vector<std::pair<rsocket::StreamId, std::unique_ptr<folly::IOBuf>>>
+      copies;
+  copies.emplace_back(1, first.move());
+  copies.emplace_back(3, second.move());
+  for (const auto& copy : copies) {
+    // The frame header is written into the batch, the rest is the
+    // received buffer.
+    ASSERT_EQ(2, copy.second->countChainElements());
+    EXPECT_EQ(data + 6, copy.second->next()->data());
+    EXPECT_EQ(fanout.frameLength(), copy.second->computeChainDataLength());
+
+    Frame_REQUEST_FNF forwarded;
+    ASSERT_TRUE(
+        serializer->deserializeFrom(forwarded, copy.second->clone()));
+    EXPECT_EQ(copy.first, forwarded.header_.streamId);
+    EXPECT_EQ(
+        "424242",
+        forwarded.payload_.data->cloneCoalescedAsValue().moveToFbString());
+    auto metadata = forwarded.payload_.metadata->cloneCoalescedAsValue();
+    auto view = BroadcastView::tryParse(metadata);
+    ASSERT_TRUE(view.hasValue());
+    EXPECT_EQ("services", view->toGroup());
+    EXPECT_EQ("app-metadata", folly::StringPiece(view->metadata()));
+  }
+}
+
+TEST(BroadcastFanoutTest, FanOutToGroup) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  NameTable names;
+  GroupRoutingTable table(names);
+  const auto services = names.intern("services");
+  std::vector<NameId> instances;
+  for (auto name : {"instance-1", "instance-2", "instance-3"}) {
+    instances.push_back(names.intern(name));
+    table.add(services, instances.back());
+  }
+
+  // Two destinations share a connection, the third one is skipped.
+  FrameBatch shared(FrameSplitter::kFrameLengthFieldSize);
+  std::map<NameId, BroadcastFanout::Target> targets{
+      {instances[0], {&shared, 2}},
+      {instances[1], {&shared, 4}},
+      {instances[2], {nullptr, 0}},
+  };
+
+  BroadcastFanout fanout(receive(
+      *serializer,
+      broadcastFrame("services"),
+      folly::IOBuf::copyBuffer(std::string(1000, 'x'))));
+  EXPECT_EQ(2, fanout.fanOut(table, [&](NameId destination) {
+    return targets.at(destination);
+  }));
+  EXPECT_EQ(2, shared.frameCount());
+
+  FrameSplitter splitter;
+  splitter.append(shared.move());
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  ASSERT_EQ(2, splitter.split(frames));
+  std::vector<rsocket::StreamId> streamIds;
+  for (auto& buf : frames) {
+    Frame_REQUEST_FNF forwarded;
+    ASSERT_TRUE(serializer->deserializeFrom(forwarded, std::move(buf)));
+    EXPECT_EQ(1000, forwarded.payload_.data->computeChainDataLength());
+    streamIds.push_back(forwarded.header_.streamId);
+  }
+  EXPECT_THAT(streamIds, ElementsAre(2, 4));
+}
+
+TEST(BroadcastFanoutTest, UnknownGroup) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  NameTable names;
+  GroupRoutingTable table(names);
+  table.add(names.intern("services"), names.intern("instance-1"));
+
+  BroadcastFanout fanout(receive(
+      *serializer,
+      broadcastFrame("others"),
+      folly::IOBuf::copyBuffer("424242")));
+  EXPECT_EQ(0, fanout.fanOut(table, [](NameId) {
+    ADD_FAILURE();
+    return BroadcastFanout::Target();
+  }));
+}
+
+TEST(BroadcastFanoutTest, NotABroadcast) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  NameTable names;
+  GroupRoutingTable table(names);
+  table.add(names.intern("services"), names.intern("instance-1"));
+
+  BroadcastFanout fanout(receive(
+      *serializer,
+      folly::IOBuf::copyBuffer("not a routing header"),
+      folly::IOBuf::copyBuffer("424242")));
+  EXPECT_FALSE(fanout.view().hasValue());
+  EXPECT_EQ(0, fanout.fanOut(table, [](NameId) {
+    ADD_FAILURE();
+    return BroadcastFanout::Target();
+  }));
+
+  // It can still be copied by hand.
+  FrameBatch batch;
+  fanout.writeTo(batch, 5);
+  Frame_REQUEST_FNF forwarded;
+  ASSERT_TRUE(serializer->deserializeFrom(forwarded, batch.move()));
+  EXPECT_EQ(5, forwarded.header_.streamId);
+}
+
+TEST(BroadcastFanoutTest, ChecksummedAndCompressed) {
+  // Both connections checksum frames and compress data the same way.
+  PayloadCompressor sourceCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  PayloadCompressor destinationCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  auto source =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  source->checksumFrames() = true;
+  source->setPayloadCompressor(&sourceCompressor);
+  auto destination =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  destination->checksumFrames() = true;
+  destination->setPayloadCompressor(&destinationCompressor);
+
+  const std::string data(1000, 'x');
+  LazyFrame frame;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      source->tryDeserializeFrom(
+          frame,
+          source->serializeBatchOut(Frame_REQUEST_FNF(
+              42,
+              FrameFlags::METADATA,
+              rsocket::Payload(
+                  folly::IOBuf::copyBuffer(data),
+                  broadcastFrame("services"))))));
+
+  // The received trailer was trimmed, the batch writes a new one.
+  BroadcastFanout fanout(std::move(frame), &sourceCompressor);
+  auto batch = destination->createFrameBatch();
+  fanout.writeTo(batch, 7, &destinationCompressor);
+
+  Frame_REQUEST_FNF forwarded;
+  ASSERT_EQ(
+      DecodeError::NONE,
+      destination->tryDeserializeFrom(forwarded, batch.move()));
+  EXPECT_EQ(7, forwarded.header_.streamId);
+  EXPECT_EQ(
+      data, forwarded.payload_.data->cloneCoalescedAsValue().moveToFbString());
+}
+
+TEST(BroadcastFanoutTest, ReencodedPerCompression) {
+  PayloadCompressor sourceCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  PayloadCompressor zstdCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  PayloadCompressor lz4Compressor(
+      PayloadCompression::LZ4, PayloadCompression::LZ4);
+  auto source =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  source->setPayloadCompressor(&sourceCompressor);
+  auto plain = FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto zstd = FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  zstd->setPayloadCompressor(&zstdCompressor);
+  auto lz4 = FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  lz4->setPayloadCompressor(&lz4Compressor);
+
+  NameTable names;
+  GroupRoutingTable table(names);
+  const auto services = names.intern("services");
+  std::vector<NameId> instances;
+  for (auto name : {"instance-1", "instance-2", "instance-3", "instance-4"}) {
+    instances.push_back(names.intern(name));
+    table.add(services, instances.back());
+  }
+  FrameBatch plainBatch;
+  FrameBatch zstdBatch;
+  FrameBatch lz4Batch;
+  FrameBatch otherPlainBatch;
+  std::map<NameId, BroadcastFanout::Target> targets{
+      {instances[0], {&plainBatch, 2, nullptr}},
+      {instances[1], {&zstdBatch, 4, &zstdCompressor}},
+      {instances[2], {&lz4Batch, 6, &lz4Compressor}},
+      {instances[3], {&otherPlainBatch, 8, nullptr}},
+  };
+
+  const std::string data(1000, 'x');
+  auto frame = receive(
+      *source, broadcastFrame("services"), folly::IOBuf::copyBuffer(data));
+  const auto* received = frame.buffer().data();
+
+  BroadcastFanout fanout(std::move(frame), &sourceCompressor);
+  EXPECT_EQ(4, fanout.fanOut(table, [&](NameId destination) {
+    return targets.at(destination);
+  }));
+
+  auto zstdCopy = zstdBatch.move();
+  // The connection compressing like the source shares the received body.
+  ASSERT_EQ(2, zstdCopy->countChainElements());
+  EXPECT_EQ(received + 6, zstdCopy->next()->data());
+  // The plain connections share one decompressed body.
+  auto plainCopy = plainBatch.move();
+  auto otherPlainCopy = otherPlainBatch.move();
+  EXPECT_EQ(plainCopy->next()->data(), otherPlainCopy->next()->data());
+  EXPECT_EQ(
+      plainCopy->computeChainDataLength(),
+      otherPlainCopy->computeChainDataLength());
+
+  std::vector<std::pair<FrameSerializer*, std::unique_ptr<folly::IOBuf>>>
+      copies;
+  copies.emplace_back(plain.get(), std::move(plainCopy));
+  copies.emplace_back(zstd.get(), std::move(zstdCopy));
+  copies.emplace_back(lz4.get(), lz4Batch.move());
+  copies.emplace_back(plain.get(), std::move(otherPlainCopy));
+  rsocket::StreamId streamId = 2;
+  for (const auto& copy : copies) {
+    Frame_REQUEST_FNF forwarded;
+    ASSERT_EQ(
+        DecodeError::NONE,
+        copy.first->tryDeserializeFrom(forwarded, copy.second->clone()));
+    EXPECT_EQ(streamId, forwarded.header_.streamId);
+    EXPECT_EQ(
+        data,
+        forwarded.payload_.data->cloneCoalescedAsValue().moveToFbString());
+    auto metadata = forwarded.payload_.metadata->cloneCoalescedAsValue();
+    auto view = BroadcastView::tryParse(metadata);
+    ASSERT_TRUE(view.hasValue());
+    EXPECT_EQ("services", view->toGroup());
+    streamId += 2;
+  }
+}
+
+TEST(BroadcastFanoutTest, SkipsTargetsItCantReencodeFor) {
+  // Received as ZSTD compressed data that doesn't decompress.
+  PayloadCompressor sourceCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  NameTable names;
+  GroupRoutingTable table(names);
+  const auto services = names.intern("services");
+  const auto zstdInstance = names.intern("instance-1");
+  const auto plainInstance = names.intern("instance-2");
+  table.add(services, zstdInstance);
+  table.add(services, plainInstance);
+
+  BroadcastFanout fanout(
+      receive(
+          *serializer,
+          broadcastFrame("services"),
+          folly::IOBuf::copyBuffer(std::string("\x02garbage", 8))),
+      &sourceCompressor);
+  PayloadCompressor zstdCompressor(
+      PayloadCompression::NONE, PayloadCompression::ZSTD);
+  FrameBatch zstdBatch;
+  FrameBatch plainBatch;
+  EXPECT_EQ(1, fanout.fanOut(table, [&](NameId destination) {
+    return destination == zstdInstance
+        ? BroadcastFanout::Target{&zstdBatch, 2, &zstdCompressor}
+        : BroadcastFanout::Target{&plainBatch, 4, nullptr};
+  }));
+  EXPECT_EQ(1, zstdBatch.frameCount());
+  EXPECT_EQ(0, plainBatch.frameCount());
+  EXPECT_FALSE(fanout.writeTo(plainBatch, 6));
+  EXPECT_EQ(0, plainBatch.frameCount());
+}
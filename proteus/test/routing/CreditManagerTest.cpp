@@ -0,0 +1,131 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "proteus/framing/Frame.h"
+#include "proteus/routing/CreditManager.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+using Clock = CreditManager::Clock;
+
+constexpr auto kMaxDelay = std::chrono::milliseconds(10);
+
+} // namespace
+
+TEST(CreditManagerTest, CoalescesSmallRequests) {
+  CreditManager credits(64, 8, kMaxDelay);
+  const auto now = Clock::now();
+  EXPECT_EQ(4u, credits.open(1, 4));
+
+  // The upstream still has credit, request(1)s add up.
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(0u, credits.request(1, 1, now));
+  }
+  EXPECT_EQ(8u, credits.request(1, 1, now));
+
+  // Once the upstream runs out of credit, demand is granted right away.
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_TRUE(credits.receive(1));
+    EXPECT_EQ(0u, credits.deliver(1, 1, now));
+  }
+  EXPECT_EQ(1u, credits.request(1, 1, now));
+}
+
+TEST(CreditManagerTest, FlushesAfterMaxDelay) {
+  CreditManager credits(64, 8, kMaxDelay);
+  const auto start = Clock::now();
+  EXPECT_EQ(4u, credits.open(1, 4));
+  EXPECT_EQ(2u, credits.open(3, 2));
+  EXPECT_EQ(0u, credits.request(1, 3, start));
+  EXPECT_EQ(0u, credits.request(3, 1, start + kMaxDelay / 2));
+
+  std::vector<std::pair<rsocket::StreamId, uint32_t>> flushed;
+  auto collect = [&](rsocket::StreamId streamId, uint32_t requestN) {
+    flushed.emplace_back(streamId, requestN);
+  };
+  EXPECT_EQ(0u, credits.flush(start + kMaxDelay / 2, collect));
+  EXPECT_EQ(1u, credits.flush(start + kMaxDelay, collect));
+  EXPECT_THAT(flushed, ElementsAre(std::make_pair(1u, 3u)));
+  EXPECT_EQ(1u, credits.flush(start + 2 * kMaxDelay, collect));
+  EXPECT_THAT(
+      flushed,
+      ElementsAre(std::make_pair(1u, 3u), std::make_pair(3u, 1u)));
+
+  // Nothing is left to flush, nor for closed streams.
+  EXPECT_EQ(0u, credits.request(3, 1, start + 2 * kMaxDelay));
+  credits.close(3);
+  EXPECT_EQ(0u, credits.flush(start + 4 * kMaxDelay, collect));
+}
+
+TEST(CreditManagerTest, SlowSubscriberStallsUpstream) {
+  CreditManager credits(16, 1, kMaxDelay);
+  const auto now = Clock::now();
+  // An unbounded request becomes a window of 16 payloads.
+  EXPECT_EQ(16u, credits.open(1, Frame_REQUEST_N::kMaxRequestN));
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_TRUE(credits.receive(1));
+  }
+  EXPECT_EQ(16u, credits.bufferedFrames());
+  // Beyond the window.
+  EXPECT_FALSE(credits.receive(1));
+  EXPECT_EQ(0u, credits.request(1, 100, now));
+
+  // Every payload the subscriber takes lets the upstream send one more.
+  EXPECT_EQ(4u, credits.deliver(1, 4, now));
+  EXPECT_EQ(12u, credits.bufferedFrames());
+  credits.close(1);
+  EXPECT_EQ(0u, credits.bufferedFrames());
+  EXPECT_EQ(0u, credits.streamCount());
+}
+
+TEST(CreditManagerTest, UnboundedRequestNeverRunsOut) {
+  CreditManager credits(Frame_REQUEST_N::kMaxRequestN, 1, kMaxDelay);
+  const auto now = Clock::now();
+  // The whole unbounded request is granted at once, and still more is
+  // granted as payloads are delivered.
+  EXPECT_EQ(
+      uint32_t(Frame_REQUEST_N::kMaxRequestN),
+      credits.open(1, Frame_REQUEST_N::kMaxRequestN));
+  EXPECT_TRUE(credits.receive(1));
+  EXPECT_EQ(1u, credits.deliver(1, 1, now));
+
+  // Requests adding up to kMaxRequestN are unbounded too.
+  EXPECT_EQ(10u, credits.open(3, 10));
+  EXPECT_EQ(
+      uint32_t(Frame_REQUEST_N::kMaxRequestN - 10),
+      credits.request(3, Frame_REQUEST_N::kMaxRequestN - 10, now));
+  EXPECT_TRUE(credits.receive(3));
+  EXPECT_EQ(1u, credits.deliver(3, 1, now));
+
+  // A bounded stream is done once its request is.
+  EXPECT_EQ(5u, credits.open(5, 5));
+  EXPECT_TRUE(credits.receive(5));
+  EXPECT_EQ(0u, credits.deliver(5, 1, now));
+}
+
+TEST(CreditManagerTest, UntrackedStreams) {
+  CreditManager credits(16, 8, kMaxDelay);
+  EXPECT_EQ(5u, credits.request(7, 5, Clock::now()));
+  EXPECT_TRUE(credits.receive(7));
+  EXPECT_EQ(0u, credits.deliver(7, 1, Clock::now()));
+  EXPECT_EQ(0u, credits.bufferedFrames());
+}
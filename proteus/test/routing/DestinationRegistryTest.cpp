@@ -0,0 +1,183 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <gmock/gmock.h>
+
+#include "proteus/routing/DestinationRegistry.h"
+#include "proteus/test/BrokerFrames.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+using namespace ::proteus::test;
+
+TEST(DestinationRegistryTest, AddRemove) {
+  NameTable names;
+  DestinationRegistry registry(names);
+  EXPECT_EQ(0u, registry.size());
+  EXPECT_FALSE(registry.find(1, 10).hasValue());
+
+  EXPECT_TRUE(registry.add(1, 10, 100));
+  EXPECT_TRUE(registry.add(1, 20, 200));
+  EXPECT_TRUE(registry.add(2, 10, 300));
+  EXPECT_EQ(3u, registry.size());
+  EXPECT_EQ(100u, registry.find(1, 10).value());
+  EXPECT_EQ(200u, registry.find(1, 20).value());
+  EXPECT_EQ(300u, registry.find(2, 10).value());
+  EXPECT_FALSE(registry.find(2, 20).hasValue());
+
+  // A destination registering again replaces its connection.
+  EXPECT_FALSE(registry.add(1, 10, 400));
+  EXPECT_EQ(400u, registry.find(1, 10).value());
+  EXPECT_EQ(3u, registry.size());
+
+  EXPECT_TRUE(registry.remove(1, 10));
+  EXPECT_FALSE(registry.remove(1, 10));
+  EXPECT_FALSE(registry.find(1, 10).hasValue());
+  EXPECT_EQ(300u, registry.find(2, 10).value());
+  EXPECT_EQ(2u, registry.size());
+}
+
+TEST(DestinationRegistryTest, ManyDestinations) {
+  NameTable names;
+  DestinationRegistry registry(names);
+  constexpr NameId kCount = 100000;
+  for (NameId destination = 0; destination < kCount; ++destination) {
+    ASSERT_TRUE(registry.add(destination % 10, destination, destination));
+  }
+  EXPECT_EQ(kCount, registry.size());
+  for (NameId destination = 0; destination < kCount; ++destination) {
+    ASSERT_EQ(destination, registry.find(destination % 10, destination));
+    ASSERT_FALSE(registry.find(destination % 10 + 1, destination));
+  }
+
+  for (NameId destination = 0; destination < kCount; destination += 2) {
+    ASSERT_TRUE(registry.remove(destination % 10, destination));
+  }
+  EXPECT_EQ(kCount / 2, registry.size());
+  for (NameId destination = 0; destination < kCount; ++destination) {
+    ASSERT_EQ(
+        destination % 2 == 1,
+        registry.find(destination % 10, destination).hasValue());
+  }
+}
+
+TEST(DestinationRegistryTest, Churn) {
+  // Removed slots are reclaimed, lookups keep finding what is left.
+  NameTable names;
+  DestinationRegistry registry(names);
+  ASSERT_TRUE(registry.add(0, 0, 0));
+  for (NameId destination = 1; destination < 50000; ++destination) {
+    ASSERT_TRUE(registry.add(1, destination, destination));
+    ASSERT_TRUE(registry.remove(1, destination));
+  }
+  EXPECT_EQ(1u, registry.size());
+  EXPECT_EQ(0u, registry.find(0, 0).value());
+}
+
+TEST(DestinationRegistryTest, Frames) {
+  NameTable names;
+  DestinationRegistry registry(names);
+
+  auto setup = destinationSetup("service-1", "services");
+  EXPECT_TRUE(registry.add(*DestinationSetupView::tryParse(*setup), 7));
+  EXPECT_EQ(
+      7u,
+      registry.find(names.intern("services"), names.intern("service-1")));
+
+  auto frame = destinationFrame("service-1", "services");
+  auto view = DestinationView::tryParse(*frame);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ(7u, registry.find(*view).value());
+
+  // Unknown destinations are looked up without being interned.
+  auto unknown = destinationFrame("service-2", "services");
+  EXPECT_FALSE(registry.find(*DestinationView::tryParse(*unknown)));
+  EXPECT_FALSE(names.find("service-2").hasValue());
+
+  EXPECT_TRUE(registry.remove(*DestinationSetupView::tryParse(*setup)));
+  EXPECT_FALSE(registry.find(*view).hasValue());
+}
+
+TEST(DestinationRegistryTest, FullNameTable) {
+  NameTable names;
+  DestinationRegistry registry(names);
+  auto known = destinationSetup("service-1", "services");
+  EXPECT_TRUE(registry.add(*DestinationSetupView::tryParse(*known), 7));
+  for (size_t i = names.size(); i < NameTable::kMaxNames; ++i) {
+    names.intern(folly::to<std::string>("name-", i));
+  }
+
+  // Setups bringing new names are refused instead of failing.
+  auto fresh = destinationSetup("service-2", "services");
+  EXPECT_FALSE(registry.add(*DestinationSetupView::tryParse(*fresh), 8));
+  EXPECT_FALSE(names.find("service-2").hasValue());
+  EXPECT_EQ(1u, registry.size());
+
+  // Known names still register.
+  EXPECT_TRUE(registry.add(*DestinationSetupView::tryParse(*known), 9));
+  auto frame = destinationFrame("service-1", "services");
+  EXPECT_EQ(9u, registry.find(*DestinationView::tryParse(*frame)).value());
+}
+
+TEST(DestinationRegistryTest, ConcurrentReaders) {
+  NameTable names;
+  DestinationRegistry registry(names);
+  for (NameId destination = 0; destination < 100; ++destination) {
+    registry.add(0, destination, destination);
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        // Group 0 is never changed, group 1 churns around it.
+        for (NameId destination = 0; destination < 100; ++destination) {
+          EXPECT_EQ(destination, registry.find(0, destination));
+          auto handle = registry.find(1, destination);
+          if (handle) {
+            EXPECT_EQ(destination + 1000, *handle);
+          }
+        }
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for (NameId first = 0; first < 2; ++first) {
+    writers.emplace_back([&, first] {
+      for (int round = 0; round < 100; ++round) {
+        for (NameId d = first; d < 20000; d += 2) {
+          registry.add(1, d, d + 1000);
+        }
+        for (NameId d = first; d < 20000; d += 2) {
+          registry.remove(1, d);
+        }
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(100u, registry.size());
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <vector>
+
+#include <folly/Range.h>
+#include <gmock/gmock.h>
+
+#include "proteus/routing/GroupBalancer.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+using Clock = LoadStats::Clock;
+using Policy = GroupBalancer::Policy;
+using std::chrono::milliseconds;
+
+constexpr NameId kGroup = 100;
+
+} // namespace
+
+TEST(GroupBalancerTest, LeastOutstanding) {
+  LoadStats stats;
+  auto balancer = GroupBalancer::create(Policy::LEAST_OUTSTANDING, stats);
+  const auto now = Clock::now();
+  const std::vector<NameId> one{1};
+  EXPECT_EQ(1u, balancer->select(kGroup, folly::range(one), now));
+
+  // With two destinations both are sampled every time.
+  const std::vector<NameId> two{1, 2};
+  stats.start(1);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(2u, balancer->select(kGroup, folly::range(two), now));
+  }
+
+  // A destination stuck with requests is mostly avoided.
+  const std::vector<NameId> many{1, 2, 3, 4};
+  for (int i = 0; i < 100; ++i) {
+    stats.start(1);
+  }
+  std::map<NameId, int> picked;
+  for (int i = 0; i < 1000; ++i) {
+    ++picked[balancer->select(kGroup, folly::range(many), now)];
+  }
+  EXPECT_EQ(0, picked[1]);
+}
+
+TEST(GroupBalancerTest, PeakEwmaAvoidsSlowDestination) {
+  LoadStats stats;
+  auto balancer = GroupBalancer::create(Policy::PEAK_EWMA, stats);
+  const auto now = Clock::now();
+  for (NameId destination = 1; destination <= 4; ++destination) {
+    stats.start(destination);
+    stats.complete(destination, milliseconds(1), now);
+  }
+  // Destination 1 pauses.
+  stats.start(1);
+  stats.complete(1, milliseconds(500), now);
+
+  const std::vector<NameId> two{1, 2};
+  EXPECT_EQ(2u, balancer->select(kGroup, folly::range(two), now));
+  const std::vector<NameId> many{1, 2, 3, 4};
+  std::map<NameId, int> picked;
+  for (int i = 0; i < 1000; ++i) {
+    ++picked[balancer->select(kGroup, folly::range(many), now)];
+  }
+  EXPECT_EQ(0, picked[1]);
+}
+
+TEST(GroupBalancerTest, PeakEwmaTrustsSlowDestinationAgain) {
+  const auto decay = milliseconds(100);
+  LoadStats stats(decay);
+  auto balancer = GroupBalancer::create(Policy::PEAK_EWMA, stats);
+  const auto start = Clock::now();
+  // Destination 1 pauses once, then gets no request while it is avoided.
+  stats.start(1);
+  stats.complete(1, milliseconds(500), start);
+
+  const std::vector<NameId> many{1, 2, 3, 4};
+  auto pick = [&](Clock::time_point now) {
+    // The others keep answering in 1ms.
+    for (NameId destination = 2; destination <= 4; ++destination) {
+      stats.start(destination);
+      stats.complete(destination, milliseconds(1), now);
+    }
+    std::map<NameId, int> picked;
+    for (int i = 0; i < 1000; ++i) {
+      ++picked[balancer->select(kGroup, folly::range(many), now)];
+    }
+    return picked[1];
+  };
+  EXPECT_EQ(0, pick(start + decay));
+  EXPECT_GT(pick(start + 10 * decay), 0);
+}
+
+TEST(GroupBalancerTest, WeightedRoundRobin) {
+  LoadStats stats;
+  auto balancer = GroupBalancer::create(Policy::WEIGHTED_ROUND_ROBIN, stats);
+  const auto now = Clock::now();
+  stats.setWeight(1, 3);
+  stats.setWeight(2, 1);
+  stats.setWeight(3, 0);
+  const std::vector<NameId> destinations{1, 2, 3};
+
+  std::vector<NameId> round;
+  for (int i = 0; i < 4; ++i) {
+    round.push_back(balancer->select(kGroup, folly::range(destinations), now));
+  }
+  // Spread out rather than back to back.
+  EXPECT_THAT(round, ElementsAre(1, 2, 1, 1));
+
+  std::map<NameId, int> picked;
+  for (int i = 0; i < 400; ++i) {
+    ++picked[balancer->select(kGroup, folly::range(destinations), now)];
+  }
+  EXPECT_EQ(300, picked[1]);
+  EXPECT_EQ(100, picked[2]);
+  EXPECT_EQ(0, picked[3]);
+
+  // Groups take turns of their own.
+  EXPECT_EQ(1u, balancer->select(kGroup + 1, folly::range(destinations), now));
+}
+
+TEST(GroupBalancerTest, Route) {
+  NameTable names;
+  GroupRoutingTable table(names);
+  LoadStats stats;
+  auto balancer = GroupBalancer::create(Policy::LEAST_OUTSTANDING, stats);
+  const auto now = Clock::now();
+  EXPECT_FALSE(balancer->route(table, kGroup, now).hasValue());
+
+  table.add(kGroup, 1);
+  table.add(kGroup, 2);
+  auto first = balancer->route(table, kGroup, now);
+  ASSERT_TRUE(first.hasValue());
+  EXPECT_EQ(1u, stats.outstanding(*first));
+  // The other one has fewer requests outstanding now.
+  auto second = balancer->route(table, kGroup, now);
+  ASSERT_TRUE(second.hasValue());
+  EXPECT_NE(*first, *second);
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <gmock/gmock.h>
+
+#include "proteus/routing/GroupRoutingTable.h"
+#include "proteus/test/BrokerFrames.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+using namespace ::proteus::test;
+
+TEST(GroupRoutingTableTest, AddRemove) {
+  NameTable names;
+  GroupRoutingTable table(names);
+  EXPECT_EQ(0u, table.groupCount());
+  EXPECT_FALSE(table.withDestinations(1, [](folly::Range<const NameId*>) {
+    ADD_FAILURE();
+  }));
+
+  EXPECT_TRUE(table.add(1, 30));
+  EXPECT_TRUE(table.add(1, 10));
+  EXPECT_TRUE(table.add(1, 20));
+  EXPECT_FALSE(table.add(1, 20));
+  EXPECT_TRUE(table.add(2, 10));
+  EXPECT_EQ(2u, table.groupCount());
+  EXPECT_THAT(table.destinations(1), ElementsAre(10, 20, 30));
+  EXPECT_THAT(table.destinations(2), ElementsAre(10));
+
+  EXPECT_TRUE(table.remove(1, 20));
+  EXPECT_FALSE(table.remove(1, 20));
+  EXPECT_FALSE(table.remove(3, 10));
+  EXPECT_THAT(table.destinations(1), ElementsAre(10, 30));
+
+  EXPECT_TRUE(table.remove(2, 10));
+  EXPECT_EQ(1u, table.groupCount());
+  EXPECT_TRUE(table.destinations(2).empty());
+}
+
+TEST(GroupRoutingTableTest, ManyGroups) {
+  NameTable names;
+  GroupRoutingTable table(names);
+  for (NameId group = 0; group < 100; ++group) {
+    EXPECT_TRUE(table.add(group, group + 1000));
+  }
+  EXPECT_EQ(100u, table.groupCount());
+  for (NameId group = 0; group < 100; ++group) {
+    EXPECT_THAT(table.destinations(group), ElementsAre(group + 1000));
+  }
+  for (NameId group = 0; group < 100; group += 2) {
+    EXPECT_TRUE(table.remove(group, group + 1000));
+  }
+  EXPECT_EQ(50u, table.groupCount());
+  EXPECT_TRUE(table.destinations(98).empty());
+  EXPECT_THAT(table.destinations(99), ElementsAre(1099));
+}
+
+TEST(GroupRoutingTableTest, Frames) {
+  NameTable names;
+  GroupRoutingTable table(names);
+
+  auto setup1 = destinationSetup("service-1", "services");
+  auto setup2 = destinationSetup("service-2", "services");
+  EXPECT_TRUE(table.add(*DestinationSetupView::tryParse(*setup1)));
+  EXPECT_TRUE(table.add(*DestinationSetupView::tryParse(*setup2)));
+  EXPECT_FALSE(table.add(*DestinationSetupView::tryParse(*setup2)));
+
+  auto group = groupFrame(FrameType::GROUP, "services");
+  auto view = GroupView::tryParse(*group);
+  ASSERT_TRUE(view.hasValue());
+
+  std::vector<folly::StringPiece> routed;
+  EXPECT_TRUE(
+      table.withDestinations(*view, [&](folly::Range<const NameId*> ids) {
+        for (auto id : ids) {
+          routed.push_back(names.name(id));
+        }
+      }));
+  EXPECT_THAT(routed, ElementsAre("service-1", "service-2"));
+
+  EXPECT_TRUE(table.remove(*DestinationSetupView::tryParse(*setup1)));
+  EXPECT_TRUE(table.remove(*DestinationSetupView::tryParse(*setup2)));
+  EXPECT_FALSE(
+      table.withDestinations(*view, [](folly::Range<const NameId*>) {}));
+
+  // Unknown groups are looked up without being interned.
+  auto unknown = groupFrame(FrameType::GROUP, "nobody");
+  EXPECT_FALSE(table.withDestinations(
+      *GroupView::tryParse(*unknown), [](folly::Range<const NameId*>) {}));
+  EXPECT_FALSE(names.find("nobody").hasValue());
+}
+
+TEST(GroupRoutingTableTest, FullNameTable) {
+  NameTable names;
+  GroupRoutingTable table(names);
+  auto known = destinationSetup("service-1", "services");
+  EXPECT_TRUE(table.add(*DestinationSetupView::tryParse(*known)));
+  for (size_t i = names.size(); i < NameTable::kMaxNames; ++i) {
+    names.intern(folly::to<std::string>("name-", i));
+  }
+
+  // Setups bringing new names are refused instead of failing.
+  auto fresh = destinationSetup("service-2", "services");
+  EXPECT_FALSE(table.add(*DestinationSetupView::tryParse(*fresh)));
+  EXPECT_FALSE(names.find("service-2").hasValue());
+  EXPECT_THAT(
+      table.destinations(*names.find("services")),
+      ElementsAre(*names.find("service-1")));
+
+  // Known names still register.
+  EXPECT_TRUE(table.remove(*DestinationSetupView::tryParse(*known)));
+  EXPECT_TRUE(table.add(*DestinationSetupView::tryParse(*known)));
+}
+
+TEST(GroupRoutingTableTest, ConcurrentReaders) {
+  NameTable names;
+  GroupRoutingTable table(names);
+  table.add(1, 0);
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        table.withDestinations(1, [](folly::Range<const NameId*> ids) {
+          // Destination 0 is never removed and ids stay sorted.
+          EXPECT_EQ(0u, ids[0]);
+          EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+        });
+      }
+    });
+  }
+
+  for (NameId destination = 1; destination < 2000; ++destination) {
+    table.add(1, destination);
+    if (destination % 3 == 0) {
+      table.remove(1, destination - 1);
+    }
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "proteus/routing/LeaseIssuer.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+using Clock = LeaseIssuer::Clock;
+
+constexpr auto kTtl = std::chrono::milliseconds(100);
+
+} // namespace
+
+TEST(LeaseIssuerTest, LeasesQueueRoom) {
+  LeaseIssuer issuer(100, kTtl);
+  const auto start = Clock::now();
+
+  auto lease = issuer.update(40, start);
+  ASSERT_TRUE(lease.hasValue());
+  EXPECT_EQ(FrameType::LEASE, lease->header_.type);
+  EXPECT_EQ(100u, lease->ttl_);
+  EXPECT_EQ(60u, lease->numberOfRequests_);
+
+  // Still good for half its ttl.
+  EXPECT_FALSE(issuer.update(40, start + kTtl / 4).hasValue());
+  EXPECT_FALSE(issuer.update(20, start + kTtl / 4).hasValue());
+  lease = issuer.update(40, start + kTtl / 2);
+  ASSERT_TRUE(lease.hasValue());
+  EXPECT_EQ(60u, lease->numberOfRequests_);
+}
+
+TEST(LeaseIssuerTest, RenewsEarlyWhenDrained) {
+  LeaseIssuer issuer(100, kTtl);
+  const auto start = Clock::now();
+  ASSERT_TRUE(issuer.update(90, start).hasValue());
+
+  auto lease = issuer.update(80, start + std::chrono::milliseconds(1));
+  ASSERT_TRUE(lease.hasValue());
+  EXPECT_EQ(20u, lease->numberOfRequests_);
+}
+
+TEST(LeaseIssuerTest, FullQueueLetsLeaseExpire) {
+  LeaseIssuer issuer(100, kTtl);
+  const auto start = Clock::now();
+  ASSERT_TRUE(issuer.update(0, start).hasValue());
+  EXPECT_FALSE(issuer.update(100, start + kTtl).hasValue());
+  EXPECT_FALSE(issuer.update(150, start + 2 * kTtl).hasValue());
+
+  auto lease = issuer.update(99, start + 3 * kTtl);
+  ASSERT_TRUE(lease.hasValue());
+  EXPECT_EQ(1u, lease->numberOfRequests_);
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/Range.h>
+#include <gmock/gmock.h>
+
+#include "proteus/routing/LeaseTable.h"
+#include "proteus/test/BrokerFrames.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+using namespace ::proteus::test;
+
+namespace {
+
+using Clock = LeaseTable::Clock;
+
+} // namespace
+
+TEST(LeaseTableTest, BudgetAndTtl) {
+  LeaseTable leases;
+  const auto now = Clock::now();
+  EXPECT_FALSE(leases.tryAcquire(1, now));
+  EXPECT_EQ(0u, leases.remaining(1, now));
+
+  leases.grant(1, Frame_LEASE(100, 2), now);
+  EXPECT_EQ(2u, leases.remaining(1, now));
+  EXPECT_TRUE(leases.tryAcquire(1, now));
+  EXPECT_TRUE(leases.tryAcquire(1, now));
+  EXPECT_FALSE(leases.tryAcquire(1, now));
+
+  // A new lease replaces the spent one, until it expires.
+  leases.grant(1, Frame_LEASE(100, 5), now);
+  EXPECT_TRUE(leases.tryAcquire(1, now + std::chrono::milliseconds(99)));
+  EXPECT_FALSE(leases.tryAcquire(1, now + std::chrono::milliseconds(100)));
+  EXPECT_EQ(0u, leases.remaining(1, now + std::chrono::milliseconds(100)));
+
+  leases.grant(1, Frame_LEASE(100, 5), now);
+  leases.revoke(1);
+  EXPECT_FALSE(leases.tryAcquire(1, now));
+  // Destinations far apart live in chunks of their own.
+  leases.grant(NameTable::kMaxNames - 1, Frame_LEASE(100, 1), now);
+  EXPECT_TRUE(leases.tryAcquire(NameTable::kMaxNames - 1, now));
+}
+
+TEST(LeaseTableTest, AcquirePicksLargestBudget) {
+  LeaseTable leases;
+  const auto now = Clock::now();
+  const std::vector<NameId> destinations{1, 2, 3};
+  EXPECT_FALSE(leases.acquire(folly::range(destinations), now).hasValue());
+
+  leases.grant(1, Frame_LEASE(100, 1), now);
+  leases.grant(2, Frame_LEASE(100, 3), now);
+  std::vector<NameId> picked;
+  for (int i = 0; i < 4; ++i) {
+    auto destination = leases.acquire(folly::range(destinations), now);
+    ASSERT_TRUE(destination.hasValue());
+    picked.push_back(*destination);
+  }
+  EXPECT_THAT(picked, ElementsAre(2, 2, 1, 2));
+  // Saturated instances get nothing more.
+  EXPECT_FALSE(leases.acquire(folly::range(destinations), now).hasValue());
+}
+
+TEST(LeaseTableTest, GroupFrames) {
+  NameTable names;
+  GroupRoutingTable groups(names);
+  LeaseTable leases;
+  const auto now = Clock::now();
+  const auto services = names.intern("services");
+  const auto service1 = names.intern("service-1");
+  const auto service2 = names.intern("service-2");
+  groups.add(services, service1);
+  groups.add(services, service2);
+  leases.grant(service2, Frame_LEASE(100, 1), now);
+
+  auto frame = groupFrame(FrameType::GROUP, "services");
+  auto view = GroupView::tryParse(*frame);
+  ASSERT_TRUE(view.hasValue());
+  EXPECT_EQ(service2, leases.acquire(groups, *view, now));
+  EXPECT_FALSE(leases.acquire(groups, *view, now).hasValue());
+}
+
+TEST(LeaseTableTest, ConcurrentAcquire) {
+  LeaseTable leases;
+  const auto now = Clock::now();
+  const std::vector<NameId> destinations{1, 2};
+  leases.grant(1, Frame_LEASE(1000, 5000), now);
+  leases.grant(2, Frame_LEASE(1000, 5000), now);
+
+  std::atomic<size_t> acquired{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      while (leases.acquire(folly::range(destinations), now)) {
+        ++acquired;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // Not one request more than the leases allow.
+  EXPECT_EQ(10000u, acquired.load());
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "proteus/routing/LoadStats.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+using Clock = LoadStats::Clock;
+using std::chrono::milliseconds;
+
+} // namespace
+
+TEST(LoadStatsTest, Outstanding) {
+  LoadStats stats;
+  const auto now = Clock::now();
+  EXPECT_EQ(0u, stats.outstanding(1));
+  stats.start(1);
+  stats.start(1);
+  stats.start(2);
+  EXPECT_EQ(2u, stats.outstanding(1));
+  EXPECT_EQ(1u, stats.outstanding(2));
+  stats.complete(1, milliseconds(1), now);
+  EXPECT_EQ(1u, stats.outstanding(1));
+}
+
+TEST(LoadStatsTest, PeakEwma) {
+  LoadStats stats(milliseconds(100));
+  const auto start = Clock::now();
+  EXPECT_EQ(0, stats.latency(1).count());
+
+  stats.start(1);
+  stats.complete(1, milliseconds(10), start);
+  EXPECT_EQ(milliseconds(10), stats.latency(1));
+
+  // Peaks are taken at once.
+  stats.start(1);
+  stats.complete(1, milliseconds(50), start + milliseconds(1));
+  EXPECT_EQ(milliseconds(50), stats.latency(1));
+
+  // Lower latencies are decayed towards, with time.
+  stats.start(1);
+  stats.complete(1, milliseconds(10), start + milliseconds(2));
+  EXPECT_GT(stats.latency(1), milliseconds(49));
+  stats.start(1);
+  stats.complete(1, milliseconds(10), start + milliseconds(1000));
+  EXPECT_LT(stats.latency(1), milliseconds(11));
+}
+
+TEST(LoadStatsTest, Cost) {
+  LoadStats stats;
+  const auto now = Clock::now();
+  EXPECT_EQ(0, stats.cost(1, now));
+
+  // Outstanding requests and no response yet: maybe stuck.
+  stats.start(1);
+  stats.start(2);
+  stats.complete(2, milliseconds(1), now);
+  EXPECT_GT(stats.cost(1, now), stats.cost(2, now));
+
+  stats.complete(1, milliseconds(1), now);
+  stats.start(1);
+  stats.start(1);
+  EXPECT_DOUBLE_EQ(3 * stats.cost(2, now), stats.cost(1, now));
+}
+
+TEST(LoadStatsTest, CostDecaysWithoutResponses) {
+  LoadStats stats(milliseconds(100));
+  const auto start = Clock::now();
+  stats.start(1);
+  stats.complete(1, milliseconds(500), start);
+  EXPECT_DOUBLE_EQ(5e8, stats.cost(1, start));
+  EXPECT_NEAR(
+      5e8 * std::exp(-1.0), stats.cost(1, start + milliseconds(100)), 1e3);
+  EXPECT_LT(stats.cost(1, start + milliseconds(1000)), 1e5);
+  // The stored latency is only decayed by the next response.
+  EXPECT_EQ(milliseconds(500), stats.latency(1));
+
+  // A response above the decayed latency is the new peak.
+  stats.start(1);
+  stats.complete(1, milliseconds(20), start + milliseconds(1000));
+  EXPECT_EQ(milliseconds(20), stats.latency(1));
+}
+
+TEST(LoadStatsTest, Weight) {
+  LoadStats stats;
+  EXPECT_EQ(LoadStats::kDefaultWeight, stats.weight(1));
+  stats.setWeight(1, 5);
+  EXPECT_EQ(5u, stats.weight(1));
+}
+
+TEST(LoadStatsTest, ConcurrentUpdates) {
+  LoadStats stats;
+  const auto now = Clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 10000; ++j) {
+        stats.start(1);
+        stats.complete(1, milliseconds(1), now);
+      }
+      stats.start(1);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4u, stats.outstanding(1));
+  EXPECT_EQ(milliseconds(1), stats.latency(1));
+}
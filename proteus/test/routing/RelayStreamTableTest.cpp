@@ -0,0 +1,169 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "proteus/routing/RelayStreamTable.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+using Role = RelayStreamTable::Role;
+
+constexpr RelayStreamTable::ConnectionId kClient = 0;
+constexpr RelayStreamTable::ConnectionId kService = 1;
+
+} // namespace
+
+TEST(RelayStreamTableTest, RouteBothWays) {
+  RelayStreamTable table;
+  // The broker is the server of the client and the client of the service.
+  table.open(kClient, Role::SERVER);
+  table.open(kService, Role::CLIENT);
+
+  auto first = table.relay({kClient, 1}, kService);
+  auto second = table.relay({kClient, 3}, kService);
+  ASSERT_TRUE(first.hasValue());
+  ASSERT_TRUE(second.hasValue());
+  EXPECT_EQ(1u, *first);
+  EXPECT_EQ(3u, *second);
+  // Already relayed.
+  EXPECT_FALSE(table.relay({kClient, 3}, kService).hasValue());
+  // The broker's own stream IDs can't be opened by the peer.
+  EXPECT_FALSE(table.relay({kClient, 2}, kService).hasValue());
+
+  auto to = table.route({kClient, 3});
+  ASSERT_TRUE(to.hasValue());
+  EXPECT_EQ(kService, to->connection);
+  EXPECT_EQ(3u, to->streamId);
+  auto back = table.route({kService, 1});
+  ASSERT_TRUE(back.hasValue());
+  EXPECT_EQ(kClient, back->connection);
+  EXPECT_EQ(1u, back->streamId);
+  EXPECT_FALSE(table.route({kClient, 5}).hasValue());
+  EXPECT_FALSE(table.route({kService, 5}).hasValue());
+  EXPECT_EQ(2u, table.streamCount(kClient));
+  EXPECT_EQ(2u, table.streamCount(kService));
+
+  // Released from the responder's end.
+  EXPECT_TRUE(table.release({kService, 1}));
+  EXPECT_FALSE(table.release({kService, 1}));
+  EXPECT_FALSE(table.route({kClient, 1}).hasValue());
+  EXPECT_EQ(1u, table.streamCount(kClient));
+  EXPECT_EQ(1u, table.streamCount(kService));
+}
+
+TEST(RelayStreamTableTest, ReusesFreedStreamIds) {
+  RelayStreamTable table;
+  table.open(kClient, Role::SERVER);
+  table.open(kService, Role::SERVER);
+
+  constexpr auto kQuarantine = RelayStreamTable::kStreamIdQuarantine;
+  rsocket::StreamId id = 1;
+  for (; id <= 2 * kQuarantine + 3; id += 2) {
+    EXPECT_EQ(id + 1, table.relay({kClient, id}, kService).value());
+  }
+  // Freed stream IDs are held back while fewer than the quarantine are.
+  EXPECT_TRUE(table.release({kClient, 3}));
+  EXPECT_TRUE(table.release({kClient, 1}));
+  EXPECT_EQ(id + 1, table.relay({kClient, id}, kService).value());
+  id += 2;
+  for (rsocket::StreamId freed = 5; freed < 2 * kQuarantine + 3;
+       freed += 2) {
+    EXPECT_TRUE(table.release({kClient, freed}));
+  }
+
+  // Then handed out oldest first.
+  EXPECT_EQ(4u, table.relay({kClient, id}, kService).value());
+  auto to = table.route({kClient, id});
+  ASSERT_TRUE(to.hasValue());
+  EXPECT_EQ(4u, to->streamId);
+  EXPECT_EQ(id, table.route({kService, 4})->streamId);
+  id += 2;
+  EXPECT_EQ(
+      2 * kQuarantine + 8, table.relay({kClient, id}, kService).value());
+}
+
+TEST(RelayStreamTableTest, InboundWindowStaysSmall) {
+  RelayStreamTable table;
+  table.open(kClient, Role::SERVER);
+  table.open(kService, Role::CLIENT);
+
+  // Long-lived stream 1 while the peer's stream IDs grow past it.
+  ASSERT_TRUE(table.relay({kClient, 1}, kService).hasValue());
+  for (rsocket::StreamId id = 3; id < 20000; id += 2) {
+    auto to = table.relay({kClient, id}, kService);
+    ASSERT_TRUE(to.hasValue());
+    ASSERT_EQ(id, table.route({kService, *to})->streamId);
+    ASSERT_TRUE(table.release({kClient, id}));
+  }
+  EXPECT_EQ(1u, table.route({kClient, 1})->streamId);
+  EXPECT_EQ(1u, table.streamCount(kClient));
+  EXPECT_EQ(16u, table.inboundWindow(kClient));
+
+  // Stream IDs far apart share the window too.
+  const auto far = static_cast<rsocket::StreamId>(
+      1 + 2 * RelayStreamTable::kMaxInboundStreams);
+  auto to = table.relay({kClient, far}, kService);
+  ASSERT_TRUE(to.hasValue());
+  EXPECT_EQ(far, table.route({kService, *to})->streamId);
+  EXPECT_EQ(16u, table.inboundWindow(kClient));
+
+  // A collision in a window at least half full doubles it.
+  for (rsocket::StreamId id = 3; id <= 33; id += 2) {
+    ASSERT_TRUE(table.relay({kClient, id}, kService).hasValue());
+  }
+  EXPECT_EQ(32u, table.inboundWindow(kClient));
+  EXPECT_EQ(18u, table.streamCount(kClient));
+  for (rsocket::StreamId id = 1; id <= 33; id += 2) {
+    ASSERT_EQ(kService, table.route({kClient, id})->connection);
+  }
+  EXPECT_TRUE(table.release({kClient, far}));
+  EXPECT_FALSE(table.route({kClient, far}).hasValue());
+  EXPECT_EQ(17u, table.streamCount(kClient));
+}
+
+TEST(RelayStreamTableTest, CloseReleasesInBulk) {
+  RelayStreamTable table;
+  constexpr RelayStreamTable::ConnectionId kOther = 2;
+  table.open(kClient, Role::SERVER);
+  table.open(kService, Role::CLIENT);
+  table.open(kOther, Role::SERVER);
+
+  for (rsocket::StreamId id = 1; id <= 9; id += 2) {
+    ASSERT_TRUE(table.relay({kClient, id}, kService).hasValue());
+  }
+  ASSERT_TRUE(table.relay({kOther, 1}, kService).hasValue());
+  EXPECT_EQ(6u, table.streamCount(kService));
+
+  EXPECT_EQ(5u, table.close(kClient));
+  EXPECT_EQ(0u, table.streamCount(kClient));
+  EXPECT_FALSE(table.route({kClient, 1}).hasValue());
+
+  // The service's ends are dropped lazily, or all at once.
+  EXPECT_FALSE(table.route({kService, 1}).hasValue());
+  EXPECT_EQ(5u, table.streamCount(kService));
+  EXPECT_EQ(4u, table.reclaim(kService));
+  EXPECT_EQ(1u, table.streamCount(kService));
+  EXPECT_EQ(kOther, table.route({kService, 11})->connection);
+
+  // A new incarnation of the connection doesn't see the old streams.
+  table.open(kClient, Role::SERVER);
+  EXPECT_FALSE(table.route({kClient, 3}).hasValue());
+  auto to = table.relay({kClient, 1}, kService);
+  ASSERT_TRUE(to.hasValue());
+  EXPECT_EQ(1u, table.route({kService, *to})->streamId);
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2018-present, Netifi Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <gmock/gmock.h>
+
+#include "proteus/routing/ShardResolver.h"
+
+using namespace ::testing;
+using namespace ::proteus;
+
+namespace {
+
+constexpr size_t kKeys = 10000;
+
+std::string key(size_t i) {
+  return folly::to<std::string>("key-", i);
+}
+
+std::vector<ShardResolver::Destination> destinations(
+    NameTable& names,
+    std::initializer_list<std::pair<const char*, uint32_t>> weights) {
+  std::vector<ShardResolver::Destination> result;
+  for (const auto& weight : weights) {
+    result.push_back({names.intern(weight.first), weight.second});
+  }
+  return result;
+}
+
+// Destination name of every key.
+std::vector<std::string> resolveAll(
+    const ShardResolver& resolver,
+    const NameTable& names) {
+  std::vector<std::string> result;
+  for (size_t i = 0; i < kKeys; ++i) {
+    auto id = resolver.resolve(folly::ByteRange(folly::StringPiece(key(i))));
+    result.push_back(id ? names.name(*id).str() : "");
+  }
+  return result;
+}
+
+std::map<std::string, size_t> countKeys(const std::vector<std::string>& v) {
+  std::map<std::string, size_t> counts;
+  for (const auto& name : v) {
+    ++counts[name];
+  }
+  return counts;
+}
+
+} // namespace
+
+TEST(ShardResolverTest, JumpHash) {
+  for (uint64_t key = 0; key < 1000; ++key) {
+    const auto hash = ShardResolver::hashKey(
+        folly::ByteRange(folly::StringPiece(folly::to<std::string>(key))));
+    EXPECT_EQ(0u, ShardResolver::jumpHash(hash, 1));
+    for (uint32_t buckets = 1; buckets < 20; ++buckets) {
+      const auto before = ShardResolver::jumpHash(hash, buckets);
+      const auto after = ShardResolver::jumpHash(hash, buckets + 1);
+      EXPECT_LT(after, buckets + 1);
+      EXPECT_TRUE(after == before || after == buckets);
+    }
+  }
+}
+
+TEST(ShardResolverTest, Empty) {
+  NameTable names;
+  for (auto algorithm :
+       {ShardResolver::Algorithm::JUMP, ShardResolver::Algorithm::RENDEZVOUS}) {
+    ShardResolver none(algorithm, {}, names);
+    EXPECT_FALSE(none.resolve(folly::ByteRange()).hasValue());
+    ShardResolver unweighted(
+        algorithm, destinations(names, {{"a", 0}, {"b", 0}}), names);
+    EXPECT_FALSE(unweighted.resolve(folly::ByteRange()).hasValue());
+  }
+}
+
+TEST(ShardResolverTest, Weights) {
+  NameTable names;
+  for (auto algorithm :
+       {ShardResolver::Algorithm::JUMP, ShardResolver::Algorithm::RENDEZVOUS}) {
+    ShardResolver resolver(
+        algorithm, destinations(names, {{"a", 1}, {"b", 3}, {"c", 0}}), names);
+    auto counts = countKeys(resolveAll(resolver, names));
+    EXPECT_EQ(0u, counts.count("c"));
+    EXPECT_NEAR(0.25, static_cast<double>(counts["a"]) / kKeys, 0.05);
+    EXPECT_NEAR(0.75, static_cast<double>(counts["b"]) / kKeys, 0.05);
+  }
+}
+
+TEST(ShardResolverTest, JumpAppendMovesMinimum) {
+  NameTable names;
+  ShardResolver before(
+      ShardResolver::Algorithm::JUMP,
+      destinations(names, {{"a", 1}, {"b", 1}, {"c", 1}}),
+      names);
+  ShardResolver after(
+      ShardResolver::Algorithm::JUMP,
+      destinations(names, {{"a", 1}, {"b", 1}, {"c", 1}, {"d", 1}}),
+      names);
+  const auto keysBefore = resolveAll(before, names);
+  const auto keysAfter = resolveAll(after, names);
+  size_t moved = 0;
+  for (size_t i = 0; i < kKeys; ++i) {
+    if (keysBefore[i] != keysAfter[i]) {
+      EXPECT_EQ("d", keysAfter[i]);
+      ++moved;
+    }
+  }
+  EXPECT_NEAR(0.25, static_cast<double>(moved) / kKeys, 0.05);
+}
+
+TEST(ShardResolverTest, RendezvousRemoveMovesMinimum) {
+  NameTable names;
+  ShardResolver before(
+      ShardResolver::Algorithm::RENDEZVOUS,
+      destinations(names, {{"a", 1}, {"b", 1}, {"c", 1}, {"d", 1}}),
+      names);
+  // Removing a destination from the middle only moves its own keys.
+  ShardResolver after(
+      ShardResolver::Algorithm::RENDEZVOUS,
+      destinations(names, {{"a", 1}, {"c", 1}, {"d", 1}}),
+      names);
+  const auto keysBefore = resolveAll(before, names);
+  const auto keysAfter = resolveAll(after, names);
+  for (size_t i = 0; i < kKeys; ++i) {
+    if (keysBefore[i] != "b") {
+      EXPECT_EQ(keysBefore[i], keysAfter[i]);
+    } else {
+      EXPECT_NE("b", keysAfter[i]);
+    }
+  }
+}
+
+TEST(ShardResolverTest, IndependentOfNameIds) {
+  // Two brokers interning the names in a different order agree.
+  NameTable names1;
+  NameTable names2;
+  names2.intern("c");
+  names2.intern("b");
+  ShardResolver resolver1(
+      ShardResolver::Algorithm::RENDEZVOUS,
+      destinations(names1, {{"a", 1}, {"b", 2}, {"c", 1}}),
+      names1);
+  ShardResolver resolver2(
+      ShardResolver::Algorithm::RENDEZVOUS,
+      destinations(names2, {{"c", 1}, {"a", 1}, {"b", 2}}),
+      names2);
+  EXPECT_EQ(resolveAll(resolver1, names1), resolveAll(resolver2, names2));
+}